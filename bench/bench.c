@@ -0,0 +1,452 @@
+/**
+ * @file bench.c
+ * @brief Microbenchmarks of the catalog hot paths, reported as JSON.
+ *
+ * For every requested catalog size the suite generates a synthetic movies.txt
+ * (generate.c), then times:
+ *
+ * - `load_movies_from_file` and `save_movies_to_file`, per row;
+ * - `create_movie` / `remove_movie` churn on a full catalog, per pair;
+ * - `search_movie` by title, per lookup;
+ * - `sort_movies` by title and by year then rating, per movie sorted.
+ *
+ * Each result carries the nanoseconds per operation, the allocations made and
+ * bytes requested while it ran (bench_alloc.c) and the peak resident set size.
+ * Small catalogs are repeated until a benchmark has done enough operations to
+ * time reliably. The JSON goes to stdout or to the file named by --output;
+ * progress goes to stderr.
+ *
+ * Usage:
+ *   myMovieRating_bench [--rows N]... [--data DIR] [--output FILE] [--seed S]
+ *   myMovieRating_bench --generate N FILE [--seed S]
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "catalog.h"
+#include "movie.h"
+#include "storage.h"
+#include "name_table.h"
+#include "field_scan.h"
+#include "bench_alloc.h"
+#include "generate.h"
+
+#define BENCH_MAX_SIZES 8
+#define BENCH_PER_SIZE 6          // Results per catalog size
+#define BENCH_MIN_OPS 1000000L    // Repeat small catalogs until this many operations
+#define BENCH_MAX_LOOKUPS 2000000L
+#define BENCH_DEFAULT_SEED 42
+
+// One measured benchmark
+typedef struct
+{
+    const char *name;
+    long rows;           // Catalog size
+    long ops;            // Operations timed
+    double ns_per_op;
+    uint64_t allocations;
+    uint64_t bytes_allocated;
+    long peak_rss_kb;
+} BenchResult;
+
+// A running measurement, see bench_start() and bench_stop()
+typedef struct
+{
+    struct timespec started;
+    BenchAllocCounts allocs;
+    double elapsed_ns;   // Accumulated over the timed sections
+} BenchClock;
+
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+
+static void bench_begin(BenchClock *clock)
+{
+    bench_peak_rss_reset();
+    clock->allocs = bench_alloc_counts();
+    clock->elapsed_ns = 0.0;
+}
+
+
+static void bench_start(BenchClock *clock)
+{
+    clock_gettime(CLOCK_MONOTONIC, &clock->started);
+}
+
+
+static void bench_stop(BenchClock *clock)
+{
+    double started = (double)clock->started.tv_sec * 1e9 + (double)clock->started.tv_nsec;
+    clock->elapsed_ns += now_ns() - started;
+}
+
+
+/**
+ * @brief Fills in a result from a finished measurement.
+ *
+ * Allocations are counted from bench_begin(), so work done between the timed
+ * sections (building fresh catalogs for each repetition, say) is included.
+ * Benchmarks keep that work allocation-free or note it.
+ */
+
+static void bench_end(const BenchClock *clock, const char *name, long rows, long ops, BenchResult *result)
+{
+    BenchAllocCounts allocs = bench_alloc_counts();
+    result->name = name;
+    result->rows = rows;
+    result->ops = ops;
+    result->ns_per_op = ops > 0 ? clock->elapsed_ns / (double)ops : 0.0;
+    result->allocations = allocs.allocations - clock->allocs.allocations;
+    result->bytes_allocated = allocs.bytes - clock->allocs.bytes;
+    result->peak_rss_kb = bench_peak_rss_kb();
+    fprintf(stderr, "  %-28s %10ld rows %12.1f ns/op\n", name, rows, result->ns_per_op);
+}
+
+
+static long repetitions(long rows)
+{
+    long reps = BENCH_MIN_OPS / (rows > 0 ? rows : 1);
+    return reps > 0 ? reps : 1;
+}
+
+
+// Records a benchmark that could not run, so it still shows up in the output with no operations
+static void bench_skip(const char *name, long rows, BenchResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->name = name;
+    result->rows = rows;
+    result->peak_rss_kb = -1;
+    fprintf(stderr, "  %-28s %10ld rows skipped\n", name, rows);
+}
+
+
+static void bench_load(const char *path, long rows, BenchResult *result)
+{
+    BenchClock clock;
+    long reps = repetitions(rows);
+
+    bench_begin(&clock);
+    for (long rep = 0; rep < reps; ++rep)
+    {
+        MovieCatalog catalog;
+        if (catalog_init(&catalog, 10) != MOVIE_SUCCESS)
+        {
+            bench_skip("load_movies_from_file", rows, result);
+            return;
+        }
+        bench_start(&clock);
+        load_movies_from_file(path, &catalog);
+        bench_stop(&clock);
+        catalog_destroy(&catalog);
+    }
+    bench_end(&clock, "load_movies_from_file", rows, rows * reps, result);
+}
+
+
+static void bench_save(MovieCatalog *catalog, const char *path, long rows, BenchResult *result)
+{
+    BenchClock clock;
+    long reps = repetitions(rows);
+
+    bench_begin(&clock);
+    bench_start(&clock);
+    for (long rep = 0; rep < reps; ++rep)
+    {
+        save_movies_to_file(path, catalog);
+    }
+    bench_stop(&clock);
+    bench_end(&clock, "save_movies_to_file", rows, rows * reps, result);
+    remove(path);
+}
+
+
+/**
+ * @brief Replaces random movies one at a time: each operation is a
+ *        `remove_movie()` followed by a `create_movie()` reusing the freed slot.
+ */
+
+static void bench_churn(MovieCatalog *catalog, long rows, BenchResult *result)
+{
+    long ops = rows < BENCH_MIN_OPS ? BENCH_MIN_OPS : rows;
+    int slots = catalog->movies.slot_count;
+    uint64_t state = BENCH_DEFAULT_SEED;
+    long done = 0;
+    char title[64];
+    BenchClock clock;
+
+    if (slots == 0)
+    {
+        bench_skip("create_movie/remove_movie", rows, result);
+        return;
+    }
+    bench_begin(&clock);
+    bench_start(&clock);
+    for (long op = 0; op < ops; ++op)
+    {
+        int id = (int)(bench_random(&state) % (uint64_t)slots);
+        if (!catalog_get(catalog, id)) continue;
+        remove_movie(catalog, id);
+        snprintf(title, sizeof(title), "Churned Title %ld", op);
+        create_movie(catalog, title, "Churn Director", 1950 + (int)(op % 70));
+        done++;
+    }
+    bench_stop(&clock);
+    bench_end(&clock, "create_movie/remove_movie", rows, done, result);
+}
+
+
+static void bench_search(MovieCatalog *catalog, long rows, BenchResult *result)
+{
+    int slots = catalog->movies.slot_count;
+    long ops = rows < BENCH_MAX_LOOKUPS ? (rows < BENCH_MIN_OPS ? BENCH_MIN_OPS : rows) : BENCH_MAX_LOOKUPS;
+    const char **titles = (const char**)malloc(sizeof(char*) * (size_t)ops);
+    uint64_t state = BENCH_DEFAULT_SEED + 1;
+    long found = 0;
+    BenchClock clock;
+
+    if (!titles || slots == 0)
+    {
+        free(titles);
+        bench_skip("search_movie", rows, result);
+        return;
+    }
+    for (long op = 0; op < ops; ++op) // Pick the keys first so only lookups are timed
+    {
+        const Movie *movie = NULL;
+        while (!movie) movie = catalog_get(catalog, (int)(bench_random(&state) % (uint64_t)slots));
+        titles[op] = movie->title;
+    }
+    bench_begin(&clock);
+    bench_start(&clock);
+    for (long op = 0; op < ops; ++op)
+    {
+        found += search_movie(catalog, titles[op]) != NULL;
+    }
+    bench_stop(&clock);
+    bench_end(&clock, "search_movie", rows, ops, result);
+    if (found != ops) fprintf(stderr, "  warning: %ld of %ld lookups missed\n", ops - found, ops);
+    free(titles);
+}
+
+
+static void bench_sort(MovieCatalog *catalog, long rows, const char *name,
+                       const MovieSortKey *keys, int key_count, BenchResult *result)
+{
+    int count = 0;
+    Movie **original = (Movie**)malloc(sizeof(Movie*) * (size_t)(catalog->movies.slot_count + 1));
+    Movie **work = (Movie**)malloc(sizeof(Movie*) * (size_t)(catalog->movies.slot_count + 1));
+    BenchClock clock;
+
+    if (!original || !work)
+    {
+        free(original);
+        free(work);
+        bench_skip(name, rows, result);
+        return;
+    }
+    for (int id = 0; id < catalog->movies.slot_count; ++id)
+    {
+        Movie *movie = catalog_get(catalog, id);
+        if (movie) original[count++] = movie;
+    }
+
+    long reps = repetitions(count);
+    bench_begin(&clock);
+    for (long rep = 0; rep < reps; ++rep)
+    {
+        memcpy(work, original, sizeof(Movie*) * (size_t)count); // Every repetition sorts the same input
+        bench_start(&clock);
+        sort_movies(work, count, keys, key_count);
+        bench_stop(&clock);
+    }
+    bench_end(&clock, name, rows, (long)count * reps, result);
+    free(original);
+    free(work);
+}
+
+
+/**
+ * @brief Runs every benchmark on a catalog of `rows` movies.
+ *
+ * @return Number of results written to `results`, which has room for BENCH_PER_SIZE.
+ */
+
+static int run_size(const char *data_dir, long rows, uint64_t seed, BenchResult *results)
+{
+    char path[512], out_path[512];
+    int count = 0;
+
+    snprintf(path, sizeof(path), "%s/movies_%ld.txt", data_dir, rows);
+    snprintf(out_path, sizeof(out_path), "%s/saved_%ld.txt", data_dir, rows);
+
+    struct stat info;
+    if (stat(path, &info) != 0)
+    {
+        fprintf(stderr, "Generating %s\n", path);
+        if (!bench_generate_movies(path, rows, seed))
+        {
+            fprintf(stderr, "Could not write %s\n", path);
+            return 0;
+        }
+    }
+    fprintf(stderr, "Catalog of %ld movies\n", rows);
+
+    bench_load(path, rows, &results[count++]);
+
+    MovieCatalog catalog;
+    if (catalog_init(&catalog, 10) != MOVIE_SUCCESS) return count;
+    load_movies_from_file(path, &catalog); // Shared by the benchmarks below, untimed
+
+    static const MovieSortKey by_title[] = { { MOVIE_SORT_TITLE, false } };
+    static const MovieSortKey by_year_rating[] = { { MOVIE_SORT_YEAR, false }, { MOVIE_SORT_RATING, true } };
+
+    bench_save(&catalog, out_path, rows, &results[count++]);
+    bench_search(&catalog, rows, &results[count++]);
+    bench_sort(&catalog, rows, "sort_movies/title", by_title, 1, &results[count++]);
+    bench_sort(&catalog, rows, "sort_movies/year,rating", by_year_rating, 2, &results[count++]);
+    bench_churn(&catalog, rows, &results[count++]); // Last, it replaces the loaded titles
+
+    catalog_destroy(&catalog);
+    return count;
+}
+
+
+static void write_json(FILE *file, const BenchResult *results, int count)
+{
+    fprintf(file, "{\n");
+    fprintf(file, "  \"field_scan\": \"%s\",\n", field_scan_name());
+    fprintf(file, "  \"alloc_counting\": %s,\n", bench_alloc_available() ? "true" : "false");
+    fprintf(file, "  \"results\": [\n");
+    for (int i = 0; i < count; ++i)
+    {
+        const BenchResult *result = &results[i];
+        fprintf(file, "    {\"benchmark\": \"%s\", \"rows\": %ld, \"ops\": %ld, \"ns_per_op\": %.2f, "
+                      "\"allocations\": %llu, \"bytes_allocated\": %llu, \"peak_rss_kb\": %ld}%s\n",
+                result->name, result->rows, result->ops, result->ns_per_op,
+                (unsigned long long)result->allocations, (unsigned long long)result->bytes_allocated,
+                result->peak_rss_kb, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+
+static bool parse_count(const char *text, long *value)
+{
+    char *end;
+    errno = 0;
+    long result = strtol(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || result < 1) return false;
+    *value = result;
+    return true;
+}
+
+
+static int usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--rows N]... [--data DIR] [--output FILE] [--seed S]\n"
+                    "       %s --generate N FILE [--seed S]\n", program, program);
+    return 1;
+}
+
+
+/**
+ * @brief Runs the suite, or only the generator with --generate.
+ *
+ * Without --rows the sizes are 1000 and 100000. Generated inputs are kept in
+ * the data directory (default `bench_data`) and reused by later runs.
+ */
+
+int main(int argc, char *argv[])
+{
+    long sizes[BENCH_MAX_SIZES];
+    int size_count = 0;
+    const char *data_dir = "bench_data";
+    const char *output = NULL;
+    const char *generate_path = NULL;
+    long generate_rows = 0;
+    long seed = BENCH_DEFAULT_SEED;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--rows") == 0 && has_value && size_count < BENCH_MAX_SIZES)
+        {
+            if (!parse_count(argv[++i], &sizes[size_count++])) return usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--data") == 0 && has_value)
+        {
+            data_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--output") == 0 && has_value)
+        {
+            output = argv[++i];
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && has_value)
+        {
+            if (!parse_count(argv[++i], &seed)) return usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--generate") == 0 && i + 2 < argc)
+        {
+            if (!parse_count(argv[++i], &generate_rows)) return usage(argv[0]);
+            generate_path = argv[++i];
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    if (generate_path)
+    {
+        if (bench_generate_movies(generate_path, generate_rows, (uint64_t)seed)) return 0;
+        fprintf(stderr, "Could not write %s\n", generate_path);
+        return 1;
+    }
+
+    if (size_count == 0)
+    {
+        sizes[size_count++] = 1000;
+        sizes[size_count++] = 100000;
+    }
+    if (mkdir(data_dir, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Could not create %s\n", data_dir);
+        return 1;
+    }
+
+    BenchResult results[BENCH_MAX_SIZES * BENCH_PER_SIZE];
+    int count = 0;
+    for (int i = 0; i < size_count; ++i)
+    {
+        count += run_size(data_dir, sizes[i], (uint64_t)seed, results + count);
+    }
+    name_table_destroy();
+
+    FILE *file = output ? fopen(output, "w") : stdout;
+    if (!file)
+    {
+        fprintf(stderr, "Could not write %s\n", output);
+        return 1;
+    }
+    write_json(file, results, count);
+    if (output) fclose(file);
+
+    int status = count == size_count * BENCH_PER_SIZE ? 0 : 1;
+    for (int i = 0; i < count; ++i)
+    {
+        if (results[i].ops == 0) status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file bench_alloc.c
+ * @brief Counting allocator and peak RSS readings for the benchmarks.
+ *
+ * The counters are updated with relaxed atomics: the parallel text loader
+ * allocates from several threads, and only the totals between two readings
+ * matter. Peak RSS comes from VmHWM in /proc/self/status, which Linux lets a
+ * process reset by writing 5 to /proc/self/clear_refs, so each benchmark
+ * reports its own peak rather than the largest one so far.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include "bench_alloc.h"
+#include "perf.h"
+
+#if defined(__GLIBC__) && PERF_ENABLED
+
+// perf.c already counts allocations, and only one definition of malloc() can be linked
+
+bool bench_alloc_available(void)
+{
+    uint64_t allocations, bytes;
+    return perf_alloc_totals(&allocations, &bytes);
+}
+
+
+BenchAllocCounts bench_alloc_counts(void)
+{
+    BenchAllocCounts counts;
+    perf_alloc_totals(&counts.allocations, &counts.bytes);
+    return counts;
+}
+
+#elif defined(__GLIBC__)
+
+static uint64_t allocation_count;
+static uint64_t allocation_bytes;
+
+// The C library's own entry points, which the definitions below forward to
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+
+static inline void count_allocation(size_t size)
+{
+    __atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocation_bytes, (uint64_t)size, __ATOMIC_RELAXED);
+}
+
+
+void *malloc(size_t size)
+{
+    count_allocation(size);
+    return __libc_malloc(size);
+}
+
+
+void *calloc(size_t count, size_t size)
+{
+    count_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+
+void *realloc(void *pointer, size_t size)
+{
+    count_allocation(size); // A resize may move the block, so the new size is what it costs
+    return __libc_realloc(pointer, size);
+}
+
+
+bool bench_alloc_available(void)
+{
+    return true;
+}
+
+
+/**
+ * @brief Returns the number of allocations and bytes requested since the start.
+ */
+
+BenchAllocCounts bench_alloc_counts(void)
+{
+    BenchAllocCounts counts;
+    counts.allocations = __atomic_load_n(&allocation_count, __ATOMIC_RELAXED);
+    counts.bytes = __atomic_load_n(&allocation_bytes, __ATOMIC_RELAXED);
+    return counts;
+}
+
+#else
+
+bool bench_alloc_available(void)
+{
+    return false;
+}
+
+
+BenchAllocCounts bench_alloc_counts(void)
+{
+    BenchAllocCounts counts = { 0, 0 };
+    return counts;
+}
+
+#endif
+
+
+/**
+ * @brief Starts a new peak RSS measurement, where the system allows it.
+ */
+
+void bench_peak_rss_reset(void)
+{
+    FILE *file = fopen("/proc/self/clear_refs", "w");
+    if (!file) return;
+    fputs("5", file);
+    fclose(file);
+}
+
+
+/**
+ * @brief Returns the peak resident set size in KiB since the last reset.
+ *
+ * Falls back to the peak of the whole process where VmHWM is not available.
+ */
+
+long bench_peak_rss_kb(void)
+{
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file)
+    {
+        char line[128];
+        long peak = -1;
+        while (fgets(line, sizeof(line), file))
+        {
+            if (strncmp(line, "VmHWM:", 6) == 0)
+            {
+                peak = strtol(line + 6, NULL, 10);
+                break;
+            }
+        }
+        fclose(file);
+        if (peak >= 0) return peak;
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+    return usage.ru_maxrss;
+}
@@ -0,0 +1,30 @@
+#ifndef BENCH_ALLOC_H
+#define BENCH_ALLOC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Allocation and memory counters for the benchmarks.
+ *
+ * On glibc the bench executable defines `malloc()`, `calloc()` and `realloc()`
+ * itself, counting each call and the bytes requested before handing it to the
+ * C library. Because the core library is linked statically into the
+ * executable, and glibc calls these through the dynamic linker too, every
+ * allocation made during a benchmark is seen, `strdup()` included. Elsewhere
+ * the counters are unavailable and `bench_alloc_available()` returns false.
+ */
+
+typedef struct
+{
+    uint64_t allocations;
+    uint64_t bytes;
+} BenchAllocCounts;
+
+// Function Prototypes
+bool bench_alloc_available(void);
+BenchAllocCounts bench_alloc_counts(void);
+void bench_peak_rss_reset(void);
+long bench_peak_rss_kb(void);
+
+#endif //BENCH_ALLOC_H
@@ -0,0 +1,18 @@
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Synthetic movies.txt files for the benchmarks.
+ *
+ * The same row count and seed always give the same file, so numbers from
+ * different builds are measured on identical input.
+ */
+
+// Function Prototypes
+bool bench_generate_movies(const char *path, long rows, uint64_t seed);
+uint64_t bench_random(uint64_t *state);
+
+#endif //GENERATE_H
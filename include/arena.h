@@ -0,0 +1,53 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ * @brief Bump allocator for immutable strings.
+ *
+ * Strings are carved out of large blocks and are never freed individually;
+ * every block is released at once by `string_arena_destroy()`. Buffers that
+ * were allocated elsewhere with malloc (such as a whole file read by the
+ * loader) can be handed over with `string_arena_adopt()` so they share the
+ * same lifetime.
+ */
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct
+{
+    ArenaBlock *head;   // Block currently being filled, linked to older blocks
+    size_t block_size;  // Default payload size of a new block
+} StringArena;
+
+/**
+ * @brief Fixed-size object allocator with a free-list.
+ *
+ * Objects are handed out from blocks of `objects_per_block` slots. Freed objects
+ * are threaded onto an intrusive free-list and reused before a new block is taken.
+ * All blocks are released at once by `slab_destroy()`.
+ */
+typedef struct SlabBlock SlabBlock;
+
+typedef struct
+{
+    SlabBlock *blocks;         // Most recent block first
+    void *free_list;           // Singly linked list of released objects
+    size_t object_size;        // Rounded up to pointer alignment
+    size_t objects_per_block;
+    size_t used_in_head;       // Objects already handed out from the head block
+} Slab;
+
+// Function Prototypes
+void string_arena_init(StringArena *arena, size_t block_size);
+char* string_arena_alloc(StringArena *arena, size_t size);
+char* string_arena_strdup(StringArena *arena, const char *string);
+int string_arena_adopt(StringArena *arena, void *buffer);
+void string_arena_destroy(StringArena *arena);
+
+void slab_init(Slab *slab, size_t object_size, size_t objects_per_block);
+void* slab_alloc(Slab *slab);
+void slab_free(Slab *slab, void *object);
+void slab_destroy(Slab *slab);
+
+#endif //ARENA_H
@@ -0,0 +1,68 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define AUTOSAVE_MAX_FILES 2
+
+// Runs on the UI thread from `autosave_poll()` once a job has been written
+typedef void (*AutosaveDoneFn)(void *context, bool ok);
+
+/**
+ * @brief A set of files captured in memory, to be written by the autosave worker.
+ *
+ * Every file is written to `<filename>.tmp` and flushed, and only once all of
+ * them are complete are they renamed into place, in the order they were added.
+ * `retired_filename`, if set, is removed after the last rename.
+ */
+typedef struct AutosaveJob
+{
+    int file_count;
+    char *filenames[AUTOSAVE_MAX_FILES];
+    char *data[AUTOSAVE_MAX_FILES];
+    size_t sizes[AUTOSAVE_MAX_FILES];
+    char *retired_filename;
+    AutosaveDoneFn done;
+    void *context;
+    bool ok;
+    struct AutosaveJob *next;
+} AutosaveJob;
+
+/**
+ * @brief The background persistence worker.
+ *
+ * The UI thread captures what it wants saved into an AutosaveJob, which costs
+ * memory copies only, and submits it. The worker does the disk I/O. Finished
+ * jobs wait until the UI thread calls `autosave_poll()`, so their callbacks
+ * never race with the UI. Without a worker thread, jobs are written on submit.
+ */
+typedef struct
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t written;    // Signalled each time the worker finishes a job
+    AutosaveJob *pending;      // Oldest first
+    AutosaveJob *running;      // Being written by the worker
+    AutosaveJob *pending_tail;
+    AutosaveJob *finished;     // Written, waiting for autosave_poll()
+    int outstanding;           // Jobs submitted and not yet polled
+    bool stopping;
+    bool started;              // false: the worker could not be created
+} Autosave;
+
+// Function Prototypes
+void autosave_start(Autosave *autosave);
+AutosaveJob* autosave_job_create(AutosaveDoneFn done, void *context);
+bool autosave_job_add_file(AutosaveJob *job, const char *filename, char *data, size_t size);
+bool autosave_job_retire(AutosaveJob *job, const char *filename);
+void autosave_job_destroy(AutosaveJob *job);
+void autosave_submit(Autosave *autosave, AutosaveJob *job);
+bool autosave_idle(Autosave *autosave);
+void autosave_wait_for_file(Autosave *autosave, const char *filename);
+void autosave_poll(Autosave *autosave);
+void autosave_stop(Autosave *autosave);
+
+#endif //AUTOSAVE_H
@@ -0,0 +1,20 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "catalog.h"
+#include "storage.h"
+
+/**
+ * @brief Non-interactive command line mode.
+ *
+ * `myMovieRating --import movies.txt --script edits.txt --export out.bin` runs
+ * without curses. Options are carried out in the order given, against the same
+ * catalog and store the interactive program uses, and the collection is saved
+ * once at the end rather than journaled edit by edit. See `run_batch()` for the
+ * options and the script commands.
+ */
+
+// Function Prototypes
+int run_batch(CatalogStore *store, MovieCatalog *catalog, int argc, char *argv[]);
+
+#endif //BATCH_H
@@ -0,0 +1,77 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "movie.h"
+#include "collection.h"
+#include "journal.h"
+#include "trigram_index.h"
+#include "movie_columns.h"
+#include "catalog_stats.h"
+
+/**
+ * @brief The movie collection together with the indexes built over it.
+ *
+ * The records themselves live in `movies`, a Collection (collection.h) that
+ * gives every movie a stable slot id, frees and reuses slots in O(1), and keeps
+ * the title index and the sorted views current. Code that walks the catalog
+ * iterates `movies.slot_count` slots and skips the NULL holes. Ids only change
+ * in `catalog_compact()`, which runs right after a snapshot has been written,
+ * so journaled ids always refer to the snapshot that precedes them.
+ *
+ * Movie structures come from the collection's slab and their titles from its
+ * string arena, so the whole catalog is released by `catalog_destroy()` with a
+ * handful of free() calls regardless of how many records it holds.
+ *
+ * On top of the collection the catalog maintains what only movies have: the
+ * trigram index over titles and directors behind the list filter, built lazily
+ * (see `catalog_text_index()`), the year, rating and director of every slot in
+ * `columns` (movie_columns.h) for whole-catalog queries, and running totals in
+ * `stats` (catalog_stats.h) for the statistics screen. While a journal is
+ * attached, the record functions in movie.c append every change to it, so
+ * edits are persisted one entry at a time, and a bulk edit as a single entry
+ * (see `edit_movies()`). An attached recommendation index is
+ * refreshed on rating changes and marked stale by every other edit, and an
+ * attached history (history.h) logs every edit so it can be undone.
+ */
+// Maintained orderings of the catalog, indexes into the collection's orders
+typedef enum
+{
+    MOVIE_VIEW_ID,       // Slot order, the order the records are saved in
+    MOVIE_VIEW_TITLE,    // Title, then year
+    MOVIE_VIEW_YEAR,     // Year, then title
+    MOVIE_VIEW_RATING,   // Best rated first, then title
+    MOVIE_VIEW_DIRECTOR, // Director, then year
+    MOVIE_VIEW_COUNT,
+} MovieView;
+
+struct MovieCatalog
+{
+    Collection movies;  // Slots indexed by movie id, with the title index and sorted views
+    Journal *journal;   // Receives every edit when attached, NULL while loading
+    TrigramIndex text_index; // Title and director trigrams -> id, built on first use
+    MovieColumns columns; // Year, rating and director code per slot, for scans and aggregates
+    CatalogStats stats;   // Histogram and per-decade and per-director totals over the columns
+    struct RecommendIndex *recommend; // Kept current with rating changes when attached, see recommend.h
+    struct History *history; // Records every edit for undo when attached, see history.h
+};
+
+// Function Prototypes
+MovieError catalog_init(MovieCatalog *catalog, int capacity);
+MovieError catalog_reserve(MovieCatalog *catalog, int extra);
+MovieError catalog_append(MovieCatalog *catalog, Movie *movie);
+void catalog_unlink(MovieCatalog *catalog, Movie *movie);
+void catalog_link(MovieCatalog *catalog, Movie *movie);
+void catalog_unlink_batch(MovieCatalog *catalog, Movie *const *movies, int count);
+void catalog_link_batch(MovieCatalog *catalog, Movie *const *movies, int count);
+void catalog_release(MovieCatalog *catalog, Movie *movie);
+void catalog_detach(MovieCatalog *catalog, Movie *movie);
+void catalog_discard_borrowed(MovieCatalog *catalog, const char *begin, const char *end);
+Movie* catalog_get(const MovieCatalog *catalog, int id);
+bool catalog_needs_compaction(const MovieCatalog *catalog);
+void catalog_compact(MovieCatalog *catalog);
+SortedView* catalog_view(MovieCatalog *catalog, MovieView view);
+TrigramIndex* catalog_text_index(MovieCatalog *catalog);
+const CatalogStats* catalog_statistics(MovieCatalog *catalog);
+void catalog_destroy(MovieCatalog *catalog);
+
+#endif //CATALOG_H
@@ -0,0 +1,51 @@
+#ifndef CATALOG_STATS_H
+#define CATALOG_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "movie_columns.h"
+
+/**
+ * @brief Running totals behind the statistics screen.
+ *
+ * The catalog hooks add a movie's column values when it is linked and subtract
+ * them when it is unlinked, so creating, rating, editing or deleting a movie
+ * costs a few counter updates and the dashboard reads finished numbers instead
+ * of scanning the collection. Counters are keyed by the same values the columns
+ * store: ratings in tenths of a point, decades as year / 10, and directors by
+ * their code in the shared name table, which never changes for a name.
+ *
+ * If the per-director table cannot grow, the totals are marked stale and
+ * `catalog_stats_rebuild()` recomputes them from the columns on the next read.
+ */
+
+#define STATS_RATING_BINS (UINT8_MAX + 1) // One bin per column rating, 0 for unrated
+
+// Count, rated count and rating sum of a group of movies
+typedef struct
+{
+    uint32_t count;
+    uint32_t rated;
+    uint64_t rating_sum; // Tenths of a point, unrated movies add 0
+} StatsGroup;
+
+typedef struct
+{
+    uint32_t ratings[STATS_RATING_BINS]; // Movies per column rating
+    StatsGroup *decades;    // MOVIE_DECADE_SLOTS groups indexed by year / 10
+    StatsGroup *directors;  // Indexed by director code
+    uint32_t director_capacity;
+    StatsGroup total;
+    bool valid;             // false after an allocation failure, until rebuilt
+} CatalogStats;
+
+// Function Prototypes
+bool catalog_stats_init(CatalogStats *stats);
+void catalog_stats_destroy(CatalogStats *stats);
+void catalog_stats_add(CatalogStats *stats, int16_t year, uint8_t rating, uint32_t director);
+void catalog_stats_remove(CatalogStats *stats, int16_t year, uint8_t rating, uint32_t director);
+bool catalog_stats_rebuild(CatalogStats *stats, const MovieColumns *columns, int slot_count);
+float stats_group_average(const StatsGroup *group);
+int catalog_stats_top_directors(const CatalogStats *stats, uint32_t *codes, int max);
+
+#endif //CATALOG_STATS_H
@@ -0,0 +1,100 @@
+#ifndef COLLECTION_H
+#define COLLECTION_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "arena.h"
+#include "sort.h"
+#include "title_index.h"
+#include "sorted_view.h"
+
+/**
+ * @brief Record storage shared by the movie and TV series collections.
+ *
+ * A collection keeps records of one type in slots indexed by their id. Ids are
+ * stable: removing a record leaves a NULL hole and pushes the slot on a free
+ * stack, and the next insert reuses it, so both are O(1). Code that walks a
+ * collection iterates `slot_count` slots and skips the holes.
+ * `collection_compact()` closes the holes and renumbers the ids.
+ *
+ * Every record is indexed by title in a hash index, so a lookup by title is
+ * O(1), and the orderings named by its CollectionType are maintained as sorted
+ * views, built the first time they are asked for and from then on kept current
+ * in O(log N) per change.
+ *
+ * A record's type says where its `int id` and `char *title` members are. The
+ * collection also offers a slab for the records and a string arena for their
+ * strings; types that allocate their records elsewhere name a `destroy`
+ * function instead, which the collection calls on the records it still holds
+ * when it is destroyed.
+ *
+ * The hooks follow the same protocol for every type: `collection_append()` for
+ * a new record, `collection_unlink()` before a record is removed or one of its
+ * keys changes, `collection_link()` once the new keys are in place, and
+ * `collection_release()` to empty the slot of an unlinked record.
+ * `collection_unlink_batch()` and `collection_link_batch()` do the same for many
+ * records at once; a view that a batch would re-key in large part is dropped
+ * instead, and sorted once on its next use.
+ */
+
+#define COLLECTION_MAX_VIEWS 8
+#define COLLECTION_MAX_VIEW_FIELDS 2
+#define COLLECTION_REBUILD_FRACTION 8 // A batch re-keying 1/8 of the records drops an index to rebuild it
+
+// One maintained ordering of a collection
+typedef struct
+{
+    SortField fields[COLLECTION_MAX_VIEW_FIELDS];
+    int field_count;
+} CollectionOrder;
+
+// What a collection needs to know about its records
+typedef struct
+{
+    size_t record_size;          // Size of the slab objects
+    size_t id_offset;            // offsetof(Record, id), an int
+    size_t title_offset;         // offsetof(Record, title), a char *
+    const CollectionOrder *orders;
+    int order_count;             // At most COLLECTION_MAX_VIEWS
+    void (*destroy)(void *record); // Frees a record not taken from the slab, or NULL
+} CollectionType;
+
+typedef struct
+{
+    const CollectionType *type;
+    void **records;       // Slots indexed by id, NULL for removed records
+    int count;            // Live records
+    int slot_count;       // Slots handed out so far, live or free
+    int capacity;         // Allocated slots
+    int *free_slots;      // Stack of released ids, reused before new slots
+    int free_count;
+    Slab slab;            // Storage for records of `record_size` bytes
+    StringArena strings;  // Storage for their strings
+    TitleIndex title_index; // Normalized title -> record
+    SortedView views[COLLECTION_MAX_VIEWS]; // One per order, built on first use
+} Collection;
+
+// Called by collection_compact() for every record that changes slot
+typedef void (*CollectionMoveFn)(void *context, int from, int to);
+
+// Function Prototypes
+bool collection_init(Collection *collection, const CollectionType *type, int capacity);
+void collection_destroy(Collection *collection);
+bool collection_reserve(Collection *collection, int extra);
+void* collection_alloc(Collection *collection);
+void collection_free(Collection *collection, void *record);
+bool collection_append(Collection *collection, void *record);
+void collection_unlink(Collection *collection, void *record);
+void collection_link(Collection *collection, void *record);
+void collection_unlink_batch(Collection *collection, void *const *records, int count);
+void collection_link_batch(Collection *collection, void *const *records, int count);
+void collection_release(Collection *collection, void *record);
+void* collection_get(const Collection *collection, int id);
+int collection_id(const Collection *collection, const void *record);
+void* collection_find(const Collection *collection, const char *title);
+bool collection_needs_compaction(const Collection *collection);
+void collection_compact(Collection *collection, CollectionMoveFn moved, void *context);
+SortedView* collection_view(Collection *collection, int order);
+int collection_page(Collection *collection, int order, int start, void **page, int max);
+
+#endif //COLLECTION_H
@@ -0,0 +1,53 @@
+#ifndef DUMP_IMPORT_H
+#define DUMP_IMPORT_H
+
+#include <stdbool.h>
+#include "catalog.h"
+
+/**
+ * @brief Streaming import of CSV and TSV dumps into the catalog.
+ *
+ * The first row names the columns; `title`/`primaryTitle`/`name`, `director`/
+ * `directors`, `year`/`startYear`, `rating`/`averageRating` (IMDb's, out of 10)
+ * and `titleType` are recognised in any case, and a file whose first row names
+ * no title and year column is read as title, director, year, rating. CSV fields
+ * may be quoted as in RFC 4180, with embedded delimiters, doubled quotes and
+ * line breaks; TSV fields are taken literally, and `\N` is an empty field, as in
+ * the IMDb datasets. A '|' or line break in a title or director becomes a space,
+ * as the text export separates fields and movies with them. Gzipped dumps
+ * (`.csv.gz`, `.tsv.gz`) are read as they are.
+ *
+ * The file is read DUMP_BUFFER_SIZE bytes at a time, and rows are collected in
+ * batches of at most DUMP_BATCH_ROWS before they are checked and added, so the
+ * memory used is the same for a thousand rows or a hundred million.
+ */
+
+#define DUMP_BUFFER_SIZE (1 << 20)    // Bytes read from the file at a time
+#define DUMP_BATCH_ROWS 4096          // Rows collected before they are added to the catalog
+#define DUMP_BATCH_BYTES (4 << 20)    // Or bytes of their strings, whichever comes first
+#define DUMP_MAX_FIELDS 64            // Columns kept per row; later ones are ignored
+#define DUMP_MAX_ROW 65536            // Bytes kept per row; longer rows are rejected
+
+// What an import did with the rows of a dump
+typedef struct
+{
+    int rows;        // Data rows read, not counting the header
+    int added;
+    int duplicates;  // Same title and year as a movie in the catalog, or earlier in the dump
+    int invalid;     // Missing or malformed title, year or rating, or too long
+    int skipped;     // Not a movie according to the titleType column
+} DumpImportStats;
+
+// Error codes
+typedef enum
+{
+    DUMP_IMPORT_SUCCESS,
+    DUMP_IMPORT_ERROR_IO,
+    DUMP_IMPORT_ERROR_MEMORY_ALLOCATION,
+} DumpImportError;
+
+// Function Prototypes
+bool dump_import_supported(const char *filename);
+DumpImportError import_dump(const char *filename, MovieCatalog *catalog, DumpImportStats *stats);
+
+#endif //DUMP_IMPORT_H
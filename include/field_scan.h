@@ -0,0 +1,33 @@
+#ifndef FIELD_SCAN_H
+#define FIELD_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Vectorized search for the delimiters of the pipe-separated text format.
+ *
+ * `field_scan()` finds every '|' and '\n' in a block of bytes in one pass and
+ * writes their offsets, in order, to a table the parser then walks instead of
+ * searching each line field by field. The implementation is chosen once, at the
+ * first call, from what the CPU supports: AVX2 or SSE2 on x86, NEON on ARM, and
+ * a portable byte loop everywhere else. All of them produce the same table.
+ */
+
+// Implementations, see field_scan_use()
+typedef enum
+{
+    FIELD_SCAN_AUTO,     // Best one the CPU supports
+    FIELD_SCAN_SCALAR,
+    FIELD_SCAN_SSE2,
+    FIELD_SCAN_AVX2,
+    FIELD_SCAN_NEON,
+} FieldScanKind;
+
+// Function Prototypes
+size_t field_scan(const char *data, size_t size, uint32_t *offsets);
+bool field_scan_use(FieldScanKind kind);
+const char* field_scan_name(void);
+
+#endif //FIELD_SCAN_H
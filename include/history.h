@@ -0,0 +1,69 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "movie.h"
+
+#define HISTORY_CAPACITY (4 << 20) // Bytes of deltas kept; the oldest are dropped to make room
+#define HISTORY_LABEL_SIZE 96      // Room for the description `history_undo()` gives
+
+/**
+ * @brief Multi-level undo and redo of the edits made to a catalog.
+ *
+ * While a history is attached to a catalog (`catalog->history`), the record
+ * functions in movie.c log every add, rating, update, deletion and bulk edit
+ * as a delta in a ring buffer of fixed size. A delta holds only what the edit
+ * replaced, never a copy of the record: a pointer to the movie and its previous
+ * values, or for a bulk edit the previous values of the fields the edit set,
+ * movie by movie. Strings are shared, not copied, since the catalog never frees
+ * or modifies a title or director once handed out (see `update_movie()`).
+ * Undoing exchanges the values in the delta with those in the movie, so the
+ * same delta redoes the edit afterwards, and a bulk edit of thousands of movies
+ * is undone by one pass over the indexes, as it was applied
+ * (see `catalog_unlink_batch()`).
+ *
+ * Deltas point at Movie structures rather than ids, which change when the
+ * catalog is compacted. A deleted movie's structure is therefore kept out of
+ * the catalog for as long as its deletion can be undone, and put back as it
+ * was; it returns to the slab when the delta is dropped. An edit made after
+ * some undos drops the deltas that could have been redone.
+ *
+ * Undos and redos are journaled like the edits themselves, so they persist.
+ * The history only lives for the session, and only covers the catalog's own
+ * fields: ratings given with a user profile active belong to the profile.
+ */
+
+typedef struct History
+{
+    MovieCatalog *catalog;
+    unsigned char *buffer;   // Ring of deltas, each framed by its size (see history.c)
+    size_t capacity;
+    size_t start;            // Offset of the oldest delta
+    size_t applied;          // Bytes of deltas from `start` that can be undone
+    size_t used;             // Bytes of deltas from `start`; those past `applied` can be redone
+} History;
+
+// Error codes
+typedef enum
+{
+    HISTORY_SUCCESS,
+    HISTORY_ERROR_EMPTY,               // Nothing to undo or redo
+    HISTORY_ERROR_MEMORY_ALLOCATION,   // The catalog could not take a movie back; the history is unchanged
+} HistoryError;
+
+// Function Prototypes
+bool history_init(History *history, MovieCatalog *catalog, size_t capacity);
+void history_clear(History *history);
+void history_destroy(History *history);
+bool history_can_undo(const History *history);
+bool history_can_redo(const History *history);
+void history_record_add(History *history, Movie *movie);
+bool history_record_delete(History *history, Movie *movie);
+void history_record_rate(History *history, Movie *movie);
+void history_record_update(History *history, Movie *movie);
+void history_record_edit(History *history, Movie *const *movies, int count, unsigned fields);
+HistoryError history_undo(History *history, char *label, size_t label_size);
+HistoryError history_redo(History *history, char *label, size_t label_size);
+
+#endif //HISTORY_H
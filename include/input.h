@@ -0,0 +1,31 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+
+#define INPUT_IDLE_MS 200          // How often the idle hook runs while no key arrives
+#define INPUT_MAX_COALESCE 1024    // Repeats folded into one event at most
+
+/**
+ * @brief One key press, or a run of identical presses that were already waiting.
+ *
+ * Holding down an arrow key over a slow link queues dozens of presses; they come
+ * back as a single event whose `count` says how many there were, so the screen
+ * moves once and redraws once. Only keys whose repeats add up (arrows, page keys,
+ * Home/End and KEY_RESIZE) are folded; every other key has a count of 1.
+ */
+typedef struct
+{
+    int key;
+    int count;
+} InputEvent;
+
+// Background work run between key presses, e.g. collecting finished autosaves
+typedef void (*InputIdleFn)(void *context);
+
+// Function Prototypes
+void input_set_idle(InputIdleFn idle, void *context);
+bool input_read(WINDOW *win, int timeout, InputEvent *event);
+
+#endif //INPUT_H
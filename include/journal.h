@@ -0,0 +1,95 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "movie.h"
+
+/**
+ * On-disk layout of the operation journal (host byte order):
+ *
+ *   JournalHeader
+ *   { JournalEntry, title bytes, director bytes [, int32_t ids[id]] }*
+ *
+ * An EDIT entry stands for a whole bulk edit (see `edit_movies()`): its `id` is
+ * the number of movies, whose ids follow the strings, `fields` says which of
+ * title, director, year and rating it sets, and the strings are empty for the
+ * fields it leaves alone. Being one entry, a bulk edit is replayed entirely or,
+ * if the entry was torn, not at all.
+ *
+ * Every entry carries a checksum over itself and its strings, so a record torn
+ * by a crash is detected and dropped on replay. The header names the snapshot
+ * generation the entries apply to; a journal with any other base is stale.
+ *
+ * An append that fails is reported through `notify()` and cut back off the
+ * file, and the journal refuses every later one: replaying the edits after a
+ * missing entry would apply them to the wrong ids. The owner then has to write
+ * a snapshot and reset the journal to save the catalog (see `store_maintain()`).
+ */
+
+#define JOURNAL_MAGIC "MMRJ"
+#define JOURNAL_VERSION 1
+#define JOURNAL_COMPACT_THRESHOLD (1024 * 1024) // Bytes of entries before a new snapshot is due
+
+typedef enum
+{
+    JOURNAL_OP_ADD = 1,
+    JOURNAL_OP_RATE,
+    JOURNAL_OP_UPDATE,
+    JOURNAL_OP_DELETE,
+    JOURNAL_OP_EDIT,
+} JournalOp;
+
+typedef struct
+{
+    char magic[4];            // JOURNAL_MAGIC
+    uint32_t version;         // JOURNAL_VERSION
+    uint64_t base_generation; // Snapshot generation the entries apply on top of
+} JournalHeader;
+
+typedef struct
+{
+    uint32_t checksum;      // FNV-1a over the entry (checksum zeroed) and its strings
+    uint8_t op;             // JournalOp
+    uint8_t fields;         // MovieEditField bits of an EDIT entry, otherwise 0
+    uint8_t reserved[2];
+    int32_t id;             // Catalog id of the record, or the number of records of an EDIT entry
+    int32_t year;
+    float rating;
+    uint32_t title_length;  // Bytes following the entry, no terminator
+    uint32_t director_length;
+} JournalEntry;
+
+typedef struct
+{
+    int fd;                   // Open for appending, -1 when closed
+    uint64_t base_generation;
+    size_t size;              // Current file size in bytes
+    bool failed;              // An edit could not be appended; no more are until the next reset
+} Journal;
+
+// Error codes
+typedef enum
+{
+    JOURNAL_SUCCESS,
+    JOURNAL_ERROR_IO,
+    JOURNAL_ERROR_MEMORY_ALLOCATION,
+} JournalError;
+
+// Function Prototypes
+JournalError journal_open(Journal *journal, const char *filename, uint64_t base_generation);
+JournalError journal_reset(Journal *journal, uint64_t base_generation);
+JournalError journal_rotate(Journal *journal, const char *filename, const char *retired_filename, uint64_t base_generation);
+void journal_close(Journal *journal);
+bool journal_needs_compaction(const Journal *journal);
+bool journal_peek_generation(const char *filename, uint64_t *base_generation);
+bool journal_has_entries(const char *filename, uint64_t base_generation);
+int journal_replay(const char *filename, uint64_t base_generation, MovieCatalog *catalog);
+
+JournalError journal_record_add(Journal *journal, const Movie *movie);
+JournalError journal_record_rate(Journal *journal, const Movie *movie);
+JournalError journal_record_update(Journal *journal, const Movie *movie);
+JournalError journal_record_delete(Journal *journal, int id);
+JournalError journal_record_edit(Journal *journal, const MovieEdit *edit, Movie *const *movies, int count);
+
+#endif //JOURNAL_H
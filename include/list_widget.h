@@ -0,0 +1,68 @@
+#ifndef LIST_WIDGET_H
+#define LIST_WIDGET_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <ncurses.h>
+
+/**
+ * @brief A scrolling, boxed list that only repaints what changed.
+ *
+ * The widget never holds the list itself. It asks `fetch` for the records of the
+ * visible page and `format` for the text of each row, so a list of a million
+ * records costs no more to show than a list of ten. Rendered rows are cached:
+ * moving the highlight repaints the two rows involved, scrolling or a data change
+ * repaints only the rows whose text differs, and the frame is drawn once. Output
+ * is batched with wnoutrefresh()/doupdate().
+ *
+ * The page size follows the terminal height and is recomputed on KEY_RESIZE.
+ */
+
+// Returns up to `max` records starting at list position `start`, or -1 on failure
+typedef int (*ListFetchFn)(void *context, int start, void **rows, int max);
+
+// Writes the text of the row showing `record` at list position `position`
+typedef void (*ListFormatFn)(void *context, const void *record, int position, char *buffer, size_t size);
+
+typedef struct
+{
+    WINDOW *win;
+    int width;
+    int page_size;          // Visible rows, from the terminal height
+    int total;              // Rows in the list
+    int top;                // List position of the first visible row
+    int highlight;          // List position of the highlighted row
+
+    void **rows;            // Records of the visible page
+    int row_count;
+    char *lines;            // Cached text of each visible row, `width` bytes apiece
+    int drawn_highlight;    // Screen row currently drawn highlighted, -1 for none
+    bool page_stale;        // Rows must be fetched and compared again
+    bool frame_stale;       // Box, title, header and footer must be drawn again
+
+    const char *title;
+    const char *header;
+    const char *footer;
+    char tag[24];           // Shown at the right of the top border, e.g. the sort order
+
+    ListFetchFn fetch;
+    ListFormatFn format;
+    void *context;
+} ListWidget;
+
+// Function Prototypes
+bool list_widget_create(ListWidget *list, const char *title, const char *header, const char *footer,
+                        ListFetchFn fetch, ListFormatFn format, void *context);
+void list_widget_destroy(ListWidget *list);
+bool list_widget_resize(ListWidget *list);
+void list_widget_set_total(ListWidget *list, int total);
+void list_widget_set_tag(ListWidget *list, const char *tag);
+void list_widget_set_footer(ListWidget *list, const char *footer);
+void list_widget_move(ListWidget *list, int delta);
+void list_widget_select(ListWidget *list, int position);
+void* list_widget_selected(const ListWidget *list);
+void list_widget_invalidate(ListWidget *list);
+void list_widget_touch(ListWidget *list);
+bool list_widget_render(ListWidget *list);
+
+#endif //LIST_WIDGET_H
@@ -18,20 +18,63 @@ typedef enum
 typedef struct 
 {
     char *title;
-    char *director;
+    const char *director; // Shared copy from name_intern(), see name_table.h
     int year;
     float rating;  // Added this for the movie rating
+    int id;        // Slot in the owning catalog, stable until the catalog is compacted
 } Movie;
 
+// Sort keys, see sort_movies()
+typedef enum
+{
+    MOVIE_SORT_TITLE,
+    MOVIE_SORT_DIRECTOR,
+    MOVIE_SORT_YEAR,
+    MOVIE_SORT_RATING,
+} MovieSortField;
+
+typedef struct
+{
+    MovieSortField field;
+    bool descending;
+} MovieSortKey;
+
+// Fields changed by a bulk edit, see edit_movies()
+typedef enum
+{
+    MOVIE_EDIT_TITLE    = 1 << 0,
+    MOVIE_EDIT_DIRECTOR = 1 << 1,
+    MOVIE_EDIT_YEAR     = 1 << 2,
+    MOVIE_EDIT_RATING   = 1 << 3,
+} MovieEditField;
+
+// One change applied to every movie of a bulk edit
+typedef struct
+{
+    unsigned fields;       // MovieEditField bits
+    const char *title;     // Used with MOVIE_EDIT_TITLE
+    const char *director;  // Used with MOVIE_EDIT_DIRECTOR
+    int year;              // Used with MOVIE_EDIT_YEAR
+    float rating;          // Used with MOVIE_EDIT_RATING
+} MovieEdit;
+
+// Owner of the Movie structures and their strings, see catalog.h
+typedef struct MovieCatalog MovieCatalog;
+
 // Function Prototypes
-Movie* create_movie(const char *title, const char *director, int year);
-MovieError update_movie(Movie *movie, const char *new_title, const char *new_director, int new_year);
+Movie* create_movie(MovieCatalog *catalog, const char *title, const char *director, int year);
+Movie* create_movie_borrowed(MovieCatalog *catalog, char *title, const char *director, int year, float rating);
+MovieError update_movie(MovieCatalog *catalog, Movie *movie, const char *new_title, const char *new_director, int new_year);
+MovieError edit_movies(MovieCatalog *catalog, Movie *const *movies, int count, const MovieEdit *edit);
 void display_movie(const Movie *movie);
-Movie* search_movie(Movie* movies[], int count, const char* title);
-void sort_movies(Movie* movies[], int count); // Sort by criteria like title or year
-void rate_movie(Movie *movie); // Correctly declared
-void delete_movie(Movie ***movies, int *count, int index);
-void handle_deletion(Movie ***movies, int *count, int selected_index); 
+Movie* search_movie(const MovieCatalog *catalog, const char *title);
+MovieError sort_movies(Movie* movies[], int count, const MovieSortKey keys[], int key_count); // Compound keys, most significant first
+MovieError set_movie_rating(MovieCatalog *catalog, Movie *movie, float rating);
+int read_movie_rating(const Movie *movie);
+void rate_movie(MovieCatalog *catalog, Movie *movie); // Correctly declared
+MovieError remove_movie(MovieCatalog *catalog, int id);
+void delete_movie(MovieCatalog *catalog, int id);
+void handle_deletion(MovieCatalog *catalog, int selected_id); 
 
 
 #endif //MOVIE_H
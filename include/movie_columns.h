@@ -0,0 +1,55 @@
+#ifndef MOVIE_COLUMNS_H
+#define MOVIE_COLUMNS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "movie.h"
+#include "name_table.h"
+
+/**
+ * @brief Column copies of the numeric movie fields, indexed by movie id.
+ *
+ * Scanning `Movie **` for a year or rating costs a pointer chase and a cache
+ * miss per record. The catalog therefore keeps each movie's year, rating and
+ * director additionally in contiguous arrays indexed by slot, so aggregates and
+ * range filters are plain loops over a few bytes per movie that the compiler
+ * can vectorize. The Movie structures stay the source of truth; the catalog
+ * hooks keep the columns in step with them.
+ *
+ * Years are stored as int16_t (clamped to INT16_MAX) with 0 marking a free
+ * slot, ratings as tenths of a point in a uint8_t (the precision the text file
+ * keeps), and directors as their codes in the shared name table.
+ */
+
+#define MOVIE_RATING_SCALE 10  // Column ratings are in tenths of a point
+#define MOVIE_DECADE_SLOTS (INT16_MAX / 10 + 1) // Every decade a year column can hold
+
+typedef struct
+{
+    int16_t *years;        // 0 for free slots
+    uint8_t *ratings;      // Tenths of a point, 0 for unrated
+    uint32_t *directors;   // name_code() of the director, STRING_INTERN_NONE for free slots
+    int capacity;
+} MovieColumns;
+
+// One decade of `movie_columns_decades()`
+typedef struct
+{
+    int decade;       // First year of the decade, e.g. 1990
+    int count;        // Movies from the decade
+    int rated;        // Of which rated
+    float average;    // Average rating of the rated ones, 0 if none
+} DecadeSummary;
+
+// Function Prototypes
+bool movie_columns_init(MovieColumns *columns, int capacity);
+void movie_columns_destroy(MovieColumns *columns);
+bool movie_columns_reserve(MovieColumns *columns, int capacity);
+void movie_columns_set(MovieColumns *columns, int id, const Movie *movie);
+void movie_columns_clear(MovieColumns *columns, int id);
+void movie_columns_move(MovieColumns *columns, int from, int to);
+uint8_t movie_rating_quantize(float rating);
+int movie_columns_select(const MovieColumns *columns, int slot_count, int min_year, int max_year, float min_rating, int *ids);
+int movie_columns_decades(const MovieColumns *columns, int slot_count, DecadeSummary *out, int max);
+
+#endif //MOVIE_COLUMNS_H
@@ -0,0 +1,44 @@
+#ifndef MOVIE_FILTER_H
+#define MOVIE_FILTER_H
+
+#include <stdbool.h>
+#include "movie.h"
+
+/**
+ * @brief Incremental substring filter over a catalog's titles and directors.
+ *
+ * The query is built one character at a time and the matching ids are kept for
+ * every prefix of it, so extending the query only re-checks the previous result
+ * set (or the catalog's trigram candidates, whichever is smaller) and deleting
+ * a character just goes back to the result set that was already there.
+ * Matching ignores ASCII case. Results are ids in ascending order.
+ */
+
+#define MOVIE_FILTER_MAX_QUERY 63
+
+typedef struct
+{
+    int *ids;
+    int count;
+    int capacity;
+    bool valid;
+} MovieFilterLevel;
+
+typedef struct
+{
+    char query[MOVIE_FILTER_MAX_QUERY + 1];
+    int length;
+    MovieFilterLevel levels[MOVIE_FILTER_MAX_QUERY + 1]; // levels[n]: matches of the first n characters
+} MovieFilter;
+
+// Function Prototypes
+void movie_filter_init(MovieFilter *filter);
+void movie_filter_destroy(MovieFilter *filter);
+MovieError movie_filter_push(MovieFilter *filter, MovieCatalog *catalog, char c);
+MovieError movie_filter_pop(MovieFilter *filter, MovieCatalog *catalog);
+MovieError movie_filter_refresh(MovieFilter *filter, MovieCatalog *catalog);
+void movie_filter_clear(MovieFilter *filter);
+const int* movie_filter_results(const MovieFilter *filter, int *count);
+bool movie_matches(const Movie *movie, const char *query);
+
+#endif //MOVIE_FILTER_H
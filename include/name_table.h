@@ -0,0 +1,31 @@
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <stdint.h>
+#include "string_intern.h"
+
+/**
+ * @brief One shared copy of every director and creator name.
+ *
+ * `Movie.director` and `TV_Series.creator` point into this process-wide table
+ * instead of owning a copy: a few thousand distinct names are shared by
+ * millions of records. `name_intern()` returns the table's copy of a name, so
+ * two records have the same person exactly when their pointers are equal, and
+ * editing a record to a name that is already known allocates nothing. Each
+ * name also carries a dense code, stored in front of its bytes, that
+ * `name_code()` reads without hashing; per-person counters are arrays indexed
+ * by it.
+ *
+ * Names are never removed; `name_table_destroy()` releases them all at exit.
+ * The table is not locked: it is used from the main thread only (the parallel
+ * text parser hands its records over before they are created).
+ */
+
+// Function Prototypes
+const char* name_intern(const char *name);
+uint32_t name_code(const char *name);
+const char* name_from_code(uint32_t code);
+uint32_t name_count(void);
+void name_table_destroy(void);
+
+#endif //NAME_TABLE_H
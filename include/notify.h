@@ -0,0 +1,38 @@
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Non-blocking notifications shown on the bottom line of the screen.
+ *
+ * `notify()` queues a message and returns at once. While the UI is running the
+ * oldest queued message is shown on a one-line status window and dismissed
+ * after a few seconds (sooner when others are waiting); input loops call
+ * `notify_update()` before reading a key and use its result as their read
+ * timeout so messages disappear on time without a key press. The queue is
+ * bounded: when it is full the oldest waiting message is dropped and counted.
+ *
+ * Without a running UI (before `notify_start()`, after `notify_stop()`, or in
+ * batch mode) messages go straight to stderr.
+ *
+ * Questions that need an answer are not notifications; see `confirm_popup()`.
+ */
+
+#define NOTIFY_QUEUE_SIZE 8
+#define NOTIFY_MESSAGE_SIZE 128
+
+typedef enum
+{
+    NOTIFY_INFO,
+    NOTIFY_WARNING,
+    NOTIFY_ERROR,
+} NotifyLevel;
+
+// Function Prototypes
+void notify_start(void);
+void notify_stop(void);
+void notify(NotifyLevel level, const char *format, ...);
+int notify_update(void);
+
+#endif //NOTIFY_H
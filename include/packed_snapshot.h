@@ -0,0 +1,60 @@
+#ifndef PACKED_SNAPSHOT_H
+#define PACKED_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "snapshot.h"
+
+/**
+ * On-disk layout of a packed (compressed) snapshot, `.mbz` (host byte order):
+ *
+ *   PackedHeader
+ *   block[block_count]          (each a zlib stream, see below)
+ *   PackedBlock[block_count]    (the block index, at `index_offset`)
+ *
+ * Every block holds up to `block_records` consecutive movies and inflates on
+ * its own, so one record is read by inflating one block. Inflated, a block is
+ *
+ *   int32_t years[n]
+ *   float ratings[n]
+ *   n titles:     varint shared prefix with the previous title, varint suffix length, suffix
+ *   n directors:  varint 0, varint length, name   for a name new to the block
+ *                 varint k                        for the block's k-th distinct name
+ *
+ * and is decoded into the layout of a plain snapshot with block-local string
+ * offsets: SnapshotRecord[n] followed by the strings, `decoded_size` bytes.
+ */
+
+#define PACKED_MAGIC "MMRZ"
+#define PACKED_VERSION 1
+#define PACKED_BLOCK_RECORDS 1024     // Movies per block
+#define PACKED_MAX_THREADS 16         // Threads inflating blocks at most when loading
+
+typedef struct
+{
+    char magic[4];          // PACKED_MAGIC
+    uint32_t version;       // PACKED_VERSION
+    uint32_t record_count;
+    uint32_t block_records; // Movies per block, the last one may hold fewer
+    uint32_t block_count;
+    uint32_t reserved;
+    uint64_t generation;
+    uint64_t index_offset;  // Where the PackedBlock array starts
+} PackedHeader;
+
+typedef struct
+{
+    uint64_t offset;            // Of the zlib stream in the file
+    uint32_t compressed_size;
+    uint32_t encoded_size;      // Inflated size
+    uint32_t decoded_size;      // Size as records and strings, see above
+    uint32_t records;
+} PackedBlock;
+
+// Function Prototypes
+SnapshotError save_packed_snapshot(const char *filename, const MovieCatalog *catalog, uint64_t generation);
+SnapshotError load_packed_snapshot(const char *filename, MovieCatalog *catalog, uint64_t *generation);
+SnapshotError read_packed_index(int fd, PackedHeader *header, PackedBlock **blocks);
+SnapshotError decode_packed_block(const PackedBlock *block, const void *compressed, char *decoded);
+
+#endif //PACKED_SNAPSHOT_H
@@ -0,0 +1,93 @@
+#ifndef PAGED_CATALOG_H
+#define PAGED_CATALOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "snapshot.h"
+#include "packed_snapshot.h"
+
+#define PAGED_PAGE_SIZE 65536                      // Bytes read from the file at a time
+#define PAGED_MIN_PAGES 4                          // A record and its two strings fit, whatever the budget
+#define PAGED_DEFAULT_BUDGET ((size_t)64 << 20)    // Bytes of cached pages when none is given
+#define PAGED_TEXT_SIZE 256                        // Longest title or director copied out, with terminator
+
+// One record copied out of the file, with room for its strings
+typedef struct
+{
+    Movie movie;                     // `title` and `director` point into the buffers below
+    char title[PAGED_TEXT_SIZE];
+    char director[PAGED_TEXT_SIZE];
+} PagedMovie;
+
+// A cached page of the file
+typedef struct
+{
+    uint64_t number;     // Offset / PAGED_PAGE_SIZE, or the block number of a packed file
+    char *data;
+    size_t length;       // Bytes held: up to PAGED_PAGE_SIZE, or the decoded size of a block
+    int newer, older;    // Neighbours in the recency list, -1 at the ends
+    int hash_next;       // Next page in the same bucket, -1 at the end
+    bool loaded;
+} PagedPage;
+
+/**
+ * @brief A catalog snapshot (snapshot.h) read in place, without loading it.
+ *
+ * Records and strings are read from the file through a cache of fixed-size
+ * pages. Its size is set when the file is opened, and the least recently used
+ * page is evicted to make room, so memory stays the same whether the file holds
+ * a thousand movies or a hundred million. Only the records a caller asks for are
+ * copied out, into PagedMovie buffers the caller owns.
+ *
+ * Packed snapshots (packed_snapshot.h) are read the same way, except that a
+ * page is one block, inflated and decoded when it is loaded, and the budget is
+ * counted in the largest decoded block.
+ *
+ * The view is read-only and ignores the journal: it shows the catalog as of the
+ * snapshot.
+ */
+typedef struct
+{
+    int fd;
+    SnapshotHeader header;     // Only `record_count` and `generation` are set for a packed file
+    uint64_t records_offset;   // Where the SnapshotRecord array starts
+    uint64_t strings_offset;   // Where the string table starts
+    uint64_t file_size;
+    PackedBlock *blocks;       // Block index of a packed file, NULL for a plain snapshot
+    uint32_t block_count;
+    uint32_t block_records;
+    char *compressed;          // Room for the largest compressed block of a packed file
+    size_t page_bytes;         // Size of every page buffer
+
+    PagedPage *pages;
+    int page_count;            // Pages the budget allows, loaded or not
+    int *buckets;              // Page number hash -> first page, -1 for none
+    int bucket_mask;
+    int newest, oldest;        // Ends of the recency list of loaded pages
+    int free_page;             // Next never-loaded page, page_count once all were used
+
+    uint64_t hits;
+    uint64_t misses;
+} PagedCatalog;
+
+// Error codes
+typedef enum
+{
+    PAGED_SUCCESS,
+    PAGED_ERROR_IO,
+    PAGED_ERROR_FORMAT,
+    PAGED_ERROR_MEMORY_ALLOCATION,
+    PAGED_ERROR_OUT_OF_RANGE,
+} PagedError;
+
+// Function Prototypes
+PagedError paged_catalog_open(PagedCatalog *paged, const char *filename, size_t budget);
+int paged_catalog_count(const PagedCatalog *paged);
+PagedError paged_catalog_read(PagedCatalog *paged, int index, PagedMovie *out);
+int paged_catalog_find(PagedCatalog *paged, int start, const char *query);
+size_t paged_catalog_resident(const PagedCatalog *paged);
+size_t paged_catalog_budget(const PagedCatalog *paged);
+void paged_catalog_close(PagedCatalog *paged);
+
+#endif //PAGED_CATALOG_H
@@ -0,0 +1,87 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Hot-path counters, latency histograms and allocation tallies.
+ *
+ * Built in only when the project is configured with -DENABLE_PERF=ON, which
+ * defines MOVIE_PERF. A timed section is bracketed by PERF_BEGIN() and
+ * PERF_END(); each span adds one to the event's count, its duration to a
+ * log2 latency histogram, and the allocations made while it ran to the
+ * event's tallies. A span left on an error path is simply not counted.
+ * Without MOVIE_PERF the macros expand to nothing and the functions below are
+ * empty inlines, so instrumented code costs nothing.
+ *
+ * The numbers are shown by the overlay of the movie list ('p') and written
+ * to a JSON file on exit with `perf_dump()`.
+ */
+
+// Instrumented operations
+typedef enum
+{
+    PERF_LOAD,    // Text or snapshot load
+    PERF_SAVE,    // Text or snapshot save
+    PERF_CREATE,
+    PERF_UPDATE,  // Edits and ratings
+    PERF_DELETE,
+    PERF_SEARCH,  // Title lookups and filter steps
+    PERF_SORT,
+    PERF_FRAME,   // One render of the movie list
+    PERF_EVENT_COUNT,
+} PerfEvent;
+
+#define PERF_BUCKETS 32 // Bucket b counts spans of 2^b to 2^(b+1) - 1 ns, the last one everything longer
+
+// Totals of one event since the start of the program
+typedef struct
+{
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t allocations;   // Made during the spans, by any thread
+    uint64_t bytes;         // Requested by those allocations
+    uint64_t buckets[PERF_BUCKETS];
+} PerfStats;
+
+#ifdef MOVIE_PERF
+
+#define PERF_ENABLED 1
+
+// Start of a timed section, see PERF_BEGIN()
+typedef struct
+{
+    uint64_t start_ns;
+    uint64_t allocations;
+    uint64_t bytes;
+} PerfSpan;
+
+#define PERF_BEGIN(span) PerfSpan span = perf_span_begin()
+#define PERF_END(span, event) perf_span_end((event), &span)
+
+// Function Prototypes
+PerfSpan perf_span_begin(void);
+void perf_span_end(PerfEvent event, const PerfSpan *span);
+void perf_snapshot(PerfEvent event, PerfStats *out);
+uint64_t perf_percentile(const PerfStats *stats, double fraction);
+const char* perf_event_name(PerfEvent event);
+bool perf_alloc_totals(uint64_t *allocations, uint64_t *bytes);
+bool perf_dump(const char *filename);
+
+#else
+
+#define PERF_ENABLED 0
+#define PERF_BEGIN(span) ((void)0)
+#define PERF_END(span, event) ((void)0)
+
+static inline bool perf_dump(const char *filename)
+{
+    (void)filename;
+    return true;
+}
+
+#endif
+
+#endif //PERF_H
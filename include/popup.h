@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <stdarg.h>
+#include <stdbool.h>
 
 /**
  * @brief Displays a popup with the given title and formatted message.
@@ -20,6 +21,16 @@ extern "C" {
  */
 void show_popup(const char* title, const char* format, ...);
 
+/**
+ * @brief Asks a yes/no question in a popup and waits for the answer.
+ *
+ * @param title The title of the popup.
+ * @param format The format string for the question (printf-style).
+ * @param ... The arguments that fit the format string.
+ * @return true if the user pressed 'y', false for 'n' or Esc.
+ */
+bool confirm_popup(const char* title, const char* format, ...);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,79 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "movie.h"
+#include "autosave.h"
+
+/**
+ * On-disk layout of one user's ratings, `ratings-<name>.bin` (host byte order):
+ *
+ *   ProfileHeader
+ *   uint64_t keys[rated]     (see `profile_movie_key()`)
+ *   uint8_t ratings[rated]   (tenths, 1 to 50)
+ *
+ * Only the ratings a user has given are stored. The movies themselves stay in
+ * the shared catalog; a rating is tied to its movie by title and year, which
+ * survive the renumbering of catalog ids.
+ */
+
+#define PROFILE_MAGIC "MMRU"
+#define PROFILE_VERSION 1
+#define PROFILE_NAME_SIZE 32          // Longest user name plus terminator
+#define PROFILE_RATING_SCALE 10       // Ratings are stored in tenths
+#define PROFILE_FILE_FORMAT "ratings-%s.bin"
+
+typedef struct
+{
+    char magic[4];     // PROFILE_MAGIC
+    uint32_t version;  // PROFILE_VERSION
+    uint32_t rated;
+    uint32_t reserved;
+} ProfileHeader;
+
+/**
+ * @brief The ratings of the active user, as a sparse overlay on the shared catalog.
+ *
+ * An open-addressing hash table from movie key to rating. Clearing a rating
+ * leaves its key with a rating of 0, which is dropped when the table grows or
+ * is saved. With no user active (`name` empty) the table is empty and the
+ * catalog's own ratings apply.
+ */
+typedef struct
+{
+    char name[PROFILE_NAME_SIZE];
+    uint64_t *keys;      // 0 marks a free slot
+    uint8_t *ratings;    // Tenths; 0 for a cleared rating
+    uint32_t capacity;   // Power of two, or 0 before the first rating
+    uint32_t used;       // Slots holding a key
+    uint32_t rated;      // Keys with a rating above 0
+    bool dirty;          // Changed since it was loaded or captured
+} Profile;
+
+// Error codes
+typedef enum
+{
+    PROFILE_SUCCESS,
+    PROFILE_ERROR_NAME,               // Empty, too long, or not letters, digits, '-' and '_'
+    PROFILE_ERROR_IO,
+    PROFILE_ERROR_FORMAT,
+    PROFILE_ERROR_MEMORY_ALLOCATION,
+    PROFILE_ERROR_OUT_OF_RANGE,       // Rating outside 0 to 5
+} ProfileError;
+
+// Function Prototypes
+void profile_init(Profile *profile);
+ProfileError profile_open(Profile *profile, const char *name);
+void profile_close(Profile *profile);
+bool profile_active(const Profile *profile);
+uint64_t profile_movie_key(const Movie *movie);
+float profile_rating_key(const Profile *profile, uint64_t key);
+float profile_rating(const Profile *profile, const Movie *movie);
+ProfileError profile_rate_key(Profile *profile, uint64_t key, float rating);
+ProfileError profile_rate(Profile *profile, const Movie *movie, float rating);
+bool save_profile_in_background(Profile *profile, Autosave *autosave);
+void profile_wait_saved(const char *name, Autosave *autosave);
+
+#endif //PROFILE_H
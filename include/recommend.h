@@ -0,0 +1,77 @@
+#ifndef RECOMMEND_H
+#define RECOMMEND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "movie.h"
+#include "profile.h"
+
+#define RECOMMEND_K 10                 // Neighbours kept per movie
+#define RECOMMEND_DIRECTOR_WINDOW 8    // Same-director movies closest in rating looked at on each side
+#define RECOMMEND_MAX_USER_ITEMS 500   // Users who rated more still count in similarities but do not propose candidates
+#define RECOMMEND_MIN_CORATERS 2       // Users who must have rated both movies for their ratings to count
+#define RECOMMEND_SHRINK 2.0f          // Damps similarities resting on few co-raters
+#define RECOMMEND_DIRECTOR_WEIGHT 0.3f // Added for a shared director, scaled by how close the ratings are
+#define RECOMMEND_MAX_USERS 64
+
+typedef struct
+{
+    int32_t item;   // Movie id, -1 for an empty entry
+    float score;
+} RecommendNeighbor;
+
+// One rater: the catalog's shared ratings (index 0) or a user profile
+typedef struct
+{
+    char name[PROFILE_NAME_SIZE]; // Empty for the shared ratings
+    Profile ratings;              // The user's ratings; unused for the shared ratings
+    int *items;                   // Ids the user has rated
+    int item_count;
+    int item_capacity;
+    double rating_sum;
+    int rated;
+} RecommendUser;
+
+/**
+ * @brief Precomputed item-item neighbourhoods for "recommend me something".
+ *
+ * For every movie the RECOMMEND_K most similar other movies are kept, best
+ * first. Similarity is the mean-centred cosine of the ratings given by users
+ * who rated both movies, damped when there are few of them, plus a bonus for a
+ * shared director that grows as the catalog ratings of the two get closer.
+ * Candidates come from the same-director movies nearest in rating and from the
+ * other movies rated by each user who rated this one, so no step compares all
+ * pairs of movies.
+ *
+ * The table is built on the first query. A rating change then recomputes the
+ * movie's own neighbours and updates its entry in the lists of the movies it is
+ * compared with, in time proportional to its candidates. Adding, removing,
+ * editing or renumbering movies marks the table stale instead, and the next
+ * query rebuilds it.
+ */
+typedef struct RecommendIndex
+{
+    bool built;
+    bool stale;
+    int item_count;                 // Catalog slots as of the build
+    Movie **movies;                 // By id as of the build, NULL for holes
+    uint64_t *keys;                 // profile_movie_key() of each movie
+    float *shared;                  // Catalog ratings by id
+    RecommendNeighbor *neighbors;   // RECOMMEND_K per id, best first
+    int *director_order;            // Live ids grouped by director, by rating within a group
+    int *order_position;            // Position of each id in director_order
+    int *seen;                      // Per id: the stamp of the last pass that visited it
+    int stamp;
+    RecommendUser users[RECOMMEND_MAX_USERS];
+    int user_count;
+} RecommendIndex;
+
+// Function Prototypes
+void recommend_init(RecommendIndex *index);
+void recommend_invalidate(RecommendIndex *index);
+bool recommend_ready(const RecommendIndex *index);
+void recommend_rating_changed(RecommendIndex *index, const Profile *profile, const Movie *movie, float rating);
+int recommend_movies(RecommendIndex *index, MovieCatalog *catalog, const Profile *profile, Movie **movies, float *scores, int max);
+void recommend_destroy(RecommendIndex *index);
+
+#endif //RECOMMEND_H
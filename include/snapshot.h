@@ -0,0 +1,55 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "catalog.h"
+
+/**
+ * On-disk layout of a catalog snapshot (host byte order):
+ *
+ *   SnapshotHeader
+ *   SnapshotRecord[record_count]
+ *   string table (string_table_size bytes of NUL-terminated strings)
+ *
+ * Record string offsets are relative to the start of the string table. The
+ * file is loaded with a single read and the movies point straight into it.
+ */
+
+#define SNAPSHOT_MAGIC "MMRS"
+#define SNAPSHOT_VERSION 2
+
+typedef struct
+{
+    char magic[4];              // SNAPSHOT_MAGIC
+    uint32_t version;           // SNAPSHOT_VERSION
+    uint32_t record_count;
+    uint32_t record_size;       // sizeof(SnapshotRecord), guards against layout changes
+    uint64_t string_table_size;
+    uint64_t generation;        // Bumped on every save, names the journal that applies on top
+} SnapshotHeader;
+
+typedef struct
+{
+    int32_t year;
+    float rating;
+    uint32_t title_offset;
+    uint32_t director_offset;
+} SnapshotRecord;
+
+// Error codes
+typedef enum
+{
+    SNAPSHOT_SUCCESS,
+    SNAPSHOT_ERROR_IO,            // File missing, unreadable or unwritable
+    SNAPSHOT_ERROR_FORMAT,        // Bad magic, version or inconsistent sizes
+    SNAPSHOT_ERROR_MEMORY_ALLOCATION,
+} SnapshotError;
+
+// Function Prototypes
+SnapshotError save_snapshot(const char *filename, const MovieCatalog *catalog, uint64_t generation);
+SnapshotError capture_snapshot(const MovieCatalog *catalog, uint64_t generation, char **data, size_t *size);
+SnapshotError load_snapshot(const char *filename, MovieCatalog *catalog, uint64_t *generation);
+bool snapshot_peek_generation(const char *filename, uint64_t *generation);
+
+#endif //SNAPSHOT_H
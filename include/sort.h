@@ -0,0 +1,35 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Describes one sort key of a record by member offset and type.
+ *
+ * A key list such as { year, rating descending, title } sorts by year, breaks
+ * ties by rating and then by title. Strings compare ASCII case-insensitively.
+ * The same description works for any record type, which lets Movie and
+ * TV_Series share the sorting code.
+ */
+typedef enum
+{
+    SORT_FIELD_STRING, // char * member
+    SORT_FIELD_INT,    // int member
+    SORT_FIELD_FLOAT,  // float member
+} SortFieldType;
+
+typedef struct
+{
+    SortFieldType type;
+    size_t offset;     // offsetof(Record, member)
+    bool descending;
+} SortField;
+
+#define SORT_MAX_FIELDS 4
+
+// Function Prototypes
+bool sort_records(void **records, size_t count, const SortField *fields, int field_count);
+int sort_compare_records(const void *a, const void *b, const SortField *fields, int field_count);
+
+#endif //SORT_H
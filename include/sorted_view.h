@@ -0,0 +1,50 @@
+#ifndef SORTED_VIEW_H
+#define SORTED_VIEW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "arena.h"
+#include "sort.h"
+
+/**
+ * @brief A maintained ordering of records: an indexable skip list.
+ *
+ * Records are kept sorted on a SortField key list (see sort.h), with the record
+ * address as the final tie-breaker so every record has exact position. Each
+ * link stores how many records it skips, which makes insert, remove, lookup by
+ * rank and rank of a record all O(log N). Paging from any rank is a lookup
+ * followed by a walk along the bottom level.
+ *
+ * A record must be removed before any of its key members change and inserted
+ * again afterwards. Nodes come from one slab per tower height.
+ */
+
+#define SORTED_VIEW_MAX_LEVEL 16 // Branching factor 4, plenty for 2^32 records
+
+typedef struct SortedViewNode SortedViewNode;
+
+typedef struct
+{
+    SortedViewNode *head;       // Sentinel with SORTED_VIEW_MAX_LEVEL links
+    int level;                  // Levels currently in use
+    size_t count;
+    uint32_t seed;              // State of the tower height generator
+    bool built;                 // False until sorted_view_build() succeeds
+    SortField fields[SORT_MAX_FIELDS];
+    int field_count;
+    Slab pools[SORTED_VIEW_MAX_LEVEL]; // pools[h - 1] holds nodes of height h
+} SortedView;
+
+// Function Prototypes
+bool sorted_view_init(SortedView *view, const SortField *fields, int field_count);
+void sorted_view_clear(SortedView *view);
+void sorted_view_destroy(SortedView *view);
+bool sorted_view_build(SortedView *view, void *const *records, size_t count);
+bool sorted_view_insert(SortedView *view, void *record);
+bool sorted_view_remove(SortedView *view, void *record);
+void* sorted_view_at(const SortedView *view, size_t rank);
+size_t sorted_view_rank(const SortedView *view, const void *record);
+size_t sorted_view_page(const SortedView *view, size_t start, void **out, size_t max);
+
+#endif //SORTED_VIEW_H
@@ -0,0 +1,78 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "catalog.h"
+#include "tv_catalog.h"
+#include "journal.h"
+#include "autosave.h"
+
+#define TEXT_MAX_FIELDS 8
+#define STORE_AUTOSAVE_SECONDS 60 // A journal with entries is folded into a snapshot at most this often
+
+/**
+ * @brief How one record type is stored as lines of '|'-separated fields.
+ *
+ * `load_text_records()` splits each line at its first `field_count - 1` '|'
+ * (any further ones stay in the last field) and NUL-terminates the fields in
+ * place. `parse` turns them into a `parsed_size`-byte record; it runs on the
+ * parser threads, so it must only read its arguments. `reserve` and `add` then
+ * run on the calling thread, once and in file order respectively. `write`
+ * prints a record as one line for `save_text_records()`.
+ */
+typedef struct
+{
+    const char *noun;       // What the records are called in messages, e.g. "movies"
+    int field_count;        // At most TEXT_MAX_FIELDS
+    size_t parsed_size;
+    bool (*parse)(char **fields, int field_count, void *parsed); // false for a malformed line
+    bool (*reserve)(void *target, int count);
+    bool (*add)(void *target, void *parsed);                     // false if the target refused the record
+    void (*write)(FILE *file, const void *record);
+} TextFormat;
+
+/**
+ * @brief The set of files that persist one catalog.
+ *
+ * The snapshot holds the catalog as of its generation, the journal holds every
+ * edit made since, and the text file is a human-readable export of the snapshot.
+ * While a background compaction is being written, the journal of the previous
+ * generation is kept as the retired journal.
+ */
+typedef struct
+{
+    const char *text_filename;
+    const char *snapshot_filename;
+    const char *journal_filename;
+    char retired_filename[1024]; // `<journal_filename>.prev`
+    uint64_t generation;         // Generation of the snapshot on disk, or being written
+    Journal journal;
+    time_t compacted_at;         // When the last snapshot was captured
+    bool background_failed;      // A background compaction failed; the journal keeps growing instead
+} CatalogStore;
+
+// Function Prototypes
+bool save_text_records(const char *filename, const TextFormat *format, const Collection *collection);
+bool load_text_records(const char *filename, const TextFormat *format, StringArena *arena, void *target);
+void save_movies_to_file(const char *filename, const MovieCatalog *catalog);
+void load_movies_from_file(const char *filename, MovieCatalog *catalog);
+bool save_series_to_file(const char *filename, TvCatalog *catalog);
+bool save_series_in_background(const char *filename, TvCatalog *catalog, Autosave *autosave);
+void load_series_from_file(const char *filename, TvCatalog *catalog);
+void storage_set_parse_threads(int threads);
+int storage_parse_threads(void);
+bool load_catalog(const char *text_filename, const char *snapshot_filename, MovieCatalog *catalog, uint64_t *generation,
+                  bool journaled);
+bool save_catalog(const char *text_filename, const char *snapshot_filename, const MovieCatalog *catalog, uint64_t generation);
+int read_whole_file(const char *filename, char **buffer, size_t *size);
+
+void store_init(CatalogStore *store, const char *text_filename, const char *snapshot_filename, const char *journal_filename);
+void store_open(CatalogStore *store, MovieCatalog *catalog);
+bool store_compact(CatalogStore *store, MovieCatalog *catalog);
+void store_maintain(CatalogStore *store, MovieCatalog *catalog, Autosave *autosave);
+void store_close(CatalogStore *store, MovieCatalog *catalog);
+
+#endif //STORAGE_H
@@ -0,0 +1,37 @@
+#ifndef STRING_INTERN_H
+#define STRING_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Maps distinct strings to small dense codes.
+ *
+ * The first time a string is interned it gets the next code (0, 1, 2, ...);
+ * interning an equal string again returns the same code. A column of codes can
+ * then be grouped and compared as integers. The table keeps a pointer to the
+ * first instance of each string and does not copy it, so the strings must
+ * outlive the table (the catalog's arena strings do). Matching is exact.
+ */
+
+#define STRING_INTERN_NONE UINT32_MAX
+
+typedef struct
+{
+    uint32_t *slots;       // code + 1, 0 marks an empty slot
+    size_t capacity;       // Power of two
+    const char **names;    // Indexed by code
+    uint32_t *hashes;      // Indexed by code
+    uint32_t count;
+    uint32_t names_capacity;
+} StringIntern;
+
+// Function Prototypes
+void string_intern_init(StringIntern *table);
+void string_intern_destroy(StringIntern *table);
+uint32_t string_intern(StringIntern *table, const char *text);
+uint32_t string_intern_find(const StringIntern *table, const char *text);
+const char* string_intern_name(const StringIntern *table, uint32_t code);
+
+#endif //STRING_INTERN_H
@@ -0,0 +1,44 @@
+#ifndef TITLE_INDEX_H
+#define TITLE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Open-addressing hash index from normalized title to record.
+ *
+ * Records are stored by pointer together with the hash of their title. The
+ * title itself is read from the record through `title_offset`, the offset of
+ * its `char *title` member, so the same index serves Movie and TV_Series.
+ *
+ * Titles are normalized while hashing and comparing: ASCII case is folded,
+ * leading and trailing whitespace is ignored and inner whitespace runs count
+ * as a single space. No lowered copy is ever allocated.
+ */
+typedef struct
+{
+    uint32_t hash;  // 0 marks an empty slot
+    void *record;
+} TitleIndexSlot;
+
+typedef struct
+{
+    TitleIndexSlot *slots;
+    size_t capacity;     // Power of two
+    size_t count;
+    size_t title_offset; // offsetof(Record, title)
+} TitleIndex;
+
+// Function Prototypes
+bool title_index_init(TitleIndex *index, size_t title_offset);
+void title_index_destroy(TitleIndex *index);
+bool title_index_reserve(TitleIndex *index, size_t count);
+bool title_index_insert(TitleIndex *index, void *record);
+bool title_index_remove(TitleIndex *index, void *record);
+void* title_index_find(const TitleIndex *index, const char *title);
+void* title_index_find_next(const TitleIndex *index, const char *title, const void *previous);
+uint32_t title_hash(const char *title);
+bool title_equals(const char *a, const char *b);
+
+#endif //TITLE_INDEX_H
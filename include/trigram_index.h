@@ -0,0 +1,49 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Inverted index from case-folded 3-byte substrings to record ids.
+ *
+ * Every trigram of an indexed string gets the record id appended to its posting
+ * list. A substring query of three or more bytes can only match records that
+ * appear in the posting list of each of its trigrams, so the shortest of those
+ * lists is a complete candidate set that is usually far smaller than the whole
+ * collection. Candidates must still be verified against the real text.
+ *
+ * Posting lists are append-only. When a record changes or goes away its old
+ * entries stay behind as stale candidates (verification discards them); the
+ * owner rebuilds the index once `trigram_index_needs_rebuild()` says the stale
+ * entries outnumber the live ones. Lists are unsorted and may repeat an id.
+ */
+typedef struct
+{
+    uint32_t key;    // Folded trigram bytes, 0 marks an empty slot
+    int count;
+    int capacity;
+    int *ids;
+} TrigramPosting;
+
+typedef struct
+{
+    TrigramPosting *table;
+    size_t capacity;   // Power of two
+    size_t used;       // Distinct trigrams
+    size_t entries;    // Total ids across all posting lists
+    size_t stale;      // Entries known to be out of date
+    bool built;        // False until the owner has filled the index
+} TrigramIndex;
+
+// Function Prototypes
+void trigram_index_init(TrigramIndex *index);
+void trigram_index_clear(TrigramIndex *index);
+void trigram_index_destroy(TrigramIndex *index);
+bool trigram_index_add(TrigramIndex *index, int id, const char *text);
+void trigram_index_forget(TrigramIndex *index, const char *text);
+bool trigram_index_needs_rebuild(const TrigramIndex *index);
+bool trigram_index_candidates(const TrigramIndex *index, const char *query, const int **ids, int *count);
+
+#endif //TRIGRAM_INDEX_H
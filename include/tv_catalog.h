@@ -0,0 +1,64 @@
+#ifndef TV_CATALOG_H
+#define TV_CATALOG_H
+
+#include <stdbool.h>
+#include "tv_series.h"
+#include "collection.h"
+
+/**
+ * @brief The TV series collection.
+ *
+ * Series are held in a Collection (collection.h), the same engine behind the
+ * movie catalog, so they get stable ids with O(1) insert and delete, an O(1)
+ * title lookup and sorted views maintained in O(log N) per change.
+ *
+ * Series are created on their own with `create_tv_series()` and handed over
+ * with `tv_catalog_add()`; from then on each knows its catalog, so
+ * `update_tv_series()` re-indexes it and `delete_tv_series()` takes it out
+ * before freeing it. The catalog keeps the season and episode totals current
+ * on every change and notes that it has unsaved changes in `dirty`.
+ */
+
+// Maintained orderings of the series, indexes into the collection's orders
+typedef enum
+{
+    TV_VIEW_ID,       // Slot order, the order the series are saved in
+    TV_VIEW_TITLE,    // Title, then creator
+    TV_VIEW_CREATOR,  // Creator, then title
+    TV_VIEW_SEASONS,  // Most seasons first, then title
+    TV_VIEW_EPISODES, // Most episodes first, then title
+    TV_VIEW_RATING,   // Best mean episode rating first, then title
+    TV_VIEW_COUNT,
+} TvView;
+
+// Running totals over the series of a catalog
+typedef struct
+{
+    int series;
+    long seasons;
+    long episodes;
+    long rated_episodes;
+    long rating_sum;  // Tenths of a point over the rated episodes
+} TV_SeriesTotals;
+
+struct TvCatalog
+{
+    Collection series;       // Slots indexed by series id, with the title index and sorted views
+    TV_SeriesTotals totals;  // Kept current by the hooks
+    bool dirty;              // Changed since it was last loaded or saved
+};
+
+// Function Prototypes
+TV_SeriesError tv_catalog_init(TvCatalog *catalog, int capacity);
+void tv_catalog_destroy(TvCatalog *catalog);
+TV_SeriesError tv_catalog_reserve(TvCatalog *catalog, int extra);
+TV_SeriesError tv_catalog_add(TvCatalog *catalog, TV_Series *series);
+void tv_catalog_unlink(TvCatalog *catalog, TV_Series *series);
+void tv_catalog_link(TvCatalog *catalog, TV_Series *series);
+void tv_catalog_remove(TvCatalog *catalog, TV_Series *series);
+TV_Series* tv_catalog_get(const TvCatalog *catalog, int id);
+TV_Series* tv_catalog_find(const TvCatalog *catalog, const char *title);
+SortedView* tv_catalog_view(TvCatalog *catalog, TvView view);
+TV_SeriesTotals tv_catalog_totals(const TvCatalog *catalog);
+
+#endif //TV_CATALOG_H
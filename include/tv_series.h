@@ -2,14 +2,42 @@
 #define TV_SERIES_H
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "title_index.h"
 
+#define TV_RATING_SCALE 10 // Episode ratings are stored in tenths of a point
+
+// Owner of a set of TV_Series, see tv_catalog.h
+typedef struct TvCatalog TvCatalog;
+
+// Number of rated episodes and the sum of their ratings, in tenths of a point
+typedef struct
+{
+    uint32_t rated;
+    uint32_t rating_sum;
+} TV_RatingTotals;
+
+/*
+ * Episode ratings live in one block per series, allocated with it: the first
+ * episode of every season, the cached totals of every season, then one byte
+ * per episode. Season s (0-based) covers episode_ratings[season_starts[s]] up
+ * to episode_ratings[season_starts[s + 1]], so a show with thousands of
+ * episodes costs one byte each and a season average is read, not computed.
+ */
 typedef struct 
 {
     char *title;
-    char *creator;
+    const char *creator; // Shared copy from name_intern(), see name_table.h
     int seasons; // Total number of seasons
     int episodes; // Total number of episodes
-    // The rating and reviews are assumed to be handled externally
+    int id;             // Slot in the owning catalog, -1 until added to one
+    TvCatalog *catalog; // The catalog holding the series, NULL until added to one
+    uint32_t *season_starts;        // seasons + 1 offsets into episode_ratings
+    TV_RatingTotals *season_totals; // One per season, kept current by rate_tv_episode()
+    uint8_t *episode_ratings;       // One per episode in tenths of a point, 0 when unrated
+    TV_RatingTotals rating_totals;  // Over every episode of the series
+    float rating;                   // Mean episode rating, 0 when none is rated
 } TV_Series;
 
 // Error codes similar to MovieError
@@ -18,12 +46,38 @@ typedef enum
     TV_SERIES_SUCCESS,
     TV_SERIES_ERROR_NULL_POINTER,
     TV_SERIES_ERROR_MEMORY_ALLOCATION,
+    TV_SERIES_ERROR_OUT_OF_RANGE, // No such season or episode, or a rating outside 0 to 5
 } TV_SeriesError;
 
+// Sort keys, see sort_tv_series()
+typedef enum
+{
+    TV_SERIES_SORT_TITLE,
+    TV_SERIES_SORT_CREATOR,
+    TV_SERIES_SORT_SEASONS,
+    TV_SERIES_SORT_EPISODES,
+    TV_SERIES_SORT_RATING,
+} TV_SeriesSortField;
+
+typedef struct
+{
+    TV_SeriesSortField field;
+    bool descending;
+} TV_SeriesSortKey;
+
 // Function Prototypes
 TV_Series* create_tv_series(const char *title, const char *creator, int seasons, int episodes);
 TV_SeriesError update_tv_series(TV_Series *series, const char *new_title, const char *new_creator, int new_seasons, int new_episodes);
 void display_tv_series(const TV_Series *series);
-void delete_tv_series(TV_Series *series); // Just deletes the TV series, reviews are handled separately
+void delete_tv_series(TV_Series *series); // Removes it from its catalog and frees it, reviews are handled separately
+TV_Series* search_tv_series(const TitleIndex *index, const char *title); // Index built with offsetof(TV_Series, title)
+TV_SeriesError sort_tv_series(TV_Series *series[], int count, const TV_SeriesSortKey keys[], int key_count);
+
+TV_SeriesError set_tv_series_seasons(TV_Series *series, const int episodes_per_season[], int seasons);
+TV_SeriesError rate_tv_episode(TV_Series *series, int season, int episode, float rating);
+int tv_season_episodes(const TV_Series *series, int season);
+float tv_episode_rating(const TV_Series *series, int season, int episode);
+float tv_season_average(const TV_Series *series, int season);
+TV_RatingTotals tv_season_totals(const TV_Series *series, int season);
 
 #endif //TV_SERIES_H
@@ -3,7 +3,11 @@
 
 #include <ncurses.h>
 #include "movie.h"
+#include "catalog.h"
 #include "tv_series.h"
+#include "tv_catalog.h"
+#include "profile.h"
+#include "paged_catalog.h"
 
 // Menu options enumeration
 typedef enum 
@@ -12,10 +16,22 @@ typedef enum
     MENU_MOVIE_DISPLAY,
     MENU_TV_SERIES_ADD,
     MENU_TV_SERIES_DISPLAY,
+    MENU_STATS,
+    MENU_SWITCH_USER,
     MENU_EXIT,
     // Add more menu options as necessary
 } MenuOption;
 
+// Color pairs, set up once by init_ui()
+typedef enum
+{
+    UI_PAIR_MENU = 1,       // Menu entries
+    UI_PAIR_MENU_SELECTED,  // Highlighted menu entry
+    UI_PAIR_ROW,            // List rows
+    UI_PAIR_ACCENT,
+    UI_PAIR_HEADER,         // List column headers
+} UiColorPair;
+
 // Function Prototypes
 void init_ui(); // Initialize the UI environment
 void end_ui();  // Clean up and close the UI
@@ -30,9 +46,14 @@ void display_tv_series_list(const TV_Series *series, int count); // Display a li
 void print_to_left(WINDOW *win, int starty, const char *string, chtype color);
 
 // Add missing function prototypes
-void display_movie_list_ui(Movie** movies, int count);
+void display_movie_list_ui(MovieCatalog *catalog, Profile *profile);
+void display_paged_movie_list_ui(PagedCatalog *paged, const char *filename);
+void display_stats_ui(MovieCatalog *catalog, const TvCatalog *series);
+void add_tv_series_ui(TvCatalog *catalog);
+void read_user_name_ui(const char *current, char *name, int size);
+void display_tv_series_list_ui(TvCatalog *catalog);
 void ui_print_error(const char* format, ...);
-void edit_movie_ui(Movie** movies, int count);
+bool edit_movie_ui(MovieCatalog *catalog, Profile *profile, Movie **movies, int count);
 
 
 
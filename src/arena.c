@@ -0,0 +1,256 @@
+/**
+ * @file arena.c
+ * @brief Bulk allocators used by the catalog for records and their strings.
+ *
+ * The string arena hands out memory by bumping a pointer through large blocks, so
+ * allocating a title costs a few instructions instead of a malloc call. The slab
+ * does the same for fixed-size records and keeps released records on a free-list
+ * for reuse. Neither allocator returns memory to the system until it is destroyed,
+ * which turns teardown of a whole catalog into a handful of free() calls.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "arena.h"
+
+struct ArenaBlock
+{
+    ArenaBlock *next;  // Older block
+    size_t used;       // Bytes handed out from data
+    size_t size;       // Payload capacity, 0 for adopted buffers
+    void *adopted;     // External buffer owned by this block, or NULL
+    char data[];
+};
+
+struct SlabBlock
+{
+    SlabBlock *next;
+    max_align_t align; // Forces the objects that follow to be suitably aligned
+};
+
+#define SLAB_OBJECTS(block) ((char*)((block) + 1))
+
+
+/**
+ * @brief Prepares an empty string arena.
+ *
+ * @param arena The arena to initialize.
+ * @param block_size Payload size of each block. Strings larger than this get a block of their own.
+ */
+
+void string_arena_init(StringArena *arena, size_t block_size)
+{
+    arena->head = NULL;
+    arena->block_size = block_size;
+}
+
+
+/**
+ * @brief Allocates `size` bytes from the arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param size Number of bytes needed.
+ * @return Pointer to the bytes, or NULL if a new block could not be allocated.
+ */
+
+char* string_arena_alloc(StringArena *arena, size_t size)
+{
+    ArenaBlock *head = arena->head;
+    if (!head || head->size - head->used < size)
+    {
+        size_t payload = size > arena->block_size ? size : arena->block_size;
+        ArenaBlock *block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + payload);
+        if (!block)
+        {
+            return NULL;
+        }
+        block->used = 0;
+        block->size = payload;
+        block->adopted = NULL;
+
+        if (head && payload == size)
+        {
+            // Oversized string: keep filling the current block afterwards
+            block->next = head->next;
+            head->next = block;
+        }
+        else
+        {
+            block->next = head;
+            arena->head = block;
+        }
+        head = block;
+    }
+
+    char *p = head->data + head->used;
+    head->used += size;
+    return p;
+}
+
+
+/**
+ * @brief Copies a NUL-terminated string into the arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param string The string to copy.
+ * @return The arena-owned copy, or NULL if allocation failed.
+ */
+
+char* string_arena_strdup(StringArena *arena, const char *string)
+{
+    size_t len = strlen(string) + 1;
+    char *copy = string_arena_alloc(arena, len);
+    if (copy)
+    {
+        memcpy(copy, string, len);
+    }
+    return copy;
+}
+
+
+/**
+ * @brief Transfers ownership of a malloc'd buffer to the arena.
+ *
+ * The buffer is freed together with the arena. Strings inside it can then be
+ * referenced exactly like strings allocated from the arena.
+ *
+ * @param arena The arena taking ownership.
+ * @param buffer A buffer obtained from malloc.
+ * @return 0 on success, -1 if the bookkeeping block could not be allocated
+ *         (the buffer is left with the caller).
+ */
+
+int string_arena_adopt(StringArena *arena, void *buffer)
+{
+    ArenaBlock *block = (ArenaBlock*)malloc(sizeof(ArenaBlock));
+    if (!block)
+    {
+        return -1;
+    }
+    block->used = 0;
+    block->size = 0;
+    block->adopted = buffer;
+
+    // Insert behind the head so the block being filled stays in front
+    if (arena->head)
+    {
+        block->next = arena->head->next;
+        arena->head->next = block;
+    }
+    else
+    {
+        block->next = NULL;
+        arena->head = block;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Releases every block and adopted buffer of the arena.
+ *
+ * @param arena The arena to destroy. It is left empty and can be reused.
+ */
+
+void string_arena_destroy(StringArena *arena)
+{
+    ArenaBlock *block = arena->head;
+    while (block)
+    {
+        ArenaBlock *next = block->next;
+        free(block->adopted);
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+}
+
+
+/**
+ * @brief Prepares an empty slab.
+ *
+ * @param slab The slab to initialize.
+ * @param object_size Size of each object.
+ * @param objects_per_block Number of objects allocated together.
+ */
+
+void slab_init(Slab *slab, size_t object_size, size_t objects_per_block)
+{
+    size_t align = _Alignof(max_align_t);
+    if (object_size < sizeof(void*)) object_size = sizeof(void*);
+    slab->object_size = (object_size + align - 1) / align * align;
+    slab->objects_per_block = objects_per_block ? objects_per_block : 1;
+    slab->blocks = NULL;
+    slab->free_list = NULL;
+    slab->used_in_head = slab->objects_per_block;
+}
+
+
+/**
+ * @brief Allocates one object, reusing a released one if available.
+ *
+ * @param slab The slab to allocate from.
+ * @return Pointer to uninitialized storage, or NULL if a new block could not be allocated.
+ */
+
+void* slab_alloc(Slab *slab)
+{
+    if (slab->free_list)
+    {
+        void *object = slab->free_list;
+        slab->free_list = *(void**)object;
+        return object;
+    }
+
+    if (slab->used_in_head == slab->objects_per_block)
+    {
+        SlabBlock *block = (SlabBlock*)malloc(sizeof(SlabBlock) + slab->object_size * slab->objects_per_block);
+        if (!block)
+        {
+            return NULL;
+        }
+        block->next = slab->blocks;
+        slab->blocks = block;
+        slab->used_in_head = 0;
+    }
+
+    return SLAB_OBJECTS(slab->blocks) + slab->object_size * slab->used_in_head++;
+}
+
+
+/**
+ * @brief Returns an object to the slab's free-list.
+ *
+ * @param slab The slab the object was allocated from.
+ * @param object The object to release. NULL is ignored.
+ */
+
+void slab_free(Slab *slab, void *object)
+{
+    if (!object) return;
+    *(void**)object = slab->free_list;
+    slab->free_list = object;
+}
+
+
+/**
+ * @brief Releases every block of the slab at once.
+ *
+ * @param slab The slab to destroy. Objects allocated from it become invalid.
+ */
+
+void slab_destroy(Slab *slab)
+{
+    SlabBlock *block = slab->blocks;
+    while (block)
+    {
+        SlabBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    slab->blocks = NULL;
+    slab->free_list = NULL;
+    slab->used_in_head = slab->objects_per_block;
+}
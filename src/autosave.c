@@ -0,0 +1,379 @@
+/**
+ * @file autosave.c
+ * @brief Background worker that writes captured files off the UI thread.
+ *
+ * The UI thread never waits on the disk for a save: it copies what needs
+ * saving into memory (see `store_maintain()` and `save_series_in_background()`
+ * in storage.c) and hands the copy to this worker. Each file is written to a
+ * temporary name, flushed to stable storage and renamed over the old one, so a
+ * crash at any point leaves either the previous or the new version in place.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "autosave.h"
+
+
+/**
+ * @brief Writes a whole buffer to a new file and flushes it.
+ *
+ * @param filename The file to create or truncate.
+ * @param data The bytes to write.
+ * @param size Number of bytes.
+ * @return true if every byte reached the disk.
+ */
+
+static bool write_file(const char *filename, const char *data, size_t size)
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    bool ok = true;
+    while (ok && size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written <= 0)
+        {
+            ok = false;
+            break;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    if (ok && fsync(fd) != 0) ok = false;
+    if (close(fd) != 0) ok = false;
+    return ok;
+}
+
+
+/**
+ * @brief Writes every file of a job to its temporary name, then renames them all into place.
+ *
+ * @param job The job; `ok` receives the outcome.
+ */
+
+static void run_job(AutosaveJob *job)
+{
+    char tmp_names[AUTOSAVE_MAX_FILES][1024];
+    int written = 0;
+
+    job->ok = true;
+    for (; written < job->file_count; ++written)
+    {
+        snprintf(tmp_names[written], sizeof(tmp_names[written]), "%s.tmp", job->filenames[written]);
+        if (!write_file(tmp_names[written], job->data[written], job->sizes[written]))
+        {
+            job->ok = false;
+            remove(tmp_names[written]);
+            break;
+        }
+    }
+
+    for (int i = 0; i < written; ++i)
+    {
+        if (!job->ok || rename(tmp_names[i], job->filenames[i]) != 0)
+        {
+            job->ok = false;
+            remove(tmp_names[i]);
+        }
+    }
+
+    if (job->ok && job->retired_filename)
+    {
+        remove(job->retired_filename);
+    }
+}
+
+
+static void* autosave_worker(void *argument)
+{
+    Autosave *autosave = argument;
+
+    pthread_mutex_lock(&autosave->lock);
+    for (;;)
+    {
+        while (!autosave->pending && !autosave->stopping)
+        {
+            pthread_cond_wait(&autosave->wake, &autosave->lock);
+        }
+        AutosaveJob *job = autosave->pending;
+        if (!job) break; // Stopping with nothing left to write
+
+        autosave->pending = job->next;
+        if (!autosave->pending) autosave->pending_tail = NULL;
+        autosave->running = job;
+        pthread_mutex_unlock(&autosave->lock);
+
+        run_job(job);
+
+        pthread_mutex_lock(&autosave->lock);
+        autosave->running = NULL;
+        job->next = autosave->finished;
+        autosave->finished = job;
+        pthread_cond_broadcast(&autosave->written);
+    }
+    pthread_mutex_unlock(&autosave->lock);
+    return NULL;
+}
+
+
+/**
+ * @brief Starts the worker thread.
+ *
+ * If the thread cannot be created the worker still works, writing each job
+ * on the calling thread as it is submitted.
+ *
+ * @param autosave The worker to start.
+ */
+
+void autosave_start(Autosave *autosave)
+{
+    pthread_mutex_init(&autosave->lock, NULL);
+    pthread_cond_init(&autosave->wake, NULL);
+    pthread_cond_init(&autosave->written, NULL);
+    autosave->pending = NULL;
+    autosave->running = NULL;
+    autosave->pending_tail = NULL;
+    autosave->finished = NULL;
+    autosave->outstanding = 0;
+    autosave->stopping = false;
+    autosave->started = pthread_create(&autosave->thread, NULL, autosave_worker, autosave) == 0;
+    if (!autosave->started)
+    {
+        fprintf(stderr, "Could not start the autosave thread, saving in the foreground\n");
+    }
+}
+
+
+/**
+ * @brief Creates an empty job.
+ *
+ * @param done Called from `autosave_poll()` with the outcome, or NULL.
+ * @param context Passed to `done`.
+ * @return The job, or NULL if memory allocation fails.
+ */
+
+AutosaveJob* autosave_job_create(AutosaveDoneFn done, void *context)
+{
+    AutosaveJob *job = calloc(1, sizeof(*job));
+    if (!job) return NULL;
+    job->done = done;
+    job->context = context;
+    return job;
+}
+
+
+/**
+ * @brief Adds a file to a job.
+ *
+ * @param job The job.
+ * @param filename Where the data belongs; copied.
+ * @param data The complete file contents, allocated with malloc. The job takes
+ *             ownership even when the call fails.
+ * @param size Number of bytes.
+ * @return false if the job is full or memory allocation fails.
+ */
+
+bool autosave_job_add_file(AutosaveJob *job, const char *filename, char *data, size_t size)
+{
+    char *name = job->file_count < AUTOSAVE_MAX_FILES ? strdup(filename) : NULL;
+    if (!name)
+    {
+        free(data);
+        return false;
+    }
+    job->filenames[job->file_count] = name;
+    job->data[job->file_count] = data;
+    job->sizes[job->file_count] = size;
+    job->file_count++;
+    return true;
+}
+
+
+/**
+ * @brief Names a file to remove once all of the job's files are in place.
+ *
+ * @param job The job.
+ * @param filename The file, typically one the new files make obsolete; copied.
+ * @return false if memory allocation fails.
+ */
+
+bool autosave_job_retire(AutosaveJob *job, const char *filename)
+{
+    free(job->retired_filename);
+    job->retired_filename = strdup(filename);
+    return job->retired_filename != NULL;
+}
+
+
+/**
+ * @brief Releases a job and the data it holds.
+ *
+ * @param job The job, or NULL.
+ */
+
+void autosave_job_destroy(AutosaveJob *job)
+{
+    if (!job) return;
+    for (int i = 0; i < job->file_count; ++i)
+    {
+        free(job->filenames[i]);
+        free(job->data[i]);
+    }
+    free(job->retired_filename);
+    free(job);
+}
+
+
+/**
+ * @brief Queues a job for the worker; jobs are written in submission order.
+ *
+ * @param autosave A started worker.
+ * @param job The job, owned by the worker from now on.
+ */
+
+void autosave_submit(Autosave *autosave, AutosaveJob *job)
+{
+    job->next = NULL;
+    if (!autosave->started)
+    {
+        run_job(job);
+        job->next = autosave->finished;
+        autosave->finished = job;
+        autosave->outstanding++;
+        return;
+    }
+
+    pthread_mutex_lock(&autosave->lock);
+    if (autosave->pending_tail) autosave->pending_tail->next = job;
+    else autosave->pending = job;
+    autosave->pending_tail = job;
+    autosave->outstanding++;
+    pthread_cond_signal(&autosave->wake);
+    pthread_mutex_unlock(&autosave->lock);
+}
+
+
+/**
+ * @brief Tells whether every submitted job has been written and polled.
+ *
+ * @param autosave A started worker.
+ * @return true if nothing is queued, being written or waiting for `autosave_poll()`.
+ */
+
+bool autosave_idle(Autosave *autosave)
+{
+    pthread_mutex_lock(&autosave->lock);
+    bool idle = autosave->outstanding == 0;
+    pthread_mutex_unlock(&autosave->lock);
+    return idle;
+}
+
+
+static bool job_writes(const AutosaveJob *job, const char *filename)
+{
+    for (int i = 0; job && i < job->file_count; ++i)
+    {
+        if (strcmp(job->filenames[i], filename) == 0) return true;
+    }
+    return false;
+}
+
+
+/**
+ * @brief Waits until no queued or running job is still to write `filename`.
+ *
+ * Call it before reading a file that may have been submitted for saving, or
+ * the read could see the previous version, which the job then overwrites.
+ * Jobs for other files are not waited for, nor are callbacks run.
+ *
+ * @param autosave A started worker.
+ * @param filename The file, as passed to `autosave_job_add_file()`.
+ */
+
+void autosave_wait_for_file(Autosave *autosave, const char *filename)
+{
+    if (!autosave->started) return; // Every job was written when it was submitted
+
+    pthread_mutex_lock(&autosave->lock);
+    for (;;)
+    {
+        bool queued = job_writes(autosave->running, filename);
+        for (const AutosaveJob *job = autosave->pending; job && !queued; job = job->next)
+        {
+            queued = job_writes(job, filename);
+        }
+        if (!queued) break;
+        pthread_cond_wait(&autosave->written, &autosave->lock);
+    }
+    pthread_mutex_unlock(&autosave->lock);
+}
+
+
+/**
+ * @brief Runs the callbacks of the jobs finished so far and releases them.
+ *
+ * Only call this from the thread that submits the jobs.
+ *
+ * @param autosave A started worker.
+ */
+
+void autosave_poll(Autosave *autosave)
+{
+    pthread_mutex_lock(&autosave->lock);
+    AutosaveJob *finished = autosave->finished;
+    autosave->finished = NULL;
+    pthread_mutex_unlock(&autosave->lock);
+
+    // The list is newest first; report in submission order
+    AutosaveJob *ordered = NULL;
+    while (finished)
+    {
+        AutosaveJob *next = finished->next;
+        finished->next = ordered;
+        ordered = finished;
+        finished = next;
+    }
+
+    int count = 0;
+    for (AutosaveJob *job = ordered; job; )
+    {
+        AutosaveJob *next = job->next;
+        if (job->done) job->done(job->context, job->ok);
+        autosave_job_destroy(job);
+        job = next;
+        count++;
+    }
+
+    pthread_mutex_lock(&autosave->lock);
+    autosave->outstanding -= count;
+    pthread_mutex_unlock(&autosave->lock);
+}
+
+
+/**
+ * @brief Writes every queued job, stops the worker and runs the remaining callbacks.
+ *
+ * @param autosave A started worker.
+ */
+
+void autosave_stop(Autosave *autosave)
+{
+    if (autosave->started)
+    {
+        pthread_mutex_lock(&autosave->lock);
+        autosave->stopping = true;
+        pthread_cond_signal(&autosave->wake);
+        pthread_mutex_unlock(&autosave->lock);
+        pthread_join(autosave->thread, NULL);
+        autosave->started = false;
+    }
+    autosave_poll(autosave);
+    pthread_cond_destroy(&autosave->wake);
+    pthread_cond_destroy(&autosave->written);
+    pthread_mutex_destroy(&autosave->lock);
+}
@@ -0,0 +1,445 @@
+/**
+ * @file batch.c
+ * @brief Headless bulk import, editing and export.
+ *
+ * Batch mode opens the collection through the regular CatalogStore, detaches
+ * the journal so edits are not written one entry at a time, runs the options
+ * in order and then persists everything once with `store_compact()`, which
+ * writes the snapshot and text export and starts the journal over. Nothing
+ * here touches curses; messages go to stderr through `notify()`.
+ *
+ * Script commands, one per line (blank lines and lines starting with '#' are
+ * skipped):
+ *
+ *   add title|director|year[|rating]
+ *   rate title|rating
+ *   delete title
+ *   import file
+ *   export file
+ *   select min_year max_year min_rating   (prints matching movies to stdout)
+ *   decades                               (prints count and average rating per decade)
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "batch.h"
+#include "movie.h"
+#include "snapshot.h"
+#include "packed_snapshot.h"
+#include "dump_import.h"
+#include "notify.h"
+
+#define SCRIPT_MAX_FIELDS 4
+#define SCRIPT_MAX_DECADES 512
+
+
+/**
+ * @brief Prints the command line help.
+ */
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [--threads N] [--import FILE] [--script FILE|-] [--export FILE] [--dry-run]\n"
+            "  --threads N    parse text imports with N threads (1: single-threaded, 0: one per CPU)\n"
+            "  --import FILE  add the movies of FILE (a .bin snapshot, a compressed .mbz snapshot,\n"
+            "                 a .csv or .tsv dump, gzipped or not, or title|director|year|rating lines)\n"
+            "  --script FILE  run the commands in FILE, '-' reads them from stdin:\n"
+            "                   add title|director|year[|rating]\n"
+            "                   rate title|rating\n"
+            "                   delete title\n"
+            "                   import FILE / export FILE\n"
+            "                   select MIN_YEAR MAX_YEAR MIN_RATING / decades\n"
+            "  --export FILE  write the collection to FILE (.bin: snapshot, .mbz: compressed snapshot,\n"
+            "                 otherwise text)\n"
+            "  --dry-run      do not save the changes to the collection\n"
+            "Or: %s --paged [FILE [CACHE_MB]] to browse a snapshot, .bin or .mbz (default movies.bin), read-only\n"
+            "  without loading it, caching at most CACHE_MB megabytes of it (default 64).\n"
+            "Options run in the order given. Without options the interactive program starts.\n",
+            program, program);
+}
+
+
+static bool has_extension(const char *filename, const char *extension)
+{
+    size_t length = strlen(filename);
+    size_t ext_length = strlen(extension);
+    return length > ext_length && strcmp(filename + length - ext_length, extension) == 0;
+}
+
+
+/**
+ * @brief Appends the movies of a snapshot, a CSV/TSV dump or a text file to the catalog.
+ *
+ * @return true if the file could be read; malformed text lines are reported and skipped.
+ */
+
+static bool import_file(MovieCatalog *catalog, const char *filename)
+{
+    int before = catalog->movies.count;
+
+    if (has_extension(filename, ".bin") || has_extension(filename, ".mbz"))
+    {
+        uint64_t generation;
+        SnapshotError err = has_extension(filename, ".mbz") ? load_packed_snapshot(filename, catalog, &generation)
+                                                           : load_snapshot(filename, catalog, &generation);
+        if (err != SNAPSHOT_SUCCESS)
+        {
+            notify(NOTIFY_ERROR, "Could not import %s (snapshot error %d).", filename, err);
+            return false;
+        }
+    }
+    else if (dump_import_supported(filename))
+    {
+        DumpImportStats stats;
+        DumpImportError err = import_dump(filename, catalog, &stats);
+        if (err != DUMP_IMPORT_SUCCESS)
+        {
+            notify(NOTIFY_ERROR, "Could not import %s (dump error %d).", filename, err);
+            return false;
+        }
+        notify(NOTIFY_INFO, "Imported %d movies from %s (%d duplicates, %d invalid, %d not movies).",
+               stats.added, filename, stats.duplicates, stats.invalid, stats.skipped);
+        return true;
+    }
+    else
+    {
+        FILE *file = fopen(filename, "r");
+        if (!file)
+        {
+            notify(NOTIFY_ERROR, "Could not open %s for reading.", filename);
+            return false;
+        }
+        fclose(file);
+        load_movies_from_file(filename, catalog);
+    }
+
+    notify(NOTIFY_INFO, "Imported %d movies from %s.", catalog->movies.count - before, filename);
+    return true;
+}
+
+
+/**
+ * @brief Writes the catalog to a snapshot (.bin), a packed snapshot (.mbz) or a text file.
+ */
+
+static bool export_file(const MovieCatalog *catalog, const char *filename)
+{
+    if (has_extension(filename, ".bin") || has_extension(filename, ".mbz"))
+    {
+        SnapshotError err = has_extension(filename, ".mbz") ? save_packed_snapshot(filename, catalog, 0)
+                                                           : save_snapshot(filename, catalog, 0);
+        if (err != SNAPSHOT_SUCCESS)
+        {
+            notify(NOTIFY_ERROR, "Could not export %s (snapshot error %d).", filename, err);
+            return false;
+        }
+    }
+    else
+    {
+        FILE *file = fopen(filename, "a");
+        if (!file)
+        {
+            notify(NOTIFY_ERROR, "Could not open %s for writing.", filename);
+            return false;
+        }
+        fclose(file);
+        save_movies_to_file(filename, catalog);
+    }
+
+    notify(NOTIFY_INFO, "Exported %d movies to %s.", catalog->movies.count, filename);
+    return true;
+}
+
+
+/**
+ * @brief Splits a line on '|' in place.
+ *
+ * @return Number of fields, at most `max`; the last field keeps any further separators.
+ */
+
+static int split_fields(char *line, char **fields, int max)
+{
+    int count = 0;
+    fields[count++] = line;
+    while (count < max)
+    {
+        char *sep = strchr(fields[count - 1], '|');
+        if (!sep) break;
+        *sep = '\0';
+        fields[count++] = sep + 1;
+    }
+    return count;
+}
+
+
+static bool parse_rating(const char *text, float *rating)
+{
+    char *end;
+    float value = strtof(text, &end);
+    if (end == text || *end != '\0' || value < 0.0f || value > 5.0f) return false;
+    *rating = value;
+    return true;
+}
+
+
+/**
+ * @brief Runs one script command.
+ *
+ * @param catalog The catalog to edit.
+ * @param line The command line, modified in place.
+ * @param changed Set when the collection was modified.
+ * @return true on success; failures are reported through notify().
+ */
+
+static bool run_command(MovieCatalog *catalog, char *line, bool *changed)
+{
+    char *argument = strchr(line, ' ');
+    if (argument) *argument++ = '\0';
+    else argument = line + strlen(line);
+
+    char *fields[SCRIPT_MAX_FIELDS];
+
+    if (strcmp(line, "add") == 0)
+    {
+        int n = split_fields(argument, fields, SCRIPT_MAX_FIELDS);
+        time_t now = time(NULL);
+        int current_year = localtime(&now)->tm_year + 1900;
+        char *end;
+        long year = n >= 3 ? strtol(fields[2], &end, 10) : 0;
+        float rating = 0.0f;
+
+        if (n < 3 || fields[0][0] == '\0' || fields[1][0] == '\0' || *end != '\0' || year <= 1800 || year > current_year)
+        {
+            notify(NOTIFY_ERROR, "add expects title|director|year[|rating] with a year after 1800.");
+            return false;
+        }
+        if (n == 4 && !parse_rating(fields[3], &rating))
+        {
+            notify(NOTIFY_ERROR, "Invalid rating '%s' for %s.", fields[3], fields[0]);
+            return false;
+        }
+
+        Movie *movie = create_movie(catalog, fields[0], fields[1], (int)year);
+        if (!movie) return false;
+        if (rating > 0.0f) set_movie_rating(catalog, movie, rating);
+        *changed = true;
+        return true;
+    }
+    if (strcmp(line, "rate") == 0)
+    {
+        float rating;
+        if (split_fields(argument, fields, 2) != 2 || !parse_rating(fields[1], &rating))
+        {
+            notify(NOTIFY_ERROR, "rate expects title|rating with a rating from 0 to 5.");
+            return false;
+        }
+        Movie *movie = search_movie(catalog, fields[0]);
+        if (!movie)
+        {
+            notify(NOTIFY_ERROR, "No movie titled '%s'.", fields[0]);
+            return false;
+        }
+        set_movie_rating(catalog, movie, rating);
+        *changed = true;
+        return true;
+    }
+    if (strcmp(line, "delete") == 0)
+    {
+        Movie *movie = search_movie(catalog, argument);
+        if (!movie)
+        {
+            notify(NOTIFY_ERROR, "No movie titled '%s'.", argument);
+            return false;
+        }
+        remove_movie(catalog, movie->id);
+        *changed = true;
+        return true;
+    }
+    if (strcmp(line, "import") == 0)
+    {
+        bool ok = import_file(catalog, argument);
+        *changed = *changed || ok;
+        return ok;
+    }
+    if (strcmp(line, "export") == 0)
+    {
+        return export_file(catalog, argument);
+    }
+    if (strcmp(line, "select") == 0)
+    {
+        int min_year, max_year;
+        float min_rating;
+        if (sscanf(argument, "%d %d %f", &min_year, &max_year, &min_rating) != 3)
+        {
+            notify(NOTIFY_ERROR, "select expects min_year max_year min_rating.");
+            return false;
+        }
+        int *ids = (int*)malloc((size_t)(catalog->movies.slot_count > 0 ? catalog->movies.slot_count : 1) * sizeof(int));
+        if (!ids) return false;
+        int count = movie_columns_select(&catalog->columns, catalog->movies.slot_count, min_year, max_year, min_rating, ids);
+        for (int i = 0; i < count; ++i)
+        {
+            const Movie *movie = catalog_get(catalog, ids[i]);
+            printf("%s|%s|%d|%.1f\n", movie->title, movie->director, movie->year, movie->rating);
+        }
+        free(ids);
+        return true;
+    }
+    if (strcmp(line, "decades") == 0)
+    {
+        DecadeSummary decades[SCRIPT_MAX_DECADES];
+        int count = movie_columns_decades(&catalog->columns, catalog->movies.slot_count, decades, SCRIPT_MAX_DECADES);
+        if (count < 0) return false;
+        for (int i = 0; i < count; ++i)
+        {
+            printf("%ds|%d|%d|%.2f\n", decades[i].decade, decades[i].count, decades[i].rated, decades[i].average);
+        }
+        return true;
+    }
+
+    notify(NOTIFY_ERROR, "Unknown command '%s'.", line);
+    return false;
+}
+
+
+/**
+ * @brief Runs every command of a script.
+ *
+ * @param catalog The catalog to edit.
+ * @param filename The script, or "-" for stdin.
+ * @param changed Set when the collection was modified.
+ * @return Number of commands that failed, or -1 if the script could not be opened.
+ */
+
+static int run_script(MovieCatalog *catalog, const char *filename, bool *changed)
+{
+    FILE *file = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "r");
+    if (!file)
+    {
+        notify(NOTIFY_ERROR, "Could not open script %s.", filename);
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    int line_number = 0;
+    int failures = 0;
+
+    while ((length = getline(&line, &capacity, file)) != -1)
+    {
+        line_number++;
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) line[--length] = '\0';
+        if (length == 0 || line[0] == '#') continue;
+
+        if (!run_command(catalog, line, changed))
+        {
+            notify(NOTIFY_ERROR, "%s:%d: command failed.", filename, line_number);
+            failures++;
+        }
+    }
+
+    free(line);
+    if (file != stdin) fclose(file);
+    return failures;
+}
+
+
+/**
+ * @brief Runs the command line options without starting the UI.
+ *
+ * The collection is loaded from `store` and the journal is detached, so
+ * imports and script edits only touch memory. When everything has run and
+ * something changed, the collection is saved once: a new snapshot and text
+ * export are written and the journal is emptied.
+ *
+ * @param store The collection's store, initialized but not opened.
+ * @param catalog An empty catalog.
+ * @param argc Argument count from main().
+ * @param argv Arguments from main().
+ * @return The process exit status: 0 if every option succeeded, 1 otherwise, 2 for bad usage.
+ */
+
+int run_batch(CatalogStore *store, MovieCatalog *catalog, int argc, char *argv[])
+{
+    bool dry_run = false;
+
+    // Validate the whole command line before loading anything
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (strcmp(argv[i], "--dry-run") == 0)
+        {
+            dry_run = true;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            char *end;
+            long threads = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || threads < 0)
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+            storage_set_parse_threads((int)threads); // Applies to the initial load as well
+        }
+        else if ((strcmp(argv[i], "--import") == 0 || strcmp(argv[i], "--export") == 0 ||
+                  strcmp(argv[i], "--script") == 0) && i + 1 < argc)
+        {
+            ++i;
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    store_open(store, catalog);
+    catalog->journal = NULL; // Saved in one go at the end instead
+
+    bool changed = false;
+    int failures = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *option = argv[i];
+        if (strcmp(option, "--dry-run") == 0) continue;
+
+        const char *value = argv[++i];
+        if (strcmp(option, "--threads") == 0)
+        {
+            continue; // Applied while validating
+        }
+        if (strcmp(option, "--import") == 0)
+        {
+            if (import_file(catalog, value)) changed = true;
+            else failures++;
+        }
+        else if (strcmp(option, "--export") == 0)
+        {
+            if (!export_file(catalog, value)) failures++;
+        }
+        else
+        {
+            int failed = run_script(catalog, value, &changed);
+            failures += failed < 0 ? 1 : failed;
+        }
+    }
+
+    if (changed && !dry_run && !store_compact(store, catalog))
+    {
+        notify(NOTIFY_ERROR, "Could not save the collection to %s.", store->snapshot_filename);
+        failures++;
+    }
+    store_close(store, catalog);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,461 @@
+/**
+ * @file catalog.c
+ * @brief Ownership of the movie collection.
+ *
+ * The catalog is a Collection of Movie records (collection.c) plus the indexes
+ * that only movies have. Records are created, edited and deleted through the
+ * functions in movie.c, which take the catalog so they can route their
+ * allocations here and journal their changes.
+ *
+ * Every index over the records (the title hash and sorted views kept by the
+ * collection, the trigram index, the columns and the statistics) is kept
+ * current from the hooks in this file: `catalog_append()` for new records,
+ * `catalog_unlink()` before a record is removed or its keys change, and
+ * `catalog_link()` once the new keys are in place.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "catalog.h"
+#include "recommend.h"
+
+static const CollectionOrder movie_orders[MOVIE_VIEW_COUNT] =
+{
+    [MOVIE_VIEW_ID]       = { { { SORT_FIELD_INT, offsetof(Movie, id), false } }, 1 },
+    [MOVIE_VIEW_TITLE]    = { { { SORT_FIELD_STRING, offsetof(Movie, title), false }, { SORT_FIELD_INT, offsetof(Movie, year), false } }, 2 },
+    [MOVIE_VIEW_YEAR]     = { { { SORT_FIELD_INT, offsetof(Movie, year), false }, { SORT_FIELD_STRING, offsetof(Movie, title), false } }, 2 },
+    [MOVIE_VIEW_RATING]   = { { { SORT_FIELD_FLOAT, offsetof(Movie, rating), true }, { SORT_FIELD_STRING, offsetof(Movie, title), false } }, 2 },
+    [MOVIE_VIEW_DIRECTOR] = { { { SORT_FIELD_STRING, offsetof(Movie, director), false }, { SORT_FIELD_INT, offsetof(Movie, year), false } }, 2 },
+};
+
+static const CollectionType movie_type =
+{
+    sizeof(Movie), offsetof(Movie, id), offsetof(Movie, title), movie_orders, MOVIE_VIEW_COUNT, NULL
+};
+
+
+/**
+ * @brief Initializes an empty catalog.
+ *
+ * @param catalog The catalog to initialize.
+ * @param capacity Initial capacity of the movie array.
+ * @return MOVIE_SUCCESS, or MOVIE_ERROR_MEMORY_ALLOCATION if the array could not be allocated.
+ */
+
+MovieError catalog_init(MovieCatalog *catalog, int capacity)
+{
+    if (!catalog) return MOVIE_ERROR_NULL_POINTER;
+    if (capacity < 1) capacity = 1;
+
+    if (!collection_init(&catalog->movies, &movie_type, capacity))
+    {
+        return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
+    if (!movie_columns_init(&catalog->columns, capacity))
+    {
+        movie_columns_destroy(&catalog->columns);
+        collection_destroy(&catalog->movies);
+        return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
+    if (!catalog_stats_init(&catalog->stats))
+    {
+        catalog_stats_destroy(&catalog->stats);
+        movie_columns_destroy(&catalog->columns);
+        collection_destroy(&catalog->movies);
+        return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
+    catalog->journal = NULL;
+    catalog->recommend = NULL;
+    catalog->history = NULL;
+    trigram_index_init(&catalog->text_index);
+
+    return MOVIE_SUCCESS;
+}
+
+
+/**
+ * @brief Makes sure the catalog has room for `extra` more movies.
+ *
+ * Grows the collection's slots and title index (see `collection_reserve()`) and
+ * the columns alongside them, so bulk loads resize everything only once.
+ *
+ * @param catalog The catalog to grow.
+ * @param extra Number of entries about to be appended.
+ * @return MOVIE_SUCCESS, or MOVIE_ERROR_MEMORY_ALLOCATION if the array could not be grown
+ *         (the catalog is left unchanged).
+ */
+
+MovieError catalog_reserve(MovieCatalog *catalog, int extra)
+{
+    if (!catalog) return MOVIE_ERROR_NULL_POINTER;
+    if (!collection_reserve(&catalog->movies, extra) ||
+        !movie_columns_reserve(&catalog->columns, catalog->movies.capacity))
+    {
+        return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
+    return MOVIE_SUCCESS;
+}
+
+
+/**
+ * @brief Adds a movie's title and director to the trigram index, if it is built.
+ *
+ * An index that runs out of memory clears itself and is rebuilt on its next use.
+ */
+
+static void index_text(MovieCatalog *catalog, const Movie *movie)
+{
+    if (!catalog->text_index.built) return;
+    if (trigram_index_add(&catalog->text_index, movie->id, movie->title))
+    {
+        trigram_index_add(&catalog->text_index, movie->id, movie->director);
+    }
+}
+
+
+/**
+ * @brief Counts the column values of slot `id` in the statistics, or takes them back.
+ */
+
+static void count_slot(MovieCatalog *catalog, int id, bool add)
+{
+    const MovieColumns *columns = &catalog->columns;
+    if (add)
+    {
+        catalog_stats_add(&catalog->stats, columns->years[id], columns->ratings[id], columns->directors[id]);
+    }
+    else
+    {
+        catalog_stats_remove(&catalog->stats, columns->years[id], columns->ratings[id], columns->directors[id]);
+    }
+}
+
+
+/**
+ * @brief Adds a movie to the catalog, assigns its id and indexes it.
+ *
+ * The slot is chosen by `collection_append()`, deterministically, so replaying
+ * the journal on top of the snapshot hands out the same ids as the original
+ * session. Built sorted views receive the movie as well. A view that cannot take
+ * it is dropped and rebuilt on its next use.
+ *
+ * @param catalog The catalog to append to.
+ * @param movie A movie allocated from this catalog.
+ * @return MOVIE_SUCCESS, or MOVIE_ERROR_MEMORY_ALLOCATION if the array or index could not be grown.
+ */
+
+MovieError catalog_append(MovieCatalog *catalog, Movie *movie)
+{
+    MovieError err = catalog_reserve(catalog, 1);
+    if (err != MOVIE_SUCCESS)
+    {
+        return err;
+    }
+    if (!collection_append(&catalog->movies, movie))
+    {
+        return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
+
+    movie_columns_set(&catalog->columns, movie->id, movie);
+    count_slot(catalog, movie->id, true);
+    index_text(catalog, movie);
+    recommend_invalidate(catalog->recommend);
+    return MOVIE_SUCCESS;
+}
+
+
+/**
+ * @brief Drops a movie from the catalog's indexes before it is removed or re-keyed.
+ *
+ * @param catalog The catalog holding the movie.
+ * @param movie The movie, still carrying the title, year and rating it was indexed under.
+ */
+
+void catalog_unlink(MovieCatalog *catalog, Movie *movie)
+{
+    collection_unlink(&catalog->movies, movie);
+    count_slot(catalog, movie->id, false); // The columns still hold the old values
+    if (catalog->text_index.built)
+    {
+        trigram_index_forget(&catalog->text_index, movie->title);
+        trigram_index_forget(&catalog->text_index, movie->director);
+    }
+}
+
+
+/**
+ * @brief Puts a movie unlinked with `catalog_unlink()` back into the indexes under its new keys.
+ *
+ * @param catalog The catalog holding the movie.
+ * @param movie The re-keyed movie.
+ */
+
+void catalog_link(MovieCatalog *catalog, Movie *movie)
+{
+    collection_link(&catalog->movies, movie);
+    movie_columns_set(&catalog->columns, movie->id, movie);
+    count_slot(catalog, movie->id, true);
+    index_text(catalog, movie);
+    if (trigram_index_needs_rebuild(&catalog->text_index))
+    {
+        trigram_index_clear(&catalog->text_index);
+    }
+}
+
+
+/**
+ * @brief `catalog_unlink()` for the movies of a bulk edit, with each index updated once per batch.
+ *
+ * The sorted views follow `collection_unlink_batch()`. The trigram index and the
+ * running totals are treated the same way: a batch of at least
+ * 1/COLLECTION_REBUILD_FRACTION of the catalog clears the index and marks the
+ * totals stale, and both are recomputed in one pass when next read, instead of
+ * being taken apart and put back together movie by movie.
+ *
+ * @param catalog The catalog holding the movies.
+ * @param movies The movies, each at most once, still carrying their old values.
+ * @param count Number of movies.
+ */
+
+void catalog_unlink_batch(MovieCatalog *catalog, Movie *const *movies, int count)
+{
+    collection_unlink_batch(&catalog->movies, (void *const*)movies, count);
+
+    bool large = (size_t)count * COLLECTION_REBUILD_FRACTION >= (size_t)catalog->movies.count;
+    if (large)
+    {
+        trigram_index_clear(&catalog->text_index); // Rebuilt by catalog_text_index()
+        catalog->stats.valid = false;              // Recomputed by catalog_statistics()
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        count_slot(catalog, movies[i]->id, false);
+        if (catalog->text_index.built)
+        {
+            trigram_index_forget(&catalog->text_index, movies[i]->title);
+            trigram_index_forget(&catalog->text_index, movies[i]->director);
+        }
+    }
+}
+
+
+/**
+ * @brief Puts movies unlinked with `catalog_unlink_batch()` back under their new values.
+ *
+ * @param catalog The catalog holding the movies.
+ * @param movies The re-keyed movies.
+ * @param count Number of movies.
+ */
+
+void catalog_link_batch(MovieCatalog *catalog, Movie *const *movies, int count)
+{
+    collection_link_batch(&catalog->movies, (void *const*)movies, count);
+    for (int i = 0; i < count; ++i)
+    {
+        movie_columns_set(&catalog->columns, movies[i]->id, movies[i]);
+        count_slot(catalog, movies[i]->id, true);
+        index_text(catalog, movies[i]);
+    }
+    if (trigram_index_needs_rebuild(&catalog->text_index))
+    {
+        trigram_index_clear(&catalog->text_index);
+    }
+}
+
+
+/**
+ * @brief Returns one of the catalog's maintained orderings, building it on first use.
+ *
+ * Building sorts the catalog once (O(N log N)); afterwards the view follows every
+ * add, edit, rating and deletion in O(log N).
+ *
+ * @param catalog The catalog.
+ * @param view Which ordering.
+ * @return The view, or NULL if it could not be built for lack of memory.
+ */
+
+SortedView* catalog_view(MovieCatalog *catalog, MovieView view)
+{
+    if (!catalog) return NULL;
+    return collection_view(&catalog->movies, (int)view);
+}
+
+
+/**
+ * @brief Returns the trigram index over titles and directors, building it on first use.
+ *
+ * Building indexes every live movie once; afterwards new and edited movies are
+ * added as they change, and the index is rebuilt from scratch once the entries
+ * left behind by edits and deletions outnumber the live ones.
+ *
+ * @param catalog The catalog.
+ * @return The index, or NULL if it could not be built for lack of memory.
+ */
+
+TrigramIndex* catalog_text_index(MovieCatalog *catalog)
+{
+    if (!catalog) return NULL;
+
+    TrigramIndex *index = &catalog->text_index;
+    if (index->built) return index;
+
+    for (int i = 0; i < catalog->movies.slot_count; ++i)
+    {
+        const Movie *movie = catalog_get(catalog, i);
+        if (!movie) continue;
+        if (!trigram_index_add(index, movie->id, movie->title) ||
+            !trigram_index_add(index, movie->id, movie->director))
+        {
+            return NULL;
+        }
+    }
+    index->built = true;
+    return index;
+}
+
+
+/**
+ * @brief Returns the running statistics, recomputing them first if they went stale.
+ *
+ * The totals are kept current by the hooks, so this is O(1) unless an earlier
+ * allocation failure left them stale, in which case it costs one pass over the
+ * columns.
+ *
+ * @param catalog The catalog.
+ * @return The statistics, or NULL if they could not be recomputed for lack of memory.
+ */
+
+const CatalogStats* catalog_statistics(MovieCatalog *catalog)
+{
+    if (!catalog) return NULL;
+    if (!catalog_stats_rebuild(&catalog->stats, &catalog->columns, catalog->movies.slot_count)) return NULL;
+    return &catalog->stats;
+}
+
+
+/**
+ * @brief Empties the slot of an unlinked movie and returns the movie to the slab.
+ *
+ * The slot goes on the free stack for the next insert. O(1).
+ *
+ * @param catalog The catalog holding the movie.
+ * @param movie The movie, already dropped with `catalog_unlink()`.
+ */
+
+void catalog_release(MovieCatalog *catalog, Movie *movie)
+{
+    catalog_detach(catalog, movie);
+    collection_free(&catalog->movies, movie);
+}
+
+
+/**
+ * @brief Empties the slot of an unlinked movie but keeps the movie itself.
+ *
+ * Used for a deletion that can be undone (see history.h): the movie, with its
+ * values, can be put back with `catalog_append()`, under the next free id, or
+ * returned to the slab with `collection_free()`.
+ *
+ * @param catalog The catalog holding the movie.
+ * @param movie The movie, already dropped with `catalog_unlink()`.
+ */
+
+void catalog_detach(MovieCatalog *catalog, Movie *movie)
+{
+    movie_columns_clear(&catalog->columns, movie->id);
+    collection_release(&catalog->movies, movie);
+    recommend_invalidate(catalog->recommend);
+}
+
+
+/**
+ * @brief Removes the movies whose titles lie in a loaded buffer, undoing a partial load.
+ *
+ * The loaders create movies whose titles point into a file buffer the catalog
+ * has adopted (see `create_movie_borrowed()`), so those titles tell their movies
+ * from the ones already in the catalog. Slots are released from the last, which
+ * leaves the lowest free id on top of the stack: the next load numbers its
+ * movies as this one would have. O(slots), without journaling.
+ *
+ * @param catalog The catalog holding the movies.
+ * @param begin First byte of the buffer.
+ * @param end One past its last byte.
+ */
+
+void catalog_discard_borrowed(MovieCatalog *catalog, const char *begin, const char *end)
+{
+    for (int id = catalog->movies.slot_count - 1; id >= 0; --id)
+    {
+        Movie *movie = catalog_get(catalog, id);
+        if (!movie || (uintptr_t)movie->title < (uintptr_t)begin || (uintptr_t)movie->title >= (uintptr_t)end) continue;
+        catalog_unlink(catalog, movie);
+        catalog_release(catalog, movie);
+    }
+}
+
+
+/**
+ * @brief Returns the movie with the given id, or NULL for a deleted or unknown id.
+ */
+
+Movie* catalog_get(const MovieCatalog *catalog, int id)
+{
+    if (!catalog) return NULL;
+    return (Movie*)collection_get(&catalog->movies, id);
+}
+
+
+/**
+ * @brief Tells whether enough slots are free for compaction to be worth it.
+ */
+
+bool catalog_needs_compaction(const MovieCatalog *catalog)
+{
+    return collection_needs_compaction(&catalog->movies);
+}
+
+
+static void move_columns(void *context, int from, int to)
+{
+    movie_columns_move((MovieColumns*)context, from, to);
+}
+
+
+/**
+ * @brief Closes the holes left by deletions and renumbers the ids.
+ *
+ * Live movies keep their relative order, which is also the order the snapshot
+ * stores them in, so after a snapshot has been written this makes the in-memory
+ * ids match the ones a reload would produce. It must not be called at any other
+ * time while a journal is attached. The sorted views stay valid and the columns
+ * move along with their movies. The trigram index holds ids, so it is dropped
+ * and rebuilt on its next use.
+ *
+ * @param catalog The catalog to compact.
+ */
+
+void catalog_compact(MovieCatalog *catalog)
+{
+    collection_compact(&catalog->movies, move_columns, &catalog->columns);
+    trigram_index_clear(&catalog->text_index);
+    recommend_invalidate(catalog->recommend);
+}
+
+
+/**
+ * @brief Releases the catalog and every movie it holds.
+ *
+ * @param catalog The catalog to destroy. All Movie pointers obtained from it become invalid.
+ */
+
+void catalog_destroy(MovieCatalog *catalog)
+{
+    if (!catalog) return;
+
+    collection_destroy(&catalog->movies);
+    movie_columns_destroy(&catalog->columns);
+    catalog_stats_destroy(&catalog->stats);
+    trigram_index_destroy(&catalog->text_index);
+}
@@ -0,0 +1,188 @@
+/**
+ * @file catalog_stats.c
+ * @brief Incremental maintenance of the catalog statistics.
+ *
+ * Adding and removing a movie are mirror images, so an edit is a removal under
+ * the old column values followed by an addition under the new ones, and
+ * compaction, which only moves the values between slots, leaves the totals
+ * alone. The per-director table grows geometrically as new codes appear.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include "catalog_stats.h"
+
+#define INITIAL_DIRECTOR_CAPACITY 64
+
+
+/**
+ * @brief Initializes empty totals.
+ *
+ * @return false if the decade table could not be allocated.
+ */
+
+bool catalog_stats_init(CatalogStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->decades = (StatsGroup*)calloc(MOVIE_DECADE_SLOTS, sizeof(StatsGroup));
+    stats->valid = true;
+    return stats->decades != NULL;
+}
+
+
+/**
+ * @brief Releases the totals.
+ */
+
+void catalog_stats_destroy(CatalogStats *stats)
+{
+    free(stats->decades);
+    free(stats->directors);
+    memset(stats, 0, sizeof(*stats));
+}
+
+
+/**
+ * @brief Makes room for director code `code`; false if the table could not grow.
+ */
+
+static bool reserve_director(CatalogStats *stats, uint32_t code)
+{
+    if (code < stats->director_capacity) return true;
+
+    uint32_t capacity = stats->director_capacity ? stats->director_capacity * 2 : INITIAL_DIRECTOR_CAPACITY;
+    while (capacity <= code) capacity *= 2;
+
+    StatsGroup *directors = (StatsGroup*)realloc(stats->directors, capacity * sizeof(StatsGroup));
+    if (!directors) return false;
+    memset(directors + stats->director_capacity, 0, (capacity - stats->director_capacity) * sizeof(StatsGroup));
+    stats->directors = directors;
+    stats->director_capacity = capacity;
+    return true;
+}
+
+
+static void group_update(StatsGroup *group, uint8_t rating, int sign)
+{
+    group->count += (uint32_t)sign;
+    group->rated += (uint32_t)(sign * (rating != 0));
+    group->rating_sum += (uint64_t)(int64_t)(sign * (int)rating);
+}
+
+
+static void stats_update(CatalogStats *stats, int16_t year, uint8_t rating, uint32_t director, int sign)
+{
+    if (!stats->valid) return;
+
+    stats->ratings[rating] += (uint32_t)sign;
+    group_update(&stats->total, rating, sign);
+    group_update(&stats->decades[year > 0 ? year / 10 : 0], rating, sign);
+    if (director == STRING_INTERN_NONE) return;
+    if (!reserve_director(stats, director))
+    {
+        stats->valid = false; // Recomputed from the columns on the next read
+        return;
+    }
+    group_update(&stats->directors[director], rating, sign);
+}
+
+
+/**
+ * @brief Counts a movie with the given column values.
+ */
+
+void catalog_stats_add(CatalogStats *stats, int16_t year, uint8_t rating, uint32_t director)
+{
+    stats_update(stats, year, rating, director, 1);
+}
+
+
+/**
+ * @brief Takes back a movie counted with `catalog_stats_add()` under the same values.
+ */
+
+void catalog_stats_remove(CatalogStats *stats, int16_t year, uint8_t rating, uint32_t director)
+{
+    stats_update(stats, year, rating, director, -1);
+}
+
+
+/**
+ * @brief Recomputes stale totals from the columns.
+ *
+ * Does nothing while the totals are valid, so it is cheap to call before every read.
+ *
+ * @param stats The totals.
+ * @param columns The catalog's columns.
+ * @param slot_count Number of slots in use.
+ * @return false if the totals are still stale for lack of memory.
+ */
+
+bool catalog_stats_rebuild(CatalogStats *stats, const MovieColumns *columns, int slot_count)
+{
+    if (stats->valid) return true;
+
+    memset(stats->ratings, 0, sizeof(stats->ratings));
+    memset(stats->decades, 0, MOVIE_DECADE_SLOTS * sizeof(StatsGroup));
+    memset(&stats->total, 0, sizeof(stats->total));
+    if (stats->directors) memset(stats->directors, 0, stats->director_capacity * sizeof(StatsGroup));
+    if (name_count() > 0 && !reserve_director(stats, name_count() - 1))
+    {
+        return false;
+    }
+
+    stats->valid = true;
+    for (int i = 0; i < slot_count; ++i)
+    {
+        if (columns->years[i] == 0) continue;
+        catalog_stats_add(stats, columns->years[i], columns->ratings[i], columns->directors[i]);
+    }
+    return true;
+}
+
+
+/**
+ * @brief Average rating of the rated movies of a group, in points; 0 if none are rated.
+ */
+
+float stats_group_average(const StatsGroup *group)
+{
+    if (group->rated == 0) return 0.0f;
+    return (float)group->rating_sum / (float)((uint64_t)group->rated * MOVIE_RATING_SCALE);
+}
+
+
+/**
+ * @brief Picks the directors with the most movies.
+ *
+ * One pass over the director table keeping the best `max` in order, so the cost
+ * depends on the number of directors, not of movies.
+ *
+ * @param stats The totals.
+ * @param codes Receives the director codes, most movies first, ties by code.
+ * @param max Capacity of `codes`.
+ * @return Number of codes written.
+ */
+
+int catalog_stats_top_directors(const CatalogStats *stats, uint32_t *codes, int max)
+{
+    if (max <= 0) return 0;
+
+    int n = 0;
+    for (uint32_t code = 0; code < stats->director_capacity; ++code)
+    {
+        uint32_t count = stats->directors[code].count;
+        if (count == 0) continue;
+        if (n == max && count <= stats->directors[codes[n - 1]].count) continue;
+
+        int pos = n < max ? n++ : n - 1;
+        while (pos > 0 && stats->directors[codes[pos - 1]].count < count)
+        {
+            codes[pos] = codes[pos - 1];
+            pos--;
+        }
+        codes[pos] = code;
+    }
+    return n;
+}
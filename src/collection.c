@@ -0,0 +1,430 @@
+/**
+ * @file collection.c
+ * @brief Slot allocation, title index and sorted views for any record type.
+ *
+ * The code here used to live in catalog.c and only knew about Movie. It reads a
+ * record's id and title through the offsets in its CollectionType, so movies
+ * and TV series share one implementation of the slot array, the free stack,
+ * the indexes and compaction.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <stdint.h>
+#include "collection.h"
+
+#define RECORDS_PER_SLAB_BLOCK 1024
+#define STRING_ARENA_BLOCK_SIZE (64 * 1024)
+#define COMPACT_MIN_HOLES 256  // Below this many holes compaction is not worth a snapshot
+
+
+static inline int* record_id(const Collection *collection, void *record)
+{
+    return (int*)((char*)record + collection->type->id_offset);
+}
+
+
+/**
+ * @brief Initializes an empty collection.
+ *
+ * @param collection The collection to initialize.
+ * @param type Describes the records; must outlive the collection.
+ * @param capacity Initial number of slots.
+ * @return false if the slot array or an index could not be allocated.
+ */
+
+bool collection_init(Collection *collection, const CollectionType *type, int capacity)
+{
+    if (capacity < 1) capacity = 1;
+
+    collection->type = type;
+    collection->records = (void**)malloc((size_t)capacity * sizeof(void*));
+    collection->free_slots = (int*)malloc((size_t)capacity * sizeof(int));
+    if (!collection->records || !collection->free_slots)
+    {
+        free(collection->records);
+        free(collection->free_slots);
+        return false;
+    }
+    if (!title_index_init(&collection->title_index, type->title_offset))
+    {
+        free(collection->records);
+        free(collection->free_slots);
+        return false;
+    }
+    for (int v = 0; v < type->order_count; ++v)
+    {
+        if (!sorted_view_init(&collection->views[v], type->orders[v].fields, type->orders[v].field_count))
+        {
+            while (v-- > 0) sorted_view_destroy(&collection->views[v]);
+            title_index_destroy(&collection->title_index);
+            free(collection->records);
+            free(collection->free_slots);
+            return false;
+        }
+    }
+    collection->count = 0;
+    collection->slot_count = 0;
+    collection->capacity = capacity;
+    collection->free_count = 0;
+    slab_init(&collection->slab, type->record_size, RECORDS_PER_SLAB_BLOCK);
+    string_arena_init(&collection->strings, STRING_ARENA_BLOCK_SIZE);
+    return true;
+}
+
+
+/**
+ * @brief Releases the collection and every record it holds.
+ *
+ * @param collection The collection to destroy. All record pointers obtained from it become invalid.
+ */
+
+void collection_destroy(Collection *collection)
+{
+    if (!collection) return;
+
+    if (collection->type && collection->type->destroy)
+    {
+        for (int i = 0; i < collection->slot_count; ++i)
+        {
+            if (collection->records[i]) collection->type->destroy(collection->records[i]);
+        }
+    }
+    free(collection->records);
+    free(collection->free_slots);
+    collection->records = NULL;
+    collection->free_slots = NULL;
+    collection->count = 0;
+    collection->slot_count = 0;
+    collection->free_count = 0;
+    collection->capacity = 0;
+    slab_destroy(&collection->slab);
+    string_arena_destroy(&collection->strings);
+    title_index_destroy(&collection->title_index);
+    for (int v = 0; collection->type && v < collection->type->order_count; ++v)
+    {
+        sorted_view_destroy(&collection->views[v]);
+    }
+}
+
+
+/**
+ * @brief Makes sure the slot array has room for `extra` more records.
+ *
+ * Free slots are not counted, so this may grow a little early. The array (and
+ * the free stack alongside it) grows geometrically, or straight to the required
+ * size when that is larger, so bulk loads resize it only once. The title index
+ * is grown ahead of time as well.
+ *
+ * @param collection The collection to grow.
+ * @param extra Number of records about to be appended.
+ * @return false if an array could not be grown; the collection keeps its old capacity.
+ */
+
+bool collection_reserve(Collection *collection, int extra)
+{
+    if (!title_index_reserve(&collection->title_index, (size_t)(collection->count + extra)))
+    {
+        return false;
+    }
+    if (collection->slot_count + extra <= collection->capacity) return true;
+
+    int new_capacity = collection->capacity * 2;
+    if (new_capacity < collection->slot_count + extra)
+    {
+        new_capacity = collection->slot_count + extra;
+    }
+
+    int *free_slots = (int*)realloc(collection->free_slots, (size_t)new_capacity * sizeof(int));
+    if (!free_slots) return false;
+    collection->free_slots = free_slots;
+
+    void **records = (void**)realloc(collection->records, (size_t)new_capacity * sizeof(void*));
+    if (!records) return false;
+    collection->records = records;
+    collection->capacity = new_capacity;
+    return true;
+}
+
+
+/**
+ * @brief Takes an uninitialized record from the collection's slab, or NULL.
+ */
+
+void* collection_alloc(Collection *collection)
+{
+    return slab_alloc(&collection->slab);
+}
+
+
+/**
+ * @brief Returns a record that was never appended, or was released, to the slab.
+ */
+
+void collection_free(Collection *collection, void *record)
+{
+    slab_free(&collection->slab, record); // Its strings stay in the arena until teardown
+}
+
+
+/**
+ * @brief Adds a record, assigns its id and indexes it.
+ *
+ * The most recently released slot is reused if there is one, otherwise the next
+ * new slot is taken; either way in O(1). The choice is deterministic, so
+ * replaying a journal on top of a snapshot hands out the same ids as the
+ * original session. Built sorted views receive the record as well.
+ *
+ * @param collection The collection to append to.
+ * @param record The record; its id is overwritten.
+ * @return false if the slot array or the title index could not be grown.
+ */
+
+bool collection_append(Collection *collection, void *record)
+{
+    if (!collection_reserve(collection, 1)) return false;
+    if (!title_index_insert(&collection->title_index, record)) return false;
+
+    int id = collection->free_count > 0 ? collection->free_slots[--collection->free_count] : collection->slot_count++;
+    *record_id(collection, record) = id;
+    collection->records[id] = record;
+    collection->count++;
+    for (int v = 0; v < collection->type->order_count; ++v)
+    {
+        sorted_view_insert(&collection->views[v], record);
+    }
+    return true;
+}
+
+
+/**
+ * @brief Drops a record from the indexes before it is removed or re-keyed.
+ *
+ * @param collection The collection holding the record.
+ * @param record The record, still carrying the keys it was indexed under.
+ */
+
+void collection_unlink(Collection *collection, void *record)
+{
+    title_index_remove(&collection->title_index, record);
+    for (int v = 0; v < collection->type->order_count; ++v)
+    {
+        sorted_view_remove(&collection->views[v], record);
+    }
+}
+
+
+/**
+ * @brief Puts a record unlinked with `collection_unlink()` back under its new keys.
+ */
+
+void collection_link(Collection *collection, void *record)
+{
+    title_index_insert(&collection->title_index, record);
+    for (int v = 0; v < collection->type->order_count; ++v)
+    {
+        sorted_view_insert(&collection->views[v], record);
+    }
+}
+
+
+/**
+ * @brief `collection_unlink()` for `count` records whose keys are all about to change.
+ *
+ * A built view that would lose at least 1/COLLECTION_REBUILD_FRACTION of its
+ * records is dropped rather than updated: one O(N log N) sort on its next use
+ * beats that many O(log N) removals and reinserts. Smaller batches update the
+ * views record by record, as `collection_unlink()` does.
+ *
+ * @param collection The collection holding the records.
+ * @param records The records, each at most once.
+ * @param count Number of records.
+ */
+
+void collection_unlink_batch(Collection *collection, void *const *records, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        title_index_remove(&collection->title_index, records[i]);
+    }
+    for (int v = 0; v < collection->type->order_count; ++v)
+    {
+        SortedView *view = &collection->views[v];
+        if (!view->built) continue;
+        if ((size_t)count * COLLECTION_REBUILD_FRACTION >= view->count)
+        {
+            sorted_view_clear(view); // Rebuilt by collection_view() when next asked for
+            continue;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            sorted_view_remove(view, records[i]);
+        }
+    }
+}
+
+
+/**
+ * @brief Puts records unlinked with `collection_unlink_batch()` back under their new keys.
+ *
+ * Views the unlink dropped ignore the inserts until they are rebuilt.
+ */
+
+void collection_link_batch(Collection *collection, void *const *records, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        collection_link(collection, records[i]);
+    }
+}
+
+
+/**
+ * @brief Empties the slot of an unlinked record, in O(1).
+ *
+ * The slot goes on the free stack for the next insert. The record itself is
+ * left to the caller, who returns it with `collection_free()` or frees it.
+ *
+ * @param collection The collection holding the record.
+ * @param record The record, already dropped with `collection_unlink()`.
+ */
+
+void collection_release(Collection *collection, void *record)
+{
+    int id = *record_id(collection, record);
+    collection->records[id] = NULL;
+    collection->free_slots[collection->free_count++] = id;
+    collection->count--;
+}
+
+
+/**
+ * @brief Returns the record with the given id, or NULL for a removed or unknown id.
+ */
+
+void* collection_get(const Collection *collection, int id)
+{
+    if (!collection || id < 0 || id >= collection->slot_count) return NULL;
+    return collection->records[id];
+}
+
+
+/**
+ * @brief Returns the id of a record held by the collection.
+ */
+
+int collection_id(const Collection *collection, const void *record)
+{
+    return *record_id(collection, (void*)record);
+}
+
+
+/**
+ * @brief Looks a record up by title, O(1) on average, ignoring case and whitespace differences.
+ */
+
+void* collection_find(const Collection *collection, const char *title)
+{
+    if (!collection || !title) return NULL;
+    return title_index_find(&collection->title_index, title);
+}
+
+
+/**
+ * @brief Tells whether enough slots are free for compaction to be worth it.
+ */
+
+bool collection_needs_compaction(const Collection *collection)
+{
+    return collection->free_count >= COMPACT_MIN_HOLES && collection->free_count * 4 > collection->slot_count;
+}
+
+
+/**
+ * @brief Closes the holes left by removals and renumbers the ids.
+ *
+ * Live records keep their relative order. The sorted views stay valid: the id
+ * order is unchanged and the other orders do not depend on ids.
+ *
+ * @param collection The collection to compact.
+ * @param moved Told about every record that moves to a lower slot, or NULL.
+ * @param context Passed to `moved`.
+ */
+
+void collection_compact(Collection *collection, CollectionMoveFn moved, void *context)
+{
+    int live = 0;
+    for (int i = 0; i < collection->slot_count; ++i)
+    {
+        void *record = collection->records[i];
+        if (!record) continue;
+        if (moved && i != live) moved(context, i, live);
+        *record_id(collection, record) = live;
+        collection->records[live++] = record;
+    }
+    collection->slot_count = live;
+    collection->free_count = 0;
+}
+
+
+/**
+ * @brief Returns one of the collection's maintained orderings, building it on first use.
+ *
+ * Building sorts the collection once (O(N log N)); afterwards the view follows
+ * every change in O(log N).
+ *
+ * @param collection The collection.
+ * @param order Index into the type's orders.
+ * @return The view, or NULL if it could not be built for lack of memory.
+ */
+
+SortedView* collection_view(Collection *collection, int order)
+{
+    if (!collection || order < 0 || order >= collection->type->order_count) return NULL;
+
+    SortedView *view = &collection->views[order];
+    if (!view->built && !sorted_view_build(view, (void* const*)collection->records, (size_t)collection->slot_count))
+    {
+        return NULL;
+    }
+    return view;
+}
+
+
+/**
+ * @brief Fetches one page of records in one of the collection's orders.
+ *
+ * A page comes from the maintained view and costs O(log N + rows) wherever it
+ * starts. If the view cannot be built and `order` is 0, which by convention is
+ * id order, the slots are scanned instead.
+ *
+ * @param collection The collection.
+ * @param order Index into the type's orders.
+ * @param start Position of the first record in the ordering.
+ * @param page Receives the records.
+ * @param max Capacity of `page`.
+ * @return Number of records fetched, or -1 if the view could not be built.
+ */
+
+int collection_page(Collection *collection, int order, int start, void **page, int max)
+{
+    SortedView *view = collection_view(collection, order);
+    if (view)
+    {
+        return (int)sorted_view_page(view, (size_t)start, page, (size_t)max);
+    }
+    if (order != 0)
+    {
+        return -1;
+    }
+
+    int n = 0;
+    for (int i = 0, live = 0; i < collection->slot_count && n < max; ++i)
+    {
+        if (collection->records[i] && live++ >= start)
+        {
+            page[n++] = collection->records[i];
+        }
+    }
+    return n;
+}
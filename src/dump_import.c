@@ -0,0 +1,497 @@
+/**
+ * @file dump_import.c
+ * @brief Streaming CSV/TSV importer for external movie dumps.
+ *
+ * The dumps the catalog is seeded from run to millions of rows, too many to
+ * read into one buffer as `load_text_records()` does. Instead the file goes
+ * through a pipeline of bounded stages: zlib's gzread() fills a fixed input
+ * buffer (plain files pass through unchanged), a byte-at-a-time state machine
+ * splits it into rows and fields, and complete rows are validated and collected
+ * into a batch. A full batch is checked against the catalog and added, with the
+ * catalog grown once for the batch, and its memory is reused for the next one.
+ *
+ * Rows are validated as `create_movie()` validates its arguments: a title, a
+ * year after 1800, and a rating, if any, from 0 to 5. Duplicates are looked up
+ * by title in the catalog's hash index (see title_index.c) and compared on the
+ * year, so a row is dropped if a movie with the same title, ignoring case and
+ * spacing, and the same year is already in the catalog or came earlier in the
+ * same dump.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+#include "dump_import.h"
+#include "movie.h"
+#include "journal.h"
+#include "perf.h"
+
+
+// Movie fields a column can map to
+typedef enum
+{
+    DUMP_FIELD_TITLE,
+    DUMP_FIELD_DIRECTOR,
+    DUMP_FIELD_YEAR,
+    DUMP_FIELD_RATING,
+    DUMP_FIELD_TYPE,     // IMDb's titleType, only "movie" rows are imported
+    DUMP_FIELD_COUNT,
+} DumpField;
+
+// A header name and the field it maps to
+typedef struct
+{
+    const char *name;
+    DumpField field;
+    float scale;         // Applied to ratings, to bring them to 0-5
+} DumpColumn;
+
+static const DumpColumn dump_columns[] =
+{
+    { "title", DUMP_FIELD_TITLE, 1.0f },
+    { "primaryTitle", DUMP_FIELD_TITLE, 1.0f },
+    { "name", DUMP_FIELD_TITLE, 1.0f },
+    { "director", DUMP_FIELD_DIRECTOR, 1.0f },
+    { "directors", DUMP_FIELD_DIRECTOR, 1.0f },
+    { "year", DUMP_FIELD_YEAR, 1.0f },
+    { "startYear", DUMP_FIELD_YEAR, 1.0f },
+    { "rating", DUMP_FIELD_RATING, 1.0f },
+    { "averageRating", DUMP_FIELD_RATING, 0.5f }, // Out of 10
+    { "titleType", DUMP_FIELD_TYPE, 1.0f },
+};
+
+#define DUMP_COLUMN_COUNT ((int)(sizeof(dump_columns) / sizeof(dump_columns[0])))
+
+// Where the row splitter is within the current field
+typedef enum
+{
+    SPLIT_FIELD_START,   // Nothing read for the field yet
+    SPLIT_UNQUOTED,
+    SPLIT_QUOTED,        // Inside quotes, delimiters and line breaks are data
+    SPLIT_QUOTE_SEEN,    // A quote inside quotes: closes them unless another follows
+} SplitState;
+
+// A validated row waiting in the batch; its strings are in the batch buffer
+typedef struct
+{
+    size_t title;
+    size_t director;
+    int year;
+    float rating;
+} DumpRow;
+
+typedef struct
+{
+    char delimiter;
+    bool quoted;             // CSV quoting; TSV fields are literal
+
+    // The row being split, its fields NUL-terminated one after the other
+    char row[DUMP_MAX_ROW + DUMP_MAX_FIELDS];
+    size_t row_length;
+    size_t field_start;
+    int fields[DUMP_MAX_FIELDS];  // Offset of each field in `row`
+    int field_count;
+    bool too_long;
+    SplitState state;
+
+    // Column of each DumpField, -1 if the dump has none
+    bool mapped;
+    int columns[DUMP_FIELD_COUNT];
+    float rating_scale;
+
+    // Rows validated but not yet added
+    DumpRow batch[DUMP_BATCH_ROWS];
+    int batch_count;
+    char *strings;
+    size_t strings_length;
+    size_t strings_capacity;
+
+    MovieCatalog *catalog;
+    DumpImportStats *stats;
+} DumpReader;
+
+
+static bool has_suffix(const char *text, const char *suffix)
+{
+    size_t length = strlen(text);
+    size_t suffix_length = strlen(suffix);
+    return length > suffix_length && strcmp(text + length - suffix_length, suffix) == 0;
+}
+
+
+/**
+ * @brief Whether `import_dump()` reads this file: `.csv`, `.tsv`, `.csv.gz` or `.tsv.gz`.
+ */
+
+bool dump_import_supported(const char *filename)
+{
+    return has_suffix(filename, ".csv") || has_suffix(filename, ".tsv")
+        || has_suffix(filename, ".csv.gz") || has_suffix(filename, ".tsv.gz");
+}
+
+
+/**
+ * @brief Adds the batched rows that are not duplicates to the catalog and empties the batch.
+ *
+ * The catalog is grown once for the whole batch. Each movie is journaled with
+ * its rating as it is added, so the title index already holds it when the next
+ * row is checked.
+ *
+ * @return DUMP_IMPORT_SUCCESS or DUMP_IMPORT_ERROR_MEMORY_ALLOCATION.
+ */
+
+static DumpImportError flush_batch(DumpReader *reader)
+{
+    MovieCatalog *catalog = reader->catalog;
+    if (reader->batch_count > 0 && catalog_reserve(catalog, reader->batch_count) != MOVIE_SUCCESS)
+    {
+        return DUMP_IMPORT_ERROR_MEMORY_ALLOCATION;
+    }
+
+    for (int i = 0; i < reader->batch_count; ++i)
+    {
+        const DumpRow *row = &reader->batch[i];
+        const char *title = reader->strings + row->title;
+
+        const Movie *match = NULL;
+        while ((match = (const Movie*)title_index_find_next(&catalog->movies.title_index, title, match)))
+        {
+            if (match->year == row->year) break;
+        }
+        if (match)
+        {
+            reader->stats->duplicates++;
+            continue;
+        }
+
+        char *copy = string_arena_strdup(&catalog->movies.strings, title);
+        Movie *movie = copy ? create_movie_borrowed(catalog, copy, reader->strings + row->director, row->year, row->rating)
+                            : NULL;
+        if (!movie) return DUMP_IMPORT_ERROR_MEMORY_ALLOCATION;
+        journal_record_add(catalog->journal, movie);
+        reader->stats->added++;
+    }
+
+    reader->batch_count = 0;
+    reader->strings_length = 0;
+    return DUMP_IMPORT_SUCCESS;
+}
+
+
+/**
+ * @brief Copies a string into the batch buffer.
+ *
+ * A quoted field may hold the '|' and line breaks movies.txt separates fields
+ * and records with (see storage.c), which would split the movie when it is
+ * written there; they are replaced with spaces.
+ *
+ * @return Its offset in the buffer, or SIZE_MAX if the buffer could not grow.
+ */
+
+static size_t batch_string(DumpReader *reader, const char *text)
+{
+    size_t length = strlen(text) + 1;
+    if (reader->strings_length + length > reader->strings_capacity)
+    {
+        size_t capacity = reader->strings_capacity ? reader->strings_capacity : 64 * 1024;
+        while (capacity < reader->strings_length + length) capacity *= 2;
+        char *strings = (char*)realloc(reader->strings, capacity);
+        if (!strings) return SIZE_MAX;
+        reader->strings = strings;
+        reader->strings_capacity = capacity;
+    }
+
+    size_t offset = reader->strings_length;
+    char *copy = reader->strings + offset;
+    memcpy(copy, text, length);
+    for (char *c = strpbrk(copy, "|\r\n"); c; c = strpbrk(c + 1, "|\r\n")) *c = ' ';
+    reader->strings_length += length;
+    return offset;
+}
+
+
+/**
+ * @brief The field of the current row that `field` maps to, or NULL if it has none.
+ *
+ * TSV's `\N` reads as an empty field.
+ */
+
+static const char* row_field(const DumpReader *reader, DumpField field)
+{
+    int column = reader->columns[field];
+    if (column < 0 || column >= reader->field_count) return NULL;
+
+    const char *text = reader->row + reader->fields[column];
+    return strcmp(text, "\\N") == 0 ? "" : text;
+}
+
+
+/**
+ * @brief Maps the columns from a header row.
+ *
+ * @return false if the row names no title and year column, in which case the
+ *         columns are taken to be title, director, year and rating.
+ */
+
+static bool map_columns(DumpReader *reader)
+{
+    for (int f = 0; f < DUMP_FIELD_COUNT; ++f) reader->columns[f] = -1;
+    reader->rating_scale = 1.0f;
+    reader->mapped = true;
+
+    for (int i = 0; i < reader->field_count; ++i)
+    {
+        const char *name = reader->row + reader->fields[i];
+        for (int c = 0; c < DUMP_COLUMN_COUNT; ++c)
+        {
+            const DumpColumn *column = &dump_columns[c];
+            if (strcasecmp(name, column->name) != 0 || reader->columns[column->field] >= 0) continue;
+            reader->columns[column->field] = i;
+            if (column->field == DUMP_FIELD_RATING) reader->rating_scale = column->scale;
+        }
+    }
+    if (reader->columns[DUMP_FIELD_TITLE] >= 0 && reader->columns[DUMP_FIELD_YEAR] >= 0) return true;
+
+    for (int f = 0; f < DUMP_FIELD_COUNT; ++f) reader->columns[f] = -1;
+    reader->columns[DUMP_FIELD_TITLE] = 0;
+    reader->columns[DUMP_FIELD_DIRECTOR] = 1;
+    reader->columns[DUMP_FIELD_YEAR] = 2;
+    reader->columns[DUMP_FIELD_RATING] = 3;
+    reader->rating_scale = 1.0f;
+    return false;
+}
+
+
+/**
+ * @brief Validates a data row and puts it in the batch, adding the batch once it is full.
+ *
+ * The title and director are stored without the text file's separators, see
+ * `batch_string()`.
+ *
+ * @return DUMP_IMPORT_SUCCESS or DUMP_IMPORT_ERROR_MEMORY_ALLOCATION.
+ */
+
+static DumpImportError take_row(DumpReader *reader)
+{
+    DumpImportStats *stats = reader->stats;
+    stats->rows++;
+    if (reader->too_long)
+    {
+        stats->invalid++;
+        return DUMP_IMPORT_SUCCESS;
+    }
+
+    const char *type = row_field(reader, DUMP_FIELD_TYPE);
+    if (type && strcmp(type, "movie") != 0)
+    {
+        stats->skipped++;
+        return DUMP_IMPORT_SUCCESS;
+    }
+
+    // The rules of create_movie(): a title, and a year after 1800
+    const char *title = row_field(reader, DUMP_FIELD_TITLE);
+    const char *year_text = row_field(reader, DUMP_FIELD_YEAR);
+    const char *rating_text = row_field(reader, DUMP_FIELD_RATING);
+    const char *director = row_field(reader, DUMP_FIELD_DIRECTOR);
+    char *end;
+    long year = year_text ? strtol(year_text, &end, 10) : 0;
+    float rating = 0.0f;
+    bool valid = title && title[0] != '\0' && year_text && end != year_text && *end == '\0' && year > 1800 && year <= 99999;
+    if (valid && rating_text && rating_text[0] != '\0')
+    {
+        rating = strtof(rating_text, &end) * reader->rating_scale;
+        valid = end != rating_text && *end == '\0' && rating >= 0.0f && rating <= 5.0f;
+    }
+    if (!valid)
+    {
+        stats->invalid++;
+        return DUMP_IMPORT_SUCCESS;
+    }
+
+    if (reader->batch_count == DUMP_BATCH_ROWS || reader->strings_length >= DUMP_BATCH_BYTES)
+    {
+        DumpImportError err = flush_batch(reader);
+        if (err != DUMP_IMPORT_SUCCESS) return err;
+    }
+
+    DumpRow *row = &reader->batch[reader->batch_count];
+    row->title = batch_string(reader, title);
+    row->director = row->title == SIZE_MAX ? SIZE_MAX : batch_string(reader, director ? director : "");
+    if (row->director == SIZE_MAX) return DUMP_IMPORT_ERROR_MEMORY_ALLOCATION;
+    row->year = (int)year;
+    row->rating = rating;
+    reader->batch_count++;
+    return DUMP_IMPORT_SUCCESS;
+}
+
+
+/**
+ * @brief Terminates the current field and starts the next one.
+ */
+
+static void end_field(DumpReader *reader)
+{
+    if (reader->field_count < DUMP_MAX_FIELDS)
+    {
+        reader->row[reader->row_length++] = '\0'; // Room is kept for every terminator
+        reader->fields[reader->field_count++] = (int)reader->field_start;
+    }
+    reader->field_start = reader->row_length;
+    reader->state = SPLIT_FIELD_START;
+}
+
+
+/**
+ * @brief Hands a complete row to the header mapping or the batch and starts the next one.
+ *
+ * Blank lines are ignored.
+ */
+
+static DumpImportError end_row(DumpReader *reader)
+{
+    end_field(reader);
+    DumpImportError err = DUMP_IMPORT_SUCCESS;
+    bool blank = reader->field_count == 1 && reader->row[0] == '\0' && !reader->too_long;
+    if (!blank && (reader->mapped || !map_columns(reader)))
+    {
+        err = take_row(reader); // The first row was data, not a header
+    }
+
+    reader->row_length = 0;
+    reader->field_start = 0;
+    reader->field_count = 0;
+    reader->too_long = false;
+    return err;
+}
+
+
+static void append_byte(DumpReader *reader, char c)
+{
+    if (reader->field_count >= DUMP_MAX_FIELDS) return; // A column past the ones kept
+    if (reader->row_length >= DUMP_MAX_ROW)
+    {
+        reader->too_long = true;
+        return;
+    }
+    reader->row[reader->row_length++] = c;
+}
+
+
+/**
+ * @brief Splits a block of input into rows, carrying a partial row over to the next block.
+ *
+ * @return DUMP_IMPORT_SUCCESS or DUMP_IMPORT_ERROR_MEMORY_ALLOCATION.
+ */
+
+static DumpImportError split_block(DumpReader *reader, const char *data, size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        char c = data[i];
+        switch (reader->state)
+        {
+            case SPLIT_QUOTED:
+                if (c == '"') reader->state = SPLIT_QUOTE_SEEN;
+                else append_byte(reader, c);
+                continue;
+            case SPLIT_QUOTE_SEEN:
+                if (c == '"')
+                {
+                    append_byte(reader, c); // A doubled quote is one quote
+                    reader->state = SPLIT_QUOTED;
+                    continue;
+                }
+                reader->state = SPLIT_UNQUOTED; // The quotes are closed, take `c` as usual
+                break;
+            case SPLIT_FIELD_START:
+                if (c == '"' && reader->quoted)
+                {
+                    reader->state = SPLIT_QUOTED;
+                    continue;
+                }
+                reader->state = SPLIT_UNQUOTED;
+                break;
+            case SPLIT_UNQUOTED:
+                break;
+        }
+
+        if (c == reader->delimiter)
+        {
+            end_field(reader);
+        }
+        else if (c == '\n')
+        {
+            DumpImportError err = end_row(reader);
+            if (err != DUMP_IMPORT_SUCCESS) return err;
+        }
+        else if (c != '\r')
+        {
+            append_byte(reader, c);
+        }
+    }
+    return DUMP_IMPORT_SUCCESS;
+}
+
+
+/**
+ * @brief Imports the movies of a CSV or TSV dump into the catalog.
+ *
+ * The format is chosen by the extension (see `dump_import_supported()`); the
+ * columns by the header row. Rows that are not valid movies or that duplicate
+ * one on title and year are counted in `stats` and skipped. The journal of the
+ * catalog, if attached, receives every movie added.
+ *
+ * @param filename The dump, optionally gzipped.
+ * @param catalog The catalog the movies are added to.
+ * @param[out] stats Receives what was done with the rows, also on failure.
+ * @return DUMP_IMPORT_SUCCESS, DUMP_IMPORT_ERROR_IO if the file could not be read, or
+ *         DUMP_IMPORT_ERROR_MEMORY_ALLOCATION; the movies added until then stay.
+ */
+
+DumpImportError import_dump(const char *filename, MovieCatalog *catalog, DumpImportStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    gzFile file = gzopen(filename, "rb");
+    if (!file) return DUMP_IMPORT_ERROR_IO;
+
+    DumpReader *reader = (DumpReader*)calloc(1, sizeof(*reader));
+    char *input = (char*)malloc(DUMP_BUFFER_SIZE);
+    if (!reader || !input)
+    {
+        free(reader);
+        free(input);
+        gzclose(file);
+        return DUMP_IMPORT_ERROR_MEMORY_ALLOCATION;
+    }
+
+    PERF_BEGIN(span);
+    bool csv = has_suffix(filename, ".csv") || has_suffix(filename, ".csv.gz");
+    reader->delimiter = csv ? ',' : '\t';
+    reader->quoted = csv;
+    reader->catalog = catalog;
+    reader->stats = stats;
+
+    DumpImportError err = DUMP_IMPORT_SUCCESS;
+    int length;
+    while (err == DUMP_IMPORT_SUCCESS && (length = gzread(file, input, DUMP_BUFFER_SIZE)) > 0)
+    {
+        err = split_block(reader, input, (size_t)length);
+    }
+    if (err == DUMP_IMPORT_SUCCESS && length < 0) err = DUMP_IMPORT_ERROR_IO;
+    if (err == DUMP_IMPORT_SUCCESS && (reader->row_length > 0 || reader->field_count > 0))
+    {
+        err = end_row(reader); // The last row had no line break
+    }
+    if (err == DUMP_IMPORT_SUCCESS) err = flush_batch(reader);
+    if (err == DUMP_IMPORT_SUCCESS) PERF_END(span, PERF_LOAD);
+
+    gzclose(file);
+    free(reader->strings);
+    free(reader);
+    free(input);
+    return err;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file field_scan.c
+ * @brief SIMD and scalar implementations of `field_scan()`.
+ *
+ * Each vector implementation compares a block of bytes against '|' and '\n',
+ * turns the result into a bit mask with one bit per byte and emits the offset
+ * of every set bit. Lines are around 40 bytes with four delimiters, so the
+ * search runs at vector speed and the emit loop touches only the hits. The
+ * few bytes after the last full vector go through the scalar loop.
+ *
+ * The AVX2 code is compiled with a target attribute, so the file builds with
+ * the default flags and the instructions only run after the CPU check.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <pthread.h>
+#include "field_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIELD_SCAN_X86 1
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define FIELD_SCAN_ARM 1
+#endif
+
+typedef size_t (*ScanFn)(const char *data, size_t size, uint32_t *offsets);
+
+static ScanFn scan_impl = NULL;
+static const char *scan_impl_name = "none";
+static pthread_once_t scan_once = PTHREAD_ONCE_INIT;
+
+
+static inline bool is_delimiter(char c)
+{
+    return c == '|' || c == '\n';
+}
+
+
+/**
+ * @brief Writes the offset of every set bit of `mask`, lowest first.
+ */
+
+static inline size_t emit_mask(uint32_t *offsets, size_t count, uint32_t base, uint64_t mask)
+{
+    while (mask)
+    {
+        offsets[count++] = base + (uint32_t)__builtin_ctzll(mask);
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+
+static size_t scan_scalar_from(const char *data, size_t start, size_t size, uint32_t *offsets, size_t count)
+{
+    for (size_t i = start; i < size; ++i)
+    {
+        if (is_delimiter(data[i])) offsets[count++] = (uint32_t)i;
+    }
+    return count;
+}
+
+
+static size_t scan_scalar(const char *data, size_t size, uint32_t *offsets)
+{
+    return scan_scalar_from(data, 0, size, offsets, 0);
+}
+
+
+#ifdef FIELD_SCAN_X86
+
+__attribute__((target("sse2")))
+static size_t scan_sse2(const char *data, size_t size, uint32_t *offsets)
+{
+    const __m128i pipe = _mm_set1_epi8('|');
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, pipe), _mm_cmpeq_epi8(block, newline));
+        count = emit_mask(offsets, count, (uint32_t)i, (uint32_t)_mm_movemask_epi8(hits));
+    }
+    return scan_scalar_from(data, i, size, offsets, count);
+}
+
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *data, size_t size, uint32_t *offsets)
+{
+    const __m256i pipe = _mm256_set1_epi8('|');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+
+    // Two vectors per step give the emit loop a 64-bit mask to work through
+    for (; i + 64 <= size; i += 64)
+    {
+        __m256i low = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i high = _mm256_loadu_si256((const __m256i*)(data + i + 32));
+        uint32_t low_mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(low, pipe), _mm256_cmpeq_epi8(low, newline)));
+        uint32_t high_mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(high, pipe), _mm256_cmpeq_epi8(high, newline)));
+        count = emit_mask(offsets, count, (uint32_t)i, ((uint64_t)high_mask << 32) | low_mask);
+    }
+    return scan_scalar_from(data, i, size, offsets, count);
+}
+
+#endif
+
+
+#ifdef FIELD_SCAN_ARM
+
+static size_t scan_neon(const char *data, size_t size, uint32_t *offsets)
+{
+    const uint8x16_t pipe = vdupq_n_u8('|');
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16)
+    {
+        uint8x16_t block = vld1q_u8((const uint8_t*)data + i);
+        uint8x16_t hits = vorrq_u8(vceqq_u8(block, pipe), vceqq_u8(block, newline));
+
+        // NEON has no movemask: narrowing by 4 bits leaves one nibble per byte
+        uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(hits), 4);
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull;
+        while (mask)
+        {
+            offsets[count++] = (uint32_t)(i + ((size_t)__builtin_ctzll(mask) >> 2));
+            mask &= mask - 1;
+        }
+    }
+    return scan_scalar_from(data, i, size, offsets, count);
+}
+
+#endif
+
+
+static bool select_impl(FieldScanKind kind)
+{
+    switch (kind)
+    {
+        case FIELD_SCAN_AUTO:
+#ifdef FIELD_SCAN_ARM
+            return select_impl(FIELD_SCAN_NEON);
+#else
+            return select_impl(FIELD_SCAN_AVX2) || select_impl(FIELD_SCAN_SSE2) || select_impl(FIELD_SCAN_SCALAR);
+#endif
+        case FIELD_SCAN_SCALAR:
+            scan_impl = scan_scalar;
+            scan_impl_name = "scalar";
+            return true;
+#ifdef FIELD_SCAN_X86
+        case FIELD_SCAN_SSE2:
+            if (!__builtin_cpu_supports("sse2")) return false;
+            scan_impl = scan_sse2;
+            scan_impl_name = "sse2";
+            return true;
+        case FIELD_SCAN_AVX2:
+            if (!__builtin_cpu_supports("avx2")) return false;
+            scan_impl = scan_avx2;
+            scan_impl_name = "avx2";
+            return true;
+#endif
+#ifdef FIELD_SCAN_ARM
+        case FIELD_SCAN_NEON:
+            scan_impl = scan_neon;
+            scan_impl_name = "neon";
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+
+static void select_best(void)
+{
+#ifdef FIELD_SCAN_X86
+    __builtin_cpu_init();
+#endif
+    select_impl(FIELD_SCAN_AUTO);
+}
+
+
+/**
+ * @brief Finds every '|' and '\n' in a block.
+ *
+ * @param data The bytes to scan.
+ * @param size Number of bytes; at most UINT32_MAX.
+ * @param offsets Receives the offsets of the delimiters in increasing order.
+ *                Must have room for `size` entries, the case where every byte is one.
+ * @return Number of offsets written.
+ */
+
+size_t field_scan(const char *data, size_t size, uint32_t *offsets)
+{
+    pthread_once(&scan_once, select_best);
+    return scan_impl(data, size, offsets);
+}
+
+
+/**
+ * @brief Switches to a particular implementation, for benchmarks and comparisons.
+ *
+ * Must not be called while another thread is scanning.
+ *
+ * @param kind The implementation, or FIELD_SCAN_AUTO for the best available.
+ * @return false if this CPU or build cannot run it; the current choice is then kept.
+ */
+
+bool field_scan_use(FieldScanKind kind)
+{
+    pthread_once(&scan_once, select_best);
+    ScanFn previous = scan_impl;
+    const char *previous_name = scan_impl_name;
+    if (select_impl(kind)) return true;
+    scan_impl = previous;
+    scan_impl_name = previous_name;
+    return false;
+}
+
+
+/**
+ * @brief Name of the implementation in use ("avx2", "sse2", "neon" or "scalar").
+ */
+
+const char* field_scan_name(void)
+{
+    pthread_once(&scan_once, select_best);
+    return scan_impl_name;
+}
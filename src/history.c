@@ -0,0 +1,733 @@
+/**
+ * @file history.c
+ * @brief Undo and redo log of catalog edits, kept as deltas in a ring buffer.
+ *
+ * Every delta is framed by its total size, before and after it:
+ *
+ *   HistoryHeader     (size, kind, fields, count)
+ *   payload           (see below)
+ *   uint32_t size     (the same size again, to step back over the delta)
+ *
+ * The payload starts with the Movie pointer, followed by the values the movie
+ * does not currently have: nothing for an add or a deletion, whose movie keeps
+ * its own values while it is out of the catalog, the other rating for a rating,
+ * the other title, director and year for an update, and for a bulk edit `count`
+ * pairs of a movie and its other values, of the fields in `fields` only. A
+ * rating-only bulk edit thus takes 12 bytes per movie.
+ *
+ * The deltas run from `start` around the end of the buffer; `applied` bytes of
+ * them can be undone, the rest up to `used` bytes redone. Undoing steps back
+ * over the last applied delta and exchanges its values with the movie's;
+ * redoing exchanges those of the next delta, which puts the values back.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "history.h"
+#include "catalog.h"
+#include "journal.h"
+#include "recommend.h"
+
+// The kinds of delta
+typedef enum
+{
+    HISTORY_ADD,
+    HISTORY_DELETE,
+    HISTORY_RATE,
+    HISTORY_UPDATE,
+    HISTORY_EDIT,
+} HistoryKind;
+
+typedef struct
+{
+    uint32_t size;     // Of the whole delta, header and trailer included
+    uint8_t kind;      // HistoryKind
+    uint8_t fields;    // MovieEditField bits of a bulk edit
+    uint16_t reserved;
+    int32_t count;     // Movies in a bulk edit, 1 otherwise
+} HistoryHeader;
+
+// The values of a movie a delta holds, only some of which are stored
+typedef struct
+{
+    Movie *movie;
+    char *title;
+    const char *director;
+    int32_t year;
+    float rating;
+} HistoryValues;
+
+#define HISTORY_TRAILER_SIZE sizeof(uint32_t)
+
+
+/**
+ * @brief Copies bytes out of the ring, `position` bytes after the oldest delta.
+ */
+
+static void ring_read(const History *history, size_t position, void *data, size_t size)
+{
+    size_t offset = (history->start + position) % history->capacity;
+    size_t first = size < history->capacity - offset ? size : history->capacity - offset;
+    memcpy(data, history->buffer + offset, first);
+    memcpy((unsigned char*)data + first, history->buffer, size - first);
+}
+
+
+/**
+ * @brief Copies bytes into the ring, `position` bytes after the oldest delta.
+ */
+
+static void ring_write(History *history, size_t position, const void *data, size_t size)
+{
+    size_t offset = (history->start + position) % history->capacity;
+    size_t first = size < history->capacity - offset ? size : history->capacity - offset;
+    memcpy(history->buffer + offset, data, first);
+    memcpy(history->buffer, (const unsigned char*)data + first, size - first);
+}
+
+
+/**
+ * @brief Bytes one movie takes in a delta of the given kind and fields.
+ */
+
+static size_t values_size(HistoryKind kind, unsigned fields)
+{
+    switch (kind)
+    {
+        case HISTORY_RATE:
+            return sizeof(Movie*) + sizeof(float);
+        case HISTORY_UPDATE:
+            return sizeof(Movie*) + sizeof(char*) + sizeof(const char*) + sizeof(int32_t);
+        case HISTORY_EDIT:
+            return sizeof(Movie*)
+                 + ((fields & MOVIE_EDIT_TITLE) ? sizeof(char*) : 0)
+                 + ((fields & MOVIE_EDIT_DIRECTOR) ? sizeof(const char*) : 0)
+                 + ((fields & MOVIE_EDIT_YEAR) ? sizeof(int32_t) : 0)
+                 + ((fields & MOVIE_EDIT_RATING) ? sizeof(float) : 0);
+        default:
+            return sizeof(Movie*);
+    }
+}
+
+
+/**
+ * @brief The fields a delta of this kind stores after the movie.
+ */
+
+static unsigned stored_fields(const HistoryHeader *header)
+{
+    switch (header->kind)
+    {
+        case HISTORY_RATE: return MOVIE_EDIT_RATING;
+        case HISTORY_UPDATE: return MOVIE_EDIT_TITLE | MOVIE_EDIT_DIRECTOR | MOVIE_EDIT_YEAR;
+        case HISTORY_EDIT: return header->fields;
+        default: return 0;
+    }
+}
+
+
+/**
+ * @brief Reads the movie and stored values at `position`.
+ *
+ * @return The position after them.
+ */
+
+static size_t read_values(const History *history, size_t position, unsigned fields, HistoryValues *values)
+{
+    ring_read(history, position, &values->movie, sizeof(values->movie));
+    position += sizeof(values->movie);
+    if (fields & MOVIE_EDIT_TITLE)
+    {
+        ring_read(history, position, &values->title, sizeof(values->title));
+        position += sizeof(values->title);
+    }
+    if (fields & MOVIE_EDIT_DIRECTOR)
+    {
+        ring_read(history, position, &values->director, sizeof(values->director));
+        position += sizeof(values->director);
+    }
+    if (fields & MOVIE_EDIT_YEAR)
+    {
+        ring_read(history, position, &values->year, sizeof(values->year));
+        position += sizeof(values->year);
+    }
+    if (fields & MOVIE_EDIT_RATING)
+    {
+        ring_read(history, position, &values->rating, sizeof(values->rating));
+        position += sizeof(values->rating);
+    }
+    return position;
+}
+
+
+/**
+ * @brief Writes a movie and its values of `fields` at `position`.
+ *
+ * @return The position after them.
+ */
+
+static size_t write_values(History *history, size_t position, unsigned fields, const HistoryValues *values)
+{
+    ring_write(history, position, &values->movie, sizeof(values->movie));
+    position += sizeof(values->movie);
+    if (fields & MOVIE_EDIT_TITLE)
+    {
+        ring_write(history, position, &values->title, sizeof(values->title));
+        position += sizeof(values->title);
+    }
+    if (fields & MOVIE_EDIT_DIRECTOR)
+    {
+        ring_write(history, position, &values->director, sizeof(values->director));
+        position += sizeof(values->director);
+    }
+    if (fields & MOVIE_EDIT_YEAR)
+    {
+        ring_write(history, position, &values->year, sizeof(values->year));
+        position += sizeof(values->year);
+    }
+    if (fields & MOVIE_EDIT_RATING)
+    {
+        ring_write(history, position, &values->rating, sizeof(values->rating));
+        position += sizeof(values->rating);
+    }
+    return position;
+}
+
+
+/**
+ * @brief The values a movie has now.
+ */
+
+static HistoryValues current_values(Movie *movie)
+{
+    HistoryValues values = { movie, movie->title, movie->director, movie->year, movie->rating };
+    return values;
+}
+
+
+/**
+ * @brief Forgets the delta at `position`, returning a movie only the delta still held to the slab.
+ *
+ * That is the movie of an applied deletion or of an undone add.
+ *
+ * @param applied Whether the delta is one that can be undone.
+ * @return The size of the delta.
+ */
+
+static size_t drop_delta(History *history, size_t position, bool applied)
+{
+    HistoryHeader header;
+    ring_read(history, position, &header, sizeof(header));
+    if ((header.kind == HISTORY_DELETE && applied) || (header.kind == HISTORY_ADD && !applied))
+    {
+        Movie *movie;
+        ring_read(history, position + sizeof(header), &movie, sizeof(movie));
+        collection_free(&history->catalog->movies, movie);
+    }
+    return header.size;
+}
+
+
+/**
+ * @brief Drops the deltas that could be redone.
+ */
+
+static void drop_redo(History *history)
+{
+    for (size_t position = history->applied; position < history->used; )
+    {
+        position += drop_delta(history, position, false);
+    }
+    history->used = history->applied;
+}
+
+
+/**
+ * @brief Makes room for a new delta after the applied ones.
+ *
+ * The deltas that could be redone are dropped, then the oldest ones until the
+ * new delta fits.
+ *
+ * @return The position of the new delta, or SIZE_MAX if it is larger than the
+ *         whole buffer; the history is then cleared, as the edit cannot be undone.
+ */
+
+static size_t reserve_delta(History *history, HistoryKind kind, unsigned fields, int count)
+{
+    size_t size = sizeof(HistoryHeader) + (size_t)count * values_size(kind, fields) + HISTORY_TRAILER_SIZE;
+    if (size > history->capacity || size > UINT32_MAX)
+    {
+        history_clear(history);
+        return SIZE_MAX;
+    }
+
+    drop_redo(history);
+    while (history->used + size > history->capacity)
+    {
+        size_t dropped = drop_delta(history, 0, true);
+        history->start = (history->start + dropped) % history->capacity;
+        history->applied -= dropped;
+        history->used -= dropped;
+    }
+
+    HistoryHeader header = { (uint32_t)size, (uint8_t)kind, (uint8_t)fields, 0, count };
+    uint32_t trailer = (uint32_t)size;
+    size_t position = history->used;
+    ring_write(history, position, &header, sizeof(header));
+    ring_write(history, position + size - HISTORY_TRAILER_SIZE, &trailer, sizeof(trailer));
+    history->used += size;
+    history->applied = history->used;
+    return position + sizeof(header);
+}
+
+
+/**
+ * @brief Sets up an empty history for a catalog.
+ *
+ * The history starts recording once it is attached as `catalog->history`.
+ *
+ * @param history The history to initialize.
+ * @param catalog The catalog whose edits it records.
+ * @param capacity Bytes of deltas to keep, at least a few hundred.
+ * @return false if the buffer could not be allocated.
+ */
+
+bool history_init(History *history, MovieCatalog *catalog, size_t capacity)
+{
+    history->catalog = catalog;
+    history->buffer = (unsigned char*)malloc(capacity);
+    history->capacity = history->buffer ? capacity : 0;
+    history->start = 0;
+    history->applied = 0;
+    history->used = 0;
+    return history->buffer != NULL;
+}
+
+
+/**
+ * @brief Forgets every delta; deleted movies kept for an undo return to the slab.
+ */
+
+void history_clear(History *history)
+{
+    drop_redo(history);
+    for (size_t position = 0; position < history->applied; )
+    {
+        position += drop_delta(history, position, true);
+    }
+    history->start = 0;
+    history->applied = 0;
+    history->used = 0;
+}
+
+
+/**
+ * @brief Releases the buffer.
+ *
+ * The movies kept for undoing deletions belong to the catalog's slab, which
+ * releases them with the catalog, so the history may be destroyed before or
+ * after it.
+ */
+
+void history_destroy(History *history)
+{
+    free(history->buffer);
+    history->buffer = NULL;
+    history->capacity = 0;
+    history->start = history->applied = history->used = 0;
+}
+
+
+/**
+ * @brief Whether there is an edit to undo.
+ */
+
+bool history_can_undo(const History *history)
+{
+    return history && history->applied > 0;
+}
+
+
+/**
+ * @brief Whether there is an undone edit to redo.
+ */
+
+bool history_can_redo(const History *history)
+{
+    return history && history->used > history->applied;
+}
+
+
+/**
+ * @brief Records a movie that was just added to the catalog.
+ */
+
+void history_record_add(History *history, Movie *movie)
+{
+    if (!history) return;
+    size_t position = reserve_delta(history, HISTORY_ADD, 0, 1);
+    HistoryValues values = current_values(movie);
+    if (position != SIZE_MAX) write_values(history, position, 0, &values);
+}
+
+
+/**
+ * @brief Records a movie about to be deleted.
+ *
+ * @return true if the history keeps the movie to put it back on an undo: the
+ *         caller then takes it out of the catalog with `catalog_detach()` rather
+ *         than `catalog_release()`.
+ */
+
+bool history_record_delete(History *history, Movie *movie)
+{
+    if (!history) return false;
+    size_t position = reserve_delta(history, HISTORY_DELETE, 0, 1);
+    if (position == SIZE_MAX) return false;
+    HistoryValues values = current_values(movie);
+    write_values(history, position, 0, &values);
+    return true;
+}
+
+
+/**
+ * @brief Records the rating of a movie about to be rated.
+ */
+
+void history_record_rate(History *history, Movie *movie)
+{
+    if (!history) return;
+    size_t position = reserve_delta(history, HISTORY_RATE, 0, 1);
+    HistoryValues values = current_values(movie);
+    if (position != SIZE_MAX) write_values(history, position, MOVIE_EDIT_RATING, &values);
+}
+
+
+/**
+ * @brief Records the title, director and year of a movie about to be updated.
+ */
+
+void history_record_update(History *history, Movie *movie)
+{
+    if (!history) return;
+    size_t position = reserve_delta(history, HISTORY_UPDATE, 0, 1);
+    HistoryValues values = current_values(movie);
+    if (position != SIZE_MAX) write_values(history, position, MOVIE_EDIT_TITLE | MOVIE_EDIT_DIRECTOR | MOVIE_EDIT_YEAR, &values);
+}
+
+
+/**
+ * @brief Records the fields of the movies a bulk edit is about to set.
+ *
+ * An edit of more movies than the buffer can describe clears the history.
+ *
+ * @param history The history, or NULL.
+ * @param movies The movies of the edit.
+ * @param count Number of movies, at least 1.
+ * @param fields The MovieEditField bits the edit sets.
+ */
+
+void history_record_edit(History *history, Movie *const *movies, int count, unsigned fields)
+{
+    if (!history) return;
+    size_t position = reserve_delta(history, HISTORY_EDIT, fields, count);
+    for (int i = 0; position != SIZE_MAX && i < count; ++i)
+    {
+        HistoryValues values = current_values(movies[i]);
+        position = write_values(history, position, fields, &values);
+    }
+}
+
+
+/**
+ * @brief Puts a movie kept by the history back into the catalog, or takes it out.
+ *
+ * @return false if the catalog could not take the movie back.
+ */
+
+static bool exchange_presence(MovieCatalog *catalog, Movie *movie, bool insert)
+{
+    if (insert)
+    {
+        if (catalog_append(catalog, movie) != MOVIE_SUCCESS) return false;
+        journal_record_add(catalog->journal, movie);
+        return true;
+    }
+
+    int id = movie->id;
+    catalog_unlink(catalog, movie);
+    catalog_detach(catalog, movie);
+    journal_record_delete(catalog->journal, id);
+    return true;
+}
+
+
+/**
+ * @brief Swaps the fields in `fields` between a movie and the values read for it.
+ */
+
+static void swap_values(Movie *movie, HistoryValues *values, unsigned fields)
+{
+    if (fields & MOVIE_EDIT_TITLE)
+    {
+        char *title = movie->title;
+        movie->title = values->title;
+        values->title = title;
+    }
+    if (fields & MOVIE_EDIT_DIRECTOR)
+    {
+        const char *director = movie->director;
+        movie->director = values->director;
+        values->director = director;
+    }
+    if (fields & MOVIE_EDIT_YEAR)
+    {
+        int year = movie->year;
+        movie->year = values->year;
+        values->year = year;
+    }
+    if (fields & MOVIE_EDIT_RATING)
+    {
+        float rating = movie->rating;
+        movie->rating = values->rating;
+        values->rating = rating;
+    }
+}
+
+
+// Orders the movies of a bulk edit by the values they now have, see journal_edit()
+static int compare_values(const void *a, const void *b)
+{
+    const HistoryValues *x = (const HistoryValues*)a;
+    const HistoryValues *y = (const HistoryValues*)b;
+    if (x->title != y->title) return (uintptr_t)x->title < (uintptr_t)y->title ? -1 : 1;
+    if (x->director != y->director) return (uintptr_t)x->director < (uintptr_t)y->director ? -1 : 1;
+    if (x->year != y->year) return x->year < y->year ? -1 : 1;
+    if (x->rating != y->rating) return x->rating < y->rating ? -1 : 1;
+    return 0;
+}
+
+
+/**
+ * @brief Journals the values a bulk edit was undone or redone to.
+ *
+ * A journal edit entry sets the same values on all its movies, while undoing
+ * gives each movie its own previous ones. The movies are grouped by the values
+ * they now have, which strings share by pointer, and each group is journaled
+ * as one entry, so a redo takes one entry and undoing a rating change as many
+ * as there were distinct previous ratings.
+ *
+ * @param values Scratch space for `count` movies; `movies` is reordered.
+ */
+
+static void journal_edit(MovieCatalog *catalog, Movie **movies, HistoryValues *values, int count, unsigned fields)
+{
+    if (!catalog->journal) return;
+
+    for (int i = 0; i < count; ++i)
+    {
+        Movie *movie = movies[i];
+        HistoryValues key = { movie, NULL, NULL, 0, 0.0f };
+        if (fields & MOVIE_EDIT_TITLE) key.title = movie->title;
+        if (fields & MOVIE_EDIT_DIRECTOR) key.director = movie->director;
+        if (fields & MOVIE_EDIT_YEAR) key.year = movie->year;
+        if (fields & MOVIE_EDIT_RATING) key.rating = movie->rating;
+        values[i] = key;
+    }
+    qsort(values, (size_t)count, sizeof(*values), compare_values);
+
+    for (int i = 0; i < count; ++i) movies[i] = values[i].movie;
+    for (int first = 0, next; first < count; first = next)
+    {
+        for (next = first + 1; next < count && compare_values(&values[first], &values[next]) == 0; ++next) { }
+        MovieEdit edit = { fields, values[first].title, values[first].director, values[first].year, values[first].rating };
+        journal_record_edit(catalog->journal, &edit, movies + first, next - first);
+    }
+}
+
+
+/**
+ * @brief Exchanges the values of a bulk edit delta with those of its movies.
+ *
+ * The movies go through the indexes as one batch, as in `edit_movies()`.
+ *
+ * @return false if there was not enough memory; nothing is changed then.
+ */
+
+static bool exchange_edit(History *history, size_t position, const HistoryHeader *header)
+{
+    MovieCatalog *catalog = history->catalog;
+    int count = header->count;
+    unsigned fields = header->fields;
+    Movie **movies = (Movie**)calloc((size_t)count, sizeof(*movies));
+    HistoryValues *values = (HistoryValues*)malloc((size_t)count * sizeof(*values));
+    if (!movies || !values)
+    {
+        free(movies);
+        free(values);
+        return false;
+    }
+
+    size_t cursor = position;
+    for (int i = 0; i < count; ++i)
+    {
+        cursor = read_values(history, cursor, fields, &values[i]);
+        movies[i] = values[i].movie;
+    }
+
+    catalog_unlink_batch(catalog, movies, count);
+    for (int i = 0; i < count; ++i)
+    {
+        swap_values(movies[i], &values[i], fields);
+    }
+    catalog_link_batch(catalog, movies, count);
+
+    // The delta now holds the values the movies had
+    cursor = position;
+    for (int i = 0; i < count; ++i)
+    {
+        cursor = write_values(history, cursor, fields, &values[i]);
+    }
+
+    if (fields == MOVIE_EDIT_RATING && (size_t)count * COLLECTION_REBUILD_FRACTION < (size_t)catalog->movies.count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            recommend_rating_changed(catalog->recommend, NULL, movies[i], movies[i]->rating);
+        }
+    }
+    else
+    {
+        recommend_invalidate(catalog->recommend);
+    }
+    journal_edit(catalog, movies, values, count, fields);
+
+    free(movies);
+    free(values);
+    return true;
+}
+
+
+/**
+ * @brief Exchanges the values of the delta at `position` with the catalog's.
+ *
+ * Runs with the history detached from the catalog, so the changes made through
+ * movie.c are journaled but not recorded again.
+ *
+ * @param undo Whether the delta is being undone rather than redone.
+ * @return false if there was not enough memory; nothing is changed then.
+ */
+
+static bool exchange_delta(History *history, size_t position, bool undo, char *label, size_t label_size)
+{
+    MovieCatalog *catalog = history->catalog;
+    HistoryHeader header;
+    ring_read(history, position, &header, sizeof(header));
+    position += sizeof(header);
+
+    HistoryValues values;
+    read_values(history, position, stored_fields(&header), &values);
+    Movie *movie = values.movie;
+    switch (header.kind)
+    {
+        case HISTORY_ADD:
+        case HISTORY_DELETE:
+            if (!exchange_presence(catalog, movie, (header.kind == HISTORY_DELETE) == undo)) return false;
+            snprintf(label, label_size, "%s of \"%s\"", header.kind == HISTORY_ADD ? "addition" : "deletion", movie->title);
+            return true;
+        case HISTORY_RATE:
+        {
+            float rating = values.rating;
+            values.rating = movie->rating;
+            set_movie_rating(catalog, movie, rating);
+            break;
+        }
+        case HISTORY_UPDATE:
+            catalog_unlink(catalog, movie);
+            swap_values(movie, &values, stored_fields(&header));
+            catalog_link(catalog, movie);
+            journal_record_update(catalog->journal, movie);
+            recommend_invalidate(catalog->recommend); // As update_movie() does
+            break;
+        case HISTORY_EDIT:
+            if (!exchange_edit(history, position, &header)) return false;
+            snprintf(label, label_size, "edit of %d movie%s", header.count, header.count == 1 ? "" : "s");
+            return true;
+    }
+    write_values(history, position, stored_fields(&header), &values);
+    snprintf(label, label_size, "%s of \"%s\"", header.kind == HISTORY_RATE ? "rating" : "update", movie->title);
+    return true;
+}
+
+
+/**
+ * @brief Undoes the last edit that has not been undone yet.
+ *
+ * The edit stays in the history and can be redone until another edit is made.
+ *
+ * @param history The history attached to the catalog.
+ * @param[out] label Receives what was undone, e.g. `rating of "Heat"`; may be NULL.
+ * @param label_size Size of `label`, HISTORY_LABEL_SIZE is enough.
+ * @return HISTORY_SUCCESS, HISTORY_ERROR_EMPTY, or HISTORY_ERROR_MEMORY_ALLOCATION
+ *         if the catalog could not take a deleted movie back.
+ */
+
+HistoryError history_undo(History *history, char *label, size_t label_size)
+{
+    if (!history_can_undo(history)) return HISTORY_ERROR_EMPTY;
+
+    char scratch[HISTORY_LABEL_SIZE];
+    if (!label)
+    {
+        label = scratch;
+        label_size = sizeof(scratch);
+    }
+    uint32_t size;
+    ring_read(history, history->applied - HISTORY_TRAILER_SIZE, &size, sizeof(size));
+
+    MovieCatalog *catalog = history->catalog;
+    catalog->history = NULL;
+    bool ok = exchange_delta(history, history->applied - size, true, label, label_size);
+    catalog->history = history;
+    if (!ok) return HISTORY_ERROR_MEMORY_ALLOCATION;
+
+    history->applied -= size;
+    return HISTORY_SUCCESS;
+}
+
+
+/**
+ * @brief Redoes the last edit undone.
+ *
+ * @param history The history attached to the catalog.
+ * @param[out] label Receives what was redone; may be NULL.
+ * @param label_size Size of `label`.
+ * @return HISTORY_SUCCESS, HISTORY_ERROR_EMPTY, or HISTORY_ERROR_MEMORY_ALLOCATION
+ *         if the catalog could not take an added movie back.
+ */
+
+HistoryError history_redo(History *history, char *label, size_t label_size)
+{
+    if (!history_can_redo(history)) return HISTORY_ERROR_EMPTY;
+
+    char scratch[HISTORY_LABEL_SIZE];
+    if (!label)
+    {
+        label = scratch;
+        label_size = sizeof(scratch);
+    }
+    HistoryHeader header;
+    ring_read(history, history->applied, &header, sizeof(header));
+
+    MovieCatalog *catalog = history->catalog;
+    catalog->history = NULL;
+    bool ok = exchange_delta(history, history->applied, false, label, label_size);
+    catalog->history = history;
+    if (!ok) return HISTORY_ERROR_MEMORY_ALLOCATION;
+
+    history->applied += header.size;
+    return HISTORY_SUCCESS;
+}
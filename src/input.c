@@ -0,0 +1,135 @@
+/**
+ * @file input.c
+ * @brief The input loop shared by every screen: wait, service background work, coalesce.
+ *
+ * Screens follow the same pattern: draw, `input_read()`, handle the event. While
+ * no key is waiting, `input_read()` sleeps in poll() on stdin, waking up when the
+ * status line needs to change (see `notify_update()`) and every INPUT_IDLE_MS to
+ * run the idle hook. Once a key arrives, every identical key already queued behind
+ * it is read without waiting and folded into the same event, and the first
+ * different one is pushed back for the next call. A screen therefore draws once
+ * per batch of input rather than once per key, however far behind the terminal
+ * has fallen.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include "input.h"
+#include "notify.h"
+
+static InputIdleFn idle_hook = NULL;
+static void *idle_context = NULL;
+
+
+static long long now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+
+/**
+ * @brief Tells whether a run of this key means the same as one press repeated `count` times.
+ */
+
+static bool coalesces(int key)
+{
+    switch (key)
+    {
+        case KEY_UP:
+        case KEY_DOWN:
+        case KEY_LEFT:
+        case KEY_RIGHT:
+        case KEY_PPAGE:
+        case KEY_NPAGE:
+        case KEY_HOME:
+        case KEY_END:
+        case KEY_RESIZE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * @brief Sets the work run between key presses.
+ *
+ * The hook runs on the UI thread at least every INPUT_IDLE_MS while a screen
+ * waits for input, and before each key is returned.
+ *
+ * @param idle The hook, or NULL for none.
+ * @param context Passed to the hook.
+ */
+
+void input_set_idle(InputIdleFn idle, void *context)
+{
+    idle_hook = idle;
+    idle_context = context;
+}
+
+
+/**
+ * @brief Waits for the next key press, folding queued repeats of it into one event.
+ *
+ * Notifications are dismissed on time and the idle hook is run while waiting.
+ * The window is left in blocking mode, as forms reading from it expect.
+ *
+ * @param win The window to read from; its pending changes are refreshed first.
+ * @param timeout Milliseconds to wait at most, or -1 to wait for a key.
+ * @param[out] event Receives the key and its repeat count.
+ * @return false if `timeout` expired without a key.
+ */
+
+bool input_read(WINDOW *win, int timeout, InputEvent *event)
+{
+    long long deadline = timeout >= 0 ? now_ms() + timeout : -1;
+    int key;
+
+    wtimeout(win, 0);
+    for (;;)
+    {
+        if (idle_hook) idle_hook(idle_context);
+        int wait = notify_update(); // Wake up to dismiss a status message on time
+        if (idle_hook && (wait < 0 || wait > INPUT_IDLE_MS)) wait = INPUT_IDLE_MS;
+
+        // Checked before poll(): ncurses may already hold keys, e.g. one pushed back below
+        key = wgetch(win);
+        if (key != ERR) break;
+
+        if (deadline >= 0)
+        {
+            long long left = deadline - now_ms();
+            if (left <= 0)
+            {
+                wtimeout(win, -1);
+                return false;
+            }
+            if (wait < 0 || wait > left) wait = (int)left;
+        }
+
+        // A resize interrupts the wait, and the next wgetch() returns KEY_RESIZE
+        struct pollfd terminal = { STDIN_FILENO, POLLIN, 0 };
+        poll(&terminal, 1, wait);
+    }
+
+    event->key = key;
+    event->count = 1;
+    while (coalesces(key) && event->count < INPUT_MAX_COALESCE)
+    {
+        int next = wgetch(win);
+        if (next == ERR) break;
+        if (next != key)
+        {
+            ungetch(next); // Handled by the next call, after this event is drawn
+            break;
+        }
+        event->count++;
+    }
+
+    wtimeout(win, -1);
+    return true;
+}
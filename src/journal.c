@@ -0,0 +1,606 @@
+/**
+ * @file journal.c
+ * @brief Append-only log of catalog edits.
+ *
+ * Instead of rewriting the whole catalog to record one change, every add, rate,
+ * update and delete is appended to the journal as a single self-checking entry
+ * with one write() call, and so is every bulk edit, however many movies it
+ * changes. On startup the journal is replayed on top of the
+ * snapshot it was started from. Once it grows past JOURNAL_COMPACT_THRESHOLD the
+ * owner writes a fresh snapshot and resets the journal (see storage.c).
+ *
+ * Entries identify records by their catalog id. Ids are only renumbered when a
+ * snapshot is written and the journal reset, and slot reuse is deterministic, so
+ * replaying the same operations in the same order on the same snapshot hands out
+ * the same ids; an ADD entry also records the id it was given, which replay
+ * checks to detect a journal that does not belong to the loaded catalog.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "journal.h"
+#include "catalog.h"
+#include "storage.h"
+#include "notify.h"
+
+
+/**
+ * @brief Bytes following an entry: its strings, and the ids of an EDIT entry.
+ *
+ * @return The size, or SIZE_MAX for an EDIT entry with a negative count.
+ */
+
+static size_t payload_size(const JournalEntry *entry)
+{
+    size_t size = (size_t)entry->title_length + entry->director_length;
+    if (entry->op != JOURNAL_OP_EDIT) return size;
+    if (entry->id < 0) return SIZE_MAX;
+    return size + (size_t)entry->id * sizeof(int32_t);
+}
+
+
+/**
+ * @brief Computes the FNV-1a checksum of an entry and its payload.
+ *
+ * @param entry The entry. Its checksum field is treated as zero.
+ * @param strings The title bytes immediately followed by the director bytes, and the ids of an EDIT entry.
+ * @return The 32-bit checksum.
+ */
+
+static uint32_t entry_checksum(const JournalEntry *entry, const char *strings)
+{
+    JournalEntry copy = *entry;
+    copy.checksum = 0;
+
+    uint32_t hash = 2166136261u;
+    const unsigned char *p = (const unsigned char*)&copy;
+    for (size_t i = 0; i < sizeof(copy); ++i)
+    {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    size_t length = payload_size(entry);
+    p = (const unsigned char*)strings;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+
+/**
+ * @brief Writes a fresh header, discarding any entries.
+ *
+ * @param journal An open journal.
+ * @param base_generation Generation of the snapshot the new entries will apply to.
+ * @return JOURNAL_SUCCESS or JOURNAL_ERROR_IO.
+ */
+
+JournalError journal_reset(Journal *journal, uint64_t base_generation)
+{
+    JournalHeader header;
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.base_generation = base_generation;
+
+    if (ftruncate(journal->fd, 0) != 0
+        || write(journal->fd, &header, sizeof(header)) != (ssize_t)sizeof(header))
+    {
+        return JOURNAL_ERROR_IO;
+    }
+    journal->base_generation = base_generation;
+    journal->size = sizeof(header);
+    journal->failed = false;
+    return JOURNAL_SUCCESS;
+}
+
+
+/**
+ * @brief Opens the journal for appending.
+ *
+ * An existing journal with a matching header is kept so new entries follow the
+ * replayed ones. Otherwise the file is created or truncated with a new header.
+ *
+ * @param journal The journal to open.
+ * @param filename Path of the journal file.
+ * @param base_generation Generation of the snapshot currently loaded.
+ * @return JOURNAL_SUCCESS or JOURNAL_ERROR_IO.
+ */
+
+JournalError journal_open(Journal *journal, const char *filename, uint64_t base_generation)
+{
+    journal->fd = open(filename, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (journal->fd < 0)
+    {
+        perror("Could not open journal");
+        return JOURNAL_ERROR_IO;
+    }
+
+    uint64_t existing;
+    off_t size = lseek(journal->fd, 0, SEEK_END);
+    if (size >= (off_t)sizeof(JournalHeader)
+        && journal_peek_generation(filename, &existing)
+        && existing == base_generation)
+    {
+        journal->base_generation = base_generation;
+        journal->size = (size_t)size;
+        journal->failed = false;
+        return JOURNAL_SUCCESS;
+    }
+
+    if (journal_reset(journal, base_generation) != JOURNAL_SUCCESS)
+    {
+        journal_close(journal);
+        return JOURNAL_ERROR_IO;
+    }
+    return JOURNAL_SUCCESS;
+}
+
+
+/**
+ * @brief Moves the journal's entries aside and continues in a fresh file.
+ *
+ * The new journal is created under a temporary name before the current file is
+ * renamed to `retired_filename`, so the journal file always exists. The retired
+ * entries are needed, together with the new ones, until a snapshot of the new
+ * generation is on disk.
+ *
+ * @param journal An open journal.
+ * @param filename Path of the journal file.
+ * @param retired_filename Where the current entries are moved.
+ * @param base_generation Generation of the snapshot the new entries will apply to.
+ * @return JOURNAL_SUCCESS, or JOURNAL_ERROR_IO with the journal unchanged.
+ */
+
+JournalError journal_rotate(Journal *journal, const char *filename, const char *retired_filename, uint64_t base_generation)
+{
+    char new_name[1024];
+    snprintf(new_name, sizeof(new_name), "%s.new", filename);
+
+    Journal fresh;
+    remove(new_name);
+    if (journal_open(&fresh, new_name, base_generation) != JOURNAL_SUCCESS)
+    {
+        return JOURNAL_ERROR_IO;
+    }
+    if (rename(filename, retired_filename) != 0)
+    {
+        close(fresh.fd);
+        remove(new_name);
+        return JOURNAL_ERROR_IO;
+    }
+    if (rename(new_name, filename) != 0)
+    {
+        rename(retired_filename, filename);
+        close(fresh.fd);
+        remove(new_name);
+        return JOURNAL_ERROR_IO;
+    }
+
+    // No fsync: the retired entries were written the same way as every other entry
+    close(journal->fd);
+    *journal = fresh;
+    return JOURNAL_SUCCESS;
+}
+
+
+/**
+ * @brief Flushes the journal to stable storage and closes it.
+ *
+ * @param journal The journal to close. Closing a closed journal does nothing.
+ */
+
+void journal_close(Journal *journal)
+{
+    if (journal->fd >= 0)
+    {
+        fsync(journal->fd);
+        close(journal->fd);
+    }
+    journal->fd = -1;
+}
+
+
+/**
+ * @brief Tells whether the journal has grown enough to be folded into a snapshot.
+ *
+ * @param journal The journal to check.
+ * @return true once the entries exceed JOURNAL_COMPACT_THRESHOLD bytes.
+ */
+
+bool journal_needs_compaction(const Journal *journal)
+{
+    return journal->fd >= 0 && journal->size - sizeof(JournalHeader) > JOURNAL_COMPACT_THRESHOLD;
+}
+
+
+/**
+ * @brief Reads the base generation from a journal's header.
+ *
+ * @param filename Path of the journal file.
+ * @param base_generation Receives the generation.
+ * @return true if the file exists and has a valid header.
+ */
+
+bool journal_peek_generation(const char *filename, uint64_t *base_generation)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    JournalHeader header;
+    bool ok = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header)
+           && memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) == 0
+           && header.version == JOURNAL_VERSION;
+    close(fd);
+
+    if (ok) *base_generation = header.base_generation;
+    return ok;
+}
+
+
+/**
+ * @brief Tells whether a journal holds entries on top of snapshot `base_generation`.
+ *
+ * @param filename Path of the journal file.
+ * @param base_generation The snapshot generation.
+ * @return true if the journal belongs to that generation and is longer than its header.
+ */
+
+bool journal_has_entries(const char *filename, uint64_t base_generation)
+{
+    uint64_t existing;
+    struct stat st;
+    return journal_peek_generation(filename, &existing) && existing == base_generation
+        && stat(filename, &st) == 0 && (size_t)st.st_size > sizeof(JournalHeader);
+}
+
+
+/**
+ * @brief Stops appending after an edit could not be journaled, and tells the user.
+ *
+ * @return JOURNAL_ERROR_IO or JOURNAL_ERROR_MEMORY_ALLOCATION, as given.
+ */
+
+static JournalError fail_append(Journal *journal, JournalError err, const char *reason)
+{
+    journal->failed = true;
+    notify(NOTIFY_ERROR, "Could not journal the edit (%s); the catalog will be saved in full.", reason);
+    return err;
+}
+
+
+/**
+ * @brief Writes one complete entry with a single write() call.
+ *
+ * A short write would leave a torn entry that replay stops at, so the file is
+ * cut back to the last complete entry.
+ *
+ * @return JOURNAL_SUCCESS or JOURNAL_ERROR_IO.
+ */
+
+static JournalError write_entry(Journal *journal, const char *buffer, size_t total)
+{
+    ssize_t written = write(journal->fd, buffer, total);
+    if (written == (ssize_t)total)
+    {
+        journal->size += total;
+        return JOURNAL_SUCCESS;
+    }
+
+    const char *reason = written < 0 ? strerror(errno) : "short write";
+    if (written > 0 && ftruncate(journal->fd, (off_t)journal->size) != 0)
+    {
+        perror("Could not cut a torn entry off the journal");
+    }
+    return fail_append(journal, JOURNAL_ERROR_IO, reason);
+}
+
+
+/**
+ * @brief Appends one entry with a single write() call.
+ *
+ * @param journal The journal to append to. A closed journal ignores the call.
+ * @param op The operation.
+ * @param id Catalog id of the record.
+ * @param movie Source of year, rating and strings, or NULL for a delete.
+ * @param with_strings Whether to store the title and director.
+ * @return JOURNAL_SUCCESS, JOURNAL_ERROR_IO or JOURNAL_ERROR_MEMORY_ALLOCATION. A failure has
+ *         already been reported, and the journal takes no more entries (see journal.h).
+ */
+
+static JournalError append_entry(Journal *journal, JournalOp op, int id, const Movie *movie, bool with_strings)
+{
+    if (!journal || journal->fd < 0) return JOURNAL_SUCCESS;
+    if (journal->failed) return JOURNAL_ERROR_IO;
+
+    JournalEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.op = (uint8_t)op;
+    entry.id = id;
+    if (movie)
+    {
+        entry.year = movie->year;
+        entry.rating = movie->rating;
+    }
+    if (with_strings)
+    {
+        entry.title_length = (uint32_t)strlen(movie->title);
+        entry.director_length = (uint32_t)strlen(movie->director);
+    }
+
+    size_t total = sizeof(entry) + entry.title_length + entry.director_length;
+    char stack_buffer[512];
+    char *buffer = total <= sizeof(stack_buffer) ? stack_buffer : (char*)malloc(total);
+    if (!buffer) return fail_append(journal, JOURNAL_ERROR_MEMORY_ALLOCATION, "out of memory");
+
+    char *strings = buffer + sizeof(entry);
+    if (with_strings)
+    {
+        memcpy(strings, movie->title, entry.title_length);
+        memcpy(strings + entry.title_length, movie->director, entry.director_length);
+    }
+    entry.checksum = entry_checksum(&entry, with_strings ? strings : NULL); // No payload otherwise
+    memcpy(buffer, &entry, sizeof(entry));
+
+    JournalError err = write_entry(journal, buffer, total);
+    if (buffer != stack_buffer) free(buffer);
+    return err;
+}
+
+
+/**
+ * @brief Records that a movie was added with id `movie->id`.
+ */
+
+JournalError journal_record_add(Journal *journal, const Movie *movie)
+{
+    return append_entry(journal, JOURNAL_OP_ADD, movie->id, movie, true);
+}
+
+
+/**
+ * @brief Records the new rating of a movie.
+ */
+
+JournalError journal_record_rate(Journal *journal, const Movie *movie)
+{
+    return append_entry(journal, JOURNAL_OP_RATE, movie->id, movie, false);
+}
+
+
+/**
+ * @brief Records the new title, director and year of a movie.
+ */
+
+JournalError journal_record_update(Journal *journal, const Movie *movie)
+{
+    return append_entry(journal, JOURNAL_OP_UPDATE, movie->id, movie, true);
+}
+
+
+/**
+ * @brief Records that the movie with id `id` was deleted.
+ */
+
+JournalError journal_record_delete(Journal *journal, int id)
+{
+    return append_entry(journal, JOURNAL_OP_DELETE, id, NULL, false);
+}
+
+
+/**
+ * @brief Records a bulk edit as one entry, written with a single write() call.
+ *
+ * @param journal The journal to append to. A closed journal ignores the call.
+ * @param edit The change applied to every movie.
+ * @param movies The movies it was applied to.
+ * @param count Number of movies.
+ * @return JOURNAL_SUCCESS, JOURNAL_ERROR_IO or JOURNAL_ERROR_MEMORY_ALLOCATION. A failure has
+ *         already been reported, and the journal takes no more entries (see journal.h).
+ */
+
+JournalError journal_record_edit(Journal *journal, const MovieEdit *edit, Movie *const *movies, int count)
+{
+    if (!journal || journal->fd < 0) return JOURNAL_SUCCESS;
+    if (journal->failed) return JOURNAL_ERROR_IO;
+
+    JournalEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.op = JOURNAL_OP_EDIT;
+    entry.fields = (uint8_t)edit->fields;
+    entry.id = count;
+    entry.year = (edit->fields & MOVIE_EDIT_YEAR) ? edit->year : 0;
+    entry.rating = (edit->fields & MOVIE_EDIT_RATING) ? edit->rating : 0.0f;
+    entry.title_length = (edit->fields & MOVIE_EDIT_TITLE) ? (uint32_t)strlen(edit->title) : 0;
+    entry.director_length = (edit->fields & MOVIE_EDIT_DIRECTOR) ? (uint32_t)strlen(edit->director) : 0;
+
+    size_t total = sizeof(entry) + payload_size(&entry);
+    char *buffer = (char*)malloc(total);
+    if (!buffer) return fail_append(journal, JOURNAL_ERROR_MEMORY_ALLOCATION, "out of memory");
+
+    char *strings = buffer + sizeof(entry);
+    if (entry.title_length > 0) memcpy(strings, edit->title, entry.title_length);
+    if (entry.director_length > 0) memcpy(strings + entry.title_length, edit->director, entry.director_length);
+    char *ids = strings + entry.title_length + entry.director_length;
+    for (int i = 0; i < count; ++i)
+    {
+        int32_t id = movies[i]->id;
+        memcpy(ids + (size_t)i * sizeof(id), &id, sizeof(id));
+    }
+    entry.checksum = entry_checksum(&entry, strings);
+    memcpy(buffer, &entry, sizeof(entry));
+
+    JournalError err = write_entry(journal, buffer, total);
+    free(buffer);
+    return err;
+}
+
+
+/**
+ * @brief Applies an EDIT entry: looks up every movie, then edits them as one batch.
+ *
+ * @return true if every id named a movie and the edit was applied.
+ */
+
+static bool apply_edit(MovieCatalog *catalog, const JournalEntry *entry, const char *title,
+                       const char *director, const char *ids)
+{
+    Movie **movies = (Movie**)malloc(((size_t)entry->id + 1) * sizeof(*movies));
+    if (!movies) return false;
+
+    bool ok = true;
+    for (int i = 0; i < entry->id && ok; ++i)
+    {
+        int32_t id;
+        memcpy(&id, ids + (size_t)i * sizeof(id), sizeof(id));
+        movies[i] = catalog_get(catalog, id);
+        ok = movies[i] != NULL;
+    }
+
+    MovieEdit edit = { entry->fields, title, director, entry->year, entry->rating };
+    ok = ok && edit_movies(catalog, movies, entry->id, &edit) == MOVIE_SUCCESS;
+    free(movies);
+    return ok;
+}
+
+
+/**
+ * @brief Applies one journal entry to the catalog.
+ *
+ * @return true if the entry was consistent with the catalog.
+ */
+
+static bool apply_entry(MovieCatalog *catalog, const JournalEntry *entry, char *strings)
+{
+    Movie *movie = NULL;
+    if (entry->op != JOURNAL_OP_ADD && entry->op != JOURNAL_OP_EDIT)
+    {
+        movie = catalog_get(catalog, entry->id);
+        if (!movie)
+        {
+            return false;
+        }
+    }
+
+    // Strings are copied into the catalog, terminate them in a scratch buffer
+    char *title = (char*)malloc((size_t)entry->title_length + entry->director_length + 2);
+    if (!title) return false;
+    char *director = title + entry->title_length + 1;
+    memcpy(title, strings, entry->title_length);
+    title[entry->title_length] = '\0';
+    memcpy(director, strings + entry->title_length, entry->director_length);
+    director[entry->director_length] = '\0';
+
+    bool ok;
+    switch (entry->op)
+    {
+        case JOURNAL_OP_ADD:
+            movie = create_movie(catalog, title, director, entry->year);
+            ok = movie && movie->id == entry->id;
+            if (ok && entry->rating != 0.0f)
+            {
+                // Through the hooks, so the columns, totals and rating view see it
+                ok = set_movie_rating(catalog, movie, entry->rating) == MOVIE_SUCCESS;
+            }
+            break;
+        case JOURNAL_OP_RATE:
+            ok = set_movie_rating(catalog, movie, entry->rating) == MOVIE_SUCCESS;
+            break;
+        case JOURNAL_OP_UPDATE:
+            ok = update_movie(catalog, movie, title, director, entry->year) == MOVIE_SUCCESS;
+            break;
+        case JOURNAL_OP_DELETE:
+            ok = remove_movie(catalog, entry->id) == MOVIE_SUCCESS;
+            break;
+        case JOURNAL_OP_EDIT:
+            ok = apply_edit(catalog, entry, title, director, strings + entry->title_length + entry->director_length);
+            break;
+        default:
+            ok = false;
+            break;
+    }
+
+    free(title);
+    return ok;
+}
+
+
+/**
+ * @brief Replays a journal on top of the catalog loaded from snapshot `base_generation`.
+ *
+ * Replay stops at the first torn, corrupt or inconsistent entry. Trailing bytes
+ * after the last good entry are truncated so later appends start cleanly. The
+ * catalog must not have a journal attached, or the replayed edits would be
+ * journaled again.
+ *
+ * @param filename Path of the journal file.
+ * @param base_generation Generation of the snapshot that was loaded.
+ * @param catalog The catalog to apply the entries to.
+ * @return Number of entries applied, or -1 if the journal is missing or belongs
+ *         to another generation.
+ */
+
+int journal_replay(const char *filename, uint64_t base_generation, MovieCatalog *catalog)
+{
+    char *data;
+    size_t size;
+    if (read_whole_file(filename, &data, &size) != 0)
+    {
+        return -1;
+    }
+
+    JournalHeader header;
+    if (size < sizeof(header))
+    {
+        free(data);
+        return -1;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0
+        || header.version != JOURNAL_VERSION
+        || header.base_generation != base_generation)
+    {
+        free(data);
+        return -1;
+    }
+
+    int applied = 0;
+    size_t offset = sizeof(header);
+    while (size - offset >= sizeof(JournalEntry))
+    {
+        JournalEntry entry;
+        memcpy(&entry, data + offset, sizeof(entry));
+        size_t strings_length = payload_size(&entry);
+        if (strings_length > size - offset - sizeof(entry))
+        {
+            break; // Torn tail
+        }
+
+        char *strings = data + offset + sizeof(entry);
+        if (entry_checksum(&entry, strings) != entry.checksum
+            || !apply_entry(catalog, &entry, strings))
+        {
+            fprintf(stderr, "Journal %s: stopping replay at byte %zu\n", filename, offset);
+            break;
+        }
+        offset += sizeof(entry) + strings_length;
+        applied++;
+    }
+    free(data);
+
+    if (offset < size)
+    {
+        if (truncate(filename, (off_t)offset) != 0)
+        {
+            perror("Could not truncate journal");
+        }
+    }
+
+    return applied;
+}
@@ -0,0 +1,339 @@
+/**
+ * @file list_widget.c
+ * @brief Virtualized list widget with row-level diff rendering.
+ *
+ * The window is laid out like the original movie list: the title on the top
+ * border, a header line, the rows, and the key help on the bottom border.
+ * Everything except the rows is drawn only when `frame_stale` is set. Each row
+ * keeps the text it was last drawn with in `lines`; a render compares the new
+ * text against it and touches the window only where they differ, plus the rows
+ * whose highlight state changed.
+ *
+ * The caller owns the input loop and tells the widget what happened:
+ * list_widget_move()/list_widget_select() for navigation, list_widget_invalidate()
+ * when the records changed, and list_widget_touch() when something else (a
+ * popup, a prompt on stdscr) painted over the window.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include "list_widget.h"
+#include "ui.h"
+
+#define LIST_MAX_WIDTH 70
+#define LIST_TOP 1          // Screen row of the top border
+#define LIST_CHROME 4       // Top border, header, spacer and bottom border
+#define LIST_STATUS_ROWS 1  // Bottom screen line kept free for status messages
+
+#define ROW_TEXT(list, row) ((list)->lines + (size_t)(row) * (size_t)(list)->width)
+
+
+/**
+ * @brief (Re)creates the window and the row caches for the current terminal size.
+ *
+ * @param list The widget.
+ * @return false if the window or the caches could not be allocated.
+ */
+
+bool list_widget_resize(ListWidget *list)
+{
+    int width = COLS < LIST_MAX_WIDTH ? COLS : LIST_MAX_WIDTH;
+    int height = LINES - LIST_TOP - LIST_STATUS_ROWS;
+    if (height < LIST_CHROME + 1) height = LIST_CHROME + 1;
+    if (width < 20) width = 20;
+
+    int page_size = height - LIST_CHROME;
+    void **rows = (void**)malloc((size_t)page_size * sizeof(void*));
+    char *lines = (char*)malloc((size_t)page_size * (size_t)width);
+    WINDOW *win = newwin(height, width, LIST_TOP, (COLS - width) / 2 > 0 ? (COLS - width) / 2 : 0);
+    if (!rows || !lines || !win)
+    {
+        free(rows);
+        free(lines);
+        if (win) delwin(win);
+        return false;
+    }
+    keypad(win, TRUE);
+
+    if (list->win)
+    {
+        delwin(list->win);
+        erase();                 // Clear what the old, larger window left behind
+        wnoutrefresh(stdscr);
+    }
+    free(list->rows);
+    free(list->lines);
+
+    list->win = win;
+    list->width = width;
+    list->page_size = page_size;
+    list->rows = rows;
+    list->lines = lines;
+    list->row_count = 0;
+    for (int i = 0; i < page_size; ++i)
+    {
+        ROW_TEXT(list, i)[0] = '\0';
+    }
+    list->drawn_highlight = -1;
+    list->page_stale = true;
+    list->frame_stale = true;
+    list_widget_set_total(list, list->total); // Re-clamp the scroll position
+    return true;
+}
+
+
+/**
+ * @brief Creates a list widget sized to the terminal.
+ *
+ * @param list The widget to initialize.
+ * @param title Text on the top border.
+ * @param header Column header line.
+ * @param footer Key help on the bottom border.
+ * @param fetch Provides the records of a page.
+ * @param format Provides the text of a row.
+ * @param context Passed to `fetch` and `format`.
+ * @return false if the window could not be created.
+ */
+
+bool list_widget_create(ListWidget *list, const char *title, const char *header, const char *footer,
+                        ListFetchFn fetch, ListFormatFn format, void *context)
+{
+    memset(list, 0, sizeof(*list));
+    list->title = title;
+    list->header = header;
+    list->footer = footer;
+    list->fetch = fetch;
+    list->format = format;
+    list->context = context;
+    return list_widget_resize(list);
+}
+
+
+/**
+ * @brief Deletes the window and the caches.
+ */
+
+void list_widget_destroy(ListWidget *list)
+{
+    if (list->win) delwin(list->win);
+    free(list->rows);
+    free(list->lines);
+    list->win = NULL;
+    list->rows = NULL;
+    list->lines = NULL;
+}
+
+
+/**
+ * @brief Sets the number of rows in the list and keeps the highlight inside it.
+ */
+
+void list_widget_set_total(ListWidget *list, int total)
+{
+    list->total = total > 0 ? total : 0;
+    list_widget_select(list, list->highlight);
+    list->page_stale = true;
+}
+
+
+/**
+ * @brief Sets the label shown at the right of the top border.
+ */
+
+void list_widget_set_tag(ListWidget *list, const char *tag)
+{
+    if (strncmp(list->tag, tag, sizeof(list->tag) - 1) == 0) return;
+    strncpy(list->tag, tag, sizeof(list->tag) - 1);
+    list->tag[sizeof(list->tag) - 1] = '\0';
+    list->frame_stale = true;
+}
+
+
+/**
+ * @brief Replaces the key help on the bottom border.
+ *
+ * The text is not copied; it must stay valid until the next call. Passing the
+ * same buffer again after changing its contents redraws it.
+ */
+
+void list_widget_set_footer(ListWidget *list, const char *footer)
+{
+    list->footer = footer;
+    list->frame_stale = true;
+}
+
+
+/**
+ * @brief Highlights the row at `position`, scrolling only as far as needed to show it.
+ */
+
+void list_widget_select(ListWidget *list, int position)
+{
+    if (position >= list->total) position = list->total - 1;
+    if (position < 0) position = 0;
+    list->highlight = position;
+
+    int top = list->top;
+    if (position < top) top = position;
+    if (position >= top + list->page_size) top = position - list->page_size + 1;
+    if (top > list->total - list->page_size) top = list->total - list->page_size;
+    if (top < 0) top = 0;
+
+    if (top != list->top)
+    {
+        list->top = top;
+        list->page_stale = true;
+    }
+}
+
+
+/**
+ * @brief Moves the highlight by `delta` rows (negative is up).
+ */
+
+void list_widget_move(ListWidget *list, int delta)
+{
+    list_widget_select(list, list->highlight + delta);
+}
+
+
+/**
+ * @brief Returns the highlighted record, or NULL for an empty list.
+ *
+ * Valid after list_widget_render().
+ */
+
+void* list_widget_selected(const ListWidget *list)
+{
+    int row = list->highlight - list->top;
+    if (row < 0 || row >= list->row_count) return NULL;
+    return list->rows[row];
+}
+
+
+/**
+ * @brief Marks the records as changed; the next render fetches and diffs the page.
+ */
+
+void list_widget_invalidate(ListWidget *list)
+{
+    list->page_stale = true;
+}
+
+
+/**
+ * @brief Schedules a full repaint after something else drew over the window.
+ *
+ * The window's own contents are still correct, so nothing is re-fetched; curses
+ * is just told to send all of it again.
+ */
+
+void list_widget_touch(ListWidget *list)
+{
+    touchwin(list->win);
+}
+
+
+/**
+ * @brief Draws the border, title, tag, header and footer.
+ */
+
+static void draw_frame(ListWidget *list)
+{
+    WINDOW *win = list->win;
+    int height = list->page_size + LIST_CHROME;
+
+    box(win, 0, 0);
+    mvwprintw(win, 0, (list->width - (int)strlen(list->title)) / 2 - 1, " %s ", list->title);
+    if (list->tag[0] && list->width > 24)
+    {
+        mvwprintw(win, 0, list->width - 18, " %-13.13s ", list->tag);
+    }
+    wattron(win, A_BOLD | COLOR_PAIR(UI_PAIR_HEADER));
+    mvwprintw(win, 1, 1, "%-*.*s", list->width - 2, list->width - 2, list->header);
+    wattroff(win, A_BOLD | COLOR_PAIR(UI_PAIR_HEADER));
+    mvwprintw(win, height - 1, 2, "%.*s", list->width - 4, list->footer);
+}
+
+
+/**
+ * @brief Paints one screen row from the cache.
+ */
+
+static void draw_row(ListWidget *list, int row)
+{
+    bool highlighted = list->top + row == list->highlight && row < list->row_count;
+    chtype attributes = COLOR_PAIR(UI_PAIR_ROW) | (highlighted ? A_REVERSE : 0);
+
+    wattron(list->win, attributes);
+    mvwprintw(list->win, row + 2, 1, "%-*.*s", list->width - 2, list->width - 2, ROW_TEXT(list, row));
+    wattroff(list->win, attributes);
+}
+
+
+/**
+ * @brief Brings the screen up to date, repainting only the rows that changed.
+ *
+ * @param list The widget.
+ * @return false if the page could not be fetched.
+ */
+
+bool list_widget_render(ListWidget *list)
+{
+    bool ok = true;
+
+    if (list->frame_stale)
+    {
+        draw_frame(list);
+        list->frame_stale = false;
+    }
+
+    if (list->page_stale)
+    {
+        int count = list->total > 0 ? list->fetch(list->context, list->top, list->rows, list->page_size) : 0;
+        if (count < 0)
+        {
+            count = 0;
+            ok = false;
+        }
+        list->row_count = count;
+
+        char text[LIST_MAX_WIDTH];
+        for (int row = 0; row < list->page_size; ++row)
+        {
+            text[0] = '\0';
+            if (row < count)
+            {
+                list->format(list->context, list->rows[row], list->top + row, text, (size_t)list->width - 1);
+            }
+            if (strcmp(text, ROW_TEXT(list, row)) != 0)
+            {
+                strcpy(ROW_TEXT(list, row), text);
+                draw_row(list, row);
+                if (list->drawn_highlight == row) list->drawn_highlight = -2; // Redrawn, state unknown
+            }
+        }
+        list->page_stale = false;
+    }
+
+    // Move the highlight bar: repaint the row losing it and the row gaining it
+    int row = list->highlight - list->top;
+    if (row >= list->row_count) row = -1;
+    if (row != list->drawn_highlight)
+    {
+        if (list->drawn_highlight >= 0 && list->drawn_highlight < list->page_size)
+        {
+            draw_row(list, list->drawn_highlight);
+        }
+        if (row >= 0)
+        {
+            draw_row(list, row);
+        }
+        list->drawn_highlight = row;
+    }
+
+    wnoutrefresh(list->win);
+    doupdate();
+    return ok;
+}
@@ -7,13 +7,17 @@
  * movie and TV series entries. The UI is managed through curses library calls for a
  * terminal-based interface.
  *
- * It also includes utility functions such as `resize_entries` for dynamic array resizing,
- * `save_movies_to_file` for persisting movie data to a file, and `load_movies_from_file`
- * for initializing the program state from a file.
+ * Movies are held in a MovieCatalog (catalog.c), which owns their memory. Persisting
+ * movie data (`save_movies_to_file`, `load_movies_from_file`) lives in storage.c.
  *
  * The program utilizes a menu-driven interface to navigate through different functionalities:
- * adding new entries, displaying lists of entries, and exiting the program while ensuring
- * all changes are saved.
+ * adding new entries, displaying lists of entries, and exiting the program. Every change is
+ * appended to a journal as it is made, so nothing needs to be rewritten on exit. Snapshots
+ * and the TV series file are written by a background thread (autosave.c), so the menu
+ * never waits on the disk. Several users can share the catalog, each with their own
+ * ratings file (profile.c); only the chosen user's is read.
+ * Recommendations come from an item-item index over everyone's ratings (recommend.c).
+ * Given command line options, the program runs them headless instead (batch.c).
  *
  * @note All UI-related functionalities are assumed to be implemented in separate modules
  * referenced via "ui.h".
@@ -34,12 +38,73 @@
 #include <time.h>
 #include "movie.h"
 #include "tv_series.h"
+#include "tv_catalog.h"
 #include "ui.h"
+#include "catalog.h"
+#include "storage.h"
+#include "notify.h"
+#include "batch.h"
+#include "name_table.h"
+#include "perf.h"
+#include "autosave.h"
+#include "input.h"
+#include "profile.h"
+#include "recommend.h"
+#include "history.h"
+#include "paged_catalog.h"
+
+#define MOVIES_TEXT_FILE "movies.txt"         // Human-readable import/export copy
+#define MOVIES_SNAPSHOT_FILE "movies.bin"     // Binary snapshot used for fast startup
+#define MOVIES_JOURNAL_FILE "movies.journal"  // Edits made since the snapshot
+#define TV_SERIES_TEXT_FILE "tv_series.txt"   // TV series, rewritten whenever they change
+#define PERF_DUMP_FILE "perf.json"            // Perf counters, written on exit in -DENABLE_PERF=ON builds
 
-/*FUNCTION PROTOTYPES*/
-void save_movies_to_file(const char *filename, Movie **movies, int count);
-void load_movies_from_file(const char *filename, Movie ***movies, int *count, int *capacity);
-void* resize_entries(void** entries, int* capacity); 
+
+/**
+ * @brief Runs the callbacks of finished autosaves; the input loop's idle hook.
+ */
+
+static void service_autosave(void *context)
+{
+    autosave_poll(context);
+}
+
+
+/**
+ * @brief Browses a snapshot without loading it into memory: `--paged [FILE [CACHE_MB]]`.
+ *
+ * @return The exit status.
+ */
+
+static int run_paged(int argc, char *argv[])
+{
+    const char *filename = argc > 2 ? argv[2] : MOVIES_SNAPSHOT_FILE;
+    size_t budget = 0;
+    if (argc > 3)
+    {
+        char *end;
+        unsigned long megabytes = strtoul(argv[3], &end, 10);
+        if (*end != '\0' || megabytes == 0)
+        {
+            notify(NOTIFY_ERROR, "The cache size must be a number of megabytes, not \"%s\".", argv[3]);
+            return 1;
+        }
+        budget = (size_t)megabytes << 20;
+    }
+
+    PagedCatalog paged;
+    PagedError err = paged_catalog_open(&paged, filename, budget);
+    if (err != PAGED_SUCCESS)
+    {
+        notify(NOTIFY_ERROR, err == PAGED_ERROR_FORMAT ? "%s is not a movie snapshot." : "Could not open %s.", filename);
+        return 1;
+    }
+    init_ui();
+    display_paged_movie_list_ui(&paged, filename);
+    end_ui();
+    paged_catalog_close(&paged);
+    return 0;
+}
 
 
 /**
@@ -52,27 +117,66 @@ void* resize_entries(void** entries, int* capacity);
  * the program's execution. It persists movie data across sessions by saving to and loading from
  * a file. The user interface is command-line based, potentially using ncurses for windowing.
  *
+ * When any arguments are given the program runs in batch mode instead (see batch.c):
+ * the options are carried out without starting curses and the collection is saved once.
+ *
+ * `--paged` as the first argument opens a snapshot for read-only browsing
+ * through a bounded page cache instead (see paged_catalog.c), for catalogs too
+ * large to load.
+ *
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments; see `run_batch()`.
  * @return int The exit status of the program. Returns 0 on successful completion, or 1 if an
- *             error occurred during initialization.
+ *             error occurred during initialization or a batch option failed.
  */
 
-int main() 
+int main(int argc, char *argv[]) 
 {
-    int movie_capacity = 10, tv_series_capacity = 10;
-    int movie_count = 0, tv_series_count = 0;
-    Movie** movies = (Movie**) malloc(movie_capacity * sizeof(Movie*));
+    MovieCatalog catalog;
+    TvCatalog tv_catalog;
 
-    ///NOTE: Un-comment the following line when implemented 
-    //TV_Series** tv_series = (TV_Series**) malloc(tv_series_capacity * sizeof(TV_Series*));
-
-    if (!movies) // ||!tvseries
+    if (argc > 1 && strcmp(argv[1], "--paged") == 0)
+    {
+        return run_paged(argc, argv);
+    }
+    if (catalog_init(&catalog, 10) != MOVIE_SUCCESS)
     {
         ui_print_error("Failed to allocate memory.");
         return 1;
     }
+    if (tv_catalog_init(&tv_catalog, 10) != TV_SERIES_SUCCESS)
+    {
+        catalog_destroy(&catalog);
+        ui_print_error("Failed to allocate memory.");
+        return 1;
+    }
 
-   load_movies_from_file("movies.txt", &movies, &movie_count, &movie_capacity);
-   bool data_changed = false; // flag to track if we have unsaved changes
+   CatalogStore store;
+   store_init(&store, MOVIES_TEXT_FILE, MOVIES_SNAPSHOT_FILE, MOVIES_JOURNAL_FILE);
+   if (argc > 1)
+   {
+       // Batch mode: no curses, one save at the end (see batch.c)
+       int status = run_batch(&store, &catalog, argc, argv);
+       perf_dump(PERF_DUMP_FILE);
+       catalog_destroy(&catalog);
+       tv_catalog_destroy(&tv_catalog);
+       name_table_destroy();
+       return status;
+   }
+   store_open(&store, &catalog);
+   load_series_from_file(TV_SERIES_TEXT_FILE, &tv_catalog);
+   Autosave autosave;
+   autosave_start(&autosave);
+   Profile profile; // No user until one is chosen; their ratings are read only then
+   profile_init(&profile);
+   RecommendIndex recommend; // Built on the first request for recommendations
+   recommend_init(&recommend);
+   catalog.recommend = &recommend; // Attached after loading, which would only mark it stale
+   History history; // Undo and redo of this session's edits; replaying the journal is not one
+   if (history_init(&history, &catalog, HISTORY_CAPACITY)) catalog.history = &history;
+   else notify(NOTIFY_WARNING, "Not enough memory to keep an undo history.");
+   input_set_idle(service_autosave, &autosave); // Report finished saves while a screen waits for keys
+   init_ui(); // ncurses is started once and shared by every screen
 
    MenuOption choice;
    do 
@@ -81,15 +185,10 @@ int main()
     switch (choice) 
     {
         case MENU_MOVIE_ADD:
-            if (movie_count == movie_capacity) 
+            if (catalog_reserve(&catalog, 1) != MOVIE_SUCCESS) 
             {
-                Movie** temp = (Movie**) resize_entries((void**)movies, &movie_capacity);
-                if (!temp)
-                {
-                    show_popup("ERROR", "Failed to resize movie array.\n");
-                    break; // Break out of the switch case if resize fails
-                }
-                movies = temp;
+                notify(NOTIFY_ERROR, "Failed to resize movie array.");
+                break; // Break out of the switch case if resize fails
             }
             
             //Define dimensions and starting position for the new window
@@ -157,201 +256,109 @@ int main()
             noecho();
             delwin(input_win);
 
-            // Look for the first available NULL position
-            int insert_index = -1;
-            for (int i = 0; i < movie_count; i++) 
+            // Create the movie, the catalog appends and journals it
+            Movie* new_movie = create_movie(&catalog, title, director, year);
+            if (!new_movie) 
             {
-                if (movies[i] == NULL) 
-                {
-                    insert_index = i;
-                    break;
-                }
-            }
-
-            // Create the movie and add it to the list
-            // 1.Reuse the first available spot
-            // 2.If there's no gap, add to the end of the array
-            Movie* new_movie = create_movie(title, director, year);
-            if (new_movie) 
-            {
-                if (insert_index != -1) 
-                {
-                    movies[insert_index] = new_movie;
-                } 
-                else 
-                {
-                    movies[movie_count++] = new_movie;
-                }
-            } 
-            else 
-            {
-                show_popup("ERROR", "Failed to create a new movie entry.\n");
+                notify(NOTIFY_ERROR, "Failed to create a new movie entry.");
                 ///NOTE:Add Additional Error Handling (if needed!)
             }
-            data_changed = true;
         break;
         case MENU_MOVIE_DISPLAY:
-            if(movie_count == 0) 
+            if(catalog.movies.count == 0) 
             {
-                show_popup("WARNING","No movies to display!\n");
-                clear();
-                refresh(); 
+                notify(NOTIFY_WARNING, "No movies to display!");
             } 
             else 
             {
-                display_movie_list_ui(movies, movie_count); 
+                display_movie_list_ui(&catalog, &profile); 
             }
-            data_changed = true;
         break;
 
 
         case MENU_TV_SERIES_ADD:
-            ///TODO:
+            add_tv_series_ui(&tv_catalog);
             break;
 
         case MENU_TV_SERIES_DISPLAY:
-            ///TODO:
+            if (tv_catalog.series.count == 0)
+            {
+                notify(NOTIFY_WARNING, "No TV series to display!");
+            }
+            else
+            {
+                display_tv_series_list_ui(&tv_catalog);
+            }
             break;
 
-        case MENU_EXIT:
-            if (data_changed) 
+        case MENU_STATS:
+            display_stats_ui(&catalog, &tv_catalog);
+            break;
+
+        case MENU_SWITCH_USER:
+        {
+            char name[PROFILE_NAME_SIZE];
+            read_user_name_ui(profile.name, name, (int)sizeof(name));
+            if (strcmp(name, profile.name) == 0) break;
+
+            // The outgoing user's ratings are captured before their table is released
+            if (!save_profile_in_background(&profile, &autosave))
             {
-                save_movies_to_file("movies.txt", movies, movie_count);
+                notify(NOTIFY_ERROR, "Failed to save the ratings of %s.", profile.name);
+                break;
             }
+            if (name[0] == '\0')
+            {
+                profile_close(&profile);
+                notify(NOTIFY_INFO, "Showing the shared ratings.");
+                break;
+            }
+            profile_wait_saved(name, &autosave); // Back to a user whose ratings are still being written
+            ProfileError err = profile_open(&profile, name);
+            if (err == PROFILE_ERROR_NAME)
+                notify(NOTIFY_WARNING, "User names may only use letters, digits, '-' and '_'.");
+            else if (err != PROFILE_SUCCESS)
+                notify(NOTIFY_ERROR, "Could not read the ratings of %s.", name);
+            else
+                notify(NOTIFY_INFO, "Now rating as %s (%u rated).", profile.name, profile.rated);
+            break;
+        }
+
+        case MENU_EXIT:
         break;
 
         default:
             ui_print_error("Invalid choice, please try again.");
         }
-    } while (choice != MENU_EXIT);
-    save_movies_to_file("movies.txt", movies, movie_count);
-
-    ///NOTE: FREE ALLOCATED MEMORY AT THE END OF SESSION
-    for (int i = 0; i < movie_count; ++i) 
-    {
-        free(movies[i]);
-    }
-    // for (int i = 0; i < tv_series_count; ++i) 
-    // {
-    //     free(&tv_series[i]);
-    // }
-    free(movies);
-    //free(tv_series);
-    show_popup("WARNING","Exiting Program...\n");
-
-    return 0;
-}
-
-
-/**
- * @brief Resizes the array of entries to double its current capacity.
- *
- * This function takes a pointer to an array and its current capacity and reallocates
- * the array to double its size, which is a common operation in dynamic array management
- * to accommodate more entries as they are added.
- *
- * @param[in,out] entries A pointer to the array of pointers that needs resizing.
- * @param[in,out] capacity A pointer to the current capacity of the array. This value
- *                         will be modified to reflect the new capacity after resizing.
- * @return A pointer to the resized array, or NULL if the reallocation fails.
- */
-
-void* resize_entries(void** entries, int* capacity) 
-{
-    *capacity *= 2;
-    return realloc(entries, (*capacity) * sizeof(void*));
-}
-
-
-/**
- * @brief Saves the array of movies to a specified file.
- *
- * Writes the movie details to a file with each movie's attributes separated by a pipe ('|')
- * character and each movie entry on a new line. The function handles the file opening,
- * writing to the file, and closing the file once writing is complete.
- *
- * @param[in] filename The name of the file to which the movie details will be saved.
- * @param[in] movies A pointer to the array of Movie pointers that will be saved to the file.
- * @param[in] count The number of movies to be saved from the array.
- */
-
-void save_movies_to_file(const char *filename, Movie **movies, int count) 
-{
-    FILE *file = fopen(filename, "w"); // Open the file for writing
-    if (file == NULL) 
-    {
-        perror("Error opening file for writing");
-        return;
-    }
-
-    for (int i = 0; i < count; ++i) 
-    {
-        if (movies[i] != NULL) 
+        // Saves are captured here and written by the autosave thread
+        autosave_poll(&autosave);
+        store_maintain(&store, &catalog, &autosave); // Fold the journal into a new snapshot
+        if (!save_series_in_background(TV_SERIES_TEXT_FILE, &tv_catalog, &autosave))
         {
-            // Save the movie details in the format: title|director|year|rating\n
-            fprintf(file, "%s|%s|%d|%.1f\n", movies[i]->title, movies[i]->director, movies[i]->year, movies[i]->rating);
+            notify(NOTIFY_ERROR, "Failed to save the TV series to %s.", TV_SERIES_TEXT_FILE);
         }
-    }
-
-    fclose(file); // Close the file
-}
-
-
-/**
- * @brief Loads movie details from a specified file into an array of Movie structures.
- *
- * Reads movie details from a file with each movie's attributes expected to be separated by
- * a pipe ('|') character. Each line corresponds to one movie. If the array is full, it is
- * resized by calling the `resize_entries` function to double its capacity. The function
- * handles opening the file, reading from it, and closing it after loading the entries.
- *
- * @param[in] filename The name of the file from which the movie details will be read.
- * @param[out] movies A double pointer to the array of Movie pointers where loaded movies
- *                    will be stored.
- * @param[out] count A pointer to an integer that will hold the number of movies loaded.
- * @param[in,out] capacity A pointer to the current capacity of the movies array. It may be
- *                         modified if the array needs to be resized.
- */
-
-void load_movies_from_file(const char *filename, Movie ***movies, int *count, int *capacity) 
-{
-    FILE *file = fopen(filename, "r");
-    if (!file) 
-    {
-        perror("Could not open file for reading");
-        return;
-    }
-
-    char line[256];
-    while (fgets(line, sizeof(line), file)) 
-    {
-        //Trim '\n' char
-        line[strcspn(line, "\n")] = 0;
-
-        //Resize array in needed!
-        if (*count == *capacity) 
+        if (!save_profile_in_background(&profile, &autosave))
         {
-            *movies = (Movie**)resize_entries((void**)*movies, capacity);
+            notify(NOTIFY_ERROR, "Failed to save the ratings of %s.", profile.name);
         }
+    } while (choice != MENU_EXIT);
+    end_ui();
+    input_set_idle(NULL, NULL);
+    autosave_stop(&autosave);      // Waits for the saves still being written
+    store_close(&store, &catalog); // Every edit is already journaled, unless journaling failed
+    if (!perf_dump(PERF_DUMP_FILE)) notify(NOTIFY_WARNING, "Could not write %s.", PERF_DUMP_FILE);
 
-        char *title = strtok(line, "|");
-        char *director = strtok(NULL, "|");
-        char *year_str = strtok(NULL, "|");
-        if (title && director && year_str) 
-        {
-            int year = atoi(year_str);
-
-            Movie *movie = create_movie(title, director, year);
-            if (movie) 
-            {
-                (*movies)[(*count)++] = movie;
-            }
-        } 
-        else 
-        {
-            fprintf(stderr, "Error parsing line: %s\n", line);
-        }
-    }
+    ///NOTE: FREE ALLOCATED MEMORY AT THE END OF SESSION
+    profile_close(&profile);
+    catalog.recommend = NULL;
+    recommend_destroy(&recommend);
+    catalog.history = NULL;
+    history_destroy(&history);
+    catalog_destroy(&catalog); // Releases every movie and string in bulk
+    tv_catalog_destroy(&tv_catalog);
+    name_table_destroy();      // Directors and creators are shared across collections
+    notify(NOTIFY_INFO, "Exiting Program..."); // The UI has ended, so this goes to stderr
 
-    fclose(file);
+    return 0;
 }
+
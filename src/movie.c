@@ -5,8 +5,9 @@
  * This source file contains the implementation of functions declared in movie.h.
  * It provides detailed logic for creating, updating, displaying, rating, and
  * deleting movie records. It includes robust error checking and user interaction
- * via console and pop-up dialogs using the ncurses library. The functions
- * manage dynamic memory allocation and handle input/output operations for
+ * via console and pop-up dialogs using the ncurses library. Records and their
+ * strings are allocated from the owning MovieCatalog (see catalog.c) rather than
+ * with individual malloc calls. The functions handle input/output operations for
  * movie data, ensuring a seamless user experience in movie management tasks.
  * Error handling is consistently implemented, with informative pop-up messages
  * for the user in cases of incorrect or invalid operations.
@@ -14,25 +15,37 @@
 /*LIBRARY INCLUSIONS*/
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <ncurses.h>
 #include "movie.h"
+#include "catalog.h"
+#include "sort.h"
 #include "popup.h"
+#include "notify.h"
+#include "name_table.h"
+#include "perf.h"
+#include "input.h"
+#include "recommend.h"
+#include "history.h"
 
 
 /**
  * @function create_movie
  * @brief Creates a new movie record.
  *
- * This function dynamically allocates memory for a new movie structure and
+ * This function allocates a new movie structure from the catalog's slab and
  * initializes it with the provided title, director, and year. It performs
  * necessary validations to ensure that none of the input parameters are NULL
  * and that the year is a reasonable value (greater than 1800). In case of
  * successful creation, a pointer to the new movie structure is returned.
  *
- * Memory allocation is performed for the movie structure itself and the strings
- * for the title and director. If any memory allocation fails, the function
- * cleans up any allocated memory before returning NULL to prevent leaks.
+ * The title and director are copied into the catalog's string arena, so the
+ * record costs no malloc call of its own and is released together with the
+ * catalog. The new movie is appended to the catalog, journaled and recorded in
+ * an attached history so it can be undone. If any
+ * allocation fails, the structure is returned to the slab before NULL is returned.
  *
+ * @param catalog The catalog that owns the new record's memory.
  * @param title Pointer to a string representing the movie's title.
  * @param director Pointer to a string representing the movie's director.
  * @param year Integer representing the year the movie was released.
@@ -40,60 +53,323 @@
  *         an error occurred during creation.
  */
 
-Movie* create_movie(const char* title, const char* director, int year) 
+Movie* create_movie(MovieCatalog* catalog, const char* title, const char* director, int year) 
 {
-    if (!title || !director || year <= 1800) 
+    if (!catalog || !title || !director || year <= 1800) 
     {
         return NULL; // Updated check to be consistent with main function
     }
 
-    Movie* new_movie = (Movie*)malloc(sizeof(Movie));
+    PERF_BEGIN(span);
+    Movie* new_movie = (Movie*)collection_alloc(&catalog->movies);
     if (!new_movie) 
     {
-        show_popup("Warning", "New Movie Allocation Failed.\n");
+        notify(NOTIFY_WARNING, "New Movie Allocation Failed.");
         return NULL;
     }
 
-    new_movie->title = strdup(title);
+    new_movie->title = string_arena_strdup(&catalog->movies.strings, title);
     if (!new_movie->title) 
-    { // Check strdup success for title
-        free(new_movie); // Ensure no memory leak
-        show_popup("Warning", "Memory Allocation for Title Failed.\n");
+    { // Check arena allocation for title
+        collection_free(&catalog->movies, new_movie); // Give the slot back
+        notify(NOTIFY_WARNING, "Memory Allocation for Title Failed.");
         return NULL;
     }
 
-    new_movie->director = strdup(director);
-    if (!new_movie->director) { // Check strdup success for director
-        free(new_movie->title); // Ensure no memory leak
-        free(new_movie); // Ensure no memory leak
-        show_popup("Warning", "Memory Allocation for Director Failed.\n");
+    new_movie->director = name_intern(director); // Shared with every record by this director
+    if (!new_movie->director) 
+    { // Check name table allocation for director
+        collection_free(&catalog->movies, new_movie); // Give the slot back
+        notify(NOTIFY_WARNING, "Memory Allocation for Director Failed.");
         return NULL;
     }
 
     new_movie->year = year;
+    new_movie->rating = 0.0f;
 
+    if (catalog_append(catalog, new_movie) != MOVIE_SUCCESS)
+    {
+        collection_free(&catalog->movies, new_movie);
+        notify(NOTIFY_WARNING, "Failed to resize movie array.");
+        return NULL;
+    }
+    journal_record_add(catalog->journal, new_movie);
+    history_record_add(catalog->history, new_movie);
+
+    PERF_END(span, PERF_CREATE);
     return new_movie;
 }
 
 
-///FIXME:IMPLEMENT THIS!
-MovieError update_movie(Movie* movie, const char* new_title, const char* new_director, int new_year) 
+/**
+ * @function create_movie_borrowed
+ * @brief Creates a movie record whose strings already belong to the catalog.
+ *
+ * Used by the file loaders: the title lives in a buffer that has been adopted by
+ * the catalog's string arena, so only the structure is allocated; the director is
+ * looked up in the shared name table, which copies it only the first time. The
+ * movie is appended to the catalog but not journaled, since it is already on disk.
+ * Validation is the same as `create_movie`.
+ *
+ * @param catalog The catalog that owns the new record's memory.
+ * @param title Pointer to the movie's title inside catalog-owned memory.
+ * @param director The movie's director.
+ * @param year Integer representing the year the movie was released.
+ * @param rating The movie's stored rating.
+ * @return Movie* A pointer to the newly created movie structure, or NULL if
+ *         an error occurred during creation.
+ */
+
+Movie* create_movie_borrowed(MovieCatalog* catalog, char* title, const char* director, int year, float rating)
+{
+    if (!catalog || !title || !director || year <= 1800)
+    {
+        return NULL;
+    }
+    director = name_intern(director);
+    if (!director)
+    {
+        notify(NOTIFY_WARNING, "Memory Allocation for Director Failed.");
+        return NULL;
+    }
+
+    Movie* new_movie = (Movie*)collection_alloc(&catalog->movies);
+    if (!new_movie)
+    {
+        notify(NOTIFY_WARNING, "New Movie Allocation Failed.");
+        return NULL;
+    }
+
+    new_movie->title = title;
+    new_movie->director = director;
+    new_movie->year = year;
+    new_movie->rating = rating;
+
+    if (catalog_append(catalog, new_movie) != MOVIE_SUCCESS)
+    {
+        collection_free(&catalog->movies, new_movie);
+        return NULL;
+    }
+
+    return new_movie;
+}
+
+
+/**
+ * @function update_movie
+ * @brief Replaces the title, director and year of a movie.
+ *
+ * A title that actually changes is copied into the catalog's string arena, and
+ * the director is looked up in the shared name table, which only allocates for a
+ * name it has not seen. The previous strings are left untouched (arena memory is
+ * reclaimed when the catalog is destroyed), so a string is never modified once it
+ * has been handed out.
+ * The movie is re-keyed in the catalog's title index and sorted views.
+ *
+ * @param catalog The catalog that owns the record.
+ * @param movie The movie to update.
+ * @param new_title The new title.
+ * @param new_director The new director.
+ * @param new_year The new release year, after 1800 as for `create_movie()`.
+ * @return MOVIE_SUCCESS, MOVIE_ERROR_NULL_POINTER on invalid input, or
+ *         MOVIE_ERROR_MEMORY_ALLOCATION if a string could not be copied (the movie is unchanged).
+ */
+
+MovieError update_movie(MovieCatalog* catalog, Movie* movie, const char* new_title, const char* new_director, int new_year) 
 {
-    if (!movie || !new_title || !new_director || new_year <= 0) 
+    if (!catalog || !movie || !new_title || !new_director || new_year <= 1800) 
     {
         return MOVIE_ERROR_NULL_POINTER; // Check for invalid input
     }
 
-    free(movie->title);
-    free(movie->director);
+    PERF_BEGIN(span);
+    char *title = movie->title;
+    const char *director = name_intern(new_director);
+    if (strcmp(title, new_title) != 0)
+    {
+        title = string_arena_strdup(&catalog->movies.strings, new_title);
+    }
+    if (!title || !director)
+    {
+        return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
 
-    movie->title = strdup(new_title);
-    movie->director = strdup(new_director);
+    // Re-key the title index and the sorted views under the new values
+    history_record_update(catalog->history, movie); // The strings it keeps stay valid, see above
+    catalog_unlink(catalog, movie);
+    movie->title = title;
+    movie->director = director;
     movie->year = new_year;
+    catalog_link(catalog, movie);
+    journal_record_update(catalog->journal, movie);
+    recommend_invalidate(catalog->recommend); // The movie's key and director changed
 
+    PERF_END(span, PERF_UPDATE);
     return MOVIE_SUCCESS; // Successfully updated
 }
 
+
+/**
+ * @function edit_movies
+ * @brief Applies one change to many movies as a single transaction.
+ *
+ * Sets the fields named in `edit->fields` on every movie, for instance the
+ * rating of all the selected movies or the corrected spelling of a director.
+ * The new strings are copied once for the whole batch, so either every movie
+ * is changed or, if that copy fails, none is.
+ *
+ * The batch goes through the indexes once rather than once per movie (see
+ * `catalog_unlink_batch()`): an index mostly re-keyed by it is rebuilt on its
+ * next use instead of updated movie by movie. The journal receives a single
+ * entry for the whole batch, and an attached recommendation index is marked
+ * stale once, or, for a small batch that only changes ratings, refreshed
+ * movie by movie as `set_movie_rating()` does. An attached history keeps the
+ * previous values of the changed fields, so the batch can be undone as a whole.
+ *
+ * @param catalog The catalog that owns the records.
+ * @param movies The movies to change, each at most once.
+ * @param count Number of movies.
+ * @param edit The change. A year must be after 1800, as for `create_movie()`.
+ * @return MOVIE_SUCCESS, MOVIE_ERROR_NULL_POINTER on invalid input, or
+ *         MOVIE_ERROR_MEMORY_ALLOCATION if a string could not be copied (no movie is changed).
+ */
+
+MovieError edit_movies(MovieCatalog *catalog, Movie *const *movies, int count, const MovieEdit *edit)
+{
+    if (!catalog || !edit || count < 0 || (count > 0 && !movies)
+        || ((edit->fields & MOVIE_EDIT_TITLE) && !edit->title)
+        || ((edit->fields & MOVIE_EDIT_DIRECTOR) && !edit->director)
+        || ((edit->fields & MOVIE_EDIT_YEAR) && edit->year <= 1800)) // As create_movie() and the snapshot loaders
+    {
+        return MOVIE_ERROR_NULL_POINTER;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        if (!movies[i]) return MOVIE_ERROR_NULL_POINTER;
+    }
+    if (count == 0 || edit->fields == 0) return MOVIE_SUCCESS;
+
+    PERF_BEGIN(span);
+    char *title = NULL;
+    const char *director = NULL;
+    if (edit->fields & MOVIE_EDIT_TITLE)
+    {
+        title = string_arena_strdup(&catalog->movies.strings, edit->title); // Shared by the batch, never modified
+        if (!title) return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
+    if (edit->fields & MOVIE_EDIT_DIRECTOR)
+    {
+        director = name_intern(edit->director);
+        if (!director) return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
+
+    history_record_edit(catalog->history, movies, count, edit->fields);
+    catalog_unlink_batch(catalog, movies, count);
+    for (int i = 0; i < count; ++i)
+    {
+        if (title) movies[i]->title = title;
+        if (director) movies[i]->director = director;
+        if (edit->fields & MOVIE_EDIT_YEAR) movies[i]->year = edit->year;
+        if (edit->fields & MOVIE_EDIT_RATING) movies[i]->rating = edit->rating;
+    }
+    catalog_link_batch(catalog, movies, count);
+    journal_record_edit(catalog->journal, edit, movies, count);
+
+    bool ratings_only = edit->fields == MOVIE_EDIT_RATING;
+    if (ratings_only && (size_t)count * COLLECTION_REBUILD_FRACTION < (size_t)catalog->movies.count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            recommend_rating_changed(catalog->recommend, NULL, movies[i], edit->rating);
+        }
+    }
+    else
+    {
+        recommend_invalidate(catalog->recommend);
+    }
+
+    PERF_END(span, PERF_UPDATE);
+    return MOVIE_SUCCESS;
+}
+
+/**
+ * @function search_movie
+ * @brief Looks up a movie by title.
+ *
+ * The lookup goes through the catalog's hash index, so it costs O(1) on average
+ * regardless of catalog size. Matching ignores case and differences in whitespace.
+ * When several movies share the title, the one indexed first is returned.
+ *
+ * @param catalog The catalog to search.
+ * @param title The title to look for.
+ * @return The matching movie, or NULL if there is none.
+ */
+
+Movie* search_movie(const MovieCatalog *catalog, const char *title)
+{
+    if (!catalog || !title)
+    {
+        return NULL;
+    }
+    PERF_BEGIN(span);
+    Movie *movie = (Movie*)collection_find(&catalog->movies, title);
+    PERF_END(span, PERF_SEARCH);
+    return movie;
+}
+
+/**
+ * @function sort_movies
+ * @brief Sorts an array of movie pointers on one or more keys.
+ *
+ * Keys are applied most significant first, so { year, rating descending } orders
+ * by year and puts the best rated movie of each year first. The sort is stable.
+ * Numeric-only key lists are radix sorted; otherwise a merge sort over cached
+ * title/director prefixes is used (see sort.c). Titles and directors compare
+ * ignoring ASCII case.
+ *
+ * The catalog's own array must not be passed, as a movie's id is its position
+ * there; sort a copy of the pointers instead.
+ *
+ * @param movies The array to sort.
+ * @param count Number of movies in the array.
+ * @param keys The sort keys.
+ * @param key_count Number of keys, 1 to SORT_MAX_FIELDS.
+ * @return MOVIE_SUCCESS, MOVIE_ERROR_NULL_POINTER on invalid arguments or
+ *         MOVIE_ERROR_MEMORY_ALLOCATION (the array is then left unchanged).
+ */
+
+MovieError sort_movies(Movie* movies[], int count, const MovieSortKey keys[], int key_count)
+{
+    static const SortField fields[] =
+    {
+        [MOVIE_SORT_TITLE]    = { SORT_FIELD_STRING, offsetof(Movie, title), false },
+        [MOVIE_SORT_DIRECTOR] = { SORT_FIELD_STRING, offsetof(Movie, director), false },
+        [MOVIE_SORT_YEAR]     = { SORT_FIELD_INT, offsetof(Movie, year), false },
+        [MOVIE_SORT_RATING]   = { SORT_FIELD_FLOAT, offsetof(Movie, rating), false },
+    };
+    SortField spec[SORT_MAX_FIELDS];
+
+    if (!movies || !keys || key_count < 1 || key_count > SORT_MAX_FIELDS)
+    {
+        return MOVIE_ERROR_NULL_POINTER;
+    }
+    for (int i = 0; i < key_count; ++i)
+    {
+        if ((unsigned)keys[i].field > MOVIE_SORT_RATING)
+        {
+            return MOVIE_ERROR_NULL_POINTER;
+        }
+        spec[i] = fields[keys[i].field];
+        spec[i].descending = keys[i].descending;
+    }
+
+    if (!sort_records((void**)movies, count > 0 ? (size_t)count : 0, spec, key_count))
+    {
+        return MOVIE_ERROR_MEMORY_ALLOCATION;
+    }
+    return MOVIE_SUCCESS;
+}
+
 ///FIXME:IMPLEMENT THIS!
 void display_movie(const Movie* movie) 
 {
@@ -105,6 +381,79 @@ void display_movie(const Movie* movie)
             printf("Attempted to Display a NULL movie.\n");
 }
 
+/**
+ * @function set_movie_rating
+ * @brief Stores a new rating for a movie and journals it.
+ *
+ * The movie moves to its new place in the rating view in O(log N), and an
+ * attached recommendation index refreshes its neighbours.
+ *
+ * @param catalog The catalog that owns the record.
+ * @param movie The movie to rate.
+ * @param rating The new rating.
+ * @return MOVIE_SUCCESS, or MOVIE_ERROR_NULL_POINTER on invalid input.
+ */
+
+MovieError set_movie_rating(MovieCatalog *catalog, Movie *movie, float rating)
+{
+    if (!catalog || !movie)
+    {
+        return MOVIE_ERROR_NULL_POINTER;
+    }
+
+    PERF_BEGIN(span);
+    history_record_rate(catalog->history, movie);
+    catalog_unlink(catalog, movie);
+    movie->rating = rating;
+    catalog_link(catalog, movie);
+    journal_record_rate(catalog->journal, movie);
+    recommend_rating_changed(catalog->recommend, NULL, movie, rating);
+    PERF_END(span, PERF_UPDATE);
+
+    return MOVIE_SUCCESS;
+}
+
+
+/**
+ * @function read_movie_rating
+ * @brief Asks for a rating of a movie from 1 to 5.
+ *
+ * The prompt is shown on the top line with echoing enabled, and asked again
+ * until a digit between 1 and 5 is entered. A rejected key queues a warning
+ * on the status line (see `notify()`) without waiting for it to be dismissed.
+ *
+ * @param movie The movie being rated; only its title is shown.
+ * @return The rating, 1 to 5.
+ */
+
+int read_movie_rating(const Movie *movie)
+{
+    int ch;
+    echo(); // Enable echoing of input characters
+
+    while (1) 
+    {
+        mvprintw(0, 0, "Enter a rating for the movie (%s) from 1 to 5: ", movie->title);
+        clrtoeol(); // Drop the echo of a rejected key
+        refresh(); // Refresh the screen to show the output
+
+        InputEvent event;
+        input_read(stdscr, -1, &event); // Get one character from the user
+        ch = event.key;
+        if (ch >= '1' && ch <= '5') 
+        {
+            break; 
+        } 
+        // Reported on the status line; the prompt is simply asked again
+        notify(NOTIFY_WARNING, "Invalid rating. Please try again.");
+    }
+
+    // Disable echoing of input characters as we're done with input
+    noecho(); 
+    return ch - '0';
+}
+
+
 /**
  * @function rate_movie
  * @brief Rates a movie with user input.
@@ -112,22 +461,17 @@ void display_movie(const Movie* movie)
  * This function allows the user to input a rating for a given movie. The
  * function checks if the provided movie pointer is valid and if the movie
  * has a title. If the movie is valid, it prompts the user to enter a rating
- * from 1 to 5.
- *
- * The function uses ncurses functions for input and output to the terminal.
- * It enables echoing of characters so that the user's input is visible on
- * the terminal. It then enters a loop, prompting the user for a rating until
- * a valid digit between 1 and 5 is entered. If the input is not valid, a
- * popup warning is shown, and the input is cleared until the end of the line.
+ * from 1 to 5 with `read_movie_rating()`.
  *
- * Once a valid rating is entered, it is stored in the movie's rating field,
- * and echoing of characters is disabled before the function returns.
+ * Once a valid rating is entered, it is stored through `set_movie_rating`,
+ * which makes it the catalog's shared rating of the movie.
  *
+ * @param catalog The catalog that owns the record.
  * @param movie Pointer to a Movie structure to be rated.
  */
 
 
-void rate_movie(Movie *movie) 
+void rate_movie(MovieCatalog *catalog, Movie *movie) 
 {
     if (!movie || !movie->title) 
     {
@@ -135,100 +479,87 @@ void rate_movie(Movie *movie)
         return;
     }
 
-    int ch;
-    int rating = 0;
-    echo(); // Enable echoing of input characters
+    set_movie_rating(catalog, movie, (float)read_movie_rating(movie));
+}
 
-    while (1) 
+
+/**
+ * @function remove_movie
+ * @brief Removes a movie from the catalog without asking for confirmation.
+ *
+ * The movie is dropped from the title index and the sorted views, and its slot
+ * is released for reuse. No other record moves, so this is O(log N) for the
+ * views and O(1) otherwise, and every other movie keeps its id.
+ * The deletion is journaled. While a history is attached, the movie itself is
+ * kept out of the catalog for as long as the deletion can be undone.
+ *
+ * @param catalog The catalog holding the movie.
+ * @param id The id of the movie to be removed.
+ * @return MOVIE_SUCCESS, or MOVIE_ERROR_NULL_POINTER if there is no movie with that id.
+ */
+
+MovieError remove_movie(MovieCatalog *catalog, int id)
+{
+    Movie *movie = catalog_get(catalog, id);
+    if (!movie)
     {
-        printw("Enter a rating for the movie (%s) from 1 to 5: ", movie->title);
-        refresh(); // Refresh the screen to show the output
+        return MOVIE_ERROR_NULL_POINTER;
+    }
 
-        ch = getch(); // Get one character from the user
-        if (ch >= '1' && ch <= '5') 
-        {
-            rating = ch - '0';
-            movie->rating = rating; 
-            break; 
-        } 
-        else 
-        {
-            show_popup("Warning", "Invalid rating. Please try again.\n", 42);
-            // Clear the rest of the line to avoid invalid character inputs to stay in buffer
-            while ((ch = getch()) != '\n' && ch != EOF); 
-        }
+    PERF_BEGIN(span);
+    catalog_unlink(catalog, movie);
+    if (history_record_delete(catalog->history, movie))
+    {
+        catalog_detach(catalog, movie); // The history keeps the movie to put it back
+    }
+    else
+    {
+        catalog_release(catalog, movie);
     }
+    journal_record_delete(catalog->journal, id);
+    PERF_END(span, PERF_DELETE);
 
-    // Disable echoing of input characters as we're done with input
-    noecho(); 
+    return MOVIE_SUCCESS;
 }
 
 
 /**
  * @function delete_movie
- * @brief Deletes a movie from a dynamic array of movies.
- *
- * This function handles the deletion of a movie from a dynamic array based on
- * the index provided. It performs a series of checks to ensure the index is within
- * bounds and that the movie at the index has not already been deleted. If these
- * checks pass, it then prompts the user to confirm the deletion.
- *
- * The confirmation is acquired through a popup that asks the user to confirm with
- * 'y' or 'n'. If the user confirms, the function proceeds to free the memory
- * allocated for the movie's title and director, sets the movie pointer at that index
- * to NULL, and shifts all subsequent movie pointers in the array up by one position
- * to fill the gap, effectively reducing the array size by one.
- *
- * The function also handles user input directly via ncurses library functions
- * to fetch the user's choice and provides feedback popups based on the action taken,
- * whether the movie is deleted successfully or if the deletion is canceled.
- *
- * @param movies Triple pointer to an array of pointers to Movie structures.
- * @param count Pointer to the number of movies currently in the array.
- * @param index The index of the movie to be deleted in the array.
+ * @brief Deletes a movie from the catalog after asking for confirmation.
+ *
+ * This function handles the deletion of a movie based on the id provided. It
+ * performs a series of checks to ensure the id refers to a movie that has not
+ * already been deleted. If these checks pass, it then prompts the user to confirm
+ * the deletion.
+ *
+ * The confirmation is acquired through `confirm_popup()`, which waits for 'y' or
+ * 'n' (Esc also cancels). If the user confirms, the function removes the movie
+ * through `remove_movie`, which frees its slot in O(1) without moving other records.
+ *
+ * The outcome, deleted or canceled, is reported with `notify()` on the status
+ * line, so the only key press the deletion needs is the answer itself.
+ *
+ * @param catalog The catalog holding the movie.
+ * @param id The id of the movie to be deleted.
  */
 
-void delete_movie(Movie ***movies, int *count, int index) 
+void delete_movie(MovieCatalog *catalog, int id) 
 {
-    if (index < 0 || index >= *count || !(*movies)[index]) 
+    if (!catalog_get(catalog, id)) 
     {
-        show_popup("WARNING", "Invalid index or movie already deleted.\n");
+        notify(NOTIFY_WARNING, "Invalid index or movie already deleted.");
         return;
     }
 
     // Confirm deletion without needing to enter index, as index is already known
-    char *message = "Delete selected movie? (y/n): ";
-    show_popup("INFO", message);
-
-    // Get the user's choice directly after the popup
-    flushinp();
-    int ch = getch();
-    if (ch == 'y' || ch == 'Y') 
-    {
-        // Proceed with deletion
-        free((*movies)[index]->title);
-        free((*movies)[index]->director);
-        free((*movies)[index]); 
-        (*movies)[index] = NULL;
-
-        // Shift the remaining elements up
-        for (int i = index; i < *count - 1; i++) 
-        {
-            (*movies)[i] = (*movies)[i + 1];
-        }
-        (*movies)[*count - 1] = NULL;
-        (*count)--;
-
-        show_popup("INFO", "Movie deleted successfully!");
-    } 
-    else if (ch == 'n' || ch == 'N') 
+    if (confirm_popup("INFO", "Delete selected movie? (y/n): "))
     {
-        show_popup("INFO", "Deletion canceled.");
+        remove_movie(catalog, id);
+        notify(NOTIFY_INFO, "Movie deleted successfully!");
     } 
     else 
     {
-        // If the user input is not 'y/Y' or 'n/N', it's considered invalid
-        show_popup("WARNING", "Invalid input. Deletion canceled.");
+        notify(NOTIFY_INFO, "Deletion canceled.");
     }
 }
 
@@ -238,8 +569,7 @@ void delete_movie(Movie ***movies, int *count, int index)
  *
  * This function is a higher-level wrapper for the `delete_movie` function. It is
  * responsible for validating the user's selection and initiating the deletion process.
- * It ensures the selected index for deletion is within the valid range of the movies
- * array. If the selection is valid, it calls the `delete_movie` function to perform
+ * It ensures the selected id refers to a live movie. If the selection is valid, it calls the `delete_movie` function to perform
  * the actual deletion.
  *
  * Upon completion of the deletion process, the function clears the screen (which may be
@@ -247,21 +577,20 @@ void delete_movie(Movie ***movies, int *count, int index)
  * This is particularly useful in graphical or text-based user interfaces where the display
  * needs to reflect changes in real-time after an item is deleted.
  *
- * @param movies Triple pointer to an array of pointers to Movie structures.
- * @param count Pointer to the number of movies currently in the array.
- * @param selected_index The index of the movie selected for deletion.
+ * @param catalog The catalog holding the movie.
+ * @param selected_id The id of the movie selected for deletion.
  */
 
-void handle_deletion(Movie ***movies, int *count, int selected_index) 
+void handle_deletion(MovieCatalog *catalog, int selected_id) 
 {
     // Ensure that the selection is valid before attempting to delete
-    if (selected_index < 0 || selected_index >= *count) 
+    if (!catalog_get(catalog, selected_id)) 
     {
-        show_popup("WARNING", "No movie is selected or the selected movie is invalid.");
+        notify(NOTIFY_WARNING, "No movie is selected or the selected movie is invalid.");
         return;
     }
 
-    delete_movie(movies, count, selected_index); 
+    delete_movie(catalog, selected_id); 
     clear();
     refresh(); 
 }
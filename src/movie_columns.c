@@ -0,0 +1,191 @@
+/**
+ * @file movie_columns.c
+ * @brief Maintenance of the catalog's columns and the queries that scan them.
+ *
+ * The query loops read only the columns they need and avoid data-dependent
+ * branches: `movie_columns_select()` writes every id and advances the output
+ * by the match result, and `movie_columns_decades()` accumulates into arrays
+ * indexed by decade.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "movie_columns.h"
+
+
+/**
+ * @brief Allocates columns for `capacity` slots.
+ *
+ * @return false if the arrays could not be allocated.
+ */
+
+bool movie_columns_init(MovieColumns *columns, int capacity)
+{
+    memset(columns, 0, sizeof(*columns));
+    return movie_columns_reserve(columns, capacity);
+}
+
+
+/**
+ * @brief Releases the columns.
+ */
+
+void movie_columns_destroy(MovieColumns *columns)
+{
+    free(columns->years);
+    free(columns->ratings);
+    free(columns->directors);
+    memset(columns, 0, sizeof(*columns));
+}
+
+
+/**
+ * @brief Grows the columns to hold at least `capacity` slots.
+ *
+ * @return false if an array could not be grown; the columns keep their old capacity.
+ */
+
+bool movie_columns_reserve(MovieColumns *columns, int capacity)
+{
+    if (capacity <= columns->capacity) return true;
+
+    int16_t *years = (int16_t*)realloc(columns->years, (size_t)capacity * sizeof(int16_t));
+    if (!years) return false;
+    columns->years = years;
+
+    uint8_t *ratings = (uint8_t*)realloc(columns->ratings, (size_t)capacity * sizeof(uint8_t));
+    if (!ratings) return false;
+    columns->ratings = ratings;
+
+    uint32_t *directors = (uint32_t*)realloc(columns->directors, (size_t)capacity * sizeof(uint32_t));
+    if (!directors) return false;
+    columns->directors = directors;
+
+    columns->capacity = capacity;
+    return true;
+}
+
+
+/**
+ * @brief Converts a rating to the column's tenths of a point.
+ */
+
+uint8_t movie_rating_quantize(float rating)
+{
+    long tenths = lroundf(rating * MOVIE_RATING_SCALE);
+    if (tenths < 0) return 0;
+    if (tenths > UINT8_MAX) return UINT8_MAX;
+    return (uint8_t)tenths;
+}
+
+
+/**
+ * @brief Copies a movie's fields into its slot.
+ */
+
+void movie_columns_set(MovieColumns *columns, int id, const Movie *movie)
+{
+    columns->years[id] = (int16_t)(movie->year > INT16_MAX ? INT16_MAX : movie->year);
+    columns->ratings[id] = movie_rating_quantize(movie->rating);
+    columns->directors[id] = name_code(movie->director);
+}
+
+
+/**
+ * @brief Marks a slot as free.
+ */
+
+void movie_columns_clear(MovieColumns *columns, int id)
+{
+    columns->years[id] = 0;
+    columns->ratings[id] = 0;
+    columns->directors[id] = STRING_INTERN_NONE;
+}
+
+
+/**
+ * @brief Moves a slot's values to another slot, for compaction.
+ */
+
+void movie_columns_move(MovieColumns *columns, int from, int to)
+{
+    columns->years[to] = columns->years[from];
+    columns->ratings[to] = columns->ratings[from];
+    columns->directors[to] = columns->directors[from];
+}
+
+
+/**
+ * @brief Collects the ids of the movies within a year range and at or above a rating.
+ *
+ * Runs in one pass over the year and rating columns.
+ *
+ * @param columns The columns.
+ * @param slot_count Number of slots in use.
+ * @param min_year First year included.
+ * @param max_year Last year included.
+ * @param min_rating Lowest rating included, compared in tenths of a point.
+ * @param ids Receives the matching ids in id order; needs room for `slot_count` entries.
+ * @return Number of ids written.
+ */
+
+int movie_columns_select(const MovieColumns *columns, int slot_count, int min_year, int max_year, float min_rating, int *ids)
+{
+    const int16_t *years = columns->years;
+    const uint8_t *ratings = columns->ratings;
+    uint8_t threshold = movie_rating_quantize(min_rating);
+    int count = 0;
+
+    for (int i = 0; i < slot_count; ++i)
+    {
+        int year = years[i];
+        ids[count] = i;
+        count += (year != 0) & (year >= min_year) & (year <= max_year) & (ratings[i] >= threshold);
+    }
+    return count;
+}
+
+
+/**
+ * @brief Counts movies and averages ratings per decade, unrated movies excluded from the averages.
+ *
+ * @param columns The columns.
+ * @param slot_count Number of slots in use.
+ * @param out Receives the decades that have movies, oldest first.
+ * @param max Capacity of `out`.
+ * @return Number of decades written, or -1 if the counters could not be allocated.
+ */
+
+int movie_columns_decades(const MovieColumns *columns, int slot_count, DecadeSummary *out, int max)
+{
+    uint32_t *counts = (uint32_t*)calloc(MOVIE_DECADE_SLOTS * 3, sizeof(uint32_t));
+    if (!counts) return -1;
+    uint32_t *rated = counts + MOVIE_DECADE_SLOTS;
+    uint32_t *sums = rated + MOVIE_DECADE_SLOTS;
+
+    const int16_t *years = columns->years;
+    const uint8_t *ratings = columns->ratings;
+    for (int i = 0; i < slot_count; ++i)
+    {
+        int decade = years[i] / 10; // Free slots land in decade 0 and are skipped below
+        uint32_t rating = ratings[i];
+        counts[decade]++;
+        rated[decade] += rating != 0;
+        sums[decade] += rating;
+    }
+
+    int n = 0;
+    for (int decade = 1; decade < MOVIE_DECADE_SLOTS && n < max; ++decade)
+    {
+        if (counts[decade] == 0) continue;
+        out[n].decade = decade * 10;
+        out[n].count = (int)counts[decade];
+        out[n].rated = (int)rated[decade];
+        out[n].average = rated[decade] ? (float)sums[decade] / (float)(rated[decade] * MOVIE_RATING_SCALE) : 0.0f;
+        n++;
+    }
+    free(counts);
+    return n;
+}
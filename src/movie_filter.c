@@ -0,0 +1,268 @@
+/**
+ * @file movie_filter.c
+ * @brief Incremental type-ahead filtering of the movie catalog.
+ *
+ * Each level holds the ids matching one prefix of the query. A new level is
+ * computed from the smallest source that is known to contain every match:
+ * the level below it (a movie matching "alie" already matched "ali"), the
+ * catalog's trigram candidates for the whole query, or, for a first character
+ * with nothing to narrow, a scan of the catalog. Only the source is verified,
+ * so typing into a narrowed list gets cheaper with every keystroke.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include "movie_filter.h"
+#include "catalog.h"
+#include "perf.h"
+
+
+static inline unsigned char fold(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+
+/**
+ * @brief Case-insensitive (ASCII) strstr() that only reports whether there is a match.
+ */
+
+static bool contains(const char *text, const char *query)
+{
+    const unsigned char *t = (const unsigned char*)text;
+    const unsigned char *q = (const unsigned char*)query;
+    if (!q[0]) return true;
+
+    for (; *t; ++t)
+    {
+        if (fold(*t) != fold(q[0])) continue;
+        size_t i = 1;
+        while (q[i] && fold(t[i]) == fold(q[i])) ++i;
+        if (!q[i]) return true;
+    }
+    return false;
+}
+
+
+/**
+ * @brief Tells whether a movie's title or director contains `query`, ignoring ASCII case.
+ */
+
+bool movie_matches(const Movie *movie, const char *query)
+{
+    return contains(movie->title, query) || contains(movie->director, query);
+}
+
+
+/**
+ * @brief Prepares an empty filter.
+ */
+
+void movie_filter_init(MovieFilter *filter)
+{
+    memset(filter, 0, sizeof(*filter));
+}
+
+
+/**
+ * @brief Releases the result sets.
+ */
+
+void movie_filter_destroy(MovieFilter *filter)
+{
+    for (int i = 0; i <= MOVIE_FILTER_MAX_QUERY; ++i)
+    {
+        free(filter->levels[i].ids);
+    }
+    movie_filter_init(filter);
+}
+
+
+/**
+ * @brief Forgets the query. The result buffers are kept for the next one.
+ */
+
+void movie_filter_clear(MovieFilter *filter)
+{
+    for (int i = 0; i <= MOVIE_FILTER_MAX_QUERY; ++i)
+    {
+        filter->levels[i].valid = false;
+    }
+    filter->length = 0;
+    filter->query[0] = '\0';
+}
+
+
+static bool reserve_level(MovieFilterLevel *level, int capacity)
+{
+    if (capacity <= level->capacity) return true;
+    int *ids = (int*)realloc(level->ids, (size_t)capacity * sizeof(int));
+    if (!ids) return false;
+    level->ids = ids;
+    level->capacity = capacity;
+    return true;
+}
+
+
+static int compare_ids(const void *a, const void *b)
+{
+    int ia = *(const int*)a;
+    int ib = *(const int*)b;
+    return (ia > ib) - (ia < ib);
+}
+
+
+/**
+ * @brief Computes the results of the current query into its level.
+ *
+ * @param filter The filter; every level below the current one that is valid must be current.
+ * @param catalog The catalog being filtered.
+ * @return MOVIE_SUCCESS, or MOVIE_ERROR_MEMORY_ALLOCATION if the result set could not be stored.
+ */
+
+static MovieError compute_level(MovieFilter *filter, MovieCatalog *catalog)
+{
+    PERF_BEGIN(span);
+    int length = filter->length;
+    MovieFilterLevel *level = &filter->levels[length];
+    const MovieFilterLevel *previous = length > 1 && filter->levels[length - 1].valid ? &filter->levels[length - 1] : NULL;
+
+    const int *candidates = NULL;
+    int candidate_count = 0;
+    bool indexed = false;
+    if (!previous || previous->count > 0)
+    {
+        TrigramIndex *index = length >= 3 ? catalog_text_index(catalog) : NULL;
+        indexed = index && trigram_index_candidates(index, filter->query, &candidates, &candidate_count);
+    }
+
+    level->valid = false;
+    level->count = 0;
+
+    if (previous && (!indexed || previous->count <= candidate_count))
+    {
+        // Narrow the previous results; they are sorted and stay sorted
+        if (!reserve_level(level, previous->count)) return MOVIE_ERROR_MEMORY_ALLOCATION;
+        for (int i = 0; i < previous->count; ++i)
+        {
+            const Movie *movie = catalog_get(catalog, previous->ids[i]);
+            if (movie && movie_matches(movie, filter->query)) level->ids[level->count++] = previous->ids[i];
+        }
+    }
+    else if (indexed)
+    {
+        // Verify the candidates, which may be stale, repeated and out of order
+        if (!reserve_level(level, candidate_count)) return MOVIE_ERROR_MEMORY_ALLOCATION;
+        for (int i = 0; i < candidate_count; ++i)
+        {
+            const Movie *movie = catalog_get(catalog, candidates[i]);
+            if (movie && movie_matches(movie, filter->query)) level->ids[level->count++] = candidates[i];
+        }
+        if (level->count > 1) qsort(level->ids, (size_t)level->count, sizeof(int), compare_ids);
+        int unique = 0;
+        for (int i = 0; i < level->count; ++i)
+        {
+            if (unique == 0 || level->ids[unique - 1] != level->ids[i]) level->ids[unique++] = level->ids[i];
+        }
+        level->count = unique;
+    }
+    else
+    {
+        if (!reserve_level(level, catalog->movies.count)) return MOVIE_ERROR_MEMORY_ALLOCATION;
+        for (int i = 0; i < catalog->movies.slot_count; ++i)
+        {
+            const Movie *movie = catalog_get(catalog, i);
+            if (movie && movie_matches(movie, filter->query)) level->ids[level->count++] = i;
+        }
+    }
+
+    level->valid = true;
+    PERF_END(span, PERF_SEARCH);
+    return MOVIE_SUCCESS;
+}
+
+
+/**
+ * @brief Appends a character to the query and narrows the results.
+ *
+ * @param filter The filter.
+ * @param catalog The catalog being filtered.
+ * @param c The typed character; ignored once the query is MOVIE_FILTER_MAX_QUERY long.
+ * @return MOVIE_SUCCESS, or MOVIE_ERROR_MEMORY_ALLOCATION (the character is then not added).
+ */
+
+MovieError movie_filter_push(MovieFilter *filter, MovieCatalog *catalog, char c)
+{
+    if (!filter || !catalog) return MOVIE_ERROR_NULL_POINTER;
+    if (filter->length == MOVIE_FILTER_MAX_QUERY || c == '\0') return MOVIE_SUCCESS;
+
+    filter->query[filter->length++] = c;
+    filter->query[filter->length] = '\0';
+    MovieError err = compute_level(filter, catalog);
+    if (err != MOVIE_SUCCESS)
+    {
+        filter->query[--filter->length] = '\0';
+    }
+    return err;
+}
+
+
+/**
+ * @brief Removes the last character of the query.
+ *
+ * The shorter query's results are normally still there, so this costs nothing;
+ * they are only recomputed after a refresh has dropped them.
+ */
+
+MovieError movie_filter_pop(MovieFilter *filter, MovieCatalog *catalog)
+{
+    if (!filter || !catalog) return MOVIE_ERROR_NULL_POINTER;
+    if (filter->length == 0) return MOVIE_SUCCESS;
+
+    filter->levels[filter->length].valid = false;
+    filter->query[--filter->length] = '\0';
+    if (filter->length == 0 || filter->levels[filter->length].valid) return MOVIE_SUCCESS;
+    return compute_level(filter, catalog);
+}
+
+
+/**
+ * @brief Recomputes the results after the catalog changed.
+ *
+ * Results of shorter queries are dropped rather than updated; a later
+ * backspace recomputes them from the catalog.
+ */
+
+MovieError movie_filter_refresh(MovieFilter *filter, MovieCatalog *catalog)
+{
+    if (!filter || !catalog) return MOVIE_ERROR_NULL_POINTER;
+
+    for (int i = 0; i <= MOVIE_FILTER_MAX_QUERY; ++i)
+    {
+        filter->levels[i].valid = false;
+    }
+    if (filter->length == 0) return MOVIE_SUCCESS;
+    return compute_level(filter, catalog);
+}
+
+
+/**
+ * @brief Returns the ids matching the query in ascending order.
+ *
+ * @param filter The filter.
+ * @param count Receives the number of ids.
+ * @return The ids, or NULL with a count of 0 while the query is empty (everything matches).
+ */
+
+const int* movie_filter_results(const MovieFilter *filter, int *count)
+{
+    const MovieFilterLevel *level = &filter->levels[filter->length];
+    if (filter->length == 0 || !level->valid)
+    {
+        *count = 0;
+        return NULL;
+    }
+    *count = level->count;
+    return level->ids;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file name_table.c
+ * @brief The shared name table behind `Movie.director` and `TV_Series.creator`.
+ *
+ * Names are copied into a string arena with their code in the four bytes in
+ * front of them and registered in a `StringIntern` table, which maps a name
+ * back to its code. Only names seen for the first time are hashed twice.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <string.h>
+#include "name_table.h"
+#include "arena.h"
+
+#define NAME_ARENA_BLOCK_SIZE (64 * 1024)
+
+static StringIntern names; // Zero-initialized, which is an empty table
+static StringArena storage = { NULL, NAME_ARENA_BLOCK_SIZE };
+
+
+/**
+ * @brief Returns the shared copy of a name, adding it if it is new.
+ *
+ * @param name The name; it is copied, so it need not outlive the call.
+ * @return The shared copy, or NULL if it could not be stored.
+ */
+
+const char* name_intern(const char *name)
+{
+    if (!name) return NULL;
+
+    uint32_t code = string_intern_find(&names, name);
+    if (code != STRING_INTERN_NONE) return string_intern_name(&names, code);
+
+    size_t length = strlen(name) + 1;
+    char *block = string_arena_alloc(&storage, sizeof(uint32_t) + length);
+    if (!block) return NULL;
+
+    char *copy = block + sizeof(uint32_t);
+    memcpy(copy, name, length);
+    code = string_intern(&names, copy);
+    if (code == STRING_INTERN_NONE) return NULL; // The arena bytes stay unused until exit
+    memcpy(block, &code, sizeof(code)); // The arena does not align, so no direct store
+    return copy;
+}
+
+
+/**
+ * @brief Returns the code of a name returned by `name_intern()`, in O(1).
+ *
+ * @param name A shared copy, or NULL.
+ * @return The code, or STRING_INTERN_NONE for NULL.
+ */
+
+uint32_t name_code(const char *name)
+{
+    uint32_t code;
+    if (!name) return STRING_INTERN_NONE;
+    memcpy(&code, name - sizeof(uint32_t), sizeof(code));
+    return code;
+}
+
+
+/**
+ * @brief Returns the name with a given code, or NULL for an unknown code.
+ */
+
+const char* name_from_code(uint32_t code)
+{
+    return string_intern_name(&names, code);
+}
+
+
+/**
+ * @brief Number of distinct names so far; codes run from 0 to this minus one.
+ */
+
+uint32_t name_count(void)
+{
+    return names.count;
+}
+
+
+/**
+ * @brief Releases every name. Records still pointing at them must not be used afterwards.
+ */
+
+void name_table_destroy(void)
+{
+    string_intern_destroy(&names);
+    string_arena_destroy(&storage);
+    string_arena_init(&storage, NAME_ARENA_BLOCK_SIZE);
+}
@@ -0,0 +1,191 @@
+/**
+ * @file notify.c
+ * @brief Queue and status line behind `notify()`.
+ *
+ * The queue is a small array in arrival order; the message at its front is the
+ * one on screen. Timing uses the monotonic clock, so a message stays up for its
+ * full time even if the wall clock changes. The status window is a separate
+ * one-line window on the bottom row, which the list widget leaves free, so
+ * showing or clearing a message never repaints anything else.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <ncurses.h>
+#include "notify.h"
+#include "ui.h"
+
+#define NOTIFY_SHOW_MS 3000         // How long a message stays up when nothing is waiting
+#define NOTIFY_ERROR_SHOW_MS 5000
+#define NOTIFY_QUEUED_SHOW_MS 1000  // Shorter while other messages wait behind it
+
+typedef struct
+{
+    NotifyLevel level;
+    char text[NOTIFY_MESSAGE_SIZE];
+} Notification;
+
+static Notification queue[NOTIFY_QUEUE_SIZE];
+static int queued = 0;          // queue[0] is on screen while `showing`
+static int dropped = 0;         // Messages discarded because the queue was full
+static bool showing = false;
+static long long shown_at = 0;  // Monotonic ms when queue[0] was put up
+static WINDOW *status = NULL;   // NULL while the UI is not running
+static int status_lines, status_cols;
+
+static const char *level_labels[] = { "INFO", "WARNING", "ERROR" };
+
+
+static long long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/**
+ * @brief Creates the status window on the bottom row of the current screen.
+ */
+
+static void create_status(void)
+{
+    status = newwin(1, COLS, LINES - 1, 0);
+    status_lines = LINES;
+    status_cols = COLS;
+    showing = false; // Put the front message up again on the new window
+}
+
+
+/**
+ * @brief Starts showing notifications on screen. Called by `init_ui()`.
+ */
+
+void notify_start(void)
+{
+    if (!status) create_status();
+}
+
+
+/**
+ * @brief Stops showing notifications on screen; later ones go to stderr. Called by `end_ui()`.
+ *
+ * Messages still queued have already been seen or are superseded, and are dropped.
+ */
+
+void notify_stop(void)
+{
+    if (status) delwin(status);
+    status = NULL;
+    queued = 0;
+    dropped = 0;
+    showing = false;
+}
+
+
+/**
+ * @brief Queues a message without waiting for the user.
+ *
+ * @param level Severity, which decides the color and how long it stays up.
+ * @param format printf-style format; a trailing newline is ignored.
+ * @param ... Arguments for `format`.
+ */
+
+void notify(NotifyLevel level, const char *format, ...)
+{
+    Notification note;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(note.text, sizeof(note.text), format, args);
+    va_end(args);
+    note.level = level;
+
+    size_t length = strlen(note.text);
+    while (length > 0 && note.text[length - 1] == '\n') note.text[--length] = '\0';
+
+    if (!status)
+    {
+        fprintf(stderr, "%s: %s\n", level_labels[level], note.text);
+        return;
+    }
+
+    if (queued == NOTIFY_QUEUE_SIZE)
+    {
+        // Drop the oldest message that is not on screen yet
+        int oldest = showing ? 1 : 0;
+        memmove(&queue[oldest], &queue[oldest + 1], (size_t)(queued - oldest - 1) * sizeof(Notification));
+        queued--;
+        dropped++;
+    }
+    queue[queued++] = note;
+    notify_update();
+}
+
+
+/**
+ * @brief How long the front message stays up, given what is waiting behind it.
+ */
+
+static int show_time(void)
+{
+    if (queued > 1) return NOTIFY_QUEUED_SHOW_MS;
+    return queue[0].level == NOTIFY_ERROR ? NOTIFY_ERROR_SHOW_MS : NOTIFY_SHOW_MS;
+}
+
+
+/**
+ * @brief Dismisses an expired message, puts up the next one and repaints the status line.
+ *
+ * Input loops call this before each read and pass the result to wtimeout(), so the
+ * read returns ERR when the status line next needs to change.
+ *
+ * @return Milliseconds until the status line changes by itself, or -1 if it will not.
+ */
+
+int notify_update(void)
+{
+    if (!status) return -1;
+    if (LINES != status_lines || COLS != status_cols)
+    {
+        delwin(status);
+        create_status();
+    }
+
+    long long now = now_ms();
+    if (showing && now - shown_at >= show_time())
+    {
+        memmove(&queue[0], &queue[1], (size_t)(queued - 1) * sizeof(Notification));
+        queued--;
+        showing = false;
+    }
+
+    if (!showing)
+    {
+        werase(status);
+        if (queued > 0)
+        {
+            static const int level_pairs[] = { UI_PAIR_ROW, UI_PAIR_HEADER, UI_PAIR_ACCENT };
+            chtype attributes = COLOR_PAIR(level_pairs[queue[0].level]) | (queue[0].level == NOTIFY_INFO ? 0 : A_BOLD);
+
+            wattron(status, attributes);
+            mvwprintw(status, 0, 1, "%.*s", status_cols - 2, queue[0].text);
+            if (dropped > 0) wprintw(status, " (+%d more)", dropped);
+            wattroff(status, attributes);
+            dropped = 0;
+            showing = true;
+            shown_at = now;
+        }
+    }
+
+    // Other windows refreshing stdscr may have painted over the line; resending it is a no-op otherwise
+    touchwin(status);
+    wnoutrefresh(status);
+    doupdate();
+
+    if (!showing) return -1;
+    long long remaining = shown_at + show_time() - now;
+    return remaining > 0 ? (int)remaining : 0;
+}
@@ -0,0 +1,627 @@
+/**
+ * @file packed_snapshot.c
+ * @brief Compressed catalog snapshots made of independently inflatable blocks.
+ *
+ * A packed snapshot stores the same catalog as a plain one (snapshot.c) in a
+ * fraction of the space, for backups and copies over the network. Movies are
+ * grouped into blocks of PACKED_BLOCK_RECORDS; within a block the years and
+ * ratings are stored as columns, each title only by what it does not share with
+ * the previous one, and each director once, before the block is deflated with
+ * zlib (see packed_snapshot.h for the layout). The block index at the end of the
+ * file gives every block's place and sizes, so:
+ *
+ * - loading inflates the blocks on several threads at once, and each decoded
+ *   block is handed to the catalog's string arena like a plain snapshot's buffer;
+ * - one movie is read by inflating the single block holding it, which is how
+ *   the paged browser (paged_catalog.c) opens packed files.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "packed_snapshot.h"
+#include "storage.h"
+#include "perf.h"
+
+#define PACKED_DIRECTOR_SLOTS (2 * PACKED_BLOCK_RECORDS) // Per-block table of directors seen, a power of two
+
+// A growing byte buffer for encoding one block
+typedef struct
+{
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+// Blocks inflated by one loader thread: `first`, `first + step`, ...
+typedef struct
+{
+    const char *file;
+    const PackedBlock *blocks;
+    uint32_t block_count;
+    char **decoded;
+    uint32_t first;
+    uint32_t step;
+    SnapshotError err;
+} InflateJob;
+
+
+static bool buffer_reserve(ByteBuffer *buffer, size_t extra)
+{
+    if (buffer->length + extra <= buffer->capacity) return true;
+    size_t capacity = buffer->capacity ? buffer->capacity : 64 * 1024;
+    while (capacity < buffer->length + extra) capacity *= 2;
+    unsigned char *data = realloc(buffer->data, capacity);
+    if (!data) return false;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+
+static bool buffer_append(ByteBuffer *buffer, const void *bytes, size_t size)
+{
+    if (!buffer_reserve(buffer, size)) return false;
+    memcpy(buffer->data + buffer->length, bytes, size);
+    buffer->length += size;
+    return true;
+}
+
+
+static bool buffer_varint(ByteBuffer *buffer, uint32_t value)
+{
+    unsigned char bytes[5];
+    size_t length = 0;
+    do
+    {
+        bytes[length++] = (unsigned char)((value & 0x7f) | (value >= 0x80 ? 0x80 : 0));
+        value >>= 7;
+    } while (value);
+    return buffer_append(buffer, bytes, length);
+}
+
+
+static bool read_varint(const unsigned char **cursor, const unsigned char *end, uint32_t *value)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (*cursor == end) return false;
+        unsigned char byte = *(*cursor)++;
+        result |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * @brief Encodes `count` movies into `out`, before compression, and works out their decoded size.
+ *
+ * @param movies Movies of the block, in file order.
+ * @param count How many.
+ * @param out Receives the encoded block; emptied first.
+ * @param[out] decoded_size Receives the size of the block as records and strings.
+ * @return false if memory ran out or the strings do not fit 32-bit offsets.
+ */
+
+static bool encode_block(const Movie **movies, uint32_t count, ByteBuffer *out, uint64_t *decoded_size)
+{
+    const char *seen[PACKED_DIRECTOR_SLOTS];   // Interned director pointers, see name_table.h
+    uint32_t numbers[PACKED_DIRECTOR_SLOTS];   // Their 1-based number in the block
+    uint32_t distinct = 0;
+    memset(seen, 0, sizeof(seen));
+
+    out->length = 0;
+    uint64_t size = (uint64_t)count * sizeof(SnapshotRecord);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        int32_t year = movies[i]->year;
+        if (!buffer_append(out, &year, sizeof(year))) return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        float rating = movies[i]->rating;
+        if (!buffer_append(out, &rating, sizeof(rating))) return false;
+    }
+
+    const char *previous = "";
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const char *title = movies[i]->title;
+        size_t shared = 0;
+        while (previous[shared] && previous[shared] == title[shared]) shared++;
+        size_t suffix = strlen(title + shared);
+        if (shared + suffix >= UINT32_MAX) return false;
+        if (!buffer_varint(out, (uint32_t)shared) || !buffer_varint(out, (uint32_t)suffix) ||
+            !buffer_append(out, title + shared, suffix))
+        {
+            return false;
+        }
+        size += shared + suffix + 1;
+        previous = title;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const char *director = movies[i]->director;
+        uint32_t slot = (uint32_t)(((uintptr_t)director >> 4) * 2654435761u) & (PACKED_DIRECTOR_SLOTS - 1);
+        while (seen[slot] && seen[slot] != director) slot = (slot + 1) & (PACKED_DIRECTOR_SLOTS - 1);
+        if (seen[slot])
+        {
+            if (!buffer_varint(out, numbers[slot])) return false;
+            continue;
+        }
+
+        size_t length = strlen(director);
+        if (length >= UINT32_MAX) return false;
+        seen[slot] = director;
+        numbers[slot] = ++distinct;
+        if (!buffer_varint(out, 0) || !buffer_varint(out, (uint32_t)length) || !buffer_append(out, director, length))
+        {
+            return false;
+        }
+        size += length + 1;
+    }
+
+    *decoded_size = size;
+    return size <= UINT32_MAX;
+}
+
+
+/**
+ * @brief Writes the catalog as a packed snapshot to an open, seekable stream.
+ */
+
+static SnapshotError write_packed(FILE *file, const MovieCatalog *catalog, uint64_t generation)
+{
+    PackedHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACKED_MAGIC, sizeof(header.magic));
+    header.version = PACKED_VERSION;
+    header.block_records = PACKED_BLOCK_RECORDS;
+    header.generation = generation;
+    header.record_count = (uint32_t)catalog->movies.count;
+    header.block_count = (header.record_count + PACKED_BLOCK_RECORDS - 1) / PACKED_BLOCK_RECORDS;
+
+    const Movie **movies = malloc(PACKED_BLOCK_RECORDS * sizeof(*movies));
+    PackedBlock *blocks = malloc(((size_t)header.block_count + 1) * sizeof(*blocks));
+    ByteBuffer encoded = { NULL, 0, 0 };
+    ByteBuffer compressed = { NULL, 0, 0 };
+    if (!movies || !blocks)
+    {
+        free(movies);
+        free(blocks);
+        return SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+    }
+
+    SnapshotError err = fwrite(&header, sizeof(header), 1, file) == 1 ? SNAPSHOT_SUCCESS : SNAPSHOT_ERROR_IO;
+    uint64_t offset = sizeof(header);
+    uint32_t block = 0;
+    int slot = 0;
+    while (err == SNAPSHOT_SUCCESS && block < header.block_count)
+    {
+        uint32_t count = 0;
+        for (; slot < catalog->movies.slot_count && count < PACKED_BLOCK_RECORDS; ++slot)
+        {
+            const Movie *movie = catalog_get(catalog, slot);
+            if (movie) movies[count++] = movie;
+        }
+
+        uint64_t decoded_size = 0;
+        if (!encode_block(movies, count, &encoded, &decoded_size))
+        {
+            err = decoded_size > UINT32_MAX ? SNAPSHOT_ERROR_FORMAT : SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        uLongf compressed_size = compressBound((uLong)encoded.length);
+        compressed.length = 0;
+        if (!buffer_reserve(&compressed, compressed_size))
+        {
+            err = SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        if (compress2(compressed.data, &compressed_size, encoded.data, (uLong)encoded.length, Z_DEFAULT_COMPRESSION) != Z_OK)
+        {
+            err = SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+
+        blocks[block].offset = offset;
+        blocks[block].compressed_size = (uint32_t)compressed_size;
+        blocks[block].encoded_size = (uint32_t)encoded.length;
+        blocks[block].decoded_size = (uint32_t)decoded_size;
+        blocks[block].records = count;
+        if (fwrite(compressed.data, compressed_size, 1, file) != 1) err = SNAPSHOT_ERROR_IO;
+        offset += compressed_size;
+        block++;
+    }
+
+    header.index_offset = offset;
+    if (err == SNAPSHOT_SUCCESS && header.block_count > 0 &&
+        fwrite(blocks, sizeof(*blocks), header.block_count, file) != header.block_count)
+    {
+        err = SNAPSHOT_ERROR_IO;
+    }
+    if (err == SNAPSHOT_SUCCESS && (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1))
+    {
+        err = SNAPSHOT_ERROR_IO;
+    }
+
+    free(movies);
+    free(blocks);
+    free(encoded.data);
+    free(compressed.data);
+    return err;
+}
+
+
+/**
+ * @brief Writes the catalog to a packed snapshot file.
+ *
+ * Like `save_snapshot()`, the file is written to `<filename>.tmp` and renamed into place.
+ *
+ * @param filename Destination path.
+ * @param catalog The catalog to save.
+ * @param generation Generation stamp stored in the header.
+ * @return SNAPSHOT_SUCCESS, SNAPSHOT_ERROR_IO, SNAPSHOT_ERROR_FORMAT if a block's strings
+ *         do not fit 32-bit offsets, or SNAPSHOT_ERROR_MEMORY_ALLOCATION.
+ */
+
+SnapshotError save_packed_snapshot(const char *filename, const MovieCatalog *catalog, uint64_t generation)
+{
+    char tmp_name[1024];
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", filename);
+    PERF_BEGIN(span);
+
+    FILE *file = fopen(tmp_name, "wb");
+    if (!file)
+    {
+        perror("Error opening packed snapshot for writing");
+        return SNAPSHOT_ERROR_IO;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    SnapshotError err = write_packed(file, catalog, generation);
+    if (fclose(file) != 0 && err == SNAPSHOT_SUCCESS) err = SNAPSHOT_ERROR_IO;
+
+    if (err == SNAPSHOT_SUCCESS && rename(tmp_name, filename) != 0) err = SNAPSHOT_ERROR_IO;
+    if (err != SNAPSHOT_SUCCESS)
+    {
+        if (err == SNAPSHOT_ERROR_IO) perror("Error writing packed snapshot");
+        remove(tmp_name);
+        return err;
+    }
+
+    PERF_END(span, PERF_SAVE);
+    return SNAPSHOT_SUCCESS;
+}
+
+
+/**
+ * @brief Checks a header and block index against each other and the file size.
+ */
+
+static bool valid_index(const PackedHeader *header, const PackedBlock *blocks, uint64_t file_size)
+{
+    for (uint32_t i = 0; i < header->block_count; ++i)
+    {
+        const PackedBlock *block = &blocks[i];
+        uint32_t expected = i + 1 < header->block_count
+                          ? header->block_records
+                          : header->record_count - i * header->block_records;
+        if (block->records != expected
+            || block->offset < sizeof(*header)
+            || block->offset + block->compressed_size > header->index_offset
+            || block->encoded_size < (uint64_t)block->records * (sizeof(int32_t) + sizeof(float))
+            || block->decoded_size < (uint64_t)block->records * (sizeof(SnapshotRecord) + 2))
+        {
+            return false;
+        }
+    }
+    return header->index_offset + (uint64_t)header->block_count * sizeof(PackedBlock) == file_size;
+}
+
+
+static bool valid_header(const PackedHeader *header)
+{
+    return memcmp(header->magic, PACKED_MAGIC, sizeof(header->magic)) == 0
+        && header->version == PACKED_VERSION
+        && header->block_records > 0
+        && header->record_count <= INT32_MAX
+        && header->block_count == (uint32_t)(((uint64_t)header->record_count + header->block_records - 1) / header->block_records);
+}
+
+
+/**
+ * @brief Reads and checks the header and block index of a packed snapshot.
+ *
+ * @param fd The open file.
+ * @param[out] header Receives the header.
+ * @param[out] blocks Receives the block index, allocated with malloc.
+ * @return SNAPSHOT_SUCCESS, SNAPSHOT_ERROR_IO, SNAPSHOT_ERROR_FORMAT if this is not a packed
+ *         snapshot of this version, or SNAPSHOT_ERROR_MEMORY_ALLOCATION.
+ */
+
+SnapshotError read_packed_index(int fd, PackedHeader *header, PackedBlock **blocks)
+{
+    off_t file_size = lseek(fd, 0, SEEK_END);
+    if (file_size < 0) return SNAPSHOT_ERROR_IO;
+    if (pread(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header) || !valid_header(header))
+    {
+        return SNAPSHOT_ERROR_FORMAT;
+    }
+
+    size_t index_size = (size_t)header->block_count * sizeof(PackedBlock);
+    if (header->index_offset + index_size != (uint64_t)file_size) return SNAPSHOT_ERROR_FORMAT;
+    *blocks = malloc(index_size > 0 ? index_size : 1);
+    if (!*blocks) return SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+    if (pread(fd, *blocks, index_size, (off_t)header->index_offset) != (ssize_t)index_size)
+    {
+        free(*blocks);
+        return SNAPSHOT_ERROR_IO;
+    }
+    if (!valid_index(header, *blocks, (uint64_t)file_size))
+    {
+        free(*blocks);
+        return SNAPSHOT_ERROR_FORMAT;
+    }
+    return SNAPSHOT_SUCCESS;
+}
+
+
+/**
+ * @brief Decodes an inflated block into records and strings, checking every length.
+ */
+
+static bool decode_contents(const PackedBlock *block, const unsigned char *encoded, uint32_t *directors, char *decoded)
+{
+    uint32_t n = block->records;
+    SnapshotRecord *records = (SnapshotRecord*)decoded;
+    char *strings = decoded + (size_t)n * sizeof(SnapshotRecord);
+    size_t strings_size = block->decoded_size - (size_t)n * sizeof(SnapshotRecord);
+    const unsigned char *cursor = encoded + (size_t)n * (sizeof(int32_t) + sizeof(float));
+    const unsigned char *end = encoded + block->encoded_size;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        memcpy(&records[i].year, encoded + (size_t)i * sizeof(int32_t), sizeof(int32_t));
+        memcpy(&records[i].rating, encoded + (size_t)n * sizeof(int32_t) + (size_t)i * sizeof(float), sizeof(float));
+        if (records[i].year <= 1800) return false; // Refused by create_movie_borrowed(), which would shift the ids after it
+    }
+
+    size_t position = 0;
+    size_t previous = 0, previous_length = 0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        uint32_t shared, suffix;
+        if (!read_varint(&cursor, end, &shared) || !read_varint(&cursor, end, &suffix)
+            || shared > previous_length || suffix > (size_t)(end - cursor)
+            || (size_t)shared + suffix + 1 > strings_size - position
+            || memchr(cursor, '\0', suffix))
+        {
+            return false;
+        }
+        memmove(strings + position, strings + previous, shared);
+        memcpy(strings + position + shared, cursor, suffix);
+        cursor += suffix;
+        records[i].title_offset = (uint32_t)position;
+        previous = position;
+        previous_length = (size_t)shared + suffix;
+        position += previous_length;
+        strings[position++] = '\0';
+    }
+
+    uint32_t distinct = 0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        uint32_t number;
+        if (!read_varint(&cursor, end, &number) || number > distinct) return false;
+        if (number > 0)
+        {
+            records[i].director_offset = directors[number - 1];
+            continue;
+        }
+
+        uint32_t length;
+        if (!read_varint(&cursor, end, &length) || length > (size_t)(end - cursor)
+            || (size_t)length + 1 > strings_size - position || memchr(cursor, '\0', length))
+        {
+            return false;
+        }
+        memcpy(strings + position, cursor, length);
+        cursor += length;
+        records[i].director_offset = (uint32_t)position;
+        directors[distinct++] = (uint32_t)position;
+        position += length;
+        strings[position++] = '\0';
+    }
+    return cursor == end && position == strings_size;
+}
+
+
+/**
+ * @brief Inflates one block and decodes it into records and strings.
+ *
+ * The result has the layout of a plain snapshot: `block->records` SnapshotRecords
+ * followed by the strings they point to, with offsets counted from the end of the
+ * records. Every offset is checked and every string terminated.
+ *
+ * @param block The block's index entry.
+ * @param compressed Its `compressed_size` bytes from the file.
+ * @param[out] decoded Receives `block->decoded_size` bytes.
+ * @return SNAPSHOT_SUCCESS, SNAPSHOT_ERROR_FORMAT for a damaged block, or SNAPSHOT_ERROR_MEMORY_ALLOCATION.
+ */
+
+SnapshotError decode_packed_block(const PackedBlock *block, const void *compressed, char *decoded)
+{
+    unsigned char *encoded = malloc(block->encoded_size > 0 ? block->encoded_size : 1);
+    uint32_t *directors = malloc(((size_t)block->records + 1) * sizeof(*directors));
+    if (!encoded || !directors)
+    {
+        free(encoded);
+        free(directors);
+        return SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+    }
+
+    uLongf length = block->encoded_size;
+    bool ok = uncompress(encoded, &length, compressed, block->compressed_size) == Z_OK
+           && length == block->encoded_size
+           && decode_contents(block, encoded, directors, decoded);
+    free(encoded);
+    free(directors);
+    return ok ? SNAPSHOT_SUCCESS : SNAPSHOT_ERROR_FORMAT;
+}
+
+
+static void* inflate_worker(void *argument)
+{
+    InflateJob *job = (InflateJob*)argument;
+    for (uint32_t i = job->first; i < job->block_count && job->err == SNAPSHOT_SUCCESS; i += job->step)
+    {
+        const PackedBlock *block = &job->blocks[i];
+        job->decoded[i] = malloc(block->decoded_size);
+        if (!job->decoded[i])
+        {
+            job->err = SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        job->err = decode_packed_block(block, job->file + block->offset, job->decoded[i]);
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Appends the movies of a packed snapshot to the catalog, inflating its blocks in parallel.
+ *
+ * The blocks are spread over as many threads as `storage_parse_threads()` allows
+ * (at most PACKED_MAX_THREADS), then the movies are created in file order on the
+ * calling thread, borrowing their titles from the decoded blocks, which the
+ * catalog's string arena adopts. As with `load_snapshot()`, the catalog may
+ * already hold movies; the new ones take the next free ids.
+ *
+ * @param filename The packed snapshot to read.
+ * @param catalog The catalog to add to.
+ * @param[out] generation Receives the generation stamp of the snapshot.
+ * @return SNAPSHOT_SUCCESS, SNAPSHOT_ERROR_IO if the file could not be read,
+ *         SNAPSHOT_ERROR_FORMAT if it is not a valid packed snapshot, a block is damaged or
+ *         holds a movie `create_movie_borrowed()` refuses, or SNAPSHOT_ERROR_MEMORY_ALLOCATION.
+ *         On error the catalog is left unchanged.
+ */
+
+SnapshotError load_packed_snapshot(const char *filename, MovieCatalog *catalog, uint64_t *generation)
+{
+    char *data;
+    size_t size;
+
+    PERF_BEGIN(span);
+    if (read_whole_file(filename, &data, &size) != 0)
+    {
+        return SNAPSHOT_ERROR_IO;
+    }
+
+    PackedHeader header;
+    if (size < sizeof(header))
+    {
+        free(data);
+        return SNAPSHOT_ERROR_FORMAT;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (!valid_header(&header) || header.index_offset > size
+        || (size - header.index_offset) / sizeof(PackedBlock) != header.block_count)
+    {
+        free(data);
+        return SNAPSHOT_ERROR_FORMAT;
+    }
+    PackedBlock *blocks = malloc(((size_t)header.block_count + 1) * sizeof(*blocks));
+    char **decoded = calloc((size_t)header.block_count + 1, sizeof(*decoded));
+    if (!blocks || !decoded)
+    {
+        free(blocks);
+        free(decoded);
+        free(data);
+        return SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+    }
+    memcpy(blocks, data + header.index_offset, (size_t)header.block_count * sizeof(*blocks));
+    SnapshotError err = valid_index(&header, blocks, size) ? SNAPSHOT_SUCCESS : SNAPSHOT_ERROR_FORMAT;
+
+    int threads = storage_parse_threads();
+    if (threads > PACKED_MAX_THREADS) threads = PACKED_MAX_THREADS;
+    if ((uint32_t)threads > header.block_count) threads = header.block_count > 0 ? (int)header.block_count : 1;
+    InflateJob jobs[PACKED_MAX_THREADS];
+    pthread_t workers[PACKED_MAX_THREADS];
+    bool started[PACKED_MAX_THREADS];
+    for (int i = 0; err == SNAPSHOT_SUCCESS && i < threads; ++i)
+    {
+        jobs[i] = (InflateJob){ data, blocks, header.block_count, decoded, (uint32_t)i, (uint32_t)threads, SNAPSHOT_SUCCESS };
+        started[i] = i > 0 && pthread_create(&workers[i], NULL, inflate_worker, &jobs[i]) == 0;
+    }
+    if (err == SNAPSHOT_SUCCESS)
+    {
+        for (int i = 0; i < threads; ++i)
+        {
+            if (!started[i]) inflate_worker(&jobs[i]); // The calling thread takes job 0 and any that did not start
+        }
+        for (int i = 1; i < threads; ++i)
+        {
+            if (started[i]) pthread_join(workers[i], NULL);
+        }
+        for (int i = 0; i < threads; ++i)
+        {
+            if (jobs[i].err != SNAPSHOT_SUCCESS) err = jobs[i].err;
+        }
+    }
+    free(data);
+
+    if (err == SNAPSHOT_SUCCESS && catalog_reserve(catalog, (int)header.record_count) != MOVIE_SUCCESS)
+    {
+        err = SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+    }
+    // Every block is adopted before the first movie is created, so a failure leaves no movies behind
+    uint32_t adopted = 0;
+    while (err == SNAPSHOT_SUCCESS && adopted < header.block_count)
+    {
+        if (string_arena_adopt(&catalog->movies.strings, decoded[adopted]) != 0)
+        {
+            err = SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        adopted++;
+    }
+    for (uint32_t i = 0; err == SNAPSHOT_SUCCESS && i < header.block_count; ++i)
+    {
+        const SnapshotRecord *records = (const SnapshotRecord*)decoded[i];
+        char *strings = decoded[i] + (size_t)blocks[i].records * sizeof(SnapshotRecord);
+        for (uint32_t r = 0; err == SNAPSHOT_SUCCESS && r < blocks[i].records; ++r)
+        {
+            if (!create_movie_borrowed(catalog, strings + records[r].title_offset, strings + records[r].director_offset,
+                                       records[r].year, records[r].rating))
+            {
+                err = SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+                for (uint32_t b = 0; b <= i; ++b)
+                {
+                    catalog_discard_borrowed(catalog, decoded[b], decoded[b] + blocks[b].decoded_size);
+                }
+            }
+        }
+    }
+    for (uint32_t i = adopted; i < header.block_count; ++i)
+    {
+        free(decoded[i]);
+    }
+    free(decoded);
+    free(blocks);
+    if (err != SNAPSHOT_SUCCESS) return err;
+
+    *generation = header.generation;
+    PERF_END(span, PERF_LOAD);
+    return SNAPSHOT_SUCCESS;
+}
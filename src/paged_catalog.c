@@ -0,0 +1,507 @@
+/**
+ * @file paged_catalog.c
+ * @brief Browsing a snapshot larger than memory through a bounded page cache.
+ *
+ * `load_snapshot()` reads the whole file and points every Movie into it, which
+ * is the fastest way to open a catalog that fits in RAM. Archive catalogs of
+ * tens of millions of rows do not, so this module reads the same file in place:
+ * a record is found at a fixed offset from its index, its strings at their
+ * offsets in the string table, and each lookup goes through a cache of
+ * PAGED_PAGE_SIZE pages with least-recently-used eviction. What stays resident
+ * is the pages holding the records on screen and the ones a search went
+ * through last, never more than the budget given to `paged_catalog_open()`.
+ *
+ * A packed snapshot (packed_snapshot.h) is cached a block at a time instead:
+ * its block index says where every block starts, a miss reads and inflates the
+ * one block holding the record, and the record and its strings are then found
+ * in the decoded block the same way as in a plain file.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "paged_catalog.h"
+#include "movie_filter.h"
+
+
+static int bucket_of(const PagedCatalog *paged, uint64_t number)
+{
+    return (int)((number * 0x9E3779B97F4A7C15ull) >> 32) & paged->bucket_mask;
+}
+
+
+/**
+ * @brief Takes a loaded page out of the recency list.
+ */
+
+static void unlink_page(PagedCatalog *paged, int slot)
+{
+    PagedPage *page = &paged->pages[slot];
+    if (page->newer >= 0) paged->pages[page->newer].older = page->older;
+    else paged->newest = page->older;
+    if (page->older >= 0) paged->pages[page->older].newer = page->newer;
+    else paged->oldest = page->newer;
+    page->newer = page->older = -1;
+}
+
+
+/**
+ * @brief Puts a loaded page at the most recently used end of the list.
+ */
+
+static void push_newest(PagedCatalog *paged, int slot)
+{
+    PagedPage *page = &paged->pages[slot];
+    page->newer = -1;
+    page->older = paged->newest;
+    if (paged->newest >= 0) paged->pages[paged->newest].newer = slot;
+    paged->newest = slot;
+    if (paged->oldest < 0) paged->oldest = slot;
+}
+
+
+/**
+ * @brief Drops a page from its hash bucket before it is reused for another part of the file.
+ */
+
+static void unhash_page(PagedCatalog *paged, int slot)
+{
+    int *link = &paged->buckets[bucket_of(paged, paged->pages[slot].number)];
+    while (*link != slot) link = &paged->pages[*link].hash_next;
+    *link = paged->pages[slot].hash_next;
+}
+
+
+/**
+ * @brief Reads page `number` of a plain snapshot, or inflates block `number` of a packed one.
+ *
+ * @return Bytes now in `data`, 0 past the end of the file, or -1 if it could not be read.
+ */
+
+static ssize_t load_page(PagedCatalog *paged, char *data, uint64_t number)
+{
+    if (!paged->blocks)
+    {
+        ssize_t length;
+        do
+        {
+            length = pread(paged->fd, data, PAGED_PAGE_SIZE, (off_t)(number * PAGED_PAGE_SIZE));
+        } while (length < 0 && errno == EINTR);
+        return length;
+    }
+
+    if (number >= paged->block_count) return 0;
+    const PackedBlock *block = &paged->blocks[number];
+    ssize_t length;
+    do
+    {
+        length = pread(paged->fd, paged->compressed, block->compressed_size, (off_t)block->offset);
+    } while (length < 0 && errno == EINTR);
+    if (length != (ssize_t)block->compressed_size) return -1;
+    if (decode_packed_block(block, paged->compressed, data) != SNAPSHOT_SUCCESS) return -1;
+    return (ssize_t)block->decoded_size;
+}
+
+
+/**
+ * @brief The cached page `number`, read from the file (evicting the oldest page) if needed.
+ *
+ * @return The page, or NULL if it could not be read.
+ */
+
+static const PagedPage* fetch_page(PagedCatalog *paged, uint64_t number)
+{
+    int bucket = bucket_of(paged, number);
+    for (int slot = paged->buckets[bucket]; slot >= 0; slot = paged->pages[slot].hash_next)
+    {
+        if (paged->pages[slot].number != number) continue;
+        paged->hits++;
+        if (paged->newest != slot)
+        {
+            unlink_page(paged, slot);
+            push_newest(paged, slot);
+        }
+        return &paged->pages[slot];
+    }
+
+    int slot;
+    if (paged->free_page < paged->page_count)
+    {
+        slot = paged->free_page++;
+        paged->pages[slot].data = malloc(paged->page_bytes);
+        if (!paged->pages[slot].data)
+        {
+            paged->free_page--;
+            if (paged->oldest < 0) return NULL;
+            slot = -1; // Fall back on evicting, the budget was optimistic
+        }
+    }
+    else
+    {
+        slot = -1;
+    }
+    if (slot < 0)
+    {
+        slot = paged->oldest;
+        unlink_page(paged, slot);
+        if (paged->pages[slot].loaded) unhash_page(paged, slot);
+        paged->pages[slot].loaded = false;
+    }
+
+    PagedPage *page = &paged->pages[slot];
+    ssize_t length = load_page(paged, page->data, number);
+    if (length <= 0)
+    {
+        page->loaded = false; // The buffer stays for the next miss, the page is not cached
+        push_newest(paged, slot);
+        return NULL;
+    }
+
+    paged->misses++;
+    page->number = number;
+    page->length = (size_t)length;
+    page->loaded = true;
+    page->hash_next = paged->buckets[bucket];
+    paged->buckets[bucket] = slot;
+    push_newest(paged, slot);
+    return page;
+}
+
+
+/**
+ * @brief Copies `size` bytes at `offset` out of the file through the cache.
+ */
+
+static bool read_bytes(PagedCatalog *paged, uint64_t offset, void *buffer, size_t size)
+{
+    char *out = (char*)buffer;
+    while (size > 0)
+    {
+        const PagedPage *page = fetch_page(paged, offset / PAGED_PAGE_SIZE);
+        size_t within = (size_t)(offset % PAGED_PAGE_SIZE);
+        if (!page || within >= page->length) return false;
+
+        size_t chunk = page->length - within;
+        if (chunk > size) chunk = size;
+        memcpy(out, page->data + within, chunk);
+        out += chunk;
+        offset += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Copies the string at `offset` in the string table, truncated to `size` - 1 bytes.
+ */
+
+static bool read_string(PagedCatalog *paged, uint32_t offset, char *buffer, size_t size)
+{
+    if (offset >= paged->header.string_table_size) return false;
+
+    uint64_t position = paged->strings_offset + offset;
+    size_t length = 0;
+    while (length + 1 < size)
+    {
+        const PagedPage *page = fetch_page(paged, position / PAGED_PAGE_SIZE);
+        size_t within = (size_t)(position % PAGED_PAGE_SIZE);
+        if (!page || within >= page->length) return false;
+
+        size_t chunk = page->length - within;
+        if (chunk > size - 1 - length) chunk = size - 1 - length;
+        const char *end = memchr(page->data + within, '\0', chunk);
+        if (end)
+        {
+            chunk = (size_t)(end - (page->data + within));
+            memcpy(buffer + length, page->data + within, chunk);
+            length += chunk;
+            break;
+        }
+        memcpy(buffer + length, page->data + within, chunk);
+        length += chunk;
+        position += chunk;
+    }
+    buffer[length] = '\0';
+    return true;
+}
+
+
+/**
+ * @brief Reads the block index of a packed snapshot and sizes the view's pages to its blocks.
+ */
+
+static PagedError open_packed(PagedCatalog *paged)
+{
+    PackedHeader header;
+    SnapshotError err = read_packed_index(paged->fd, &header, &paged->blocks);
+    if (err != SNAPSHOT_SUCCESS)
+    {
+        paged->blocks = NULL;
+        return err == SNAPSHOT_ERROR_MEMORY_ALLOCATION ? PAGED_ERROR_MEMORY_ALLOCATION
+             : err == SNAPSHOT_ERROR_IO ? PAGED_ERROR_IO : PAGED_ERROR_FORMAT;
+    }
+
+    size_t compressed = 1;
+    paged->page_bytes = 1;
+    for (uint32_t i = 0; i < header.block_count; ++i)
+    {
+        if (paged->blocks[i].compressed_size > compressed) compressed = paged->blocks[i].compressed_size;
+        if (paged->blocks[i].decoded_size > paged->page_bytes) paged->page_bytes = paged->blocks[i].decoded_size;
+    }
+    paged->compressed = malloc(compressed);
+    if (!paged->compressed)
+    {
+        free(paged->blocks);
+        paged->blocks = NULL;
+        return PAGED_ERROR_MEMORY_ALLOCATION;
+    }
+
+    memset(&paged->header, 0, sizeof(paged->header));
+    paged->header.record_count = header.record_count;
+    paged->header.generation = header.generation;
+    paged->block_count = header.block_count;
+    paged->block_records = header.block_records;
+    return PAGED_SUCCESS;
+}
+
+
+/**
+ * @brief Opens a snapshot for paged reading; nothing but its header is read.
+ *
+ * A packed snapshot is recognised by its magic; of it, the block index is read too.
+ *
+ * @param paged The view to open.
+ * @param filename The snapshot file, plain or packed.
+ * @param budget Bytes the page cache may use, or 0 for PAGED_DEFAULT_BUDGET.
+ *               At least PAGED_MIN_PAGES pages are cached whatever it says.
+ * @return PAGED_SUCCESS, PAGED_ERROR_IO, PAGED_ERROR_FORMAT or PAGED_ERROR_MEMORY_ALLOCATION.
+ */
+
+PagedError paged_catalog_open(PagedCatalog *paged, const char *filename, size_t budget)
+{
+    memset(paged, 0, sizeof(*paged));
+    paged->fd = open(filename, O_RDONLY);
+    if (paged->fd < 0) return PAGED_ERROR_IO;
+
+    struct stat info;
+    ssize_t got = pread(paged->fd, &paged->header, sizeof(paged->header), 0);
+    if (fstat(paged->fd, &info) != 0 || got < 0)
+    {
+        close(paged->fd);
+        return PAGED_ERROR_IO;
+    }
+
+    // The same checks as load_snapshot(), short of reading the strings
+    const SnapshotHeader *header = &paged->header;
+    paged->file_size = (uint64_t)info.st_size;
+    paged->page_bytes = PAGED_PAGE_SIZE;
+    size_t file_pages = (size_t)((paged->file_size + PAGED_PAGE_SIZE - 1) / PAGED_PAGE_SIZE);
+    if ((size_t)got >= sizeof(header->magic) && memcmp(header->magic, PACKED_MAGIC, sizeof(header->magic)) == 0)
+    {
+        PagedError err = open_packed(paged);
+        if (err != PAGED_SUCCESS)
+        {
+            close(paged->fd);
+            return err;
+        }
+        file_pages = paged->block_count;
+    }
+    else if ((size_t)got != sizeof(*header)
+        || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+        || header->version != SNAPSHOT_VERSION
+        || header->record_size != sizeof(SnapshotRecord)
+        || header->record_count > INT32_MAX
+        || paged->file_size != sizeof(*header) + (uint64_t)header->record_count * sizeof(SnapshotRecord)
+                               + header->string_table_size)
+    {
+        close(paged->fd);
+        return PAGED_ERROR_FORMAT;
+    }
+    paged->records_offset = sizeof(*header);
+    paged->strings_offset = paged->records_offset + (uint64_t)header->record_count * sizeof(SnapshotRecord);
+
+    if (budget == 0) budget = PAGED_DEFAULT_BUDGET;
+    size_t page_count = budget / paged->page_bytes;
+    if (page_count < PAGED_MIN_PAGES) page_count = PAGED_MIN_PAGES;
+    if (paged->blocks && page_count > file_pages) page_count = file_pages > 0 ? file_pages : 1; // A record is in one block
+    if (page_count > file_pages && file_pages >= PAGED_MIN_PAGES) page_count = file_pages; // Room for the whole file
+    if (page_count > INT32_MAX / 2) page_count = INT32_MAX / 2;
+
+    int buckets = 1;
+    while (buckets < (int)page_count * 2) buckets *= 2;
+    paged->pages = calloc(page_count, sizeof(*paged->pages));
+    paged->buckets = malloc((size_t)buckets * sizeof(*paged->buckets));
+    if (!paged->pages || !paged->buckets)
+    {
+        free(paged->pages);
+        free(paged->buckets);
+        free(paged->blocks);
+        free(paged->compressed);
+        close(paged->fd);
+        return PAGED_ERROR_MEMORY_ALLOCATION;
+    }
+    paged->page_count = (int)page_count;
+    paged->bucket_mask = buckets - 1;
+    for (int i = 0; i < buckets; ++i) paged->buckets[i] = -1;
+    for (int i = 0; i < paged->page_count; ++i)
+    {
+        paged->pages[i].newer = paged->pages[i].older = paged->pages[i].hash_next = -1;
+    }
+    paged->newest = paged->oldest = -1;
+    return PAGED_SUCCESS;
+}
+
+
+int paged_catalog_count(const PagedCatalog *paged)
+{
+    return (int)paged->header.record_count;
+}
+
+
+/**
+ * @brief Copies record `index` and its strings out of the file.
+ *
+ * Strings longer than PAGED_TEXT_SIZE - 1 bytes are truncated. The movie's id
+ * is its index in the file.
+ *
+ * @param paged The view.
+ * @param index 0 to `paged_catalog_count()` - 1.
+ * @param[out] out Receives the movie; its strings point into it.
+ * @return PAGED_SUCCESS, PAGED_ERROR_OUT_OF_RANGE, PAGED_ERROR_IO, or PAGED_ERROR_FORMAT
+ *         for a string offset outside the table.
+ */
+
+/**
+ * @brief `paged_catalog_read()` of a packed file: the record and its strings come from one decoded block.
+ */
+
+static PagedError read_packed(PagedCatalog *paged, int index, PagedMovie *out)
+{
+    uint32_t number = (uint32_t)index / paged->block_records;
+    const PagedPage *page = fetch_page(paged, number);
+    if (!page) return PAGED_ERROR_IO;
+
+    // decode_packed_block() checked every offset and terminated every string
+    const PackedBlock *block = &paged->blocks[number];
+    SnapshotRecord record;
+    memcpy(&record, page->data + (size_t)((uint32_t)index % paged->block_records) * sizeof(record), sizeof(record));
+    const char *strings = page->data + (size_t)block->records * sizeof(SnapshotRecord);
+    snprintf(out->title, sizeof(out->title), "%s", strings + record.title_offset);
+    snprintf(out->director, sizeof(out->director), "%s", strings + record.director_offset);
+
+    out->movie.title = out->title;
+    out->movie.director = out->director;
+    out->movie.year = record.year;
+    out->movie.rating = record.rating;
+    out->movie.id = index;
+    return PAGED_SUCCESS;
+}
+
+
+PagedError paged_catalog_read(PagedCatalog *paged, int index, PagedMovie *out)
+{
+    if (index < 0 || (uint32_t)index >= paged->header.record_count) return PAGED_ERROR_OUT_OF_RANGE;
+    if (paged->blocks) return read_packed(paged, index, out);
+
+    SnapshotRecord record;
+    if (!read_bytes(paged, paged->records_offset + (uint64_t)index * sizeof(record), &record, sizeof(record)))
+    {
+        return PAGED_ERROR_IO;
+    }
+    if (record.title_offset >= paged->header.string_table_size ||
+        record.director_offset >= paged->header.string_table_size)
+    {
+        return PAGED_ERROR_FORMAT;
+    }
+    if (!read_string(paged, record.title_offset, out->title, sizeof(out->title)) ||
+        !read_string(paged, record.director_offset, out->director, sizeof(out->director)))
+    {
+        return PAGED_ERROR_IO;
+    }
+
+    out->movie.title = out->title;
+    out->movie.director = out->director;
+    out->movie.year = record.year;
+    out->movie.rating = record.rating;
+    out->movie.id = index;
+    return PAGED_SUCCESS;
+}
+
+
+/**
+ * @brief Index of the first movie from `start` on whose title or director contains `query`.
+ *
+ * Matching ignores ASCII case, as in the movie list filter (see `movie_matches()`).
+ * The scan reads the file front to back through the cache, so it costs one
+ * pass over the file however little memory the cache has.
+ *
+ * @param paged The view.
+ * @param start First index to look at.
+ * @param query The text to look for.
+ * @return The index, or -1 if no movie from `start` on matches or the file could not be read.
+ */
+
+int paged_catalog_find(PagedCatalog *paged, int start, const char *query)
+{
+    PagedMovie movie;
+    int count = paged_catalog_count(paged);
+    for (int index = start < 0 ? 0 : start; index < count; ++index)
+    {
+        if (paged_catalog_read(paged, index, &movie) != PAGED_SUCCESS) return -1;
+        if (movie_matches(&movie.movie, query)) return index;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Bytes of file currently held in the cache, decoded blocks for a packed file.
+ */
+
+size_t paged_catalog_resident(const PagedCatalog *paged)
+{
+    size_t bytes = 0;
+    for (int slot = paged->newest; slot >= 0; slot = paged->pages[slot].older)
+    {
+        if (paged->pages[slot].loaded) bytes += paged->pages[slot].length;
+    }
+    return bytes;
+}
+
+
+/**
+ * @brief Bytes the cache holds at most once every page is loaded.
+ */
+
+size_t paged_catalog_budget(const PagedCatalog *paged)
+{
+    return (size_t)paged->page_count * paged->page_bytes;
+}
+
+
+/**
+ * @brief Closes the file and releases the cache.
+ *
+ * @param paged The view to close.
+ */
+
+void paged_catalog_close(PagedCatalog *paged)
+{
+    for (int i = 0; i < paged->page_count; ++i)
+    {
+        free(paged->pages[i].data);
+    }
+    free(paged->pages);
+    free(paged->buckets);
+    free(paged->blocks);
+    free(paged->compressed);
+    if (paged->fd >= 0) close(paged->fd);
+    memset(paged, 0, sizeof(*paged));
+    paged->fd = -1;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file perf.c
+ * @brief Storage and reporting of the perf counters (see perf.h).
+ *
+ * Every counter is updated with relaxed atomic adds, so spans may end on any
+ * thread (the parallel loader, a background save) without a lock, and the
+ * overlay may read while they do; a reading is a set of recent values rather
+ * than one consistent instant, which is all a live display needs.
+ *
+ * On glibc this file also defines `malloc()`, `calloc()` and `realloc()`,
+ * counting every call before handing it to the C library. A span's allocation
+ * tally is the difference of the totals at its two ends. With MOVIE_PERF off
+ * the whole file is empty.
+ */
+
+#ifdef MOVIE_PERF
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "perf.h"
+
+static PerfStats event_totals[PERF_EVENT_COUNT];
+
+static const char *const event_names[PERF_EVENT_COUNT] =
+{
+    [PERF_LOAD]   = "load",
+    [PERF_SAVE]   = "save",
+    [PERF_CREATE] = "create",
+    [PERF_UPDATE] = "update",
+    [PERF_DELETE] = "delete",
+    [PERF_SEARCH] = "search",
+    [PERF_SORT]   = "sort",
+    [PERF_FRAME]  = "frame",
+};
+
+#ifdef __GLIBC__
+
+static uint64_t allocation_count;
+static uint64_t allocation_bytes;
+
+// The C library's own entry points, which the definitions below forward to
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+
+static inline void count_allocation(size_t size)
+{
+    __atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocation_bytes, (uint64_t)size, __ATOMIC_RELAXED);
+}
+
+
+void *malloc(size_t size)
+{
+    count_allocation(size);
+    return __libc_malloc(size);
+}
+
+
+void *calloc(size_t count, size_t size)
+{
+    count_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+
+void *realloc(void *pointer, size_t size)
+{
+    count_allocation(size); // A resize may move the block, so the new size is what it costs
+    return __libc_realloc(pointer, size);
+}
+
+
+/**
+ * @brief Reads the allocations made and bytes requested since the start of the program.
+ *
+ * @return false where allocations are not counted; both totals are then 0.
+ */
+
+bool perf_alloc_totals(uint64_t *allocations, uint64_t *bytes)
+{
+    *allocations = __atomic_load_n(&allocation_count, __ATOMIC_RELAXED);
+    *bytes = __atomic_load_n(&allocation_bytes, __ATOMIC_RELAXED);
+    return true;
+}
+
+#else
+
+bool perf_alloc_totals(uint64_t *allocations, uint64_t *bytes)
+{
+    *allocations = 0;
+    *bytes = 0;
+    return false;
+}
+
+#endif
+
+
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+ * @brief Starts a timed section; use PERF_BEGIN() rather than calling this.
+ */
+
+PerfSpan perf_span_begin(void)
+{
+    PerfSpan span;
+    perf_alloc_totals(&span.allocations, &span.bytes);
+    span.start_ns = now_ns();
+    return span;
+}
+
+
+/**
+ * @brief Ends a timed section and adds it to the event's totals; use PERF_END().
+ */
+
+void perf_span_end(PerfEvent event, const PerfSpan *span)
+{
+    uint64_t elapsed = now_ns() - span->start_ns;
+    uint64_t allocations, bytes;
+    perf_alloc_totals(&allocations, &bytes);
+
+    PerfStats *event_stats = &event_totals[event];
+    int bucket = 63 - __builtin_clzll(elapsed | 1);
+    if (bucket >= PERF_BUCKETS) bucket = PERF_BUCKETS - 1;
+
+    __atomic_fetch_add(&event_stats->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&event_stats->total_ns, elapsed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&event_stats->allocations, allocations - span->allocations, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&event_stats->bytes, bytes - span->bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&event_stats->buckets[bucket], 1, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&event_stats->max_ns, __ATOMIC_RELAXED);
+    while (elapsed > max && !__atomic_compare_exchange_n(&event_stats->max_ns, &max, elapsed, true,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+        // max now holds the value another thread stored; try again while ours is larger
+    }
+}
+
+
+/**
+ * @brief Copies the current totals of an event.
+ */
+
+void perf_snapshot(PerfEvent event, PerfStats *out)
+{
+    const PerfStats *event_stats = &event_totals[event];
+    out->count = __atomic_load_n(&event_stats->count, __ATOMIC_RELAXED);
+    out->total_ns = __atomic_load_n(&event_stats->total_ns, __ATOMIC_RELAXED);
+    out->max_ns = __atomic_load_n(&event_stats->max_ns, __ATOMIC_RELAXED);
+    out->allocations = __atomic_load_n(&event_stats->allocations, __ATOMIC_RELAXED);
+    out->bytes = __atomic_load_n(&event_stats->bytes, __ATOMIC_RELAXED);
+    for (int b = 0; b < PERF_BUCKETS; ++b)
+    {
+        out->buckets[b] = __atomic_load_n(&event_stats->buckets[b], __ATOMIC_RELAXED);
+    }
+}
+
+
+/**
+ * @brief Estimates a latency percentile from the histogram.
+ *
+ * @param stats Totals from `perf_snapshot()`.
+ * @param fraction 0.5 for the median, 0.99 for p99.
+ * @return The upper bound of the bucket holding the percentile, at most the maximum seen;
+ *         0 when there are no spans.
+ */
+
+uint64_t perf_percentile(const PerfStats *stats, double fraction)
+{
+    uint64_t total = 0;
+    for (int b = 0; b < PERF_BUCKETS; ++b) total += stats->buckets[b];
+    if (total == 0) return 0;
+
+    uint64_t wanted = (uint64_t)(fraction * (double)total + 0.5);
+    if (wanted < 1) wanted = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < PERF_BUCKETS; ++b)
+    {
+        seen += stats->buckets[b];
+        if (seen >= wanted)
+        {
+            uint64_t bound = b == PERF_BUCKETS - 1 ? UINT64_MAX : (2ull << b) - 1;
+            return bound < stats->max_ns ? bound : stats->max_ns;
+        }
+    }
+    return stats->max_ns;
+}
+
+
+/**
+ * @brief Short lower-case name of an event, as used in the overlay and the dump.
+ */
+
+const char* perf_event_name(PerfEvent event)
+{
+    return (unsigned)event < PERF_EVENT_COUNT ? event_names[event] : "?";
+}
+
+
+/**
+ * @brief Writes the totals of every event to a JSON file.
+ *
+ * @param filename The file to create or replace.
+ * @return false if it could not be written.
+ */
+
+bool perf_dump(const char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (!file) return false;
+
+    uint64_t allocations, bytes;
+    bool counted = perf_alloc_totals(&allocations, &bytes);
+    fprintf(file, "{\n  \"alloc_counting\": %s,\n  \"events\": [\n", counted ? "true" : "false");
+    for (int event = 0; event < PERF_EVENT_COUNT; ++event)
+    {
+        PerfStats snapshot;
+        perf_snapshot((PerfEvent)event, &snapshot);
+        fprintf(file, "    {\"event\": \"%s\", \"count\": %llu, \"total_ns\": %llu, \"mean_ns\": %llu, "
+                      "\"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, \"allocations\": %llu, "
+                      "\"bytes_allocated\": %llu, \"histogram_log2_ns\": [",
+                perf_event_name((PerfEvent)event), (unsigned long long)snapshot.count,
+                (unsigned long long)snapshot.total_ns,
+                (unsigned long long)(snapshot.count ? snapshot.total_ns / snapshot.count : 0),
+                (unsigned long long)perf_percentile(&snapshot, 0.5), (unsigned long long)perf_percentile(&snapshot, 0.99),
+                (unsigned long long)snapshot.max_ns, (unsigned long long)snapshot.allocations,
+                (unsigned long long)snapshot.bytes);
+        for (int b = 0; b < PERF_BUCKETS; ++b)
+        {
+            fprintf(file, "%s%llu", b ? ", " : "", (unsigned long long)snapshot.buckets[b]);
+        }
+        fprintf(file, "]}%s\n", event + 1 < PERF_EVENT_COUNT ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
+
+#else
+
+typedef int perf_disabled; // ISO C wants at least one declaration per file
+
+#endif
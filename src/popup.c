@@ -16,6 +16,8 @@
  *   include variable arguments, similar to printf. It calculates the required size of the popup
  *   window, creates it, displays the message with word-wrapping, and waits for the user's input
  *   before cleaning up and returning control to the main program.
+ * - confirm_popup: Draws the same popup for a yes/no question and returns the answer. It is the
+ *   only modal call the application needs for routine work; status messages use `notify()`.
  *
  * Usage:
  * This module is intended to be used in text-based user interfaces where modal interaction is
@@ -49,61 +51,26 @@
 #include <stdarg.h>
 #include <string.h>
 #include <ncurses.h>
+#include "popup.h"
+#include "input.h"
 
 #define MAX_POPUP_WIDTH 60  // Maximum width of the popup window
 #define POPUP_MARGIN 3      // Margin for text inside the popup
 
 
 /**
- * @function show_popup
- * @brief Displays a popup window with a message and optional title.
- *
- * This function creates a modal popup window in the middle of the terminal screen using
- * ncurses functions. It is used to show messages to the user such as errors, warnings,
- * and information. The window will display the message and will wait for the user to
- * press a key before it returns control to the calling function.
- *
- * @param title A constant character pointer to the title of the popup window. If a title is
- * provided, it will be displayed at the top of the popup window. If this parameter is NULL,
- * no title will be shown.
- * @param format A constant character pointer to a format string that will be used to format
- * the message in the popup. This parameter follows the same specification as the format
- * parameter in the standard printf function.
- * @param ... A variable number of arguments that will be formatted into the message string
- * according to the format parameter.
- *
- * @note The function uses `printw`, `wrefresh`, `wgetch`, and other ncurses functions to
- * handle window drawing and input. The ncurses library must be initialized before this
- * function is called. Also, the function assumes that the maximum width of the popup and
- * the margins are defined by MAX_POPUP_WIDTH and POPUP_MARGIN constants.
- *
- * The popup will be bordered, and its size is dynamically calculated based on the length of
- * the message and the defined margins, but it will not exceed MAX_POPUP_WIDTH in width.
- * Word wrapping is implemented to handle messages that are longer than the popup's width.
- *
- * After displaying the message, the function will block and wait for any key press from the
- * user. Upon receiving a key press, it cleans up by deleting the popup window, clearing the
- * screen, and refreshing the main window to return it to its original state.
- *
- * Example Usage:
- * To show a popup with a message "File not found":
- * show_popup("Error", "File not found");
+ * @brief Draws the popup window for a formatted message.
  *
- * To show a popup with a formatted error message for a missing file:
- * show_popup("Error", "The file '%s' could not be opened.", filename);
+ * @param title Title shown above the message, or NULL.
+ * @param message The message, word-wrapped to the popup width.
+ * @return The popup window, already refreshed.
  */
 
-void show_popup(const char* title, const char* format, ...) 
+static WINDOW* open_popup(const char* title, char* message)
 {
     int rows, cols, starty, startx;
     int length, width;
     WINDOW *popupwin;
-    char message[256];
-    va_list args;
-
-    va_start(args, format);
-    vsnprintf(message, sizeof(message), format, args);
-    va_end(args);
 
     getmaxyx(stdscr, rows, cols);
 
@@ -156,8 +123,109 @@ void show_popup(const char* title, const char* format, ...)
     }
 
     wrefresh(popupwin);
-    wgetch(popupwin);
+    return popupwin;
+}
+
+
+/**
+ * @brief Removes a popup and repaints the screen underneath it.
+ */
+
+static void close_popup(WINDOW *popupwin)
+{
     delwin(popupwin);
     clear();
     refresh();
 }
+
+
+/**
+ * @function show_popup
+ * @brief Displays a popup window with a message and optional title.
+ *
+ * This function creates a modal popup window in the middle of the terminal screen using
+ * ncurses functions. It is used to show messages to the user such as errors, warnings,
+ * and information. The window will display the message and will wait for the user to
+ * press a key before it returns control to the calling function.
+ *
+ * @param title A constant character pointer to the title of the popup window. If a title is
+ * provided, it will be displayed at the top of the popup window. If this parameter is NULL,
+ * no title will be shown.
+ * @param format A constant character pointer to a format string that will be used to format
+ * the message in the popup. This parameter follows the same specification as the format
+ * parameter in the standard printf function.
+ * @param ... A variable number of arguments that will be formatted into the message string
+ * according to the format parameter.
+ *
+ * @note The function uses `printw`, `wrefresh`, `wgetch`, and other ncurses functions to
+ * handle window drawing and input. The ncurses library must be initialized before this
+ * function is called. Also, the function assumes that the maximum width of the popup and
+ * the margins are defined by MAX_POPUP_WIDTH and POPUP_MARGIN constants.
+ *
+ * The popup will be bordered, and its size is dynamically calculated based on the length of
+ * the message and the defined margins, but it will not exceed MAX_POPUP_WIDTH in width.
+ * Word wrapping is implemented to handle messages that are longer than the popup's width.
+ *
+ * After displaying the message, the function will block and wait for any key press from the
+ * user, so it is meant for messages that must not be missed; routine feedback goes through
+ * `notify()` instead. Upon receiving a key press, it cleans up by deleting the popup window, clearing the
+ * screen, and refreshing the main window to return it to its original state.
+ *
+ * Example Usage:
+ * To show a popup with a message "File not found":
+ * show_popup("Error", "File not found");
+ *
+ * To show a popup with a formatted error message for a missing file:
+ * show_popup("Error", "The file '%s' could not be opened.", filename);
+ */
+
+void show_popup(const char* title, const char* format, ...) 
+{
+    char message[256];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    WINDOW *popupwin = open_popup(title, message);
+    InputEvent event;
+    input_read(popupwin, -1, &event);
+    close_popup(popupwin);
+}
+
+
+/**
+ * @function confirm_popup
+ * @brief Asks a yes/no question in a modal popup.
+ *
+ * This is the one popup that still waits for the user, because the caller
+ * cannot go on without the answer. Everything else is reported with `notify()`.
+ * Only 'y'/'Y', 'n'/'N' and Esc close it; other keys are ignored.
+ *
+ * @param title Title of the popup, or NULL.
+ * @param format printf-style format of the question.
+ * @param ... Arguments for `format`.
+ * @return true if the user answered yes.
+ */
+
+bool confirm_popup(const char* title, const char* format, ...)
+{
+    char message[256];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    WINDOW *popupwin = open_popup(title, message);
+    flushinp(); // Don't let keys typed ahead answer the question
+    int ch;
+    do
+    {
+        InputEvent event;
+        ch = input_read(popupwin, -1, &event) ? event.key : ERR;
+    } while (ch != 'y' && ch != 'Y' && ch != 'n' && ch != 'N' && ch != 27);
+    close_popup(popupwin);
+    return ch == 'y' || ch == 'Y';
+}
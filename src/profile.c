@@ -0,0 +1,439 @@
+/**
+ * @file profile.c
+ * @brief Per-user movie ratings kept apart from the shared catalog.
+ *
+ * Several people can share one catalog: titles, directors and years are stored
+ * once, and each user's ratings live in a small file of their own (see
+ * profile.h). Only the active user's file is read, when they are chosen, so the
+ * cost of a profile is nine bytes per movie that user has rated, whatever the
+ * size of the catalog. Saving goes through the autosave worker like every other
+ * file written while the UI runs.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "profile.h"
+#include "storage.h"
+#include "notify.h"
+
+#define PROFILE_MIN_CAPACITY 64
+#define PROFILE_FILENAME_SIZE (PROFILE_NAME_SIZE + 32)
+
+// Context of a background save; the open profile may be another one by the time it finishes
+typedef struct
+{
+    Profile *profile;
+    char name[PROFILE_NAME_SIZE];
+} ProfileSave;
+
+
+/**
+ * @brief Empties a profile: no user is active.
+ *
+ * @param profile The profile to initialize.
+ */
+
+void profile_init(Profile *profile)
+{
+    memset(profile, 0, sizeof(*profile));
+}
+
+
+/**
+ * @brief Tells whether a user is active, so their ratings replace the catalog's.
+ *
+ * @param profile The profile, or NULL.
+ */
+
+bool profile_active(const Profile *profile)
+{
+    return profile != NULL && profile->name[0] != '\0';
+}
+
+
+/**
+ * @brief The key a movie's ratings are stored under: FNV-1a over its title and year.
+ *
+ * @param movie The movie.
+ * @return The key, never 0.
+ */
+
+uint64_t profile_movie_key(const Movie *movie)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char *p = (const unsigned char*)movie->title; *p; ++p)
+    {
+        hash = (hash ^ *p) * 1099511628211ull;
+    }
+    hash = (hash ^ 0xff) * 1099511628211ull; // Separates the title from the year
+    uint32_t year = (uint32_t)movie->year;
+    for (int i = 0; i < 4; ++i)
+    {
+        hash = (hash ^ ((year >> (8 * i)) & 0xff)) * 1099511628211ull;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+
+static bool valid_name(const char *name)
+{
+    size_t length = strlen(name);
+    if (length == 0 || length >= PROFILE_NAME_SIZE) return false;
+    for (size_t i = 0; i < length; ++i)
+    {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Slot holding `key`, or the free slot where it would go.
+ */
+
+static uint32_t find_slot(const Profile *profile, uint64_t key)
+{
+    uint32_t mask = profile->capacity - 1;
+    uint32_t slot = (uint32_t)(key ^ (key >> 32)) & mask;
+    while (profile->keys[slot] != 0 && profile->keys[slot] != key)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+/**
+ * @brief Rebuilds the table with room for `rated` ratings, dropping cleared ones.
+ */
+
+static ProfileError resize_table(Profile *profile, uint32_t rated)
+{
+    uint32_t capacity = PROFILE_MIN_CAPACITY;
+    while (capacity < UINT32_MAX / 2 && (uint64_t)capacity * 7 < (uint64_t)rated * 10) // Keep the load under 0.7
+    {
+        capacity *= 2;
+    }
+
+    Profile grown = *profile;
+    grown.keys = calloc(capacity, sizeof(*grown.keys));
+    grown.ratings = calloc(capacity, sizeof(*grown.ratings));
+    if (!grown.keys || !grown.ratings)
+    {
+        free(grown.keys);
+        free(grown.ratings);
+        return PROFILE_ERROR_MEMORY_ALLOCATION;
+    }
+    grown.capacity = capacity;
+    grown.used = 0;
+
+    for (uint32_t i = 0; i < profile->capacity; ++i)
+    {
+        if (profile->keys[i] == 0 || profile->ratings[i] == 0) continue;
+        uint32_t slot = find_slot(&grown, profile->keys[i]);
+        grown.keys[slot] = profile->keys[i];
+        grown.ratings[slot] = profile->ratings[i];
+        grown.used++;
+    }
+
+    free(profile->keys);
+    free(profile->ratings);
+    *profile = grown;
+    return PROFILE_SUCCESS;
+}
+
+
+/**
+ * @brief Stores a rating in tenths under `key`; 0 clears it.
+ */
+
+static ProfileError set_rating(Profile *profile, uint64_t key, uint8_t tenths)
+{
+    if (profile->capacity == 0 || (uint64_t)(profile->used + 1) * 10 > (uint64_t)profile->capacity * 7)
+    {
+        if (tenths == 0 && profile->capacity == 0) return PROFILE_SUCCESS;
+        ProfileError err = resize_table(profile, profile->rated + 1);
+        if (err != PROFILE_SUCCESS) return err;
+    }
+
+    uint32_t slot = find_slot(profile, key);
+    if (profile->keys[slot] == 0)
+    {
+        if (tenths == 0) return PROFILE_SUCCESS;
+        profile->keys[slot] = key;
+        profile->used++;
+    }
+    if (profile->ratings[slot] != 0) profile->rated--;
+    if (tenths != 0) profile->rated++;
+    profile->ratings[slot] = tenths;
+    return PROFILE_SUCCESS;
+}
+
+
+static void profile_filename(const char *name, char *buffer, size_t size)
+{
+    snprintf(buffer, size, PROFILE_FILE_FORMAT, name);
+}
+
+
+/**
+ * @brief Reads a profile file into an empty profile.
+ */
+
+static ProfileError load_profile(Profile *profile, const char *filename)
+{
+    char *data;
+    size_t size;
+    if (read_whole_file(filename, &data, &size) != 0)
+    {
+        return errno == ENOENT ? PROFILE_SUCCESS : PROFILE_ERROR_IO; // A new user has no file yet
+    }
+
+    ProfileHeader header;
+    if (size < sizeof(header))
+    {
+        free(data);
+        return PROFILE_ERROR_FORMAT;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, PROFILE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != PROFILE_VERSION
+        || size != sizeof(header) + (size_t)header.rated * (sizeof(uint64_t) + 1))
+    {
+        free(data);
+        return PROFILE_ERROR_FORMAT;
+    }
+
+    ProfileError err = resize_table(profile, header.rated);
+    const char *keys = data + sizeof(header);
+    const uint8_t *ratings = (const uint8_t*)keys + (size_t)header.rated * sizeof(uint64_t);
+    for (uint32_t i = 0; err == PROFILE_SUCCESS && i < header.rated; ++i)
+    {
+        uint64_t key;
+        memcpy(&key, keys + (size_t)i * sizeof(key), sizeof(key));
+        if (key == 0 || ratings[i] == 0 || ratings[i] > 5 * PROFILE_RATING_SCALE)
+        {
+            err = PROFILE_ERROR_FORMAT;
+            break;
+        }
+        err = set_rating(profile, key, ratings[i]);
+    }
+    free(data);
+    return err;
+}
+
+
+/**
+ * @brief Makes `name` the active user, reading their ratings.
+ *
+ * A user without a file starts with no ratings. The previous user's ratings are
+ * released, so save them first if they are dirty. A save of `name` still in the
+ * background must be waited for first, see `profile_wait_saved()`.
+ *
+ * @param profile The profile to switch.
+ * @param name The user; letters, digits, '-' and '_' only, as it names the file.
+ * @return PROFILE_SUCCESS, PROFILE_ERROR_NAME, PROFILE_ERROR_IO, PROFILE_ERROR_FORMAT
+ *         or PROFILE_ERROR_MEMORY_ALLOCATION. On error the profile is unchanged.
+ */
+
+ProfileError profile_open(Profile *profile, const char *name)
+{
+    if (!valid_name(name)) return PROFILE_ERROR_NAME;
+
+    char filename[PROFILE_FILENAME_SIZE];
+    profile_filename(name, filename, sizeof(filename));
+
+    Profile loaded;
+    profile_init(&loaded);
+    ProfileError err = load_profile(&loaded, filename);
+    if (err != PROFILE_SUCCESS)
+    {
+        profile_close(&loaded);
+        return err;
+    }
+
+    profile_close(profile);
+    *profile = loaded;
+    strcpy(profile->name, name);
+    return PROFILE_SUCCESS;
+}
+
+
+/**
+ * @brief Releases the active user's ratings; the catalog's own ratings apply again.
+ *
+ * @param profile The profile to close.
+ */
+
+void profile_close(Profile *profile)
+{
+    free(profile->keys);
+    free(profile->ratings);
+    profile_init(profile);
+}
+
+
+/**
+ * @brief The rating stored under a movie key (see `profile_movie_key()`).
+ *
+ * @param profile The profile.
+ * @param key The movie's key.
+ * @return The rating, or 0 if the user has not rated that movie.
+ */
+
+float profile_rating_key(const Profile *profile, uint64_t key)
+{
+    if (profile->capacity == 0) return 0.0f;
+    uint32_t slot = find_slot(profile, key);
+    return profile->keys[slot] != 0 ? (float)profile->ratings[slot] / PROFILE_RATING_SCALE : 0.0f;
+}
+
+
+/**
+ * @brief The active user's rating of a movie.
+ *
+ * @param profile The profile.
+ * @param movie The movie.
+ * @return The rating, or 0 if the user has not rated it.
+ */
+
+float profile_rating(const Profile *profile, const Movie *movie)
+{
+    return profile_rating_key(profile, profile_movie_key(movie));
+}
+
+
+/**
+ * @brief Stores a rating under a movie key (see `profile_movie_key()`).
+ *
+ * @param profile The profile.
+ * @param key The movie's key.
+ * @param rating 0 to 5, rounded to tenths; 0 clears the rating.
+ * @return PROFILE_SUCCESS, PROFILE_ERROR_OUT_OF_RANGE or PROFILE_ERROR_MEMORY_ALLOCATION.
+ */
+
+ProfileError profile_rate_key(Profile *profile, uint64_t key, float rating)
+{
+    if (!(rating >= 0.0f && rating <= 5.0f)) return PROFILE_ERROR_OUT_OF_RANGE;
+
+    ProfileError err = set_rating(profile, key, (uint8_t)lroundf(rating * PROFILE_RATING_SCALE));
+    if (err == PROFILE_SUCCESS) profile->dirty = true;
+    return err;
+}
+
+
+/**
+ * @brief Records the active user's rating of a movie.
+ *
+ * @param profile An active profile.
+ * @param movie The movie.
+ * @param rating 0 to 5, rounded to tenths; 0 clears the rating.
+ * @return PROFILE_SUCCESS, PROFILE_ERROR_OUT_OF_RANGE or PROFILE_ERROR_MEMORY_ALLOCATION.
+ */
+
+ProfileError profile_rate(Profile *profile, const Movie *movie, float rating)
+{
+    return profile_rate_key(profile, profile_movie_key(movie), rating);
+}
+
+
+/**
+ * @brief Builds the file image of a profile in memory.
+ */
+
+static char* capture_profile(const Profile *profile, size_t *size)
+{
+    ProfileHeader header;
+    memcpy(header.magic, PROFILE_MAGIC, sizeof(header.magic));
+    header.version = PROFILE_VERSION;
+    header.rated = profile->rated;
+    header.reserved = 0;
+
+    *size = sizeof(header) + (size_t)profile->rated * (sizeof(uint64_t) + 1);
+    char *data = malloc(*size);
+    if (!data) return NULL;
+
+    memcpy(data, &header, sizeof(header));
+    char *keys = data + sizeof(header);
+    uint8_t *ratings = (uint8_t*)keys + (size_t)profile->rated * sizeof(uint64_t);
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < profile->capacity; ++i)
+    {
+        if (profile->keys[i] == 0 || profile->ratings[i] == 0) continue;
+        memcpy(keys + (size_t)n * sizeof(uint64_t), &profile->keys[i], sizeof(uint64_t));
+        ratings[n++] = profile->ratings[i];
+    }
+    return data;
+}
+
+
+static void profile_save_done(void *context, bool ok)
+{
+    ProfileSave *save = context;
+    if (!ok)
+    {
+        if (strcmp(save->profile->name, save->name) == 0) save->profile->dirty = true; // Try again later
+        notify(NOTIFY_ERROR, "Failed to save the ratings of %s.", save->name);
+    }
+    free(save);
+}
+
+
+/**
+ * @brief Captures the active user's ratings and has the autosave worker write them.
+ *
+ * @param profile The profile; no longer `dirty` once captured.
+ * @param autosave The worker that writes the file.
+ * @return false if there was not enough memory to capture the ratings.
+ */
+
+bool save_profile_in_background(Profile *profile, Autosave *autosave)
+{
+    if (!profile_active(profile) || !profile->dirty) return true;
+
+    char filename[PROFILE_FILENAME_SIZE];
+    profile_filename(profile->name, filename, sizeof(filename));
+
+    ProfileSave *save = malloc(sizeof(*save));
+    AutosaveJob *job = save ? autosave_job_create(profile_save_done, save) : NULL;
+    size_t size;
+    char *data = job ? capture_profile(profile, &size) : NULL;
+    if (!data || !autosave_job_add_file(job, filename, data, size))
+    {
+        autosave_job_destroy(job);
+        free(save);
+        return false;
+    }
+
+    save->profile = profile;
+    strcpy(save->name, profile->name);
+    profile->dirty = false;
+    autosave_submit(autosave, job);
+    return true;
+}
+
+
+/**
+ * @brief Waits until the ratings file of `name` has no save still queued or being written.
+ *
+ * Call it before `profile_open()` on a user whose ratings may have just been
+ * saved in the background, such as one switched away from and back to.
+ *
+ * @param name The user.
+ * @param autosave The worker the saves were submitted to.
+ */
+
+void profile_wait_saved(const char *name, Autosave *autosave)
+{
+    char filename[PROFILE_FILENAME_SIZE];
+    profile_filename(name, filename, sizeof(filename));
+    autosave_wait_for_file(autosave, filename);
+}
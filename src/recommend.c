@@ -0,0 +1,712 @@
+/**
+ * @file recommend.c
+ * @brief "Movies you may like", from precomputed item-item similarities.
+ *
+ * The raters are the catalog itself (its shared `rating` field) and every user
+ * with a ratings file (profile.h). Each movie keeps its RECOMMEND_K nearest
+ * neighbours, so answering a query only walks the neighbour lists of the movies
+ * the user has rated: O(rated * K) however large the catalog is. The lists are
+ * built on the first query and afterwards refreshed one movie at a time as
+ * ratings change (see recommend.h).
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include "recommend.h"
+#include "catalog.h"
+
+#define RECOMMEND_MIDPOINT 2.5f  // Ratings above it count for a movie's neighbours, below against
+
+// Build-time map from profile_movie_key() to catalog id
+typedef struct
+{
+    uint64_t *keys;   // 0 marks a free slot
+    int *ids;
+    uint32_t mask;
+} KeyMap;
+
+typedef struct
+{
+    const char *director;
+    float rating;
+    int id;
+} DirectorEntry;
+
+
+/**
+ * @brief Starts without a table; the first query builds it.
+ *
+ * @param index The index to initialize.
+ */
+
+void recommend_init(RecommendIndex *index)
+{
+    memset(index, 0, sizeof(*index));
+}
+
+
+/**
+ * @brief Releases the table and the users' ratings, leaving the index unbuilt.
+ */
+
+static void release_table(RecommendIndex *index)
+{
+    for (int u = 0; u < index->user_count; ++u)
+    {
+        profile_close(&index->users[u].ratings);
+        free(index->users[u].items);
+    }
+    free(index->movies);
+    free(index->keys);
+    free(index->shared);
+    free(index->neighbors);
+    free(index->director_order);
+    free(index->order_position);
+    free(index->seen);
+    recommend_init(index);
+}
+
+
+/**
+ * @brief Marks the table out of date after movies were added, removed, edited or renumbered.
+ *
+ * @param index The index, or NULL if the catalog has none.
+ */
+
+void recommend_invalidate(RecommendIndex *index)
+{
+    if (index) index->stale = true;
+}
+
+
+/**
+ * @brief Tells whether the next query can use the table as it is, without a rebuild.
+ *
+ * @param index The index.
+ */
+
+bool recommend_ready(const RecommendIndex *index)
+{
+    return index->built && !index->stale;
+}
+
+
+/**
+ * @brief A user's rating of movie `id`, 0 if they have not rated it.
+ */
+
+static float user_rating(const RecommendIndex *index, int user, int id)
+{
+    if (user == 0) return index->shared[id];
+    return profile_rating_key(&index->users[user].ratings, index->keys[id]);
+}
+
+
+static float user_mean(const RecommendUser *user)
+{
+    return user->rated > 0 ? (float)(user->rating_sum / user->rated) : 0.0f;
+}
+
+
+/**
+ * @brief Notes a rating going from `old` to `rating` in a user's totals and item list.
+ *
+ * A cleared rating takes the movie off the list, so rating it again does not
+ * list it twice and count its neighbours twice.
+ */
+
+static bool count_rating(RecommendUser *user, int id, float old, float rating)
+{
+    if (old > 0.0f)
+    {
+        user->rating_sum -= old;
+        user->rated--;
+    }
+    if (rating <= 0.0f)
+    {
+        if (old <= 0.0f) return true;
+        for (int i = 0; i < user->item_count; ++i)
+        {
+            if (user->items[i] != id) continue;
+            user->items[i] = user->items[--user->item_count]; // Order does not matter
+            break;
+        }
+        return true;
+    }
+
+    user->rating_sum += rating;
+    user->rated++;
+    if (old > 0.0f) return true;
+
+    if (user->item_count == user->item_capacity)
+    {
+        int capacity = user->item_capacity ? user->item_capacity * 2 : 16;
+        int *items = realloc(user->items, (size_t)capacity * sizeof(*items));
+        if (!items) return false;
+        user->items = items;
+        user->item_capacity = capacity;
+    }
+    user->items[user->item_count++] = id;
+    return true;
+}
+
+
+/**
+ * @brief Similarity of two movies, 0 or less when they should not be neighbours.
+ *
+ * The cosine of the users' mean-centred ratings over the users who rated both,
+ * shrunk by n / (n + RECOMMEND_SHRINK) so that a coincidence between two users
+ * does not outweigh a pattern shared by twenty. Movies by one director get
+ * RECOMMEND_DIRECTOR_WEIGHT on top, in full for equal catalog ratings, falling
+ * to nothing five stars apart, and half of it if either is unrated.
+ */
+
+static float similarity(const RecommendIndex *index, int a, int b)
+{
+    double dot = 0.0, norm_a = 0.0, norm_b = 0.0;
+    int corated = 0;
+    for (int u = 0; u < index->user_count; ++u)
+    {
+        float ra = user_rating(index, u, a);
+        if (ra <= 0.0f) continue;
+        float rb = user_rating(index, u, b);
+        if (rb <= 0.0f) continue;
+
+        float mean = user_mean(&index->users[u]);
+        dot += (double)(ra - mean) * (rb - mean);
+        norm_a += (double)(ra - mean) * (ra - mean);
+        norm_b += (double)(rb - mean) * (rb - mean);
+        corated++;
+    }
+
+    float score = 0.0f;
+    if (corated >= RECOMMEND_MIN_CORATERS && norm_a > 0.0 && norm_b > 0.0)
+    {
+        score = (float)(dot / sqrt(norm_a * norm_b)) * corated / (corated + RECOMMEND_SHRINK);
+    }
+
+    const Movie *ma = index->movies[a];
+    const Movie *mb = index->movies[b];
+    if (ma->director == mb->director) // Interned, see name_table.h
+    {
+        float sa = index->shared[a], sb = index->shared[b];
+        if (sa > 0.0f && sb > 0.0f)
+        {
+            score += RECOMMEND_DIRECTOR_WEIGHT * (1.0f - fabsf(sa - sb) / 5.0f);
+        }
+        else
+        {
+            score += RECOMMEND_DIRECTOR_WEIGHT * 0.5f;
+        }
+    }
+    return score;
+}
+
+
+/**
+ * @brief Sets movie `item`'s score in a neighbour list, keeping the K best, best first.
+ *
+ * A score of 0 or less takes the movie out of the list.
+ */
+
+static void place_neighbor(RecommendNeighbor *row, int item, float score)
+{
+    int at = 0;
+    while (at < RECOMMEND_K && row[at].item != item && row[at].item >= 0) at++;
+
+    if (at < RECOMMEND_K && row[at].item == item)
+    {
+        // Take it out, then insert it again below if it still belongs
+        memmove(row + at, row + at + 1, (size_t)(RECOMMEND_K - 1 - at) * sizeof(*row));
+        row[RECOMMEND_K - 1].item = -1;
+        row[RECOMMEND_K - 1].score = 0.0f;
+    }
+    if (score <= 0.0f) return;
+
+    int last = RECOMMEND_K - 1;
+    if (row[last].item >= 0 && row[last].score >= score) return;
+
+    int slot = last;
+    while (slot > 0 && (row[slot - 1].item < 0 || row[slot - 1].score < score))
+    {
+        slot--;
+    }
+    memmove(row + slot + 1, row + slot, (size_t)(last - slot) * sizeof(*row));
+    row[slot].item = item;
+    row[slot].score = score;
+}
+
+
+/**
+ * @brief Begins a pass over candidates; a movie seen in the pass is skipped afterwards.
+ */
+
+static void begin_pass(RecommendIndex *index)
+{
+    if (++index->stamp == 0 || index->stamp < 0)
+    {
+        memset(index->seen, 0, (size_t)index->item_count * sizeof(*index->seen));
+        index->stamp = 1;
+    }
+}
+
+
+static bool first_visit(RecommendIndex *index, int id)
+{
+    if (index->seen[id] == index->stamp) return false;
+    index->seen[id] = index->stamp;
+    return true;
+}
+
+
+typedef void (*CandidateFn)(RecommendIndex *index, int item, int candidate);
+
+/**
+ * @brief Calls `visit` once for every movie that may be a neighbour of `item`.
+ *
+ * Those are the same-director movies nearest to it in rating, and the movies
+ * rated by any user who rated it, except users with more than
+ * RECOMMEND_MAX_USER_ITEMS ratings: they would make every pair a candidate.
+ */
+
+static void for_each_candidate(RecommendIndex *index, int item, CandidateFn visit)
+{
+    begin_pass(index);
+    first_visit(index, item);
+
+    const char *director = index->movies[item]->director;
+    int position = index->order_position[item];
+    int live = index->item_count; // director_order ends at the first -1
+    for (int step = 1; step <= RECOMMEND_DIRECTOR_WINDOW; ++step)
+    {
+        int before = position - step;
+        if (before < 0) break;
+        int id = index->director_order[before];
+        if (index->movies[id]->director != director) break;
+        if (first_visit(index, id)) visit(index, item, id);
+    }
+    for (int step = 1; step <= RECOMMEND_DIRECTOR_WINDOW; ++step)
+    {
+        int after = position + step;
+        if (after >= live || index->director_order[after] < 0) break;
+        int id = index->director_order[after];
+        if (index->movies[id]->director != director) break;
+        if (first_visit(index, id)) visit(index, item, id);
+    }
+
+    for (int u = 0; u < index->user_count; ++u)
+    {
+        const RecommendUser *user = &index->users[u];
+        if (user->item_count > RECOMMEND_MAX_USER_ITEMS) continue;
+        if (user_rating(index, u, item) <= 0.0f) continue;
+        for (int i = 0; i < user->item_count; ++i)
+        {
+            int id = user->items[i];
+            if (first_visit(index, id)) visit(index, item, id);
+        }
+    }
+}
+
+
+static void add_to_row(RecommendIndex *index, int item, int candidate)
+{
+    place_neighbor(&index->neighbors[(size_t)item * RECOMMEND_K], candidate, similarity(index, item, candidate));
+}
+
+
+static void update_candidate_row(RecommendIndex *index, int item, int candidate)
+{
+    place_neighbor(&index->neighbors[(size_t)candidate * RECOMMEND_K], item, similarity(index, item, candidate));
+}
+
+
+/**
+ * @brief Recomputes the neighbour list of one movie from its candidates.
+ */
+
+static void compute_row(RecommendIndex *index, int item)
+{
+    RecommendNeighbor *row = &index->neighbors[(size_t)item * RECOMMEND_K];
+    for (int k = 0; k < RECOMMEND_K; ++k)
+    {
+        row[k].item = -1;
+        row[k].score = 0.0f;
+    }
+    for_each_candidate(index, item, add_to_row);
+}
+
+
+static int compare_director_entries(const void *a, const void *b)
+{
+    const DirectorEntry *x = (const DirectorEntry*)a;
+    const DirectorEntry *y = (const DirectorEntry*)b;
+    if (x->director != y->director) return (uintptr_t)x->director < (uintptr_t)y->director ? -1 : 1;
+    if (x->rating != y->rating) return x->rating < y->rating ? -1 : 1;
+    return x->id - y->id;
+}
+
+
+/**
+ * @brief Orders the live movies by director, then rating, for the director windows.
+ */
+
+static bool order_by_director(RecommendIndex *index)
+{
+    int n = index->item_count;
+    DirectorEntry *entries = malloc((size_t)(n > 0 ? n : 1) * sizeof(*entries));
+    if (!entries) return false;
+
+    int live = 0;
+    for (int id = 0; id < n; ++id)
+    {
+        if (!index->movies[id]) continue;
+        entries[live].director = index->movies[id]->director;
+        entries[live].rating = index->shared[id];
+        entries[live].id = id;
+        live++;
+    }
+    qsort(entries, (size_t)live, sizeof(*entries), compare_director_entries);
+
+    for (int i = 0; i < n; ++i)
+    {
+        index->director_order[i] = i < live ? entries[i].id : -1;
+    }
+    for (int i = 0; i < live; ++i)
+    {
+        index->order_position[entries[i].id] = i;
+    }
+    free(entries);
+    return true;
+}
+
+
+static bool key_map_init(KeyMap *map, const RecommendIndex *index)
+{
+    uint32_t capacity = 64;
+    while (capacity < (uint32_t)index->item_count * 2) capacity *= 2;
+    map->keys = calloc(capacity, sizeof(*map->keys));
+    map->ids = malloc(capacity * sizeof(*map->ids));
+    map->mask = capacity - 1;
+    if (!map->keys || !map->ids) return false;
+
+    for (int id = 0; id < index->item_count; ++id)
+    {
+        if (!index->movies[id]) continue;
+        uint64_t key = index->keys[id];
+        uint32_t slot = (uint32_t)(key ^ (key >> 32)) & map->mask;
+        while (map->keys[slot] != 0 && map->keys[slot] != key) slot = (slot + 1) & map->mask;
+        map->keys[slot] = key; // A title and year seen twice keep the later id
+        map->ids[slot] = id;
+    }
+    return true;
+}
+
+
+static int key_map_find(const KeyMap *map, uint64_t key)
+{
+    uint32_t slot = (uint32_t)(key ^ (key >> 32)) & map->mask;
+    while (map->keys[slot] != 0)
+    {
+        if (map->keys[slot] == key) return map->ids[slot];
+        slot = (slot + 1) & map->mask;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Adds a user whose ratings are copied from `ratings`, listing the catalog movies they rated.
+ */
+
+static bool add_user(RecommendIndex *index, const char *name, const Profile *ratings, const KeyMap *map)
+{
+    if (index->user_count == RECOMMEND_MAX_USERS) return true; // The rest are left out
+    RecommendUser *user = &index->users[index->user_count];
+    memset(user, 0, sizeof(*user));
+    snprintf(user->name, sizeof(user->name), "%s", name);
+    profile_init(&user->ratings);
+    index->user_count++;
+
+    for (uint32_t slot = 0; slot < ratings->capacity; ++slot)
+    {
+        if (ratings->keys[slot] == 0 || ratings->ratings[slot] == 0) continue;
+
+        float rating = (float)ratings->ratings[slot] / PROFILE_RATING_SCALE;
+        if (profile_rate_key(&user->ratings, ratings->keys[slot], rating) != PROFILE_SUCCESS) return false;
+        int id = key_map_find(map, ratings->keys[slot]);
+        if (id >= 0 && !count_rating(user, id, 0.0f, rating)) return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Adds every user with a ratings file, taking the active user's ratings from memory.
+ */
+
+static bool load_users(RecommendIndex *index, const Profile *active, const KeyMap *map)
+{
+    if (profile_active(active) && !add_user(index, active->name, active, map)) return false;
+
+    DIR *dir = opendir(".");
+    if (!dir) return true; // Only the catalog's and the active user's ratings then
+
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL)
+    {
+        char name[PROFILE_NAME_SIZE];
+        size_t length = strlen(entry->d_name);
+        if (length <= 12 || strncmp(entry->d_name, "ratings-", 8) != 0 ||
+            strcmp(entry->d_name + length - 4, ".bin") != 0 || length - 12 >= sizeof(name))
+        {
+            continue;
+        }
+        memcpy(name, entry->d_name + 8, length - 12);
+        name[length - 12] = '\0';
+        if (profile_active(active) && strcmp(name, active->name) == 0) continue;
+
+        Profile profile;
+        profile_init(&profile);
+        if (profile_open(&profile, name) == PROFILE_SUCCESS) // Unreadable files are skipped
+        {
+            ok = add_user(index, name, &profile, map);
+        }
+        profile_close(&profile);
+    }
+    closedir(dir);
+    return ok;
+}
+
+
+/**
+ * @brief Builds the table from scratch over the current catalog and ratings files.
+ */
+
+static bool build_table(RecommendIndex *index, MovieCatalog *catalog, const Profile *active)
+{
+    release_table(index);
+
+    int n = catalog->movies.slot_count;
+    size_t slots = (size_t)(n > 0 ? n : 1);
+    index->item_count = n;
+    index->movies = calloc(slots, sizeof(*index->movies));
+    index->keys = calloc(slots, sizeof(*index->keys));
+    index->shared = calloc(slots, sizeof(*index->shared));
+    index->neighbors = malloc(slots * RECOMMEND_K * sizeof(*index->neighbors));
+    index->director_order = malloc(slots * sizeof(*index->director_order));
+    index->order_position = malloc(slots * sizeof(*index->order_position));
+    index->seen = calloc(slots, sizeof(*index->seen));
+    if (!index->movies || !index->keys || !index->shared || !index->neighbors ||
+        !index->director_order || !index->order_position || !index->seen)
+    {
+        release_table(index);
+        return false;
+    }
+
+    // User 0 is the catalog itself
+    index->user_count = 1;
+    memset(&index->users[0], 0, sizeof(index->users[0]));
+    for (int id = 0; id < n; ++id)
+    {
+        Movie *movie = catalog_get(catalog, id);
+        if (!movie) continue;
+        index->movies[id] = movie;
+        index->keys[id] = profile_movie_key(movie);
+        index->shared[id] = movie->rating;
+        if (!count_rating(&index->users[0], id, 0.0f, movie->rating))
+        {
+            release_table(index);
+            return false;
+        }
+    }
+
+    KeyMap map;
+    bool ok = key_map_init(&map, index) && load_users(index, active, &map) && order_by_director(index);
+    free(map.keys);
+    free(map.ids);
+    if (!ok)
+    {
+        release_table(index);
+        return false;
+    }
+
+    for (int id = 0; id < n; ++id)
+    {
+        if (index->movies[id]) compute_row(index, id);
+    }
+    index->built = true;
+    return true;
+}
+
+
+/**
+ * @brief Index of the rater behind `profile`, adding a user with no ratings yet if needed.
+ *
+ * @return The user, 0 for the catalog's shared ratings, or -1 if no more users fit.
+ */
+
+static int find_user(RecommendIndex *index, const Profile *profile)
+{
+    if (!profile_active(profile)) return 0;
+    for (int u = 1; u < index->user_count; ++u)
+    {
+        if (strcmp(index->users[u].name, profile->name) == 0) return u;
+    }
+    if (index->user_count == RECOMMEND_MAX_USERS) return -1;
+
+    RecommendUser *user = &index->users[index->user_count];
+    memset(user, 0, sizeof(*user));
+    snprintf(user->name, sizeof(user->name), "%s", profile->name);
+    profile_init(&user->ratings);
+    return index->user_count++;
+}
+
+
+/**
+ * @brief Updates the table after a rating changed, in time proportional to the movie's candidates.
+ *
+ * The movie's own neighbour list is recomputed, and its entry in the list of
+ * every candidate is replaced with the new similarity. Lists of movies that are
+ * not candidates of this one keep their old scores for it, and the changed
+ * user's mean moves the similarities of all their other movies slightly; both
+ * are caught up with by the next rebuild.
+ *
+ * @param index The index, or NULL if the catalog has none.
+ * @param profile The user who rated, or NULL or an inactive profile for the catalog's rating.
+ * @param movie The movie.
+ * @param rating The new rating, 0 if it was cleared.
+ */
+
+void recommend_rating_changed(RecommendIndex *index, const Profile *profile, const Movie *movie, float rating)
+{
+    if (!index || !recommend_ready(index)) return;
+    int id = movie->id;
+    if (id < 0 || id >= index->item_count || index->movies[id] != movie)
+    {
+        index->stale = true;
+        return;
+    }
+
+    int u = find_user(index, profile);
+    if (u < 0) return;
+
+    float old = user_rating(index, u, id);
+    if (u == 0)
+    {
+        index->shared[id] = rating;
+    }
+    else if (profile_rate_key(&index->users[u].ratings, index->keys[id], rating) != PROFILE_SUCCESS)
+    {
+        index->stale = true;
+        return;
+    }
+    if (!count_rating(&index->users[u], id, old, rating))
+    {
+        index->stale = true;
+        return;
+    }
+
+    compute_row(index, id);
+    for_each_candidate(index, id, update_candidate_row);
+}
+
+
+/**
+ * @brief The movies a user is most likely to enjoy among those they have not rated.
+ *
+ * Every movie the user rated lends its neighbours its similarity times how far
+ * the rating sits above or below the middle of the scale, and the movies with
+ * the highest totals win. Without an active profile the catalog's own ratings
+ * are the user's. Builds the table first if there is none or it is stale.
+ *
+ * @param index The index.
+ * @param catalog The catalog the movies come from.
+ * @param profile The active user, or NULL.
+ * @param[out] movies Receives up to `max` movies, best first.
+ * @param[out] scores Receives their scores, or NULL.
+ * @param max Room in `movies` and `scores`.
+ * @return The number of movies stored, or -1 if the table could not be built.
+ */
+
+int recommend_movies(RecommendIndex *index, MovieCatalog *catalog, const Profile *profile, Movie **movies, float *scores, int max)
+{
+    if (!recommend_ready(index))
+    {
+        if (!build_table(index, catalog, profile)) return -1;
+    }
+
+    int u = find_user(index, profile);
+    if (u < 0 || max <= 0) return 0;
+    const RecommendUser *user = &index->users[u];
+
+    float *totals = calloc((size_t)index->item_count + 1, sizeof(*totals));
+    int *touched = malloc(((size_t)index->item_count + 1) * sizeof(*touched));
+    if (!totals || !touched)
+    {
+        free(totals);
+        free(touched);
+        return -1;
+    }
+
+    int touched_count = 0;
+    begin_pass(index);
+    for (int i = 0; i < user->item_count; ++i)
+    {
+        int id = user->items[i];
+        float rating = user_rating(index, u, id);
+        if (rating <= 0.0f) continue;
+        float weight = (rating - RECOMMEND_MIDPOINT) / RECOMMEND_MIDPOINT;
+
+        const RecommendNeighbor *row = &index->neighbors[(size_t)id * RECOMMEND_K];
+        for (int k = 0; k < RECOMMEND_K && row[k].item >= 0; ++k)
+        {
+            int candidate = row[k].item;
+            if (user_rating(index, u, candidate) > 0.0f) continue;
+            if (first_visit(index, candidate)) touched[touched_count++] = candidate;
+            totals[candidate] += row[k].score * weight;
+        }
+    }
+
+    // Insertion into the `max` best; `max` is a screenful
+    int found = 0;
+    for (int i = 0; i < touched_count; ++i)
+    {
+        int candidate = touched[i];
+        float score = totals[candidate];
+        if (score <= 0.0f) continue;
+        if (found == max && score <= totals[movies[found - 1]->id]) continue;
+
+        int at = found < max ? found++ : max - 1;
+        while (at > 0 && totals[movies[at - 1]->id] < score)
+        {
+            movies[at] = movies[at - 1];
+            at--;
+        }
+        movies[at] = index->movies[candidate];
+    }
+    for (int i = 0; scores && i < found; ++i)
+    {
+        scores[i] = totals[movies[i]->id];
+    }
+
+    free(totals);
+    free(touched);
+    return found;
+}
+
+
+/**
+ * @brief Releases the table.
+ *
+ * @param index The index to destroy.
+ */
+
+void recommend_destroy(RecommendIndex *index)
+{
+    release_table(index);
+}
@@ -0,0 +1,268 @@
+/**
+ * @file snapshot.c
+ * @brief Versioned binary snapshot of the movie catalog.
+ *
+ * A snapshot is a fixed header, a fixed-width record array and a packed string
+ * table (see snapshot.h). Loading reads the whole file with one read, checks the
+ * header and the string offsets, and creates each movie pointing directly into
+ * the string table, so startup involves no text parsing at all. The buffer is
+ * handed to the catalog's string arena.
+ *
+ * Snapshots are written to a temporary file that is renamed over the previous
+ * one, so a crash while saving leaves the last good snapshot in place. The same
+ * image can instead be captured in memory for the autosave worker to write.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "storage.h"
+#include "perf.h"
+
+
+/**
+ * @brief Writes the catalog in snapshot format to an open stream.
+ *
+ * A first pass sizes the string table so the header, records and strings can
+ * all be written front to back; the stream never has to seek.
+ *
+ * @param file The stream to write to.
+ * @param catalog The catalog to save.
+ * @param generation Generation stamp stored in the header.
+ * @return SNAPSHOT_SUCCESS, SNAPSHOT_ERROR_IO if a write failed, or SNAPSHOT_ERROR_FORMAT
+ *         if the strings do not fit the 32-bit offsets of the format.
+ */
+
+static SnapshotError write_snapshot(FILE *file, const MovieCatalog *catalog, uint64_t generation)
+{
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.record_count = 0;
+    header.record_size = sizeof(SnapshotRecord);
+    header.string_table_size = 0;
+    header.generation = generation;
+
+    for (int i = 0; i < catalog->movies.slot_count; ++i)
+    {
+        const Movie *movie = catalog_get(catalog, i);
+        if (!movie) continue;
+        header.string_table_size += strlen(movie->title) + 1 + strlen(movie->director) + 1;
+        header.record_count++;
+    }
+    if (header.string_table_size > UINT32_MAX)
+    {
+        return SNAPSHOT_ERROR_FORMAT;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint32_t offset = 0;
+    for (int i = 0; ok && i < catalog->movies.slot_count; ++i)
+    {
+        const Movie *movie = catalog_get(catalog, i);
+        if (!movie) continue;
+
+        SnapshotRecord record;
+        record.year = movie->year;
+        record.rating = movie->rating;
+        record.title_offset = offset;
+        offset += (uint32_t)strlen(movie->title) + 1;
+        record.director_offset = offset;
+        offset += (uint32_t)strlen(movie->director) + 1;
+
+        ok = fwrite(&record, sizeof(record), 1, file) == 1;
+    }
+
+    for (int i = 0; ok && i < catalog->movies.slot_count; ++i)
+    {
+        const Movie *movie = catalog_get(catalog, i);
+        if (!movie) continue;
+        ok = fwrite(movie->title, strlen(movie->title) + 1, 1, file) == 1
+          && fwrite(movie->director, strlen(movie->director) + 1, 1, file) == 1;
+    }
+    return ok ? SNAPSHOT_SUCCESS : SNAPSHOT_ERROR_IO;
+}
+
+
+/**
+ * @brief Writes the catalog to a snapshot file.
+ *
+ * @param[in] filename Destination path. The data is written to `<filename>.tmp` first
+ *                     and then renamed into place.
+ * @param[in] catalog The catalog to save.
+ * @param[in] generation Generation stamp stored in the header.
+ * @return SNAPSHOT_SUCCESS, SNAPSHOT_ERROR_IO if writing failed, or SNAPSHOT_ERROR_FORMAT
+ *         if the strings do not fit the 32-bit offsets of the format.
+ */
+
+SnapshotError save_snapshot(const char *filename, const MovieCatalog *catalog, uint64_t generation)
+{
+    char tmp_name[1024];
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", filename);
+    PERF_BEGIN(span);
+
+    FILE *file = fopen(tmp_name, "wb");
+    if (!file)
+    {
+        perror("Error opening snapshot for writing");
+        return SNAPSHOT_ERROR_IO;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    SnapshotError err = write_snapshot(file, catalog, generation);
+    if (fclose(file) != 0 && err == SNAPSHOT_SUCCESS) err = SNAPSHOT_ERROR_IO;
+
+    if (err == SNAPSHOT_SUCCESS && rename(tmp_name, filename) != 0) err = SNAPSHOT_ERROR_IO;
+    if (err != SNAPSHOT_SUCCESS)
+    {
+        if (err == SNAPSHOT_ERROR_IO) perror("Error writing snapshot");
+        remove(tmp_name);
+        return err;
+    }
+
+    PERF_END(span, PERF_SAVE);
+    return SNAPSHOT_SUCCESS;
+}
+
+
+/**
+ * @brief Builds a snapshot image of the catalog in memory, for saving elsewhere.
+ *
+ * @param[in] catalog The catalog to capture.
+ * @param[in] generation Generation stamp stored in the header.
+ * @param[out] data Receives the image, allocated with malloc.
+ * @param[out] size Receives its size in bytes.
+ * @return SNAPSHOT_SUCCESS, SNAPSHOT_ERROR_FORMAT as for `save_snapshot()`, or
+ *         SNAPSHOT_ERROR_MEMORY_ALLOCATION.
+ */
+
+SnapshotError capture_snapshot(const MovieCatalog *catalog, uint64_t generation, char **data, size_t *size)
+{
+    FILE *file = open_memstream(data, size);
+    if (!file)
+    {
+        return SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+    }
+
+    SnapshotError err = write_snapshot(file, catalog, generation);
+    if (err == SNAPSHOT_ERROR_IO) err = SNAPSHOT_ERROR_MEMORY_ALLOCATION; // A memory stream only fails to grow
+    if (fclose(file) != 0 && err == SNAPSHOT_SUCCESS) err = SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+    if (err != SNAPSHOT_SUCCESS)
+    {
+        free(*data);
+        *data = NULL;
+    }
+    return err;
+}
+
+
+/**
+ * @brief Appends the movies of a snapshot file to the catalog.
+ *
+ * At startup the catalog is empty, so the movies get ids 0 to N-1 in file order,
+ * the ids the journal of this generation refers to. An import (see batch.c) adds
+ * them to a populated catalog instead, under the next free ids.
+ *
+ * @param[in] filename The snapshot to read.
+ * @param[in,out] catalog The catalog to add to. It takes ownership of the file buffer.
+ * @param[out] generation Receives the generation stamp of the snapshot.
+ * @return SNAPSHOT_SUCCESS, SNAPSHOT_ERROR_IO if the file could not be read,
+ *         SNAPSHOT_ERROR_FORMAT if it is not a valid snapshot of this version or holds a
+ *         movie `create_movie_borrowed()` refuses, or SNAPSHOT_ERROR_MEMORY_ALLOCATION.
+ *         On error the catalog is left unchanged.
+ */
+
+SnapshotError load_snapshot(const char *filename, MovieCatalog *catalog, uint64_t *generation)
+{
+    char *data;
+    size_t size;
+
+    PERF_BEGIN(span);
+    if (read_whole_file(filename, &data, &size) != 0)
+    {
+        return SNAPSHOT_ERROR_IO;
+    }
+
+    SnapshotHeader header;
+    if (size < sizeof(header))
+    {
+        free(data);
+        return SNAPSHOT_ERROR_FORMAT;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    size_t records_size = (size_t)header.record_count * sizeof(SnapshotRecord);
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+        || header.version != SNAPSHOT_VERSION
+        || header.record_size != sizeof(SnapshotRecord)
+        || size != sizeof(header) + records_size + header.string_table_size
+        || (header.string_table_size > 0 && data[size - 1] != '\0'))
+    {
+        free(data);
+        return SNAPSHOT_ERROR_FORMAT;
+    }
+
+    const SnapshotRecord *records = (const SnapshotRecord*)(data + sizeof(header));
+    char *strings = data + sizeof(header) + records_size;
+    for (uint32_t i = 0; i < header.record_count; ++i)
+    {
+        if (records[i].title_offset >= header.string_table_size
+            || records[i].director_offset >= header.string_table_size
+            || records[i].year <= 1800) // Refused by create_movie_borrowed(), which would shift the ids after it
+        {
+            free(data);
+            return SNAPSHOT_ERROR_FORMAT;
+        }
+    }
+
+    if (catalog_reserve(catalog, (int)header.record_count) != MOVIE_SUCCESS
+        || string_arena_adopt(&catalog->movies.strings, data) != 0)
+    {
+        free(data);
+        return SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+    }
+
+    for (uint32_t i = 0; i < header.record_count; ++i)
+    {
+        if (!create_movie_borrowed(catalog,
+                                   strings + records[i].title_offset,
+                                   strings + records[i].director_offset,
+                                   records[i].year,
+                                   records[i].rating))
+        {
+            // Out of memory; the buffer stays with the arena until the catalog is destroyed
+            catalog_discard_borrowed(catalog, data, data + size);
+            return SNAPSHOT_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+    *generation = header.generation;
+
+    PERF_END(span, PERF_LOAD);
+    return SNAPSHOT_SUCCESS;
+}
+
+
+/**
+ * @brief Reads the generation from a snapshot's header, without loading it.
+ *
+ * @param filename Path of the snapshot.
+ * @param generation Receives the generation.
+ * @return true if the file exists and starts with a header of this version.
+ */
+
+bool snapshot_peek_generation(const char *filename, uint64_t *generation)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file) return false;
+
+    SnapshotHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+           && memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0
+           && header.version == SNAPSHOT_VERSION;
+    fclose(file);
+
+    if (ok) *generation = header.generation;
+    return ok;
+}
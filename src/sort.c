@@ -0,0 +1,370 @@
+/**
+ * @file sort.c
+ * @brief Multi-key sorting of record pointer arrays.
+ *
+ * Two algorithms are used depending on the key list:
+ *
+ * - Numeric keys only (year, rating, seasons...): an LSD radix sort. Each key is
+ *   mapped to an order-preserving unsigned 32-bit value and sorted with stable
+ *   byte passes, least significant key first. Passes whose byte is the same for
+ *   every record (the upper bytes of a year, for instance) are skipped.
+ *
+ * - Any string key: a stable bottom-up merge sort over compact
+ *   { 64-bit key, record } entries. The key caches the most significant field:
+ *   the first eight case-folded bytes of a string in big-endian order, or the
+ *   order-preserving value of a number. Most comparisons are then a single
+ *   integer compare on data that sits next to each other in memory; a record is
+ *   only dereferenced when two cached keys tie.
+ *
+ * Both are O(n log n) or better and stable, so records that compare equal on
+ * every key keep their original order.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sort.h"
+#include "perf.h"
+
+#define FIELD_PTR(record, field) ((const char*)(record) + (field)->offset)
+#define INSERTION_SORT_RUN 16
+
+typedef struct
+{
+    uint64_t key;  // Collation key of the first field
+    void *record;
+} SortEntry;
+
+typedef struct
+{
+    uint32_t key;
+    void *record;
+} RadixEntry;
+
+
+static inline unsigned char fold(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+
+/**
+ * @brief Compares two strings ASCII case-insensitively.
+ */
+
+static int compare_folded(const char *a, const char *b)
+{
+    const unsigned char *pa = (const unsigned char*)a;
+    const unsigned char *pb = (const unsigned char*)b;
+    while (*pa && fold(*pa) == fold(*pb))
+    {
+        pa++;
+        pb++;
+    }
+    return (int)fold(*pa) - (int)fold(*pb);
+}
+
+
+/**
+ * @brief Maps an int to an unsigned value with the same order.
+ */
+
+static inline uint32_t int_key(int value)
+{
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+
+/**
+ * @brief Maps a float to an unsigned value with the same order (IEEE 754 total order).
+ */
+
+static inline uint32_t float_key(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+
+/**
+ * @brief Builds the cached 64-bit prefix of a string key.
+ */
+
+static inline uint64_t string_prefix(const char *s)
+{
+    uint64_t key = 0;
+    int i = 0;
+    for (; i < 8 && s[i]; ++i)
+    {
+        key = (key << 8) | fold((unsigned char)s[i]);
+    }
+    return i == 0 ? 0 : key << (8 * (8 - i));
+}
+
+
+/**
+ * @brief Returns the order-preserving 32-bit key of a numeric field.
+ */
+
+static inline uint32_t numeric_key(const void *record, const SortField *field)
+{
+    uint32_t key;
+    if (field->type == SORT_FIELD_FLOAT)
+    {
+        float value;
+        memcpy(&value, FIELD_PTR(record, field), sizeof(value));
+        key = float_key(value);
+    }
+    else
+    {
+        int value;
+        memcpy(&value, FIELD_PTR(record, field), sizeof(value));
+        key = int_key(value);
+    }
+    return field->descending ? ~key : key;
+}
+
+
+/**
+ * @brief Compares two records on a single field.
+ */
+
+static int compare_field(const void *a, const void *b, const SortField *field)
+{
+    int result;
+    if (field->type == SORT_FIELD_STRING)
+    {
+        const char *sa = *(const char* const*)FIELD_PTR(a, field);
+        const char *sb = *(const char* const*)FIELD_PTR(b, field);
+        result = sa == sb ? 0 : compare_folded(sa, sb); // Interned names are equal exactly when shared
+        if (field->descending) result = -result;
+    }
+    else
+    {
+        uint32_t ka = numeric_key(a, field);
+        uint32_t kb = numeric_key(b, field);
+        result = (ka > kb) - (ka < kb);
+    }
+    return result;
+}
+
+
+/**
+ * @brief Compares two records on a list of fields.
+ *
+ * @param a First record.
+ * @param b Second record.
+ * @param fields The sort keys, most significant first.
+ * @param field_count Number of keys.
+ * @return Negative, zero or positive like strcmp.
+ */
+
+int sort_compare_records(const void *a, const void *b, const SortField *fields, int field_count)
+{
+    for (int i = 0; i < field_count; ++i)
+    {
+        int result = compare_field(a, b, &fields[i]);
+        if (result != 0) return result;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Radix-sorts records on numeric keys, least significant key first.
+ */
+
+static bool radix_sort(void **records, size_t count, const SortField *fields, int field_count)
+{
+    RadixEntry *entries = (RadixEntry*)malloc(count * sizeof(RadixEntry));
+    RadixEntry *scratch = (RadixEntry*)malloc(count * sizeof(RadixEntry));
+    if (!entries || !scratch)
+    {
+        free(entries);
+        free(scratch);
+        return false;
+    }
+
+    for (int f = field_count - 1; f >= 0; --f)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            entries[i].record = records[i];
+            entries[i].key = numeric_key(records[i], &fields[f]);
+        }
+
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            size_t histogram[256] = {0};
+            for (size_t i = 0; i < count; ++i)
+            {
+                histogram[(entries[i].key >> shift) & 0xFF]++;
+            }
+            if (histogram[(entries[0].key >> shift) & 0xFF] == count)
+            {
+                continue; // Every record has the same byte here
+            }
+
+            size_t offset = 0;
+            for (int b = 0; b < 256; ++b)
+            {
+                size_t n = histogram[b];
+                histogram[b] = offset;
+                offset += n;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                scratch[histogram[(entries[i].key >> shift) & 0xFF]++] = entries[i];
+            }
+            RadixEntry *tmp = entries;
+            entries = scratch;
+            scratch = tmp;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            records[i] = entries[i].record;
+        }
+    }
+
+    free(entries);
+    free(scratch);
+    return true;
+}
+
+
+/**
+ * @brief Compares two merge sort entries, using the cached prefix first.
+ */
+
+static inline int compare_entries(const SortEntry *a, const SortEntry *b, const SortField *fields, int field_count)
+{
+    if (a->key != b->key)
+    {
+        return a->key < b->key ? -1 : 1;
+    }
+    // Prefixes tie: compare the full first field, then the remaining ones
+    return sort_compare_records(a->record, b->record, fields, field_count);
+}
+
+
+/**
+ * @brief Stable merge sort of prefix-keyed entries.
+ */
+
+static bool merge_sort(void **records, size_t count, const SortField *fields, int field_count)
+{
+    SortEntry *entries = (SortEntry*)malloc(count * sizeof(SortEntry));
+    SortEntry *scratch = (SortEntry*)malloc(count * sizeof(SortEntry));
+    if (!entries || !scratch)
+    {
+        free(entries);
+        free(scratch);
+        return false;
+    }
+
+    const SortField *first = &fields[0];
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t key;
+        if (first->type == SORT_FIELD_STRING)
+        {
+            key = string_prefix(*(const char* const*)FIELD_PTR(records[i], first));
+            if (first->descending) key = ~key;
+        }
+        else
+        {
+            key = (uint64_t)numeric_key(records[i], first) << 32; // Already direction-adjusted
+        }
+        entries[i].key = key;
+        entries[i].record = records[i];
+    }
+
+    // Insertion-sort short runs, then merge them pairwise
+    for (size_t start = 0; start < count; start += INSERTION_SORT_RUN)
+    {
+        size_t end = start + INSERTION_SORT_RUN < count ? start + INSERTION_SORT_RUN : count;
+        for (size_t i = start + 1; i < end; ++i)
+        {
+            SortEntry item = entries[i];
+            size_t j = i;
+            while (j > start && compare_entries(&entries[j - 1], &item, fields, field_count) > 0)
+            {
+                entries[j] = entries[j - 1];
+                j--;
+            }
+            entries[j] = item;
+        }
+    }
+
+    for (size_t width = INSERTION_SORT_RUN; width < count; width *= 2)
+    {
+        for (size_t left = 0; left < count; left += 2 * width)
+        {
+            size_t mid = left + width < count ? left + width : count;
+            size_t right = left + 2 * width < count ? left + 2 * width : count;
+            size_t i = left, j = mid, k = left;
+
+            if (mid == right || compare_entries(&entries[mid - 1], &entries[mid], fields, field_count) <= 0)
+            {
+                memcpy(&scratch[left], &entries[left], (right - left) * sizeof(SortEntry));
+                continue; // Already in order
+            }
+            while (i < mid && j < right)
+            {
+                if (compare_entries(&entries[j], &entries[i], fields, field_count) < 0)
+                    scratch[k++] = entries[j++];
+                else
+                    scratch[k++] = entries[i++];
+            }
+            while (i < mid) scratch[k++] = entries[i++];
+            while (j < right) scratch[k++] = entries[j++];
+        }
+        SortEntry *tmp = entries;
+        entries = scratch;
+        scratch = tmp;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        records[i] = entries[i].record;
+    }
+
+    free(entries);
+    free(scratch);
+    return true;
+}
+
+
+/**
+ * @brief Sorts an array of record pointers on a list of keys.
+ *
+ * @param records The array to sort in place.
+ * @param count Number of records. NULL entries are not allowed.
+ * @param fields The sort keys, most significant first.
+ * @param field_count Number of keys, 1 to SORT_MAX_FIELDS.
+ * @return true on success, false if the scratch memory could not be allocated
+ *         (the array is left unchanged).
+ */
+
+bool sort_records(void **records, size_t count, const SortField *fields, int field_count)
+{
+    if (count < 2 || field_count < 1) return true;
+    if (field_count > SORT_MAX_FIELDS) field_count = SORT_MAX_FIELDS;
+
+    bool numeric = true;
+    for (int i = 0; i < field_count; ++i)
+    {
+        // A string tie-breaker behind a numeric key: the numeric key becomes
+        // the cached prefix and the merge falls back to the full key list
+        if (fields[i].type == SORT_FIELD_STRING) numeric = false;
+    }
+
+    PERF_BEGIN(span);
+    bool sorted = numeric ? radix_sort(records, count, fields, field_count)
+                          : merge_sort(records, count, fields, field_count);
+    PERF_END(span, PERF_SORT);
+    return sorted;
+}
@@ -0,0 +1,436 @@
+/**
+ * @file sorted_view.c
+ * @brief Indexable skip list used for the catalog's maintained orderings.
+ *
+ * Every node carries a tower of links; link `i` of a node points to the next
+ * node that reaches level `i` and records its span, the number of bottom-level
+ * steps it covers. Walking down from the top level while summing spans gives
+ * the rank of any position in O(log N), which is what lets the UI jump straight
+ * to page K of an ordering without walking the records before it.
+ *
+ * Tower heights are geometric with p = 1/4. `sorted_view_build()` links a whole
+ * sorted array in one pass instead of inserting record by record.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <stdint.h>
+#include "sorted_view.h"
+
+typedef struct
+{
+    SortedViewNode *next;
+    size_t span;  // Bottom-level steps to `next` (to the end of the list when next is NULL)
+} SortedViewLink;
+
+struct SortedViewNode
+{
+    void *record;
+    int height;
+    SortedViewLink links[]; // `height` entries
+};
+
+#define NODES_PER_SLAB_BLOCK 1024
+
+
+/**
+ * @brief Total order of the view: the key list, then the record address.
+ */
+
+static inline int compare(const SortedView *view, const void *a, const void *b)
+{
+    int result = sort_compare_records(a, b, view->fields, view->field_count);
+    if (result != 0) return result;
+    return ((uintptr_t)a > (uintptr_t)b) - ((uintptr_t)a < (uintptr_t)b);
+}
+
+
+static int compare_addresses(const void *a, const void *b)
+{
+    uintptr_t pa = (uintptr_t)*(void* const*)a;
+    uintptr_t pb = (uintptr_t)*(void* const*)b;
+    return (pa > pb) - (pa < pb);
+}
+
+
+/**
+ * @brief Draws a tower height (xorshift32, a quarter of the nodes go one level up).
+ */
+
+static int random_height(SortedView *view)
+{
+    int height = 1;
+    uint32_t x = view->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    view->seed = x;
+
+    while ((x & 3) == 0 && height < SORTED_VIEW_MAX_LEVEL)
+    {
+        height++;
+        x >>= 2;
+    }
+    return height;
+}
+
+
+static SortedViewNode* new_node(SortedView *view, void *record, int height)
+{
+    SortedViewNode *node = (SortedViewNode*)slab_alloc(&view->pools[height - 1]);
+    if (!node) return NULL;
+    node->record = record;
+    node->height = height;
+    return node;
+}
+
+
+/**
+ * @brief Prepares an empty, unbuilt view.
+ *
+ * @param view The view to initialize.
+ * @param fields The sort keys, most significant first (copied).
+ * @param field_count Number of keys, 1 to SORT_MAX_FIELDS.
+ * @return true on success, false if the sentinel could not be allocated.
+ */
+
+bool sorted_view_init(SortedView *view, const SortField *fields, int field_count)
+{
+    if (field_count > SORT_MAX_FIELDS) field_count = SORT_MAX_FIELDS;
+    for (int i = 0; i < field_count; ++i)
+    {
+        view->fields[i] = fields[i];
+    }
+    view->field_count = field_count;
+
+    for (int h = 1; h <= SORTED_VIEW_MAX_LEVEL; ++h)
+    {
+        size_t per_block = NODES_PER_SLAB_BLOCK >> (2 * (h - 1));
+        slab_init(&view->pools[h - 1], sizeof(SortedViewNode) + (size_t)h * sizeof(SortedViewLink),
+                  per_block < 16 ? 16 : per_block);
+    }
+
+    view->head = (SortedViewNode*)malloc(sizeof(SortedViewNode) + SORTED_VIEW_MAX_LEVEL * sizeof(SortedViewLink));
+    if (!view->head) return false;
+    view->head->record = NULL;
+    view->head->height = SORTED_VIEW_MAX_LEVEL;
+    view->seed = 0x9E3779B9u;
+    sorted_view_clear(view);
+    return true;
+}
+
+
+/**
+ * @brief Drops every record and marks the view as unbuilt.
+ *
+ * An unbuilt view ignores inserts and removes until it is built again, which
+ * is how a view that ran out of memory falls back to being rebuilt on demand.
+ */
+
+void sorted_view_clear(SortedView *view)
+{
+    for (int h = 0; h < SORTED_VIEW_MAX_LEVEL; ++h)
+    {
+        slab_destroy(&view->pools[h]);
+        view->head->links[h].next = NULL;
+        view->head->links[h].span = 0;
+    }
+    view->level = 1;
+    view->count = 0;
+    view->built = false;
+}
+
+
+/**
+ * @brief Releases the view. The records themselves are not touched.
+ */
+
+void sorted_view_destroy(SortedView *view)
+{
+    if (!view->head) return;
+    sorted_view_clear(view);
+    free(view->head);
+    view->head = NULL;
+}
+
+
+/**
+ * @brief Replaces the contents of the view with `records`, sorted.
+ *
+ * The records are sorted with sort_records() and linked bottom to top in a
+ * single pass, which is much cheaper than `count` individual inserts.
+ *
+ * @param view The view to build.
+ * @param records The records to hold, in any order. NULL entries are skipped.
+ *                The array is not modified.
+ * @param count Number of entries in `records`.
+ * @return true on success, false on allocation failure (the view is left unbuilt).
+ */
+
+bool sorted_view_build(SortedView *view, void *const *records, size_t count)
+{
+    sorted_view_clear(view);
+
+    void **sorted = (void**)malloc((count ? count : 1) * sizeof(void*));
+    if (!sorted) return false;
+    size_t live = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (records[i]) sorted[live++] = records[i];
+    }
+    count = live;
+    if (!sort_records(sorted, count, view->fields, view->field_count))
+    {
+        free(sorted);
+        return false;
+    }
+
+    // The stable sort keeps equal keys in input order; the view breaks those ties by address
+    for (size_t start = 0; start < count; )
+    {
+        size_t end = start + 1;
+        while (end < count && sort_compare_records(sorted[start], sorted[end], view->fields, view->field_count) == 0)
+        {
+            end++;
+        }
+        if (end - start > 1)
+        {
+            qsort(&sorted[start], end - start, sizeof(void*), compare_addresses);
+        }
+        start = end;
+    }
+
+    SortedViewNode *last[SORTED_VIEW_MAX_LEVEL];
+    size_t last_rank[SORTED_VIEW_MAX_LEVEL];
+    for (int h = 0; h < SORTED_VIEW_MAX_LEVEL; ++h)
+    {
+        last[h] = view->head;
+        last_rank[h] = 0;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        int height = random_height(view);
+        SortedViewNode *node = new_node(view, sorted[i], height);
+        if (!node)
+        {
+            free(sorted);
+            sorted_view_clear(view);
+            return false;
+        }
+        for (int h = 0; h < height; ++h)
+        {
+            last[h]->links[h].next = node;
+            last[h]->links[h].span = (i + 1) - last_rank[h];
+            last[h] = node;
+            last_rank[h] = i + 1;
+        }
+        if (height > view->level) view->level = height;
+    }
+    for (int h = 0; h < view->level; ++h)
+    {
+        last[h]->links[h].next = NULL;
+        last[h]->links[h].span = count - last_rank[h];
+    }
+
+    free(sorted);
+    view->count = count;
+    view->built = true;
+    return true;
+}
+
+
+/**
+ * @brief Adds a record at its sorted position. Does nothing on an unbuilt view.
+ *
+ * @param view The view.
+ * @param record The record to add; it must not already be in the view.
+ * @return false if a node could not be allocated; the view is then cleared
+ *         and has to be built again.
+ */
+
+bool sorted_view_insert(SortedView *view, void *record)
+{
+    if (!view->built) return true;
+
+    SortedViewNode *update[SORTED_VIEW_MAX_LEVEL];
+    size_t rank[SORTED_VIEW_MAX_LEVEL];
+    SortedViewNode *x = view->head;
+
+    for (int i = view->level - 1; i >= 0; --i)
+    {
+        rank[i] = (i == view->level - 1) ? 0 : rank[i + 1];
+        while (x->links[i].next && compare(view, x->links[i].next->record, record) < 0)
+        {
+            rank[i] += x->links[i].span;
+            x = x->links[i].next;
+        }
+        update[i] = x;
+    }
+
+    int height = random_height(view);
+    SortedViewNode *node = new_node(view, record, height);
+    if (!node)
+    {
+        sorted_view_clear(view);
+        return false;
+    }
+
+    if (height > view->level)
+    {
+        for (int i = view->level; i < height; ++i)
+        {
+            rank[i] = 0;
+            update[i] = view->head;
+            update[i]->links[i].span = view->count;
+        }
+        view->level = height;
+    }
+
+    for (int i = 0; i < height; ++i)
+    {
+        node->links[i].next = update[i]->links[i].next;
+        node->links[i].span = update[i]->links[i].span - (rank[0] - rank[i]);
+        update[i]->links[i].next = node;
+        update[i]->links[i].span = (rank[0] - rank[i]) + 1;
+    }
+    for (int i = height; i < view->level; ++i)
+    {
+        update[i]->links[i].span++;
+    }
+
+    view->count++;
+    return true;
+}
+
+
+/**
+ * @brief Removes a record. Does nothing on an unbuilt view.
+ *
+ * Must be called while the record still carries the key values it was inserted with.
+ *
+ * @param view The view.
+ * @param record The record to remove.
+ * @return true if the record was found.
+ */
+
+bool sorted_view_remove(SortedView *view, void *record)
+{
+    if (!view->built) return false;
+
+    SortedViewNode *update[SORTED_VIEW_MAX_LEVEL];
+    SortedViewNode *x = view->head;
+
+    for (int i = view->level - 1; i >= 0; --i)
+    {
+        while (x->links[i].next && compare(view, x->links[i].next->record, record) < 0)
+        {
+            x = x->links[i].next;
+        }
+        update[i] = x;
+    }
+
+    x = x->links[0].next;
+    if (!x || x->record != record) return false;
+
+    for (int i = 0; i < view->level; ++i)
+    {
+        if (update[i]->links[i].next == x)
+        {
+            update[i]->links[i].span += x->links[i].span - 1;
+            update[i]->links[i].next = x->links[i].next;
+        }
+        else
+        {
+            update[i]->links[i].span--;
+        }
+    }
+    while (view->level > 1 && view->head->links[view->level - 1].next == NULL)
+    {
+        view->head->links[view->level - 1].span = 0;
+        view->level--;
+    }
+
+    slab_free(&view->pools[x->height - 1], x);
+    view->count--;
+    return true;
+}
+
+
+/**
+ * @brief Finds the node at a 0-based rank.
+ */
+
+static SortedViewNode* node_at(const SortedView *view, size_t rank)
+{
+    if (rank >= view->count) return NULL;
+
+    size_t target = rank + 1;
+    size_t traversed = 0;
+    SortedViewNode *x = view->head;
+
+    for (int i = view->level - 1; i >= 0; --i)
+    {
+        while (x->links[i].next && traversed + x->links[i].span <= target)
+        {
+            traversed += x->links[i].span;
+            x = x->links[i].next;
+        }
+        if (traversed == target) return x;
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Returns the record at a 0-based rank, or NULL if out of range.
+ */
+
+void* sorted_view_at(const SortedView *view, size_t rank)
+{
+    SortedViewNode *node = node_at(view, rank);
+    return node ? node->record : NULL;
+}
+
+
+/**
+ * @brief Returns the 0-based rank of a record, or SIZE_MAX if it is not in the view.
+ */
+
+size_t sorted_view_rank(const SortedView *view, const void *record)
+{
+    size_t rank = 0;
+    SortedViewNode *x = view->head;
+
+    for (int i = view->level - 1; i >= 0; --i)
+    {
+        while (x->links[i].next && compare(view, x->links[i].next->record, record) <= 0)
+        {
+            rank += x->links[i].span;
+            x = x->links[i].next;
+        }
+        if (x->record == record) return rank - 1;
+    }
+    return SIZE_MAX;
+}
+
+
+/**
+ * @brief Copies up to `max` consecutive records starting at rank `start`.
+ *
+ * @param view The view.
+ * @param start 0-based rank of the first record.
+ * @param out Receives the records.
+ * @param max Capacity of `out`.
+ * @return Number of records copied.
+ */
+
+size_t sorted_view_page(const SortedView *view, size_t start, void **out, size_t max)
+{
+    size_t n = 0;
+    for (SortedViewNode *x = node_at(view, start); x && n < max; x = x->links[0].next)
+    {
+        out[n++] = x->record;
+    }
+    return n;
+}
@@ -0,0 +1,1209 @@
+/**
+ * @file storage.c
+ * @brief Persistence of the movie and TV series collections to and from pipe-delimited text files.
+ *
+ * Each line of movies.txt holds one movie in the format `title|director|year|rating`,
+ * and each line of the series file one series as `title|creator|seasons|episodes`,
+ * followed by `|ratings` once any of its episodes is rated (see `read_season_ratings()`).
+ * Both go through the same code: `save_text_records()` writes every live record of a
+ * Collection, and `load_text_records()` reads the entire file into one owned buffer
+ * with a single read, then walks it once, terminating each field in place. A
+ * TextFormat supplies what differs per record type. No per-line or per-field copies
+ * are made: the title of every loaded movie points into the buffer, which is handed
+ * to the catalog's string arena so it lives exactly as long as the catalog.
+ *
+ * Delimiters are located with `field_scan()` (field_scan.c), which finds every '|'
+ * and '\n' of a block in one vectorized pass.
+ *
+ * Large files are parsed by several threads, each on its own newline-aligned chunk,
+ * and merged in file order. Because the record count is known once the chunks are
+ * parsed, the movie array is grown at most once per load instead of being doubled
+ * repeatedly.
+ *
+ * `load_catalog()` and `save_catalog()` pair the text file with a binary snapshot
+ * (snapshot.c). The snapshot is the fast startup path; the text file stays the
+ * human-readable import/export format and wins whenever it has been edited more
+ * recently than the snapshot.
+ *
+ * A CatalogStore ties both to the operation journal (journal.c). Edits are appended
+ * to the journal as they happen; the snapshot and text export are only rewritten
+ * when the journal is compacted. In the interactive program that happens in the
+ * background: the catalog is captured in memory and the autosave worker
+ * (autosave.c) writes the files.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "storage.h"
+#include "snapshot.h"
+#include "field_scan.h"
+#include "perf.h"
+#include "notify.h"
+
+#define PARSE_MAX_THREADS 64
+#define PARSE_MIN_CHUNK_BYTES (1024 * 1024)  // Smaller inputs are parsed on one thread
+#define PARSE_SCAN_WINDOW (64 * 1024)        // Bytes per field_scan() call
+#define PARSE_RECORD_ALIGN 8                 // Alignment of the parsed records of a chunk
+
+// One movie parsed out of the text file; its strings point into the loaded buffer
+typedef struct
+{
+    char *title;
+    char *director;
+    int year;
+    float rating;
+} ParsedMovie;
+
+// One TV series parsed out of its text file
+typedef struct
+{
+    char *title;
+    char *creator;
+    int seasons;
+    int episodes;
+    char *ratings;   // Episode ratings field, NULL when the line has none
+} ParsedSeries;
+
+// A newline-aligned slice of the loaded buffer and the records parsed from it
+typedef struct
+{
+    const TextFormat *format;
+    size_t stride;       // Bytes per parsed record, rounded up for alignment
+    char *start;
+    char *end;
+    char *records;       // `count` parsed records of `stride` bytes
+    int *record_lines;   // Line of each record within the chunk, from 1
+    int count;
+    int capacity;
+    char **malformed;    // Lines that did not parse, reported when the chunk is merged
+    int *malformed_lines;
+    int malformed_count;
+    int malformed_capacity;
+    int lines;           // Newlines seen so far; the chunks end on one, except the last
+    bool failed;         // Ran out of memory
+} ParseChunk;
+
+static int parse_threads = 0; // 0: one per online CPU, see storage_set_parse_threads()
+
+
+/**
+ * @brief Writes every live record of a collection to a stream, one line each, in slot order.
+ */
+
+static void write_text_records(FILE *file, const TextFormat *format, const Collection *collection)
+{
+    for (int i = 0; i < collection->slot_count; ++i)
+    {
+        const void *record = collection_get(collection, i);
+        if (record != NULL) // Skip the slots of deleted records
+        {
+            format->write(file, record);
+        }
+    }
+}
+
+
+/**
+ * @brief Writes every record of a collection as one line of a text file.
+ *
+ * Records are written in slot order, skipping the slots of deleted records.
+ *
+ * @param[in] filename The file to write.
+ * @param[in] format Writes one record per line.
+ * @param[in] collection The records.
+ * @return false if the file could not be opened.
+ */
+
+bool save_text_records(const char *filename, const TextFormat *format, const Collection *collection)
+{
+    FILE *file = fopen(filename, "w"); // Open the file for writing
+    if (file == NULL)
+    {
+        perror("Error opening file for writing");
+        return false;
+    }
+
+    PERF_BEGIN(span);
+    write_text_records(file, format, collection);
+
+    fclose(file); // Close the file
+    PERF_END(span, PERF_SAVE);
+    return true;
+}
+
+
+/**
+ * @brief Formats a collection as `save_text_records()` would, into a memory buffer.
+ *
+ * @param[in] format Writes one record per line.
+ * @param[in] collection The records.
+ * @param[out] data Receives the text, allocated with malloc.
+ * @param[out] size Receives its length in bytes.
+ * @return false if memory allocation fails.
+ */
+
+static bool capture_text_records(const TextFormat *format, const Collection *collection, char **data, size_t *size)
+{
+    FILE *file = open_memstream(data, size);
+    if (file == NULL)
+    {
+        return false;
+    }
+    write_text_records(file, format, collection);
+
+    // A memory stream can only fail by running out of memory
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok)
+    {
+        free(*data);
+        *data = NULL;
+    }
+    return ok;
+}
+
+
+/**
+ * @brief Reads a whole file into a newly allocated, NUL-terminated buffer.
+ *
+ * @param[in] filename The file to read.
+ * @param[out] buffer Receives the allocated data.
+ * @param[out] size Receives the number of bytes read.
+ * @return 0 on success, -1 if the file could not be opened, sized or read.
+ */
+
+int read_whole_file(const char *filename, char **buffer, size_t *size)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    char *data = (char*)malloc((size_t)st.st_size + 1);
+    if (!data)
+    {
+        close(fd);
+        return -1;
+    }
+
+    size_t total = 0;
+    while (total < (size_t)st.st_size)
+    {
+        ssize_t n = read(fd, data + total, (size_t)st.st_size - total);
+        if (n < 0)
+        {
+            free(data);
+            close(fd);
+            return -1;
+        }
+        if (n == 0) break; // File shrank while reading, keep what we have
+        total += (size_t)n;
+    }
+    close(fd);
+
+    data[total] = '\0';
+    *buffer = data;
+    *size = total;
+    return 0;
+}
+
+
+/**
+ * @brief Parses a NUL-terminated decimal field.
+ *
+ * @param[in] text The field.
+ * @param[out] value Receives the parsed value.
+ * @return true if the field was a non-empty run of at most five digits.
+ */
+
+static bool parse_number(const char *text, int *value)
+{
+    int result = 0;
+    if (*text == '\0') return false;
+
+    for (const char *p = text; *p; ++p)
+    {
+        if (*p < '0' || *p > '9') return false;
+        result = result * 10 + (*p - '0');
+        if (result > 99999) return false;
+    }
+
+    *value = result;
+    return true;
+}
+
+
+/**
+ * @brief Parses a whole field as a rating from 0 to 5, as batch files are checked.
+ */
+
+static bool parse_rating(const char *text, float *rating)
+{
+    char *end;
+    float value = strtof(text, &end);
+    if (end == text || *end != '\0' || !(value >= 0.0f && value <= 5.0f)) return false; // Also refuses "nan"
+
+    *rating = value;
+    return true;
+}
+
+
+/**
+ * @brief Sets how many threads `load_text_records()` parses with.
+ *
+ * Packed snapshots (packed_snapshot.c) inflate their blocks with the same number.
+ *
+ * @param threads 1 for the single-threaded loader, 0 (the default) for one thread per
+ *                online CPU, anything else for that many threads (capped at PARSE_MAX_THREADS).
+ */
+
+void storage_set_parse_threads(int threads)
+{
+    parse_threads = threads < 0 ? 0 : threads;
+}
+
+
+/**
+ * @brief The number of threads the current setting asks for, before any cap on the work.
+ */
+
+int storage_parse_threads(void)
+{
+    int threads = parse_threads;
+    if (threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    return threads > PARSE_MAX_THREADS ? PARSE_MAX_THREADS : threads;
+}
+
+
+/**
+ * @brief Turns one line, already split into its fields, into a parsed record.
+ *
+ * @param chunk The chunk the line belongs to.
+ * @param fields Start of each field; `fields[0]` is the start of the line.
+ * @param field_count Number of fields found (1 to the format's count).
+ * @param eol The line's '\n', or the end of the buffer.
+ * @return false if the record array could not be grown.
+ */
+
+static bool finish_line(ParseChunk *chunk, char **fields, int field_count, char *eol)
+{
+    char *line = fields[0];
+
+    //Trim '\r' left over from files saved on Windows
+    if (eol > line && eol[-1] == '\r') eol--;
+    if (eol == line) return true; // Skip blank lines
+    *eol = '\0';
+
+    if (chunk->count == chunk->capacity)
+    {
+        int capacity = chunk->capacity ? chunk->capacity * 2 : 64;
+        char *records = (char*)realloc(chunk->records, (size_t)capacity * chunk->stride);
+        if (records) chunk->records = records;
+        int *lines = (int*)realloc(chunk->record_lines, (size_t)capacity * sizeof(int));
+        if (lines) chunk->record_lines = lines;
+        if (!records || !lines) return false;
+        chunk->capacity = capacity;
+    }
+    if (chunk->format->parse(fields, field_count, chunk->records + (size_t)chunk->count * chunk->stride))
+    {
+        chunk->record_lines[chunk->count++] = chunk->lines + 1;
+        return true;
+    }
+
+    if (chunk->malformed_count == chunk->malformed_capacity)
+    {
+        int capacity = chunk->malformed_capacity ? chunk->malformed_capacity * 2 : 16;
+        char **malformed = (char**)realloc(chunk->malformed, (size_t)capacity * sizeof(char*));
+        if (malformed) chunk->malformed = malformed;
+        int *lines = (int*)realloc(chunk->malformed_lines, (size_t)capacity * sizeof(int));
+        if (lines) chunk->malformed_lines = lines;
+        if (!malformed || !lines) return false;
+        chunk->malformed_capacity = capacity;
+    }
+    chunk->malformed_lines[chunk->malformed_count] = chunk->lines + 1;
+    chunk->malformed[chunk->malformed_count++] = line;
+    return true;
+}
+
+
+/**
+ * @brief Parses the lines of one chunk of a loaded file in place.
+ *
+ * The chunk is scanned a window at a time with `field_scan()`, which lists every
+ * '|' and '\n' in the window; the parser then only visits those positions. The
+ * first '|' of a line up to the format's field count end its fields, further ones
+ * are part of the last field, and each '\n' completes a record. Lines may span
+ * windows. Fields are NUL-terminated inside the buffer and the records are
+ * collected in the chunk's own array, so chunks can be parsed concurrently without
+ * touching the target. Malformed lines are collected rather than printed, so they
+ * are reported in file order whatever the thread count; each line's number within
+ * the chunk is kept for the report.
+ *
+ * @param chunk The chunk; `format`, `stride`, `start` and `end` are set, everything else is filled in.
+ */
+
+static void parse_chunk(ParseChunk *chunk)
+{
+    uint32_t *offsets = (uint32_t*)malloc(PARSE_SCAN_WINDOW * sizeof(uint32_t));
+    if (!offsets)
+    {
+        chunk->failed = true;
+        return;
+    }
+
+    const int max_fields = chunk->format->field_count;
+    char *fields[TEXT_MAX_FIELDS] = { chunk->start };
+    int field_count = 1;
+
+    for (char *window = chunk->start; window < chunk->end; window += PARSE_SCAN_WINDOW)
+    {
+        size_t length = (size_t)(chunk->end - window) < PARSE_SCAN_WINDOW ? (size_t)(chunk->end - window) : PARSE_SCAN_WINDOW;
+        size_t found = field_scan(window, length, offsets);
+
+        for (size_t k = 0; k < found; ++k)
+        {
+            char *p = window + offsets[k];
+            if (*p == '|')
+            {
+                if (field_count < max_fields)
+                {
+                    *p = '\0';
+                    fields[field_count++] = p + 1;
+                }
+                continue;
+            }
+            if (!finish_line(chunk, fields, field_count, p))
+            {
+                chunk->failed = true;
+                free(offsets);
+                return;
+            }
+            chunk->lines++;
+            fields[0] = p + 1;
+            field_count = 1;
+        }
+    }
+
+    // Last line without a trailing newline; the buffer is NUL-terminated past `end`
+    if (fields[0] < chunk->end && !finish_line(chunk, fields, field_count, chunk->end))
+    {
+        chunk->failed = true;
+    }
+    free(offsets);
+}
+
+
+static void* parse_worker(void *argument)
+{
+    parse_chunk((ParseChunk*)argument);
+    return NULL;
+}
+
+
+/**
+ * @brief Number of chunks to split `size` bytes into under the current thread setting.
+ */
+
+static int chunk_count_for(size_t size)
+{
+    int threads = storage_parse_threads();
+
+    // Don't start threads for less than a chunk's worth of work each
+    size_t useful = size / PARSE_MIN_CHUNK_BYTES;
+    if ((size_t)threads > useful) threads = useful > 0 ? (int)useful : 1;
+    return threads;
+}
+
+
+/**
+ * @brief Loads the records of a pipe-delimited text file.
+ *
+ * Reads the file into one buffer and parses it in one pass. Lines of any length are
+ * accepted. Malformed lines, and records `add` refuses, are reported on stderr with
+ * their line numbers and skipped.
+ *
+ * Large files are split into newline-aligned chunks that are parsed concurrently, one
+ * chunk per thread (see `storage_set_parse_threads()`). Each thread fills its own record
+ * array; once the total is known, `reserve` is called once and the arrays are handed to
+ * `add` chunk by chunk, so the records end up in file order and get the same ids as with
+ * a single thread. With one thread, or when a thread cannot be started, the chunks are
+ * parsed on the calling thread.
+ *
+ * @param[in] filename The file to read.
+ * @param[in] format Splits, parses and stores the records.
+ * @param[in,out] arena Takes ownership of the buffer the parsed strings point into, or
+ *                      NULL if `add` copies what it keeps; the buffer is then freed.
+ * @param[in,out] target Passed to `reserve` and `add`.
+ * @return false if the file could not be read or there was not enough memory.
+ */
+
+bool load_text_records(const char *filename, const TextFormat *format, StringArena *arena, void *target)
+{
+    char *data;
+    size_t size;
+
+    PERF_BEGIN(span);
+    if (read_whole_file(filename, &data, &size) != 0)
+    {
+        perror("Could not open file for reading");
+        return false;
+    }
+    if (arena && string_arena_adopt(arena, data) != 0)
+    {
+        free(data);
+        fprintf(stderr, "Failed to allocate memory for %s\n", filename);
+        return false;
+    }
+
+    // Split at line boundaries
+    ParseChunk chunks[PARSE_MAX_THREADS];
+    int chunk_count = chunk_count_for(size);
+    size_t stride = (format->parsed_size + PARSE_RECORD_ALIGN - 1) / PARSE_RECORD_ALIGN * PARSE_RECORD_ALIGN;
+    char *end = data + size;
+    char *start = data;
+    for (int i = 0; i < chunk_count; ++i)
+    {
+        char *stop = end;
+        if (i < chunk_count - 1)
+        {
+            stop = data + size / (size_t)chunk_count * (size_t)(i + 1);
+            if (stop < start) stop = start;
+            char *eol = memchr(stop, '\n', (size_t)(end - stop));
+            stop = eol ? eol + 1 : end;
+        }
+        memset(&chunks[i], 0, sizeof(chunks[i]));
+        chunks[i].format = format;
+        chunks[i].stride = stride;
+        chunks[i].start = start;
+        chunks[i].end = stop;
+        start = stop;
+    }
+
+    pthread_t threads[PARSE_MAX_THREADS];
+    bool started[PARSE_MAX_THREADS] = { false };
+    for (int i = 1; i < chunk_count; ++i)
+    {
+        started[i] = pthread_create(&threads[i], NULL, parse_worker, &chunks[i]) == 0;
+    }
+    parse_chunk(&chunks[0]);
+    for (int i = 1; i < chunk_count; ++i)
+    {
+        if (started[i]) pthread_join(threads[i], NULL);
+        else parse_chunk(&chunks[i]); // Deterministic fallback: same result, just serial
+    }
+
+    int total = 0;
+    bool failed = false;
+    for (int i = 0; i < chunk_count; ++i)
+    {
+        total += chunks[i].count;
+        failed = failed || chunks[i].failed;
+    }
+
+    bool ok = false;
+    if (failed)
+    {
+        fprintf(stderr, "Failed to allocate memory while parsing %s\n", filename);
+    }
+    else if (!format->reserve(target, total))
+    {
+        fprintf(stderr, "Failed to allocate room for %d more %s\n", total, format->noun);
+    }
+    else
+    {
+        // Merge in file order
+        int first_line = 0;
+        for (int i = 0; i < chunk_count; ++i)
+        {
+            for (int m = 0; m < chunks[i].malformed_count; ++m)
+            {
+                fprintf(stderr, "Error parsing line %d: %s\n", first_line + chunks[i].malformed_lines[m],
+                        chunks[i].malformed[m]);
+            }
+            for (int r = 0; r < chunks[i].count; ++r)
+            {
+                if (!format->add(target, chunks[i].records + (size_t)r * stride))
+                {
+                    fprintf(stderr, "Error parsing line %d: not added to the %s\n",
+                            first_line + chunks[i].record_lines[r], format->noun);
+                }
+            }
+            first_line += chunks[i].lines;
+        }
+        ok = true;
+    }
+
+    for (int i = 0; i < chunk_count; ++i)
+    {
+        free(chunks[i].records);
+        free(chunks[i].record_lines);
+        free(chunks[i].malformed);
+        free(chunks[i].malformed_lines);
+    }
+    if (!arena) free(data);
+    if (ok) PERF_END(span, PERF_LOAD);
+    return ok;
+}
+
+
+/**
+ * @brief TextFormat callback: parses `title|director|year[|rating]`.
+ */
+
+static bool parse_movie_line(char **fields, int field_count, void *parsed)
+{
+    ParsedMovie *movie = (ParsedMovie*)parsed;
+    if (field_count < 3 || !parse_number(fields[2], &movie->year)) return false;
+
+    movie->title = fields[0];
+    movie->director = fields[1];
+    movie->rating = 0.0f;
+    return field_count <= 3 || parse_rating(fields[3], &movie->rating);
+}
+
+
+static bool reserve_movies(void *target, int count)
+{
+    return catalog_reserve((MovieCatalog*)target, count) == MOVIE_SUCCESS;
+}
+
+
+static bool add_movie(void *target, void *parsed)
+{
+    const ParsedMovie *movie = (const ParsedMovie*)parsed;
+    return create_movie_borrowed((MovieCatalog*)target, movie->title, movie->director,
+                                 movie->year, movie->rating) != NULL;
+}
+
+
+static void write_movie(FILE *file, const void *record)
+{
+    const Movie *movie = (const Movie*)record;
+    // Save the movie details in the format: title|director|year|rating\n
+    fprintf(file, "%s|%s|%d|%.1f\n", movie->title, movie->director, movie->year, movie->rating);
+}
+
+
+static const TextFormat movie_text_format =
+{
+    "movies", 4, sizeof(ParsedMovie), parse_movie_line, reserve_movies, add_movie, write_movie
+};
+
+
+/**
+ * @brief Saves the catalog's movies to a specified file.
+ *
+ * Writes the movie details to a file with each movie's attributes separated by a pipe ('|')
+ * character and each movie entry on a new line (see `save_text_records()`).
+ *
+ * @param[in] filename The name of the file to which the movie details will be saved.
+ * @param[in] catalog The catalog whose movies will be saved to the file.
+ */
+
+void save_movies_to_file(const char *filename, const MovieCatalog *catalog)
+{
+    save_text_records(filename, &movie_text_format, &catalog->movies);
+}
+
+
+/**
+ * @brief Loads movie details from a specified file into the catalog.
+ *
+ * Each line is expected to hold `title|director|year|rating`; the rating column may be
+ * omitted, in which case the movie is loaded unrated. Parsing is done by
+ * `load_text_records()`, in parallel for large files. No per-line or per-field copies
+ * are made: the titles point into the loaded buffer, which the catalog's string arena
+ * takes over.
+ *
+ * @param[in] filename The name of the file from which the movie details will be read.
+ * @param[in,out] catalog The catalog the loaded movies are appended to.
+ */
+
+void load_movies_from_file(const char *filename, MovieCatalog *catalog)
+{
+    load_text_records(filename, &movie_text_format, &catalog->movies.strings, catalog);
+}
+
+
+/**
+ * @brief Reads the episode ratings field of a series line.
+ *
+ * Seasons are separated by ',' and the episodes of a season by ' ', each one a
+ * rating above 0 and up to 5 or '-' when unrated, so `4.5 - 3,5 4.2` is a first
+ * season of three episodes and a second of two. The field must describe exactly
+ * `seasons` seasons and `episodes` episodes.
+ *
+ * @param text The field.
+ * @param seasons Expected number of seasons.
+ * @param episodes Expected number of episodes.
+ * @param lengths If not NULL, receives the episodes of each season.
+ * @param ratings If not NULL, receives each rating in tenths of a point, 0 for unrated.
+ * @return false if the field is malformed or does not match the counts.
+ */
+
+static bool read_season_ratings(const char *text, int seasons, int episodes, int *lengths, uint8_t *ratings)
+{
+    int season = 0, length = 0, total = 0;
+    const char *p = text;
+
+    while (1)
+    {
+        while (*p == ' ') p++;
+        if (*p == ',' || *p == '\0')
+        {
+            if (season >= seasons) return false;
+            if (lengths) lengths[season] = length;
+            season++;
+            length = 0;
+            if (*p == '\0') break;
+            p++;
+            continue;
+        }
+
+        uint8_t tenths = 0;
+        if (*p == '-')
+        {
+            p++;
+        }
+        else
+        {
+            char *end;
+            float rating = strtof(p, &end);
+            if (end == p || !(rating > 0.0f && rating <= 5.0f)) return false;
+            tenths = (uint8_t)(rating * TV_RATING_SCALE + 0.5f);
+            p = end;
+        }
+        if ((*p != ' ' && *p != ',' && *p != '\0') || total >= episodes) return false;
+        if (ratings) ratings[total] = tenths;
+        total++;
+        length++;
+    }
+    return season == seasons && total == episodes;
+}
+
+
+/**
+ * @brief TextFormat callback: parses `title|creator|seasons|episodes[|ratings]`.
+ */
+
+static bool parse_series_line(char **fields, int field_count, void *parsed)
+{
+    ParsedSeries *series = (ParsedSeries*)parsed;
+    if (field_count < 4 || !parse_number(fields[2], &series->seasons) || !parse_number(fields[3], &series->episodes))
+    {
+        return false;
+    }
+    series->title = fields[0];
+    series->creator = fields[1];
+    series->ratings = field_count > 4 ? fields[4] : NULL;
+    if (series->seasons < 1 || series->episodes < 1) return false;
+    return !series->ratings || read_season_ratings(series->ratings, series->seasons, series->episodes, NULL, NULL);
+}
+
+
+static bool reserve_series(void *target, int count)
+{
+    return tv_catalog_reserve((TvCatalog*)target, count) == TV_SERIES_SUCCESS;
+}
+
+
+/**
+ * @brief Gives a new series the season lengths and episode ratings of its ratings field.
+ */
+
+static bool apply_season_ratings(TV_Series *series, const ParsedSeries *parsed)
+{
+    int *lengths = (int*)malloc((size_t)parsed->seasons * sizeof(int));
+    uint8_t *ratings = (uint8_t*)malloc((size_t)parsed->episodes);
+    bool applied = lengths && ratings
+        && read_season_ratings(parsed->ratings, parsed->seasons, parsed->episodes, lengths, ratings)
+        && set_tv_series_seasons(series, lengths, parsed->seasons) == TV_SERIES_SUCCESS;
+
+    for (int season = 0, index = 0; applied && season < parsed->seasons; ++season)
+    {
+        for (int episode = 0; episode < lengths[season]; ++episode, ++index)
+        {
+            if (!ratings[index]) continue;
+            rate_tv_episode(series, season + 1, episode + 1, (float)ratings[index] / TV_RATING_SCALE);
+        }
+    }
+    free(lengths);
+    free(ratings);
+    return applied;
+}
+
+
+static bool add_series(void *target, void *parsed)
+{
+    const ParsedSeries *parsed_series = (const ParsedSeries*)parsed;
+    TV_Series *series = create_tv_series(parsed_series->title, parsed_series->creator,
+                                         parsed_series->seasons, parsed_series->episodes);
+    if (!series) return false;
+    if ((parsed_series->ratings && !apply_season_ratings(series, parsed_series))
+        || tv_catalog_add((TvCatalog*)target, series) != TV_SERIES_SUCCESS)
+    {
+        delete_tv_series(series);
+        return false;
+    }
+    return true;
+}
+
+
+// True when the seasons of a series are the even split create_tv_series() gives
+static bool has_default_seasons(const TV_Series *series)
+{
+    for (int season = 0; season < series->seasons; ++season)
+    {
+        int expected = series->episodes / series->seasons + (season < series->episodes % series->seasons);
+        if (tv_season_episodes(series, season + 1) != expected) return false;
+    }
+    return true;
+}
+
+
+static void write_series(FILE *file, const void *record)
+{
+    const TV_Series *series = (const TV_Series*)record;
+    fprintf(file, "%s|%s|%d|%d", series->title, series->creator, series->seasons, series->episodes);
+    if (series->rating_totals.rated || !has_default_seasons(series))
+    {
+        const uint8_t *rating = series->episode_ratings;
+        for (int season = 1; season <= series->seasons; ++season)
+        {
+            fputc(season == 1 ? '|' : ',', file);
+            for (int episode = 1, length = tv_season_episodes(series, season); episode <= length; ++episode, ++rating)
+            {
+                if (episode > 1) fputc(' ', file);
+                if (*rating) fprintf(file, "%d.%d", *rating / TV_RATING_SCALE, *rating % TV_RATING_SCALE);
+                else fputc('-', file);
+            }
+        }
+    }
+    fputc('\n', file);
+}
+
+
+static const TextFormat series_text_format =
+{
+    "series", 5, sizeof(ParsedSeries), parse_series_line, reserve_series, add_series, write_series
+};
+
+
+/**
+ * @brief Saves the TV series as `title|creator|seasons|episodes[|ratings]` lines.
+ *
+ * @param[in] filename The file to write.
+ * @param[in,out] catalog The series; no longer `dirty` once written.
+ * @return false if the file could not be written.
+ */
+
+bool save_series_to_file(const char *filename, TvCatalog *catalog)
+{
+    if (!save_text_records(filename, &series_text_format, &catalog->series)) return false;
+    catalog->dirty = false;
+    return true;
+}
+
+
+static void series_autosave_done(void *context, bool ok)
+{
+    TvCatalog *catalog = context;
+    if (ok) return;
+    catalog->dirty = true; // Try again after the next action
+    notify(NOTIFY_ERROR, "Failed to save the TV series.");
+}
+
+
+/**
+ * @brief Captures the TV series in memory and has the autosave worker write them.
+ *
+ * @param[in] filename The file to write.
+ * @param[in,out] catalog The series; no longer `dirty` once captured, and `dirty`
+ *                        again if the write later fails.
+ * @param autosave The worker that writes the file.
+ * @return false if there was not enough memory to capture the series.
+ */
+
+bool save_series_in_background(const char *filename, TvCatalog *catalog, Autosave *autosave)
+{
+    if (!catalog->dirty) return true;
+
+    char *data;
+    size_t size;
+    AutosaveJob *job = autosave_job_create(series_autosave_done, catalog);
+    if (!job || !capture_text_records(&series_text_format, &catalog->series, &data, &size))
+    {
+        autosave_job_destroy(job);
+        return false;
+    }
+    if (!autosave_job_add_file(job, filename, data, size))
+    {
+        autosave_job_destroy(job);
+        return false;
+    }
+
+    catalog->dirty = false;
+    autosave_submit(autosave, job);
+    return true;
+}
+
+
+/**
+ * @brief Loads the TV series of a file saved by `save_series_to_file()`.
+ *
+ * A missing file is not an error: there are simply no series yet.
+ *
+ * @param[in] filename The file to read.
+ * @param[in,out] catalog The catalog the series are added to.
+ */
+
+void load_series_from_file(const char *filename, TvCatalog *catalog)
+{
+    if (access(filename, F_OK) != 0) return;
+    load_text_records(filename, &series_text_format, NULL, catalog);
+    catalog->dirty = false;
+}
+
+
+/**
+ * @brief Returns the modification time of a file in nanoseconds.
+ *
+ * @param[in] filename The file to inspect.
+ * @param[out] mtime Receives the modification time.
+ * @return true if the file exists.
+ */
+
+static bool file_mtime(const char *filename, long long *mtime)
+{
+    struct stat st;
+    if (stat(filename, &st) != 0)
+    {
+        return false;
+    }
+    *mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+
+/**
+ * @brief Loads the catalog from the snapshot when it is current, else from the text file.
+ *
+ * The snapshot is used when it exists and is at least as new as the text file (or the
+ * text file is missing), or when edits are journaled on top of it whatever the text
+ * file's age: a save that renamed the text file but not the snapshot into place leaves
+ * the text file newer, and loading it would discard those edits. If the snapshot turns
+ * out to be unreadable or of another version, the text file is loaded instead.
+ *
+ * @param[in] text_filename The pipe-delimited text file.
+ * @param[in] snapshot_filename The binary snapshot.
+ * @param[in,out] catalog The empty catalog to fill.
+ * @param[out] generation Receives the snapshot's generation when it was used.
+ * @param[in] journaled Whether a journal holds edits made on top of the snapshot.
+ * @return true if the catalog was loaded from the snapshot.
+ */
+
+bool load_catalog(const char *text_filename, const char *snapshot_filename, MovieCatalog *catalog, uint64_t *generation,
+                  bool journaled)
+{
+    long long text_mtime = 0, snapshot_mtime = 0;
+    bool has_text = file_mtime(text_filename, &text_mtime);
+    bool has_snapshot = file_mtime(snapshot_filename, &snapshot_mtime);
+
+    if (has_snapshot && (journaled || !has_text || snapshot_mtime >= text_mtime))
+    {
+        SnapshotError err = load_snapshot(snapshot_filename, catalog, generation);
+        if (err == SNAPSHOT_SUCCESS)
+        {
+            if (has_text && snapshot_mtime < text_mtime)
+            {
+                fprintf(stderr, "Ignoring %s, which is newer than %s: edits are journaled on top of the snapshot\n",
+                        text_filename, snapshot_filename);
+            }
+            return true;
+        }
+        fprintf(stderr, "Ignoring snapshot %s (error %d), loading %s\n", snapshot_filename, err, text_filename);
+    }
+
+    load_movies_from_file(text_filename, catalog);
+    return false;
+}
+
+
+/**
+ * @brief Saves the catalog as both the text file and the snapshot.
+ *
+ * The text file is written first so the snapshot ends up the newer of the two and is
+ * picked by the next `load_catalog()`. A crash between the two leaves the text file
+ * newer, but the journal still holds the edits for the old snapshot, which
+ * `store_open()` then loads regardless.
+ *
+ * @param[in] text_filename The pipe-delimited text file.
+ * @param[in] snapshot_filename The binary snapshot.
+ * @param[in] catalog The catalog to save.
+ * @param[in] generation Generation stamp for the snapshot.
+ * @return true if the snapshot was written.
+ */
+
+bool save_catalog(const char *text_filename, const char *snapshot_filename, const MovieCatalog *catalog, uint64_t generation)
+{
+    save_movies_to_file(text_filename, catalog);
+    return save_snapshot(snapshot_filename, catalog, generation) == SNAPSHOT_SUCCESS;
+}
+
+
+/**
+ * @brief Sets up the file names of a catalog store.
+ *
+ * @param store The store to initialize.
+ * @param text_filename The human-readable export, refreshed whenever the journal is compacted.
+ * @param snapshot_filename The binary snapshot.
+ * @param journal_filename The operation journal.
+ */
+
+void store_init(CatalogStore *store, const char *text_filename, const char *snapshot_filename, const char *journal_filename)
+{
+    store->text_filename = text_filename;
+    store->snapshot_filename = snapshot_filename;
+    store->journal_filename = journal_filename;
+    snprintf(store->retired_filename, sizeof(store->retired_filename), "%s.prev", journal_filename);
+    store->generation = 0;
+    store->journal.fd = -1;
+    store->journal.failed = false;
+    store->compacted_at = 0;
+    store->background_failed = false;
+}
+
+
+/**
+ * @brief Tells whether the journal or the retired journal continues from the snapshot on disk.
+ *
+ * The current journal counts once it has entries. The retired journal counts as it is:
+ * it only outlives a background compaction whose snapshot never landed.
+ */
+
+static bool snapshot_journaled(const CatalogStore *store)
+{
+    uint64_t generation;
+    if (!snapshot_peek_generation(store->snapshot_filename, &generation)) return false;
+
+    uint64_t retired;
+    return (journal_peek_generation(store->retired_filename, &retired) && retired == generation)
+        || journal_has_entries(store->journal_filename, generation);
+}
+
+
+/**
+ * @brief Loads the catalog, replays the journal and attaches the journal for new edits.
+ *
+ * When the catalog comes from the snapshot, the journal that belongs to it is replayed
+ * on top. When it comes from the text file instead (first run, or movies.txt edited by
+ * hand), the journal no longer applies and the text is folded into a fresh snapshot.
+ * The text file never wins over a snapshot with journaled edits, see `load_catalog()`.
+ *
+ * A retired journal that matches the snapshot means a background compaction never
+ * finished (see `store_maintain()`). Its entries lead up to the captured catalog and
+ * the current journal continues from there, with the ids renumbered; both are replayed
+ * and the result is folded into a new snapshot straight away.
+ *
+ * @param store The store to open.
+ * @param catalog The empty catalog to fill.
+ */
+
+void store_open(CatalogStore *store, MovieCatalog *catalog)
+{
+    uint64_t generation = 0;
+    bool recovered = false;
+    if (load_catalog(store->text_filename, store->snapshot_filename, catalog, &generation, snapshot_journaled(store)))
+    {
+        store->generation = generation;
+        if (journal_replay(store->retired_filename, generation, catalog) >= 0)
+        {
+            fprintf(stderr, "Recovering the edits in %s\n", store->retired_filename);
+            catalog_compact(catalog);
+            store->generation = generation + 1;
+            recovered = true;
+        }
+        journal_replay(store->journal_filename, store->generation, catalog);
+    }
+    else
+    {
+        uint64_t journal_generation = 0;
+        if (journal_peek_generation(store->journal_filename, &journal_generation)
+            && journal_has_entries(store->journal_filename, journal_generation))
+        {
+            // They apply to a snapshot that was not loaded
+            fprintf(stderr, "Loaded %s instead of %s, discarding the edits in %s\n",
+                    store->text_filename, store->snapshot_filename, store->journal_filename);
+        }
+        store->generation = journal_generation + 1;
+        save_snapshot(store->snapshot_filename, catalog, store->generation);
+    }
+
+    if (journal_open(&store->journal, store->journal_filename, store->generation) == JOURNAL_SUCCESS)
+    {
+        catalog->journal = &store->journal;
+    }
+    if (!recovered || store_compact(store, catalog))
+    {
+        remove(store->retired_filename); // Stale, or folded into the new snapshot
+    }
+    store->compacted_at = time(NULL);
+}
+
+
+/**
+ * @brief Folds the journal into a new snapshot and text export, then empties it.
+ *
+ * The catalog's free slots are closed at the same time (see `catalog_compact()`).
+ *
+ * If the crash happens after the new snapshot is renamed into place but before the
+ * journal is reset, the old journal no longer matches the snapshot's generation and
+ * is ignored on the next start, which is correct because its edits are in the snapshot.
+ *
+ * @param store The open store.
+ * @param catalog The catalog to persist.
+ * @return true if the snapshot was written; otherwise the journal keeps building on the old one.
+ */
+
+bool store_compact(CatalogStore *store, MovieCatalog *catalog)
+{
+    uint64_t generation = store->generation + 1;
+    if (!save_catalog(store->text_filename, store->snapshot_filename, catalog, generation))
+    {
+        return false; // Keep journaling on top of the previous snapshot
+    }
+
+    // The snapshot stores the live movies densely; renumber the ids to match it
+    // before the journal starts over
+    catalog_compact(catalog);
+    store->generation = generation;
+    if (store->journal.fd >= 0)
+    {
+        journal_reset(&store->journal, generation);
+    }
+    return true;
+}
+
+
+static void store_autosave_done(void *context, bool ok)
+{
+    CatalogStore *store = context;
+    if (ok) return;
+
+    // The retired journal still holds what the lost snapshot would have, so no
+    // further compaction may retire the current one until the next start
+    store->background_failed = true;
+    notify(NOTIFY_ERROR, "Could not save %s; edits are kept in %s.", store->snapshot_filename, store->journal_filename);
+}
+
+
+/**
+ * @brief Captures the catalog in memory and has the autosave worker write it as the next snapshot.
+ *
+ * The snapshot image and text export are built first, then the journal is retired
+ * and restarted for the new generation and the catalog renumbered to match the
+ * snapshot, exactly as `store_compact()` would; only the disk writes are left to
+ * the worker. The retired journal is removed once the snapshot is in place.
+ *
+ * @return false if the capture failed; the catalog and journal are then unchanged.
+ */
+
+static bool store_compact_in_background(CatalogStore *store, MovieCatalog *catalog, Autosave *autosave)
+{
+    uint64_t generation = store->generation + 1;
+    char *text, *image;
+    size_t text_size, image_size;
+
+    AutosaveJob *job = autosave_job_create(store_autosave_done, store);
+    if (!job) return false;
+
+    // The text file goes first so the snapshot is the newer of the two. Should the
+    // snapshot not follow, the retired journal matches the old one and keeps it in use
+    bool ok = capture_text_records(&movie_text_format, &catalog->movies, &text, &text_size)
+           && autosave_job_add_file(job, store->text_filename, text, text_size)
+           && capture_snapshot(catalog, generation, &image, &image_size) == SNAPSHOT_SUCCESS
+           && autosave_job_add_file(job, store->snapshot_filename, image, image_size);
+    if (ok && store->journal.fd >= 0)
+    {
+        ok = autosave_job_retire(job, store->retired_filename)
+          && journal_rotate(&store->journal, store->journal_filename, store->retired_filename, generation) == JOURNAL_SUCCESS;
+    }
+    if (!ok)
+    {
+        autosave_job_destroy(job);
+        return false;
+    }
+
+    catalog_compact(catalog);
+    store->generation = generation;
+    store->compacted_at = time(NULL);
+    autosave_submit(autosave, job);
+    return true;
+}
+
+
+/**
+ * @brief Compacts the journal in the background once it has grown past its threshold,
+ *        once a quarter of the catalog's slots are holes left by deletions, or once
+ *        it has held edits for STORE_AUTOSAVE_SECONDS.
+ *
+ * Meant to be called between user actions so compaction never interrupts an edit.
+ * Only memory copies happen on the calling thread; one compaction is written at a time.
+ *
+ * @param store The open store.
+ * @param catalog The catalog to persist.
+ * @param autosave The worker that writes the snapshot.
+ */
+
+void store_maintain(CatalogStore *store, MovieCatalog *catalog, Autosave *autosave)
+{
+    bool has_edits = store->journal.fd >= 0 && store->journal.size > sizeof(JournalHeader);
+    bool due = journal_needs_compaction(&store->journal) || catalog_needs_compaction(catalog)
+            || store->journal.failed // Edits since the failure are only in memory
+            || (has_edits && time(NULL) - store->compacted_at >= STORE_AUTOSAVE_SECONDS);
+    if (due && !store->background_failed && autosave_idle(autosave))
+    {
+        store_compact_in_background(store, catalog, autosave);
+    }
+}
+
+
+/**
+ * @brief Detaches and closes the journal.
+ *
+ * Every edit is normally already in the journal, so nothing has to be rewritten
+ * at exit. If an append failed since the last snapshot, or a background snapshot
+ * was lost, the catalog is saved in full instead.
+ *
+ * @param store The open store.
+ * @param catalog The catalog the journal is attached to.
+ */
+
+void store_close(CatalogStore *store, MovieCatalog *catalog)
+{
+    bool unsaved = store->journal.failed || store->background_failed;
+    if (store->journal.fd >= 0 && unsaved && !store_compact(store, catalog))
+    {
+        fprintf(stderr, "Could not save %s; the edits made since the journal failed are lost\n", store->snapshot_filename);
+    }
+    catalog->journal = NULL;
+    journal_close(&store->journal);
+}
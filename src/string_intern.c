@@ -0,0 +1,144 @@
+/**
+ * @file string_intern.c
+ * @brief String-to-code table with linear probing.
+ *
+ * The hash slots hold only codes; hashes and names live in arrays indexed by
+ * code, so growing the table rehashes without touching the strings. Nothing is
+ * ever removed: a code stays valid for the life of the table.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include "string_intern.h"
+
+#define STRING_INTERN_INITIAL_CAPACITY 256
+
+
+static uint32_t hash_string(const char *text)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (const unsigned char *p = (const unsigned char*)text; *p; ++p)
+    {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+
+/**
+ * @brief Prepares an empty table. Nothing is allocated until the first string.
+ */
+
+void string_intern_init(StringIntern *table)
+{
+    memset(table, 0, sizeof(*table));
+}
+
+
+/**
+ * @brief Releases the table. The interned strings themselves are not freed.
+ */
+
+void string_intern_destroy(StringIntern *table)
+{
+    free(table->slots);
+    free(table->names);
+    free(table->hashes);
+    string_intern_init(table);
+}
+
+
+/**
+ * @brief Returns the slot holding `text`, or the empty slot where it would go.
+ */
+
+static uint32_t* find_slot(const StringIntern *table, const char *text, uint32_t hash)
+{
+    size_t mask = table->capacity - 1;
+    size_t i = hash & mask;
+    while (table->slots[i] != 0)
+    {
+        uint32_t code = table->slots[i] - 1;
+        if (table->hashes[code] == hash && strcmp(table->names[code], text) == 0) break;
+        i = (i + 1) & mask;
+    }
+    return &table->slots[i];
+}
+
+
+static bool grow(StringIntern *table)
+{
+    size_t capacity = table->capacity ? table->capacity * 2 : STRING_INTERN_INITIAL_CAPACITY;
+    uint32_t *slots = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    if (!slots) return false;
+
+    for (uint32_t code = 0; code < table->count; ++code)
+    {
+        size_t i = table->hashes[code] & (capacity - 1);
+        while (slots[i] != 0) i = (i + 1) & (capacity - 1);
+        slots[i] = code + 1;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return true;
+}
+
+
+/**
+ * @brief Returns the code of `text`, assigning the next one if it is new.
+ *
+ * @param table The table.
+ * @param text The string; must outlive the table if it is new.
+ * @return The code, or STRING_INTERN_NONE if the table could not grow.
+ */
+
+uint32_t string_intern(StringIntern *table, const char *text)
+{
+    if ((table->count + 1) * 10 > table->capacity * 7 && !grow(table)) return STRING_INTERN_NONE;
+
+    uint32_t hash = hash_string(text);
+    uint32_t *slot = find_slot(table, text, hash);
+    if (*slot != 0) return *slot - 1;
+
+    if (table->count == table->names_capacity)
+    {
+        uint32_t capacity = table->names_capacity ? table->names_capacity * 2 : STRING_INTERN_INITIAL_CAPACITY;
+        const char **names = (const char**)realloc(table->names, capacity * sizeof(const char*));
+        if (!names) return STRING_INTERN_NONE;
+        table->names = names;
+        uint32_t *hashes = (uint32_t*)realloc(table->hashes, capacity * sizeof(uint32_t));
+        if (!hashes) return STRING_INTERN_NONE;
+        table->hashes = hashes;
+        table->names_capacity = capacity;
+    }
+
+    uint32_t code = table->count++;
+    table->names[code] = text;
+    table->hashes[code] = hash;
+    *slot = code + 1;
+    return code;
+}
+
+
+/**
+ * @brief Returns the code of `text`, or STRING_INTERN_NONE if it was never interned.
+ */
+
+uint32_t string_intern_find(const StringIntern *table, const char *text)
+{
+    if (table->capacity == 0) return STRING_INTERN_NONE;
+    uint32_t *slot = find_slot(table, text, hash_string(text));
+    return *slot != 0 ? *slot - 1 : STRING_INTERN_NONE;
+}
+
+
+/**
+ * @brief Returns the string behind a code, or NULL for an unknown code.
+ */
+
+const char* string_intern_name(const StringIntern *table, uint32_t code)
+{
+    return code < table->count ? table->names[code] : NULL;
+}
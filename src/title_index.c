@@ -0,0 +1,311 @@
+/**
+ * @file title_index.c
+ * @brief Hash index used for O(1) average title lookups.
+ *
+ * The index uses linear probing over a power-of-two table that is kept at most
+ * 70% full. Removal uses backward-shift deletion, so there are no tombstones and
+ * lookups never slow down after many deletes. Several records may share a title;
+ * `title_index_find_next()` walks all of them.
+ *
+ * Hashing and comparison both normalize the title on the fly (see title_index.h)
+ * by walking it through `next_normalized_char()`.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include "title_index.h"
+
+#define TITLE_INDEX_INITIAL_CAPACITY 64
+
+#define RECORD_TITLE(index, record) (*(const char**)((const char*)(record) + (index)->title_offset))
+
+
+/**
+ * @brief Returns the next character of a title in normalized form.
+ *
+ * Leading whitespace must already have been skipped by the caller. A run of
+ * whitespace followed by more text yields a single space; trailing whitespace
+ * yields the end of the string.
+ *
+ * @param cursor Position in the title, advanced past the consumed characters.
+ * @return The folded character, or '\0' at the end of the title.
+ */
+
+static inline unsigned char next_normalized_char(const unsigned char **cursor)
+{
+    const unsigned char *p = *cursor;
+    unsigned char c = *p;
+
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+    {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        *cursor = p;
+        return *p ? ' ' : '\0';
+    }
+    if (c == '\0')
+    {
+        return '\0';
+    }
+
+    *cursor = p + 1;
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+
+/**
+ * @brief Skips leading whitespace of a title.
+ */
+
+static inline const unsigned char* skip_leading_space(const char *title)
+{
+    const unsigned char *p = (const unsigned char*)title;
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+
+/**
+ * @brief Hashes the normalized form of a title (FNV-1a).
+ *
+ * @param title The title to hash.
+ * @return A non-zero hash value.
+ */
+
+uint32_t title_hash(const char *title)
+{
+    const unsigned char *p = skip_leading_space(title);
+    uint32_t hash = 2166136261u;
+    unsigned char c;
+
+    while ((c = next_normalized_char(&p)) != '\0')
+    {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+
+/**
+ * @brief Compares two titles in normalized form.
+ *
+ * @return true if the titles are equal ignoring case and whitespace differences.
+ */
+
+bool title_equals(const char *a, const char *b)
+{
+    const unsigned char *pa = skip_leading_space(a);
+    const unsigned char *pb = skip_leading_space(b);
+    unsigned char ca, cb;
+
+    do
+    {
+        ca = next_normalized_char(&pa);
+        cb = next_normalized_char(&pb);
+        if (ca != cb) return false;
+    } while (ca != '\0');
+
+    return true;
+}
+
+
+/**
+ * @brief Prepares an empty index.
+ *
+ * @param index The index to initialize.
+ * @param title_offset Offset of the `char *title` member inside the indexed records.
+ * @return true on success, false if the table could not be allocated.
+ */
+
+bool title_index_init(TitleIndex *index, size_t title_offset)
+{
+    index->slots = (TitleIndexSlot*)calloc(TITLE_INDEX_INITIAL_CAPACITY, sizeof(TitleIndexSlot));
+    if (!index->slots) return false;
+    index->capacity = TITLE_INDEX_INITIAL_CAPACITY;
+    index->count = 0;
+    index->title_offset = title_offset;
+    return true;
+}
+
+
+/**
+ * @brief Releases the index table. The records themselves are not touched.
+ */
+
+void title_index_destroy(TitleIndex *index)
+{
+    free(index->slots);
+    index->slots = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+
+/**
+ * @brief Places a slot into a table that is known to have room.
+ */
+
+static void place_slot(TitleIndexSlot *slots, size_t capacity, TitleIndexSlot slot)
+{
+    size_t mask = capacity - 1;
+    size_t i = slot.hash & mask;
+    while (slots[i].hash != 0)
+    {
+        i = (i + 1) & mask;
+    }
+    slots[i] = slot;
+}
+
+
+/**
+ * @brief Doubles the table and re-places every slot using the stored hashes.
+ */
+
+static bool grow(TitleIndex *index)
+{
+    size_t capacity = index->capacity * 2;
+    TitleIndexSlot *slots = (TitleIndexSlot*)calloc(capacity, sizeof(TitleIndexSlot));
+    if (!slots) return false;
+
+    for (size_t i = 0; i < index->capacity; ++i)
+    {
+        if (index->slots[i].hash != 0)
+        {
+            place_slot(slots, capacity, index->slots[i]);
+        }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = capacity;
+    return true;
+}
+
+
+/**
+ * @brief Grows the table ahead of a bulk insert.
+ *
+ * @param index The index.
+ * @param count Total number of records the index is about to hold.
+ * @return true on success, false if the table could not be grown.
+ */
+
+bool title_index_reserve(TitleIndex *index, size_t count)
+{
+    while (count * 10 > index->capacity * 7)
+    {
+        if (!grow(index)) return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Adds a record under its current title.
+ *
+ * @param index The index.
+ * @param record The record to add.
+ * @return true on success, false if the table could not be grown.
+ */
+
+bool title_index_insert(TitleIndex *index, void *record)
+{
+    if ((index->count + 1) * 10 > index->capacity * 7 && !grow(index))
+    {
+        return false;
+    }
+
+    TitleIndexSlot slot = { title_hash(RECORD_TITLE(index, record)), record };
+    place_slot(index->slots, index->capacity, slot);
+    index->count++;
+    return true;
+}
+
+
+/**
+ * @brief Removes a record.
+ *
+ * Must be called while the record still carries the title it was inserted with.
+ *
+ * @param index The index.
+ * @param record The record to remove.
+ * @return true if the record was found.
+ */
+
+bool title_index_remove(TitleIndex *index, void *record)
+{
+    size_t mask = index->capacity - 1;
+    uint32_t hash = title_hash(RECORD_TITLE(index, record));
+    size_t i = hash & mask;
+
+    while (index->slots[i].record != record)
+    {
+        if (index->slots[i].hash == 0) return false;
+        i = (i + 1) & mask;
+    }
+
+    // Backward-shift the following cluster so no tombstone is needed
+    size_t hole = i;
+    size_t j = (i + 1) & mask;
+    while (index->slots[j].hash != 0)
+    {
+        size_t home = index->slots[j].hash & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            index->slots[hole] = index->slots[j];
+            hole = j;
+        }
+        j = (j + 1) & mask;
+    }
+    index->slots[hole].hash = 0;
+    index->slots[hole].record = NULL;
+    index->count--;
+    return true;
+}
+
+
+/**
+ * @brief Finds the record that follows `previous` among those matching `title`.
+ *
+ * @param index The index.
+ * @param title The title to look up, in any case or spacing.
+ * @param previous A record returned by an earlier call, or NULL to get the first match.
+ * @return The next matching record, or NULL if there are no more.
+ */
+
+void* title_index_find_next(const TitleIndex *index, const char *title, const void *previous)
+{
+    if (!index->slots || !title) return NULL;
+
+    size_t mask = index->capacity - 1;
+    uint32_t hash = title_hash(title);
+    bool passed = previous == NULL;
+
+    for (size_t i = hash & mask; index->slots[i].hash != 0; i = (i + 1) & mask)
+    {
+        const TitleIndexSlot *slot = &index->slots[i];
+        if (!passed)
+        {
+            passed = slot->record == previous;
+            continue;
+        }
+        if (slot->hash == hash && title_equals(RECORD_TITLE(index, slot->record), title))
+        {
+            return slot->record;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Finds a record by title.
+ *
+ * @param index The index.
+ * @param title The title to look up, in any case or spacing.
+ * @return The first matching record, or NULL.
+ */
+
+void* title_index_find(const TitleIndex *index, const char *title)
+{
+    return title_index_find_next(index, title, NULL);
+}
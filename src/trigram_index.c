@@ -0,0 +1,278 @@
+/**
+ * @file trigram_index.c
+ * @brief Trigram posting lists for substring search.
+ *
+ * The trigram table uses linear probing over a power-of-two array kept at most
+ * 70% full, like the title index. Each trigram packs its three ASCII-folded bytes
+ * into the low 24 bits of its key; no byte of a C string is zero, so a zero key
+ * can mark an empty slot.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdlib.h>
+#include <string.h>
+#include "trigram_index.h"
+
+#define TRIGRAM_INDEX_INITIAL_CAPACITY 1024
+#define POSTING_INITIAL_CAPACITY 4
+#define LOCAL_TRIGRAMS 256  // Strings with more trigrams than this use a heap buffer
+
+
+static inline unsigned char fold(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+
+static inline uint32_t trigram_at(const unsigned char *p)
+{
+    return ((uint32_t)fold(p[0]) << 16) | ((uint32_t)fold(p[1]) << 8) | fold(p[2]);
+}
+
+
+static inline size_t slot_of(uint32_t key, size_t capacity)
+{
+    return (size_t)(key * 2654435761u) & (capacity - 1);
+}
+
+
+/**
+ * @brief Prepares an empty, unbuilt index. Nothing is allocated until the first add.
+ */
+
+void trigram_index_init(TrigramIndex *index)
+{
+    index->table = NULL;
+    index->capacity = 0;
+    index->used = 0;
+    index->entries = 0;
+    index->stale = 0;
+    index->built = false;
+}
+
+
+/**
+ * @brief Drops every posting list and marks the index as unbuilt.
+ */
+
+void trigram_index_clear(TrigramIndex *index)
+{
+    for (size_t i = 0; i < index->capacity; ++i)
+    {
+        free(index->table[i].ids);
+    }
+    free(index->table);
+    trigram_index_init(index);
+}
+
+
+/**
+ * @brief Releases the index.
+ */
+
+void trigram_index_destroy(TrigramIndex *index)
+{
+    trigram_index_clear(index);
+}
+
+
+/**
+ * @brief Finds the slot of a trigram, or the empty slot where it would go.
+ */
+
+static TrigramPosting* find_slot(const TrigramIndex *index, uint32_t key)
+{
+    size_t mask = index->capacity - 1;
+    size_t i = slot_of(key, index->capacity);
+    while (index->table[i].key != 0 && index->table[i].key != key)
+    {
+        i = (i + 1) & mask;
+    }
+    return &index->table[i];
+}
+
+
+/**
+ * @brief Doubles the table (or allocates the first one) and re-places the posting lists.
+ */
+
+static bool grow(TrigramIndex *index)
+{
+    size_t capacity = index->capacity ? index->capacity * 2 : TRIGRAM_INDEX_INITIAL_CAPACITY;
+    TrigramPosting *table = (TrigramPosting*)calloc(capacity, sizeof(TrigramPosting));
+    if (!table) return false;
+
+    TrigramIndex grown = *index;
+    grown.table = table;
+    grown.capacity = capacity;
+    for (size_t i = 0; i < index->capacity; ++i)
+    {
+        if (index->table[i].key != 0)
+        {
+            *find_slot(&grown, index->table[i].key) = index->table[i];
+        }
+    }
+    free(index->table);
+    index->table = table;
+    index->capacity = capacity;
+    return true;
+}
+
+
+static int compare_keys(const void *a, const void *b)
+{
+    uint32_t ka = *(const uint32_t*)a;
+    uint32_t kb = *(const uint32_t*)b;
+    return (ka > kb) - (ka < kb);
+}
+
+
+/**
+ * @brief Collects the distinct trigrams of a string, sorted.
+ *
+ * @param text The string.
+ * @param local A caller buffer of LOCAL_TRIGRAMS keys, used when it is large enough.
+ * @param keys Receives `local` or a heap buffer the caller must free.
+ * @return Number of distinct trigrams, or -1 if a heap buffer could not be allocated.
+ */
+
+static int distinct_trigrams(const char *text, uint32_t *local, uint32_t **keys)
+{
+    const unsigned char *p = (const unsigned char*)text;
+    size_t length = strlen(text);
+    size_t n = length >= 3 ? length - 2 : 0;
+
+    *keys = local;
+    if (n > LOCAL_TRIGRAMS)
+    {
+        *keys = (uint32_t*)malloc(n * sizeof(uint32_t));
+        if (!*keys) return -1;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        (*keys)[i] = trigram_at(p + i);
+    }
+    qsort(*keys, n, sizeof(uint32_t), compare_keys);
+
+    int distinct = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (distinct == 0 || (*keys)[distinct - 1] != (*keys)[i])
+        {
+            (*keys)[distinct++] = (*keys)[i];
+        }
+    }
+    return distinct;
+}
+
+
+/**
+ * @brief Indexes every trigram of `text` under `id`.
+ *
+ * @param index The index.
+ * @param id The record id.
+ * @param text The string to index.
+ * @return false on allocation failure; the index is then cleared and has to be built again.
+ */
+
+bool trigram_index_add(TrigramIndex *index, int id, const char *text)
+{
+    uint32_t local[LOCAL_TRIGRAMS];
+    uint32_t *keys;
+    int n = distinct_trigrams(text, local, &keys);
+    bool ok = n >= 0;
+
+    for (int i = 0; ok && i < n; ++i)
+    {
+        if ((index->used + 1) * 10 > index->capacity * 7 && !grow(index))
+        {
+            ok = false;
+            break;
+        }
+
+        TrigramPosting *posting = find_slot(index, keys[i]);
+        if (posting->key == 0)
+        {
+            posting->key = keys[i];
+            index->used++;
+        }
+        if (posting->count == posting->capacity)
+        {
+            int capacity = posting->capacity ? posting->capacity * 2 : POSTING_INITIAL_CAPACITY;
+            int *ids = (int*)realloc(posting->ids, (size_t)capacity * sizeof(int));
+            if (!ids)
+            {
+                ok = false;
+                break;
+            }
+            posting->ids = ids;
+            posting->capacity = capacity;
+        }
+        posting->ids[posting->count++] = id;
+        index->entries++;
+    }
+
+    if (keys != local) free(keys);
+    if (!ok) trigram_index_clear(index);
+    return ok;
+}
+
+
+/**
+ * @brief Accounts for the entries of a string that no longer belongs to its record.
+ *
+ * The entries themselves are left in place; this only feeds `trigram_index_needs_rebuild()`.
+ */
+
+void trigram_index_forget(TrigramIndex *index, const char *text)
+{
+    uint32_t local[LOCAL_TRIGRAMS];
+    uint32_t *keys;
+    int n = distinct_trigrams(text, local, &keys);
+    if (n > 0) index->stale += (size_t)n;
+    if (keys != local) free(keys);
+}
+
+
+/**
+ * @brief Tells whether stale entries have come to outnumber live ones.
+ */
+
+bool trigram_index_needs_rebuild(const TrigramIndex *index)
+{
+    return index->stale > 1024 && index->stale * 2 > index->entries;
+}
+
+
+/**
+ * @brief Returns the shortest posting list among the trigrams of `query`.
+ *
+ * Every record containing `query` (ignoring ASCII case) is in the returned list.
+ *
+ * @param index A built index.
+ * @param query The substring searched for.
+ * @param ids Receives the candidate ids (unsorted, possibly repeated or stale).
+ * @param count Receives the number of candidates; 0 when some trigram never occurs.
+ * @return false if the query is shorter than three bytes and the index cannot help.
+ */
+
+bool trigram_index_candidates(const TrigramIndex *index, const char *query, const int **ids, int *count)
+{
+    size_t length = strlen(query);
+    if (length < 3) return false;
+
+    *ids = NULL;
+    *count = 0;
+    if (index->capacity == 0) return true;
+
+    const TrigramPosting *best = NULL;
+    for (size_t i = 0; i + 3 <= length; ++i)
+    {
+        const TrigramPosting *posting = find_slot(index, trigram_at((const unsigned char*)query + i));
+        if (posting->key == 0) return true; // A trigram nobody has: no matches at all
+        if (!best || posting->count < best->count) best = posting;
+    }
+    *ids = best->ids;
+    *count = best->count;
+    return true;
+}
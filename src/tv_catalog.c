@@ -0,0 +1,200 @@
+/**
+ * @file tv_catalog.c
+ * @brief Ownership and indexing of the TV series collection.
+ *
+ * A thin layer over the shared Collection engine: it names the orderings of a
+ * series, keeps the totals in step through the same append/unlink/link hooks
+ * the movie catalog uses, and lets the collection free the series it still
+ * holds when it is destroyed.
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stddef.h>
+#include "tv_catalog.h"
+
+static void destroy_series(void *record);
+
+static const CollectionOrder series_orders[TV_VIEW_COUNT] =
+{
+    [TV_VIEW_ID]       = { { { SORT_FIELD_INT, offsetof(TV_Series, id), false } }, 1 },
+    [TV_VIEW_TITLE]    = { { { SORT_FIELD_STRING, offsetof(TV_Series, title), false }, { SORT_FIELD_STRING, offsetof(TV_Series, creator), false } }, 2 },
+    [TV_VIEW_CREATOR]  = { { { SORT_FIELD_STRING, offsetof(TV_Series, creator), false }, { SORT_FIELD_STRING, offsetof(TV_Series, title), false } }, 2 },
+    [TV_VIEW_SEASONS]  = { { { SORT_FIELD_INT, offsetof(TV_Series, seasons), true }, { SORT_FIELD_STRING, offsetof(TV_Series, title), false } }, 2 },
+    [TV_VIEW_EPISODES] = { { { SORT_FIELD_INT, offsetof(TV_Series, episodes), true }, { SORT_FIELD_STRING, offsetof(TV_Series, title), false } }, 2 },
+    [TV_VIEW_RATING]   = { { { SORT_FIELD_FLOAT, offsetof(TV_Series, rating), true }, { SORT_FIELD_STRING, offsetof(TV_Series, title), false } }, 2 },
+};
+
+static const CollectionType series_type =
+{
+    sizeof(TV_Series), offsetof(TV_Series, id), offsetof(TV_Series, title), series_orders, TV_VIEW_COUNT, destroy_series
+};
+
+
+static void destroy_series(void *record)
+{
+    TV_Series *series = (TV_Series*)record;
+    series->catalog = NULL; // The collection is going away, nothing to unlink from
+    delete_tv_series(series);
+}
+
+
+static void count_series(TvCatalog *catalog, const TV_Series *series, int sign)
+{
+    catalog->totals.series += sign;
+    catalog->totals.seasons += sign * series->seasons;
+    catalog->totals.episodes += sign * series->episodes;
+    catalog->totals.rated_episodes += sign * (long)series->rating_totals.rated;
+    catalog->totals.rating_sum += sign * (long)series->rating_totals.rating_sum;
+    catalog->dirty = true;
+}
+
+
+/**
+ * @brief Initializes an empty TV catalog.
+ *
+ * @param catalog The catalog to initialize.
+ * @param capacity Initial number of slots.
+ * @return TV_SERIES_SUCCESS, or TV_SERIES_ERROR_MEMORY_ALLOCATION.
+ */
+
+TV_SeriesError tv_catalog_init(TvCatalog *catalog, int capacity)
+{
+    if (!catalog) return TV_SERIES_ERROR_NULL_POINTER;
+    if (!collection_init(&catalog->series, &series_type, capacity))
+    {
+        return TV_SERIES_ERROR_MEMORY_ALLOCATION;
+    }
+    catalog->totals.series = 0;
+    catalog->totals.seasons = 0;
+    catalog->totals.episodes = 0;
+    catalog->totals.rated_episodes = 0;
+    catalog->totals.rating_sum = 0;
+    catalog->dirty = false;
+    return TV_SERIES_SUCCESS;
+}
+
+
+/**
+ * @brief Releases the catalog and deletes every series it holds.
+ */
+
+void tv_catalog_destroy(TvCatalog *catalog)
+{
+    if (!catalog) return;
+    collection_destroy(&catalog->series);
+}
+
+
+/**
+ * @brief Makes sure the catalog has room for `extra` more series.
+ */
+
+TV_SeriesError tv_catalog_reserve(TvCatalog *catalog, int extra)
+{
+    if (!catalog) return TV_SERIES_ERROR_NULL_POINTER;
+    return collection_reserve(&catalog->series, extra) ? TV_SERIES_SUCCESS : TV_SERIES_ERROR_MEMORY_ALLOCATION;
+}
+
+
+/**
+ * @brief Adds a series created with `create_tv_series()` and takes ownership of it.
+ *
+ * @param catalog The catalog.
+ * @param series A series that is not in any catalog yet.
+ * @return TV_SERIES_SUCCESS, TV_SERIES_ERROR_NULL_POINTER for a missing series or one that
+ *         already belongs to a catalog, or TV_SERIES_ERROR_MEMORY_ALLOCATION (the caller
+ *         still owns the series).
+ */
+
+TV_SeriesError tv_catalog_add(TvCatalog *catalog, TV_Series *series)
+{
+    if (!catalog || !series || series->catalog) return TV_SERIES_ERROR_NULL_POINTER;
+    if (!collection_append(&catalog->series, series))
+    {
+        return TV_SERIES_ERROR_MEMORY_ALLOCATION;
+    }
+    series->catalog = catalog;
+    count_series(catalog, series, 1);
+    return TV_SERIES_SUCCESS;
+}
+
+
+/**
+ * @brief Drops a series from the indexes and totals before its values change.
+ */
+
+void tv_catalog_unlink(TvCatalog *catalog, TV_Series *series)
+{
+    collection_unlink(&catalog->series, series);
+    count_series(catalog, series, -1);
+}
+
+
+/**
+ * @brief Puts a series unlinked with `tv_catalog_unlink()` back under its new values.
+ */
+
+void tv_catalog_link(TvCatalog *catalog, TV_Series *series)
+{
+    collection_link(&catalog->series, series);
+    count_series(catalog, series, 1);
+}
+
+
+/**
+ * @brief Takes a series out of the catalog in O(log N), leaving it to the caller.
+ *
+ * Its slot is reused by the next series added. `delete_tv_series()` calls this
+ * itself, so it is only needed to keep a series after removing it.
+ */
+
+void tv_catalog_remove(TvCatalog *catalog, TV_Series *series)
+{
+    tv_catalog_unlink(catalog, series);
+    collection_release(&catalog->series, series);
+    series->catalog = NULL;
+    series->id = -1;
+}
+
+
+/**
+ * @brief Returns the series with the given id, or NULL for a deleted or unknown id.
+ */
+
+TV_Series* tv_catalog_get(const TvCatalog *catalog, int id)
+{
+    if (!catalog) return NULL;
+    return (TV_Series*)collection_get(&catalog->series, id);
+}
+
+
+/**
+ * @brief Looks a series up by title through the catalog's hash index, O(1) on average.
+ */
+
+TV_Series* tv_catalog_find(const TvCatalog *catalog, const char *title)
+{
+    if (!catalog) return NULL;
+    return search_tv_series(&catalog->series.title_index, title);
+}
+
+
+/**
+ * @brief Returns one of the catalog's maintained orderings, building it on first use.
+ */
+
+SortedView* tv_catalog_view(TvCatalog *catalog, TvView view)
+{
+    if (!catalog) return NULL;
+    return collection_view(&catalog->series, (int)view);
+}
+
+
+/**
+ * @brief Returns the number of series and their season, episode and rating totals, in O(1).
+ */
+
+TV_SeriesTotals tv_catalog_totals(const TvCatalog *catalog)
+{
+    return catalog->totals;
+}
@@ -1,10 +1,86 @@
-///FIXME: Make the Implementation
 #include "tv_series.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "sort.h"
+#include "name_table.h"
+#include "tv_catalog.h"
 
-// Function to create a new TV series
+// Builds the rating block for a new season layout, carrying over the ratings of every
+// (season, episode) the old layout also has. `lengths` gives the episodes of each season,
+// or NULL to spread `episodes` evenly with the earlier seasons taking the remainder.
+static uint32_t* build_rating_block(const TV_Series* old, int seasons, const int* lengths, int episodes) {
+    size_t header = (size_t)(seasons + 1) * sizeof(uint32_t) + (size_t)seasons * sizeof(TV_RatingTotals);
+    uint32_t* starts = (uint32_t*)malloc(header + (size_t)episodes);
+    if (!starts) {
+        return NULL;
+    }
+    uint8_t* ratings = (uint8_t*)starts + header;
+
+    starts[0] = 0;
+    for (int s = 0; s < seasons; ++s) {
+        int length = lengths ? lengths[s] : episodes / seasons + (s < episodes % seasons);
+        starts[s + 1] = starts[s] + (uint32_t)length;
+    }
+    memset(ratings, 0, (size_t)episodes);
+
+    if (old && old->season_starts) {
+        int common = seasons < old->seasons ? seasons : old->seasons;
+        for (int s = 0; s < common; ++s) {
+            uint32_t old_length = old->season_starts[s + 1] - old->season_starts[s];
+            uint32_t length = starts[s + 1] - starts[s];
+            memcpy(ratings + starts[s], old->episode_ratings + old->season_starts[s],
+                   old_length < length ? old_length : length);
+        }
+    }
+    return starts;
+}
+
+static void update_average(TV_Series* series) {
+    const TV_RatingTotals* totals = &series->rating_totals;
+    series->rating = totals->rated ? (float)totals->rating_sum / ((float)totals->rated * TV_RATING_SCALE) : 0.0f;
+}
+
+// Switches the series to a block from build_rating_block() and recomputes the cached totals
+static void adopt_rating_block(TV_Series* series, uint32_t* starts, int seasons, int episodes) {
+    free(series->season_starts);
+    series->season_starts = starts;
+    series->season_totals = (TV_RatingTotals*)(starts + seasons + 1);
+    series->episode_ratings = (uint8_t*)(series->season_totals + seasons);
+    series->seasons = seasons;
+    series->episodes = episodes;
+
+    series->rating_totals.rated = 0;
+    series->rating_totals.rating_sum = 0;
+    for (int s = 0; s < seasons; ++s) {
+        TV_RatingTotals* totals = &series->season_totals[s];
+        totals->rated = 0;
+        totals->rating_sum = 0;
+        for (uint32_t e = starts[s]; e < starts[s + 1]; ++e) {
+            uint8_t rating = series->episode_ratings[e];
+            totals->rated += rating != 0;
+            totals->rating_sum += rating;
+        }
+        series->rating_totals.rated += totals->rated;
+        series->rating_totals.rating_sum += totals->rating_sum;
+    }
+    update_average(series);
+}
+
+// Index of an episode in episode_ratings, or -1 if the series has no such episode (both 1-based)
+static long episode_index(const TV_Series* series, int season, int episode) {
+    if (!series || season < 1 || season > series->seasons || episode < 1) {
+        return -1;
+    }
+    uint32_t start = series->season_starts[season - 1];
+    if ((uint32_t)episode > series->season_starts[season] - start) {
+        return -1;
+    }
+    return (long)(start + (uint32_t)episode - 1);
+}
+
+// Function to create a new TV series, not yet part of any catalog (see tv_catalog_add())
 TV_Series* create_tv_series(const char* title, const char* creator, int seasons, int episodes) {
     if (!title || !creator || seasons < 1 || episodes < 1) {
         return NULL; // Check for invalid input as per error codes
@@ -16,26 +92,61 @@ TV_Series* create_tv_series(const char* title, const char* creator, int seasons,
     }
 
     new_series->title = strdup(title);
-    new_series->creator = strdup(creator);
+    new_series->creator = name_intern(creator); // Shared with directors and other series
+    if (!new_series->title || !new_series->creator) {
+        free(new_series->title);
+        free(new_series);
+        return NULL;
+    }
     new_series->seasons = seasons;
     new_series->episodes = episodes;
+    new_series->id = -1;
+    new_series->catalog = NULL;
+    new_series->season_starts = NULL;
+
+    uint32_t* block = build_rating_block(NULL, seasons, NULL, episodes);
+    if (!block) {
+        free(new_series->title);
+        free(new_series);
+        return NULL;
+    }
+    adopt_rating_block(new_series, block, seasons, episodes); // No episode is rated yet
 
     return new_series;
 }
 
-// Function to update the details of a TV series
+// Function to update the details of a TV series; a series in a catalog is re-indexed under the new values.
+// Changing the number of seasons or episodes spreads the episodes evenly again, keeping the rating of
+// every episode that still exists
 TV_SeriesError update_tv_series(TV_Series* series, const char* new_title, const char* new_creator, int new_seasons, int new_episodes) {
     if (!series || !new_title || !new_creator || new_seasons < 1 || new_episodes < 1) {
         return TV_SERIES_ERROR_NULL_POINTER; // Check for invalid input
     }
 
+    char *title = strdup(new_title);
+    const char *creator = name_intern(new_creator);
+    bool relayout = new_seasons != series->seasons || new_episodes != series->episodes;
+    uint32_t *block = relayout ? build_rating_block(series, new_seasons, NULL, new_episodes) : NULL;
+    if (!title || !creator || (relayout && !block)) {
+        free(title);
+        free(block);
+        return TV_SERIES_ERROR_MEMORY_ALLOCATION; // The series is unchanged
+    }
+
+    TvCatalog *catalog = series->catalog;
+    if (catalog) {
+        tv_catalog_unlink(catalog, series);
+    }
     free(series->title);
-    free(series->creator);
 
-    series->title = strdup(new_title);
-    series->creator = strdup(new_creator);
-    series->seasons = new_seasons;
-    series->episodes = new_episodes;
+    series->title = title;
+    series->creator = creator;
+    if (block) {
+        adopt_rating_block(series, block, new_seasons, new_episodes);
+    }
+    if (catalog) {
+        tv_catalog_link(catalog, series);
+    }
 
     return TV_SERIES_SUCCESS; // Successfully updated
 }
@@ -47,40 +158,153 @@ void display_tv_series(const TV_Series* series) {
         printf("Creator: %s\n", series->creator);
         printf("Seasons: %d\n", series->seasons);
         printf("Episodes: %d\n", series->episodes);
+        printf("Rating: %.2f (%u of %d episodes rated)\n", series->rating, series->rating_totals.rated, series->episodes);
     }
 }
 
-// Function to delete a TV series and free the memory
+// Function to delete a TV series and free the memory, removing it from its catalog first
 void delete_tv_series(TV_Series* series) {
     if (series) {
+        if (series->catalog) {
+            tv_catalog_remove(series->catalog, series);
+        }
         free(series->title);
-        free(series->creator);
+        free(series->season_starts); // The whole rating block
         free(series);
     }
 }
 
-// Function to search for a TV series by title
-TV_Series* search_tv_series(TV_Series* series[], int count, const char* title) {
-    for (int i = 0; i < count; ++i) {
-        if (strcmp(series[i]->title, title) == 0) {
-            return series[i];
+// Function to search for a TV series by title through a hash index of the collection,
+// O(1) on average and insensitive to case and whitespace differences
+TV_Series* search_tv_series(const TitleIndex* index, const char* title) {
+    if (!index || !title) {
+        return NULL;
+    }
+    return (TV_Series*)title_index_find(index, title);
+}
+
+// Function to sort an array of TV series on one or more keys (title, creator, seasons, episodes, rating),
+// most significant first. Stable, O(n log n) or better, see sort.c
+TV_SeriesError sort_tv_series(TV_Series* series[], int count, const TV_SeriesSortKey keys[], int key_count) {
+    static const SortField fields[] = {
+        [TV_SERIES_SORT_TITLE]    = { SORT_FIELD_STRING, offsetof(TV_Series, title), false },
+        [TV_SERIES_SORT_CREATOR]  = { SORT_FIELD_STRING, offsetof(TV_Series, creator), false },
+        [TV_SERIES_SORT_SEASONS]  = { SORT_FIELD_INT, offsetof(TV_Series, seasons), false },
+        [TV_SERIES_SORT_EPISODES] = { SORT_FIELD_INT, offsetof(TV_Series, episodes), false },
+        [TV_SERIES_SORT_RATING]   = { SORT_FIELD_FLOAT, offsetof(TV_Series, rating), false },
+    };
+    SortField spec[SORT_MAX_FIELDS];
+
+    if (!series || !keys || key_count < 1 || key_count > SORT_MAX_FIELDS) {
+        return TV_SERIES_ERROR_NULL_POINTER;
+    }
+    for (int i = 0; i < key_count; ++i) {
+        if ((unsigned)keys[i].field > TV_SERIES_SORT_RATING) {
+            return TV_SERIES_ERROR_NULL_POINTER;
         }
+        spec[i] = fields[keys[i].field];
+        spec[i].descending = keys[i].descending;
+    }
+
+    if (!sort_records((void**)series, count > 0 ? (size_t)count : 0, spec, key_count)) {
+        return TV_SERIES_ERROR_MEMORY_ALLOCATION;
+    }
+    return TV_SERIES_SUCCESS;
+}
+
+// Function to give each season its own number of episodes, for shows whose seasons differ in length.
+// Ratings are kept for every (season, episode) that still exists
+TV_SeriesError set_tv_series_seasons(TV_Series* series, const int episodes_per_season[], int seasons) {
+    if (!series || !episodes_per_season || seasons < 1) {
+        return TV_SERIES_ERROR_NULL_POINTER;
     }
-    return NULL;
-}
-
-// Function to sort an array of TV series alphabetically by title
-void sort_tv_series(TV_Series* series[], int count) {
-    bool swapped;
-    do {
-        swapped = false;
-        for (int i = 0; i < count - 1; ++i) {
-            if (strcmp(series[i]->title, series[i+1]->title) > 0) {
-                TV_Series* temp = series[i];
-                series[i] = series[i+1];
-                series[i+1] = temp;
-                swapped = true;
-            }
+    long episodes = 0;
+    for (int s = 0; s < seasons; ++s) {
+        if (episodes_per_season[s] < 0 || episodes_per_season[s] > INT32_MAX - episodes) {
+            return TV_SERIES_ERROR_OUT_OF_RANGE;
         }
-    } while (swapped);
+        episodes += episodes_per_season[s];
+    }
+    if (episodes < 1) {
+        return TV_SERIES_ERROR_OUT_OF_RANGE;
+    }
+
+    uint32_t* block = build_rating_block(series, seasons, episodes_per_season, (int)episodes);
+    if (!block) {
+        return TV_SERIES_ERROR_MEMORY_ALLOCATION; // The series is unchanged
+    }
+    TvCatalog *catalog = series->catalog;
+    if (catalog) {
+        tv_catalog_unlink(catalog, series); // Seasons and episodes are indexed
+    }
+    adopt_rating_block(series, block, seasons, (int)episodes);
+    if (catalog) {
+        tv_catalog_link(catalog, series);
+    }
+    return TV_SERIES_SUCCESS;
+}
+
+// Function to rate one episode (season and episode are 1-based) from 0 to 5, 0 clearing the rating.
+// The season and series totals are updated in O(1) and a series in a catalog is re-indexed
+TV_SeriesError rate_tv_episode(TV_Series* series, int season, int episode, float rating) {
+    if (!series) {
+        return TV_SERIES_ERROR_NULL_POINTER;
+    }
+    long index = episode_index(series, season, episode);
+    if (index < 0 || !(rating >= 0.0f && rating <= 5.0f)) {
+        return TV_SERIES_ERROR_OUT_OF_RANGE;
+    }
+    uint8_t old_rating = series->episode_ratings[index];
+    uint8_t new_rating = (uint8_t)(rating * TV_RATING_SCALE + 0.5f);
+    if (old_rating == new_rating) {
+        return TV_SERIES_SUCCESS;
+    }
+
+    TvCatalog *catalog = series->catalog;
+    if (catalog) {
+        tv_catalog_unlink(catalog, series); // The mean rating is indexed and counted
+    }
+    TV_RatingTotals* totals[2] = { &series->season_totals[season - 1], &series->rating_totals };
+    for (int i = 0; i < 2; ++i) {
+        totals[i]->rated += (uint32_t)(new_rating != 0) - (uint32_t)(old_rating != 0);
+        totals[i]->rating_sum += (uint32_t)new_rating - (uint32_t)old_rating;
+    }
+    series->episode_ratings[index] = new_rating;
+    update_average(series);
+    if (catalog) {
+        tv_catalog_link(catalog, series);
+    }
+    return TV_SERIES_SUCCESS;
+}
+
+// Function to get the number of episodes of a season (1-based), 0 for a season the series does not have
+int tv_season_episodes(const TV_Series* series, int season) {
+    if (!series || season < 1 || season > series->seasons) {
+        return 0;
+    }
+    return (int)(series->season_starts[season] - series->season_starts[season - 1]);
+}
+
+// Function to get the rating of an episode (both 1-based), 0 when it is unrated or does not exist
+float tv_episode_rating(const TV_Series* series, int season, int episode) {
+    long index = episode_index(series, season, episode);
+    if (index < 0) {
+        return 0.0f;
+    }
+    return (float)series->episode_ratings[index] / TV_RATING_SCALE;
+}
+
+// Function to get the cached number of rated episodes of a season (1-based) and their rating sum
+TV_RatingTotals tv_season_totals(const TV_Series* series, int season) {
+    TV_RatingTotals none = { 0, 0 };
+    if (!series || season < 1 || season > series->seasons) {
+        return none;
+    }
+    return series->season_totals[season - 1];
+}
+
+// Function to get the mean rating of the rated episodes of a season (1-based), 0 when none is rated. O(1)
+float tv_season_average(const TV_Series* series, int season) {
+    TV_RatingTotals totals = tv_season_totals(series, season);
+    return totals.rated ? (float)totals.rating_sum / ((float)totals.rated * TV_RATING_SCALE) : 0.0f;
 }
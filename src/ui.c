@@ -17,12 +17,17 @@
  * messages and input prompts are displayed in a separate window.
  *
  * Functions in this file include:
+ * - `init_ui()` / `end_ui()`: Start and stop ncurses once for the whole session.
  * - `main_menu()`: Presents the main menu and captures user selection.
  * - `print_menu()`: Prints the menu options with navigation highlights.
  * - `print_to_left()`: Outputs strings to a window, aligned to the left.
- * - `display_movie_list_ui()`: Displays the list of movies and handles user interaction.
+ * - `display_movie_list_ui()`: Displays the list of movies in a list widget and handles user interaction.
+ * - `display_paged_movie_list_ui()`: Browses a snapshot too large to load, through its page cache.
+ * - `add_tv_series_ui()`: Asks for the details of a new TV series and adds it to the catalog.
+ * - `display_tv_series_list_ui()`: Lists the TV series with sorting and deletion.
+ * - `display_stats_ui()`: Shows the statistics dashboard from the catalog's running totals.
  * - `ui_print_error()`: Displays error messages to the user.
- * - `edit_movie_ui()`: Interface to edit the details of a movie entry.
+ * - `edit_movie_ui()`: Edits the movies marked in the list, all at once.
  *
  * @note This file is part of the UI module and should be included with `ui.h`.
  *       The functions assume that the ncurses library has been initialized
@@ -31,9 +36,21 @@
 
 #include "ui.h"
 #include <ncurses.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
 #include "movie.h"
+#include "list_widget.h"
+#include "movie_filter.h"
+#include "popup.h"
+#include "notify.h"
+#include "perf.h"
+#include "input.h"
+#include "profile.h"
+#include "recommend.h"
+#include "history.h"
 
 /*FUNCTION PROTOTYPES*/
 void print_menu(WINDOW *menu_win, int highlight);
@@ -46,12 +63,14 @@ const char *choices[] =
     "2) DISPLAY MOVIES",
     "3) ADD TV SERIES",
     "4) DISPLAY TV SERIES",
-    "5) EXIT",
+    "5) STATISTICS",
+    "6) SWITCH USER",
+    "7) EXIT",
     (char *)NULL
 };
 
 const int width = 30;  
-const int height = 12;
+const int height = 16;
 
 
 /**
@@ -64,6 +83,53 @@ const int height = 12;
  * enum MenuOption { OPTION_ONE, OPTION_TWO, OPTION_THREE, OPTION_FOUR, OPTION_FIVE };
  */
 
+static bool ui_active = false; // Between init_ui() and end_ui()
+
+
+/**
+ * @fn void init_ui()
+ * @brief Starts ncurses for the whole session.
+ *
+ * Called once at startup; every screen after that draws into the same session
+ * instead of initializing and tearing down ncurses on its own. The color pairs
+ * of all screens are defined here (see UiColorPair).
+ */
+
+void init_ui()
+{
+    initscr();
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+    set_escdelay(25); // Esc leaves the list filter; don't wait a second to tell it from a key sequence
+    if (has_colors())
+    {
+        start_color();
+        init_pair(UI_PAIR_MENU, COLOR_YELLOW, COLOR_BLUE);
+        init_pair(UI_PAIR_MENU_SELECTED, COLOR_BLACK, COLOR_WHITE);
+        init_pair(UI_PAIR_ROW, COLOR_CYAN, COLOR_BLACK);
+        init_pair(UI_PAIR_ACCENT, COLOR_MAGENTA, COLOR_BLACK);
+        init_pair(UI_PAIR_HEADER, COLOR_YELLOW, COLOR_BLACK);
+    }
+    notify_start(); // Messages now go to the status line instead of stderr
+    ui_active = true;
+}
+
+
+/**
+ * @fn void end_ui()
+ * @brief Ends the ncurses session and restores the terminal.
+ */
+
+void end_ui()
+{
+    if (!ui_active) return;
+    notify_stop();
+    endwin();
+    ui_active = false;
+}
+
+
 /**
  * @fn MenuOption main_menu()
  * @brief Creates a menu window and handles the keyboard interactions to navigate through the menu options.
@@ -74,10 +140,10 @@ const int height = 12;
  *
  * @return The selected menu option as a `MenuOption` enum value.
  *
- * @pre The ncurses library should be initialized with `initscr()` and the color pairs should
- *      be defined with `init_pair()`.
- * @post The function returns the user's selection from the main menu and the ncurses window
- *       is closed with `endwin()`.
+ * @pre The ncurses library should be initialized with `init_ui()`, which also defines the
+ *      color pairs.
+ * @post The function returns the user's selection from the main menu and the menu window
+ *       is deleted; ncurses stays active.
  * 
  * @note The function assumes that `width` and `height` are previously defined with the dimensions
  *       of the menu window and that `print_menu()` is a function that handles the actual printing of the
@@ -93,16 +159,10 @@ MenuOption main_menu()
     WINDOW *menu_win;
     int highlight = 1;
     int choice = 0;
+    int items = MENU_EXIT + 1;
     int c;
 
-    initscr();
-    clear();
-    noecho();
-    cbreak();
-    start_color();
-
-    init_pair(1, COLOR_YELLOW, COLOR_BLUE);
-    init_pair(2, COLOR_BLACK, COLOR_WHITE);
+    erase();
 
     int startx = (60 - width) / 2;
     int starty = (20 - height) / 2 - 2;  // Further adjusted starting position
@@ -116,21 +176,16 @@ MenuOption main_menu()
 
     while (1) 
     {
-        
-        c = wgetch(menu_win);
+        InputEvent event;
+        if (!input_read(menu_win, -1, &event)) continue;
+        c = event.key;
         switch (c) 
         {
-            case KEY_UP:
-                if (highlight == 1)
-                    highlight = 5;
-                else
-                    --highlight;
+            case KEY_UP: // Wraps around; repeats are folded into one step
+                highlight = (highlight - 1 + items - event.count % items) % items + 1;
                 break;
             case KEY_DOWN:
-                if (highlight == 5)
-                    highlight = 1;
-                else 
-                    ++highlight;
+                highlight = (highlight - 1 + event.count) % items + 1;
                 break;
             case 10:  // Enter key
                 choice = highlight;
@@ -144,9 +199,9 @@ MenuOption main_menu()
         if (choice != 0)
             break;
     }
-    clrtoeol();
+    delwin(menu_win);
+    erase();
     refresh();
-    endwin();
     return (MenuOption)(choice - 1);
 }
 
@@ -181,16 +236,16 @@ void print_menu(WINDOW *menu_win, int highlight)
     int x = 2, y = 2;
 
     box(menu_win, 0, 0);
-    for (int i = 0; i < 5; ++i) 
+    for (int i = 0; choices[i] != NULL; ++i) 
     {
         if (highlight == i + 1) 
         {
-            wattron(menu_win, A_REVERSE | COLOR_PAIR(2));
-            print_to_left(menu_win, y, choices[i], COLOR_PAIR(2));
-            wattroff(menu_win, A_REVERSE | COLOR_PAIR(2));
+            wattron(menu_win, A_REVERSE | COLOR_PAIR(UI_PAIR_MENU_SELECTED));
+            print_to_left(menu_win, y, choices[i], COLOR_PAIR(UI_PAIR_MENU_SELECTED));
+            wattroff(menu_win, A_REVERSE | COLOR_PAIR(UI_PAIR_MENU_SELECTED));
         } 
         else
-            print_to_left(menu_win, y, choices[i], COLOR_PAIR(1));
+            print_to_left(menu_win, y, choices[i], COLOR_PAIR(UI_PAIR_MENU));
         y += 2;
     }
     wrefresh(menu_win);
@@ -232,272 +287,2025 @@ void print_to_left(WINDOW *win, int starty, const char *string, chtype color)
 }
 
 
+// Orders offered by the movie list, cycled with 's'
+typedef struct
+{
+    const char *label;
+    MovieView view;
+} MovieListOrder;
+
+static const MovieListOrder movie_list_orders[] =
+{
+    { "catalog", MOVIE_VIEW_ID },
+    { "title", MOVIE_VIEW_TITLE },
+    { "year", MOVIE_VIEW_YEAR },
+    { "rating", MOVIE_VIEW_RATING },
+    { "director", MOVIE_VIEW_DIRECTOR },
+};
+
+#define MOVIE_LIST_ORDER_COUNT ((int)(sizeof(movie_list_orders) / sizeof(movie_list_orders[0])))
+
+// What the movie list callbacks need to fetch a page
+typedef struct
+{
+    MovieCatalog *catalog;
+    int order;   // Index into movie_list_orders
+    MovieFilter filter;
+    Movie **matches;     // Movies passing a non-empty filter, in the current order
+    int match_count;
+    int match_capacity;
+    Profile *profile;    // Whose ratings are shown and given; the catalog's when no user is active
+    unsigned char *marks; // One flag per catalog slot, the movies selected for a bulk edit
+    int mark_capacity;
+    int mark_count;
+} MovieListState;
+
+
 /**
- * @fn void display_movie_list_ui(Movie **movies, int count)
- * @brief Displays the movie list in a paginated window using ncurses.
- * 
- * Creates an ncurses window to display a list of movies with pagination support.
- * It shows a limited number of movies at a time and allows the user to scroll through
- * the list with up and down arrow keys. Additional functionalities such as rating
- * a movie or deleting a movie can be invoked with key presses. The UI loop continues
- * until 'q' is pressed to quit.
- * 
- * @param movies A pointer to an array of pointers to Movie structures that hold movie details.
- * @param count The total number of movies in the movies array.
- * 
- * @pre The ncurses library should not be active as the function initializes it.
- * @post Upon exit (when 'q' is pressed), the ncurses library is terminated and the window is cleaned up.
- * 
- * @note The function is designed to handle KEY_UP and KEY_DOWN for navigation,
- *       'r' for rating a movie, 'd' for deleting a movie, and 'q' to quit the window.
- *       If 'r' or 'd' is pressed, the function calls `rate_movie()` or `handle_deletion()`,
- *       which are assumed to be implemented elsewhere.
- *       The list can be navigated only if there are movies to display.
- * 
- * @warning The function assumes that the movies array and count accurately represent the list
- *          of movies. Any discrepancy can lead to undefined behavior or crashes.
- *          The function also assumes that each Movie pointer in the array is valid and not NULL.
- *          If a NULL pointer is encountered, it is skipped.
+ * @brief Rebuilds the filtered rows from the filter's results.
+ *
+ * The filter hands back ids in catalog order, which is already the order of the
+ * "catalog" listing; the other orders sort just the matches by the view's keys.
+ *
+ * @param state The list state.
+ * @return false if the rows could not be allocated or sorted.
  */
 
-void display_movie_list_ui(Movie **movies, int count) 
+static bool refresh_matches(MovieListState *state)
 {
-    if (movies == NULL) return; // Check for NULL pointer
+    int count;
+    const int *ids = movie_filter_results(&state->filter, &count);
 
-    WINDOW *movies_win;
-    int ch, width = 70;
-    int current_start = 0;
-    int current_highlight = 0;
-    const int display_count = 5;
+    state->match_count = 0;
+    if (count > state->match_capacity)
+    {
+        Movie **matches = (Movie**)realloc(state->matches, (size_t)count * sizeof(Movie*));
+        if (!matches) return false;
+        state->matches = matches;
+        state->match_capacity = count;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        Movie *movie = catalog_get(state->catalog, ids[i]);
+        if (movie) state->matches[state->match_count++] = movie;
+    }
 
-    initscr();
-    start_color();
-    init_pair(1, COLOR_CYAN, COLOR_BLACK);
-    init_pair(2, COLOR_MAGENTA, COLOR_BLACK);
-    init_pair(3, COLOR_YELLOW, COLOR_BLACK);
-    noecho();
-    cbreak();
-    keypad(stdscr, TRUE);
+    const SortedView *view = &state->catalog->movies.views[movie_list_orders[state->order].view];
+    if (movie_list_orders[state->order].view != MOVIE_VIEW_ID &&
+        !sort_records((void**)state->matches, (size_t)state->match_count, view->fields, view->field_count))
+    {
+        return false;
+    }
+    return true;
+}
 
-    movies_win = newwin(display_count + 4, width, 1, (COLS - width) / 2);
-    keypad(movies_win, TRUE);
-    box(movies_win, 0, 0);
-    mvwprintw(movies_win, 0, width / 2 - 7, " MOVIE LIST ");
 
-    wattron(movies_win, A_BOLD);
-    wattron(movies_win, COLOR_PAIR(3));
-    mvwprintw(movies_win, 1, 1, " No  | Title           | Director       | Year | Rating ");
-    wattroff(movies_win, COLOR_PAIR(3));
-    wattroff(movies_win, A_BOLD);
+/**
+ * @brief Number of rows in the list: the matches while a filter is set, otherwise every movie.
+ */
 
-    while (1) 
-    {
-        wclear(movies_win);
-        box(movies_win, 0, 0);
-        mvwprintw(movies_win, 0, width / 2 - 7, " MOVIE LIST ");
-        wattron(movies_win, A_BOLD);
-        wattron(movies_win, COLOR_PAIR(3));
-        mvwprintw(movies_win, 1, 1, " No  | Title           | Director     | Year - Rating |");
-        wattroff(movies_win, COLOR_PAIR(3));
-        wattroff(movies_win, A_BOLD);
+static int movie_list_total(const MovieListState *state)
+{
+    return state->filter.length > 0 ? state->match_count : state->catalog->movies.count;
+}
+
+
+/**
+ * @brief Fetches one page of the movie list in the requested order.
+ *
+ * Every order, including catalog order, comes from one of the catalog's
+ * maintained views (see `collection_page()`), so a page costs O(log N + rows)
+ * whatever its position in the list and deleted slots never show up.
+ *
+ * @param catalog The catalog to list.
+ * @param order Index into movie_list_orders.
+ * @param start Position of the first row in the ordering.
+ * @param page Receives the movies.
+ * @param max Capacity of `page`.
+ * @return Number of rows fetched, or -1 if the view could not be built.
+ */
+
+static int fetch_movie_page(MovieCatalog *catalog, int order, int start, Movie **page, int max)
+{
+    return collection_page(&catalog->movies, (int)movie_list_orders[order].view, start, (void**)page, max);
+}
+
+
+/**
+ * @brief Returns the position of a movie in a list order, or -1 if unknown.
+ */
 
-        for (int i = 0; i < display_count && (i + current_start) < count; i++) 
+static int movie_list_position(MovieListState *state, const Movie *movie)
+{
+    if (state->filter.length > 0)
+    {
+        for (int i = 0; i < state->match_count; ++i)
         {
-            if (i == current_highlight) wattron(movies_win, A_REVERSE);
-
-            Movie *current_movie = movies[i + current_start]; // Added to improve readability
-            if (current_movie == NULL) continue; // Check for NULL pointer
-
-            wattron(movies_win, COLOR_PAIR(1));
-            mvwprintw(movies_win, i + 2, 1,
-                      "%4d |%-15.15s |%-15.15s |%4d - %.1f/5",
-                      i + 1 + current_start,
-                      current_movie->title,
-                      current_movie->director,
-                      current_movie->year,
-                      current_movie->rating);
-            wattroff(movies_win, COLOR_PAIR(1));
-
-            if (i == current_highlight) wattroff(movies_win, A_REVERSE);
+            if (state->matches[i] == movie) return i;
         }
+        return -1;
+    }
+
+    SortedView *view = catalog_view(state->catalog, movie_list_orders[state->order].view);
+    if (!view) return -1;
+    size_t rank = sorted_view_rank(view, movie);
+    return rank == SIZE_MAX ? -1 : (int)rank;
+}
 
-        mvwprintw(movies_win, display_count + 3, 6, "Arrow Keys: Navigation,'r':Rate,'d':Delete,'q':Quit.");
-        wrefresh(movies_win);
 
-        ch = wgetch(movies_win);
+/**
+ * @brief List widget callback: fetches a page of movies in the current order.
+ */
 
-        switch (ch) 
+static int movie_list_fetch(void *context, int start, void **rows, int max)
+{
+    MovieListState *state = (MovieListState*)context;
+    if (state->filter.length > 0)
+    {
+        int n = 0;
+        for (int i = start; i < state->match_count && n < max; ++i)
         {
-            case KEY_UP:
-                if (current_highlight > 0) 
-                {
-                    current_highlight--;
-                } 
-                else if (current_start > 0) 
-                {
-                    current_start--;
-                }
-                break;
-            case KEY_DOWN:
-                if (current_highlight < display_count - 1 && (current_highlight + current_start) < count - 1) 
-                {
-                    current_highlight++;
-                } 
-                else if ((current_start + display_count) < count) 
-                {
-                    current_start++;
-                }
-                break;
-            case 'r':
-                if (count > 0 && (current_highlight + current_start) < count) 
-                { // Added boundary check
-                    rate_movie(movies[current_highlight + current_start]);
-                }
-                break;
-            case 'd':
-                if (count > 0 && current_highlight < count) 
-                {
-                    handle_deletion(&movies, &count, current_highlight + current_start);
-                    if (current_highlight >= count) 
-                    {
-                        current_highlight = count - 1;
-                    }
-                    if (current_highlight < current_start) 
-                    {
-                        current_start = current_highlight;
-                    }
-                    if (count == 0) 
-                    {
-                        current_highlight = 0;
-                        current_start = 0;
-                    }
-                } 
-                else 
-                {
-                    show_popup("WARNING", "No movies to delete.");
-                }
-                break;
-            case 'q':
-                delwin(movies_win);
-                endwin();
-                return;
+            rows[n++] = state->matches[i];
         }
+        return n;
     }
+    return fetch_movie_page(state->catalog, state->order, start, (Movie**)rows, max);
 }
 
 
 /**
- * @fn void ui_print_error(const char* format, ...)
- * @brief Displays an error message on the screen using ncurses.
- * 
- * This function initializes the ncurses library if not already initialized, prints an error message
- * formatted similarly to printf, and then waits for any key press before closing the ncurses window.
- * 
- * @param format A format string as in printf that contains the error message to be displayed.
- * @param ... Variable arguments providing additional information (if necessary) to be included in the format string.
- * 
- * @pre The ncurses library must not be initialized before calling this function, as it calls initscr().
- * @post After the key press, ncurses is ended and the program will return to its normal console mode.
- * 
- * @note This function is blocking as it waits for a key press before it returns.
- * 
- * @warning The function assumes that the format and the arguments passed to it are valid and that the format contains no more than the expected number of placeholders.
+ * @brief List widget callback: formats one movie row.
  */
 
-void ui_print_error(const char* format, ...) 
+static void movie_list_format(void *context, const void *record, int position, char *buffer, size_t size)
 {
-    va_list args;
-    initscr();
-    va_start(args, format);
-    vw_printw(stdscr, format, args);
-    va_end(args);
-    getch();
-    endwin();
+    const MovieListState *state = (const MovieListState*)context;
+    const Movie *movie = (const Movie*)record;
+    float rating = profile_active(state->profile) ? profile_rating(state->profile, movie) : movie->rating;
+    bool marked = movie->id < state->mark_capacity && state->marks[movie->id];
+    snprintf(buffer, size, "%4d%c|%-15.15s |%-15.15s |%4d - %.1f/5",
+             position + 1, marked ? '*' : ' ', movie->title, movie->director, movie->year, rating);
 }
 
 
 /**
- * @file ui.c
- * @brief UI functions for the movie management system using ncurses library.
+ * @brief Marks or unmarks one movie for a bulk edit.
+ *
+ * @return false if the flags could not grow to the movie's slot.
  */
 
+static bool set_movie_mark(MovieListState *state, const Movie *movie, bool marked)
+{
+    if (movie->id >= state->mark_capacity)
+    {
+        if (!marked) return true;
+        int capacity = state->catalog->movies.slot_count;
+        unsigned char *marks = (unsigned char*)realloc(state->marks, (size_t)capacity);
+        if (!marks) return false;
+        memset(marks + state->mark_capacity, 0, (size_t)(capacity - state->mark_capacity));
+        state->marks = marks;
+        state->mark_capacity = capacity;
+    }
+    if (state->marks[movie->id] != marked) state->mark_count += marked ? 1 : -1;
+    state->marks[movie->id] = marked;
+    return true;
+}
+
+
 /**
- * @fn void edit_movie_ui(Movie** movies, int count)
- * @brief Provides an interactive user interface to navigate through the list of movies and edit a selected one.
- * 
- * This function creates a new window where all the movies from the list are displayed. The user
- * can navigate through the list using the up and down arrow keys. Upon selecting a movie by pressing the
- * Enter key, the movie can be edited (functionality to be implemented).
- * 
- * @param movies A pointer to an array of pointers to Movie structures.
- * @param count The number of movies in the array.
- * 
- * @pre The ncurses library must be initialized using initscr() before calling this function.
- * @post If a movie is selected and the Enter key is pressed, the movie should be editable (not implemented in the provided code).
- * 
- * @note The function assumes the ncurses library is already initialized and will end the window session upon 'q' key press or after editing.
- * @note The function handles keyboard input within the ncurses window and uses the defined COLOR_PAIR(1) for display.
- * @note The current code does not handle the actual editing of the movie, it should be implemented where indicated.
- * @note Pressing 'q' will quit the edit menu and return to the previous screen.
- * 
- * @warning This function will not check for the validity of the pointers passed, it assumes they are valid and not NULL.
+ * @brief Marks every row of the list: the filter's matches, or the whole catalog.
  */
 
-void edit_movie_ui(Movie** movies, int count) 
+static bool mark_all_movies(MovieListState *state)
 {
-    int ch;
-    int current_highlight = 0;
-    WINDOW *movie_win;
+    if (state->filter.length > 0)
+    {
+        for (int i = 0; i < state->match_count; ++i)
+        {
+            if (!set_movie_mark(state, state->matches[i], true)) return false;
+        }
+        return true;
+    }
+    for (int id = 0; id < state->catalog->movies.slot_count; ++id)
+    {
+        const Movie *movie = catalog_get(state->catalog, id);
+        if (movie && !set_movie_mark(state, movie, true)) return false;
+    }
+    return true;
+}
 
-    // Initialization routines for ncurses
-    initscr();
-    clear();
-    noecho();
-    cbreak();  
-    start_color();  
-    keypad(stdscr, TRUE);  // We get F1, F2, etc...
-    init_pair(1, COLOR_CYAN, COLOR_BLACK);
 
-    // Create a new window for the movie list
-    movie_win = newwin(10, 50, 0, 0);  
-    keypad(movie_win, TRUE);  // Enable keyboard input for the window
+/**
+ * @brief Unmarks every movie.
+ */
 
-    while (1) 
+static void clear_movie_marks(MovieListState *state)
+{
+    if (state->marks) memset(state->marks, 0, (size_t)state->mark_capacity);
+    state->mark_count = 0;
+}
+
+
+/**
+ * @brief Unmarks the slots whose movie is gone, so the next movie added there starts unmarked.
+ */
+
+static void unmark_removed_movies(MovieListState *state)
+{
+    for (int id = 0; id < state->mark_capacity && state->mark_count > 0; ++id)
     {
-        for (int i = 0; i < count; i++) 
+        if (state->marks[id] && !catalog_get(state->catalog, id))
         {
-            if (i == current_highlight) wattron(movie_win, A_REVERSE);  // Highlight the selected movie
-            mvwprintw(movie_win, i + 1, 1, "%s - %s (%d)", movies[i]->title, movies[i]->director, movies[i]->year);
-            if (i == current_highlight) wattroff(movie_win, A_REVERSE);
+            state->marks[id] = 0;
+            state->mark_count--;
         }
+    }
+}
 
-        // Update the window
-        wrefresh(movie_win);  
-        ch = wgetch(movie_win);  
-        switch (ch) 
-        {
-            case KEY_UP:
-                if (current_highlight > 0) 
-                {
-                    current_highlight--;
-                }
-                break;
-            case KEY_DOWN:
-                if (current_highlight < count - 1) 
-                {
-                    current_highlight++;
-                }
-                break;
-            case 10:  // Enter key pressed
-                werase(movie_win);  // Clear the window
-                wrefresh(movie_win);  // Update the window
-                // Insert code to call your update function here
-                // update_movie(movies[current_highlight]);
-                // Collect new details from user input and update the movie details
-                break;
-            case 'q':  // 'q' pressed, quit the loop
-                endwin();
-                return;
+
+/**
+ * @brief Collects the marked movies in catalog order, or the highlighted one if none is marked.
+ *
+ * @return Number of movies in `*movies`, which the caller frees, or -1 for lack of memory.
+ */
+
+static int collect_marked_movies(MovieListState *state, Movie *highlighted, Movie ***movies)
+{
+    int count = state->mark_count > 0 ? state->mark_count : 1;
+    *movies = (Movie**)malloc((size_t)count * sizeof(Movie*));
+    if (!*movies) return -1;
+    if (state->mark_count == 0)
+    {
+        (*movies)[0] = highlighted;
+        return 1;
+    }
+
+    count = 0;
+    for (int id = 0; id < state->mark_capacity && count < state->mark_count; ++id)
+    {
+        Movie *movie = state->marks[id] ? catalog_get(state->catalog, id) : NULL;
+        if (movie) (*movies)[count++] = movie;
+    }
+    return count;
+}
+
+
+/**
+ * @brief Shows the sort order at the top right, with the number of marked movies if any.
+ */
+
+static void show_list_tag(ListWidget *list, const MovieListState *state)
+{
+    char tag[24];
+    if (state->mark_count > 0)
+    {
+        snprintf(tag, sizeof(tag), "%s, %d marked", movie_list_orders[state->order].label, state->mark_count);
+    }
+    else
+    {
+        snprintf(tag, sizeof(tag), "by %s", movie_list_orders[state->order].label);
+    }
+    list_widget_set_tag(list, tag);
+}
+
+
+#define MOVIE_LIST_FOOTER "Space:Mark,'r':Rate,'d':Del,'s':Sort,'/':Find,'m':For you,'z':Undo,'y':Redo,'q':Quit."
+#define MOVIE_MARK_FOOTER "Space:Mark,'a':Mark all,'u':Unmark all,'e':Edit marked,'/':Filter,'q':Quit."
+
+
+/**
+ * @brief Shows the filter query and its match count on the bottom border, or the key help.
+ *
+ * @param list The list widget.
+ * @param state The list state.
+ * @param typing Whether keys are currently going into the query.
+ * @param footer Buffer that holds the text while it is shown.
+ * @param size Size of `footer`.
+ */
+
+static void show_filter_footer(ListWidget *list, const MovieListState *state, bool typing, char *footer, size_t size)
+{
+    if (!typing && state->filter.length == 0)
+    {
+        list_widget_set_footer(list, state->mark_count > 0 ? MOVIE_MARK_FOOTER : MOVIE_LIST_FOOTER);
+        return;
+    }
+    snprintf(footer, size, typing ? "Filter: %s_ (%d found) Enter:Done,Esc:Clear"
+                                  : "Filter: %s (%d found) '/':Edit,Esc:Clear,'q':Quit",
+             state->filter.query, movie_list_total(state));
+    list_widget_set_footer(list, footer);
+}
+
+
+/**
+ * @brief Puts the current filter results on screen after the query, the order or the movies changed.
+ *
+ * @param list The list widget.
+ * @param state The list state.
+ * @param to_top Whether to move the highlight to the first row.
+ */
+
+static void show_filter_results(ListWidget *list, MovieListState *state, bool to_top)
+{
+    if (!refresh_matches(state))
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to filter the list.");
+        movie_filter_clear(&state->filter);
+        state->match_count = 0;
+    }
+    list_widget_set_total(list, movie_list_total(state));
+    if (to_top) list_widget_select(list, 0);
+    list_widget_invalidate(list);
+}
+
+
+/**
+ * @brief Deletes the list window and releases the filter.
+ */
+
+static void close_movie_list(ListWidget *list, MovieListState *state)
+{
+    list_widget_destroy(list);
+    movie_filter_destroy(&state->filter);
+    free(state->matches);
+    free(state->marks);
+}
+
+
+#define RECOMMEND_SCREEN_SIZE 50 // Recommendations listed at most
+
+// The rows of the recommendations screen, computed once when it opens
+typedef struct
+{
+    Movie *movies[RECOMMEND_SCREEN_SIZE];
+    float scores[RECOMMEND_SCREEN_SIZE];
+    int count;
+} RecommendListState;
+
+
+/**
+ * @brief List widget callback: the rows are the recommended movies, best first.
+ */
+
+static int recommend_list_fetch(void *context, int start, void **rows, int max)
+{
+    RecommendListState *state = (RecommendListState*)context;
+    int count = 0;
+    for (int position = start; position < state->count && count < max; ++position)
+    {
+        rows[count++] = state->movies[position];
+    }
+    return count;
+}
+
+
+/**
+ * @brief List widget callback: formats one recommendation with its score.
+ */
+
+static void recommend_list_format(void *context, const void *record, int position, char *buffer, size_t size)
+{
+    const RecommendListState *state = (const RecommendListState*)context;
+    const Movie *movie = (const Movie*)record;
+    snprintf(buffer, size, "%4d |%-15.15s |%-15.15s |%4d - %5.2f",
+             position + 1, movie->title, movie->director, movie->year, state->scores[position]);
+}
+
+
+/**
+ * @brief Lists the movies the user has not rated that are most like the ones they rated well.
+ *
+ * The list comes from the catalog's recommendation index (recommend.c), built on
+ * first use and kept current as ratings change, so opening the screen costs a
+ * walk over the neighbours of the user's rated movies.
+ *
+ * @param catalog The catalog, with its index attached.
+ * @param profile The active user, or NULL or an inactive profile for the catalog's ratings.
+ */
+
+static void display_recommendations_ui(MovieCatalog *catalog, const Profile *profile)
+{
+    RecommendListState state;
+    ListWidget list;
+
+    if (!catalog->recommend)
+    {
+        notify(NOTIFY_WARNING, "Recommendations are not available.");
+        return;
+    }
+    if (!recommend_ready(catalog->recommend))
+    {
+        notify(NOTIFY_INFO, "Finding recommendations...");
+        notify_update(); // Shown now, the build takes a moment on a large catalog
+    }
+    state.count = recommend_movies(catalog->recommend, catalog, profile, state.movies, state.scores, RECOMMEND_SCREEN_SIZE);
+    if (state.count < 0)
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to find recommendations.");
+        return;
+    }
+    if (state.count == 0)
+    {
+        notify(NOTIFY_INFO, "Rate a few more movies to get recommendations.");
+        return;
+    }
+
+    if (!list_widget_create(&list, "RECOMMENDED", " No  | Title           | Director     | Year - Score |",
+                            "Arrows/Pg:Move,'q':Back.", recommend_list_fetch, recommend_list_format, &state))
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to show the list.");
+        return;
+    }
+    list_widget_set_total(&list, state.count);
+    if (profile_active(profile)) list_widget_set_tag(&list, profile->name);
+
+    while (1)
+    {
+        list_widget_render(&list);
+
+        InputEvent event;
+        if (!input_read(list.win, -1, &event)) continue;
+
+        switch (event.key)
+        {
+            case KEY_UP:
+                list_widget_move(&list, -event.count);
+                break;
+            case KEY_DOWN:
+                list_widget_move(&list, event.count);
+                break;
+            case KEY_PPAGE:
+                list_widget_move(&list, -list.page_size * event.count);
+                break;
+            case KEY_NPAGE:
+                list_widget_move(&list, list.page_size * event.count);
+                break;
+            case KEY_HOME:
+                list_widget_select(&list, 0);
+                break;
+            case KEY_END:
+                list_widget_select(&list, list.total - 1);
+                break;
+            case KEY_RESIZE:
+                if (!list_widget_resize(&list))
+                {
+                    list_widget_destroy(&list);
+                    return;
+                }
+                break;
+            case 'q':
+                list_widget_destroy(&list);
+                erase();
+                refresh();
+                return;
+        }
+    }
+}
+
+
+#define PERF_OVERLAY_WIDTH 62
+#define PERF_OVERLAY_REFRESH_MS 500 // How often an open overlay redraws while no key is pressed
+
+#if PERF_ENABLED
+
+/**
+ * @brief Writes a duration with a unit that keeps it to a few digits.
+ */
+
+static void format_duration(uint64_t ns, char *buffer, size_t size)
+{
+    if (ns < 1000) snprintf(buffer, size, "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000) snprintf(buffer, size, "%.1fus", (double)ns / 1e3);
+    else if (ns < 1000000000) snprintf(buffer, size, "%.1fms", (double)ns / 1e6);
+    else snprintf(buffer, size, "%.1fs", (double)ns / 1e9);
+}
+
+
+/**
+ * @brief Fills the perf overlay with the current totals of every event.
+ */
+
+static void draw_perf_overlay(WINDOW *win)
+{
+    werase(win);
+    box(win, 0, 0);
+    mvwprintw(win, 0, 2, " PERF ('p' to close) ");
+    mvwprintw(win, 1, 1, "%-7s %8s %8s %8s %8s %8s %7s", "event", "count", "mean", "p50", "p99", "max", "alloc/op");
+    for (int event = 0; event < PERF_EVENT_COUNT; ++event)
+    {
+        PerfStats stats;
+        char mean[16], p50[16], p99[16], max[16];
+        perf_snapshot((PerfEvent)event, &stats);
+        format_duration(stats.count ? stats.total_ns / stats.count : 0, mean, sizeof(mean));
+        format_duration(perf_percentile(&stats, 0.5), p50, sizeof(p50));
+        format_duration(perf_percentile(&stats, 0.99), p99, sizeof(p99));
+        format_duration(stats.max_ns, max, sizeof(max));
+        mvwprintw(win, 2 + event, 1, "%-7s %8llu %8s %8s %8s %8s %7.1f", perf_event_name((PerfEvent)event),
+                  (unsigned long long)stats.count, mean, p50, p99, max,
+                  stats.count ? (double)stats.allocations / (double)stats.count : 0.0);
+    }
+    touchwin(win); // The list may have drawn over it since the last frame
+    wnoutrefresh(win);
+    doupdate();
+}
+
+
+/**
+ * @brief Opens the perf overlay in the bottom right corner, or closes it.
+ *
+ * @return The overlay window, or NULL once it is closed or if the terminal is too small.
+ */
+
+static WINDOW* toggle_perf_overlay(WINDOW *overlay)
+{
+    if (overlay)
+    {
+        delwin(overlay);
+        return NULL;
+    }
+    int height = PERF_EVENT_COUNT + 3;
+    if (LINES - 1 < height || COLS < PERF_OVERLAY_WIDTH)
+    {
+        notify(NOTIFY_WARNING, "The terminal is too small for the perf overlay.");
+        return NULL;
+    }
+    return newwin(height, PERF_OVERLAY_WIDTH, LINES - 1 - height, COLS - PERF_OVERLAY_WIDTH);
+}
+
+#else
+
+static void draw_perf_overlay(WINDOW *win)
+{
+    (void)win;
+}
+
+
+static WINDOW* toggle_perf_overlay(WINDOW *overlay)
+{
+    (void)overlay;
+    notify(NOTIFY_INFO, "Perf counters are not built in; configure with -DENABLE_PERF=ON.");
+    return NULL;
+}
+
+#endif
+
+
+/**
+ * @fn void display_movie_list_ui(MovieCatalog *catalog)
+ * @brief Displays the movie list in a scrolling window using ncurses.
+ * 
+ * Shows the movies in a list widget (see list_widget.c) that fills the terminal
+ * height and allows the user to scroll through the list with the arrow and page
+ * keys. Only the page on screen is fetched and only rows that changed are
+ * repainted, so moving the highlight redraws two lines. Additional functionalities
+ * such as rating a movie or deleting a movie can be invoked with key presses. The
+ * UI loop continues until 'q' is pressed to quit.
+ *
+ * '/' starts a type-ahead filter: every key typed narrows the list to the movies
+ * whose title or director contains the query (ignoring case), and Backspace widens
+ * it again. Enter keeps the filter and gives the keys back to the list, Esc clears
+ * it. Each keystroke only re-checks the previous matches or the catalog's trigram
+ * candidates (see movie_filter.c), never the whole catalog once the query has a
+ * few characters.
+ *
+ * 'p' toggles an overlay with the perf counters (see perf.h) in builds configured
+ * with -DENABLE_PERF=ON; each render of the list is timed as a frame.
+ *
+ * 'm' opens the movies recommended for the active user, or from the catalog's
+ * ratings without one (see `display_recommendations_ui()`).
+ *
+ * Space marks or unmarks the highlighted movie, 'a' marks every row (all the
+ * matches while a filter is set) and 'u' unmarks everything; marked rows show a
+ * '*'. 'e' edits the marked movies, or the highlighted one if none is marked,
+ * in one go (see `edit_movie_ui()`), e.g. to rate them all or to correct the
+ * spelling of a director across every movie the filter found.
+ *
+ * 'z' undoes the last change made to the catalog in this session, whether a
+ * rating, a deletion or a bulk edit, and 'y' redoes it (see history.h). Changes
+ * made from the main menu, such as adding a movie, are undone from here too.
+ *
+ * Keys come from `input_read()` (input.c), which folds a run of queued arrow or
+ * page presses into one event, so the list moves and redraws once per batch of
+ * input instead of once per key.
+ * 
+ * While a user profile is active (see profile.c), the rating column shows that
+ * user's ratings and 'r' changes theirs instead of the catalog's. The rating
+ * order is skipped then, as the catalog's maintained view sorts by its own ratings.
+ *
+ * @param catalog The catalog whose movies are listed. Deletions made from the list
+ *                are applied to it directly.
+ * @param profile The active user, or NULL or an inactive profile for the catalog's ratings.
+ * 
+ * @pre The ncurses library must have been started with `init_ui()`.
+ * @post Upon exit (when 'q' is pressed), the list window is deleted; ncurses stays active.
+ * 
+ * @note The function is designed to handle KEY_UP/KEY_DOWN, KEY_PPAGE/KEY_NPAGE and
+ *       KEY_HOME/KEY_END for navigation, 'r' for rating a movie, 'd' for deleting a
+ *       movie, 's' to cycle the sort order (catalog, title, year, rating, director),
+ *       '/' to filter, Space, 'a' and 'u' to mark, 'e' to edit, 'm' for recommendations, 'z' and 'y' to undo and redo and 'q' to quit the window. KEY_RESIZE re-lays the list out for
+ *       the new size. Sorted orders are read a page at a time from the catalog's
+ *       maintained views (see `catalog_view()`), so switching order or rating a movie
+ *       never re-sorts the catalog; a filtered list sorts only its matches.
+ *       If 'r' or 'd' is pressed, the function calls `rate_movie()` or `handle_deletion()`,
+ *       and for 'z' or 'y' `history_undo()` or `history_redo()`.
+ *       The list can be navigated only if there are movies to display.
+ */
+
+void display_movie_list_ui(MovieCatalog *catalog, Profile *profile) 
+{
+    if (catalog == NULL || catalog->movies.records == NULL) return; // Check for NULL pointer
+
+    MovieListState state = { .catalog = catalog, .profile = profile };
+    ListWidget list;
+    char title[PROFILE_NAME_SIZE + 16] = "MOVIE LIST";
+    bool typing = false; // Keys go into the filter query
+    char footer[MOVIE_FILTER_MAX_QUERY + 64]; // The query and the filter's keys
+    WINDOW *perf_overlay = NULL;
+    int ch;
+
+    movie_filter_init(&state.filter);
+    if (profile_active(profile)) snprintf(title, sizeof(title), "MOVIE LIST (%s)", profile->name);
+    if (!list_widget_create(&list, title, " No  | Title           | Director     | Year - Rating |",
+                            MOVIE_LIST_FOOTER, movie_list_fetch, movie_list_format, &state))
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to show the list.");
+        return;
+    }
+    list_widget_set_total(&list, catalog->movies.count);
+    list_widget_set_tag(&list, "by catalog");
+
+    while (1) 
+    {
+        PERF_BEGIN(frame);
+        bool rendered = list_widget_render(&list);
+        PERF_END(frame, PERF_FRAME);
+        if (!rendered)
+        {
+            notify(NOTIFY_ERROR, "Not enough memory to sort the list.");
+            state.order = 0;
+            list_widget_set_tag(&list, "by catalog");
+            show_filter_results(&list, &state, false);
+            continue;
+        }
+
+        if (perf_overlay) draw_perf_overlay(perf_overlay);
+        InputEvent event;
+        if (!input_read(list.win, perf_overlay ? PERF_OVERLAY_REFRESH_MS : -1, &event)) continue;
+        ch = event.key;
+
+        if (typing)
+        {
+            MovieError err = MOVIE_SUCCESS;
+            bool handled = true;
+
+            if (ch == '\n' || ch == KEY_ENTER)
+            {
+                typing = false;
+            }
+            else if (ch == 27) // Esc
+            {
+                typing = false;
+                movie_filter_clear(&state.filter);
+            }
+            else if (ch == KEY_BACKSPACE || ch == 127 || ch == '\b')
+            {
+                err = movie_filter_pop(&state.filter, catalog);
+            }
+            else if (ch >= 0 && ch < 256 && isprint(ch))
+            {
+                err = movie_filter_push(&state.filter, catalog, (char)ch);
+            }
+            else
+            {
+                handled = false; // Navigation keys still move the highlight
+            }
+
+            if (handled)
+            {
+                if (err != MOVIE_SUCCESS)
+                {
+                    notify(NOTIFY_ERROR, "Not enough memory to filter the list.");
+                }
+                show_filter_results(&list, &state, true);
+                show_filter_footer(&list, &state, typing, footer, sizeof(footer));
+                continue;
+            }
+        }
+
+        switch (ch) 
+        {
+            case KEY_UP:
+                list_widget_move(&list, -event.count);
+                break;
+            case KEY_DOWN:
+                list_widget_move(&list, event.count);
+                break;
+            case KEY_PPAGE:
+                list_widget_move(&list, -list.page_size * event.count);
+                break;
+            case KEY_NPAGE:
+                list_widget_move(&list, list.page_size * event.count);
+                break;
+            case KEY_HOME:
+                list_widget_select(&list, 0);
+                break;
+            case KEY_END:
+                list_widget_select(&list, list.total - 1);
+                break;
+            case KEY_RESIZE:
+                if (perf_overlay) perf_overlay = toggle_perf_overlay(toggle_perf_overlay(perf_overlay)); // Move it to the new corner
+                if (!list_widget_resize(&list))
+                {
+                    if (perf_overlay) delwin(perf_overlay);
+                    close_movie_list(&list, &state);
+                    return;
+                }
+                break;
+            case 'p':
+                perf_overlay = toggle_perf_overlay(perf_overlay);
+                list_widget_touch(&list);
+                break;
+            case '/':
+                typing = true;
+                show_filter_footer(&list, &state, typing, footer, sizeof(footer));
+                break;
+            case 27: // Esc
+                if (state.filter.length > 0)
+                {
+                    movie_filter_clear(&state.filter);
+                    show_filter_results(&list, &state, true);
+                    show_filter_footer(&list, &state, typing, footer, sizeof(footer));
+                }
+                break;
+            case 'r':
+            {
+                Movie *rated = (Movie*)list_widget_selected(&list);
+                if (rated && profile_active(profile))
+                {
+                    float rating = (float)read_movie_rating(rated);
+                    if (profile_rate(profile, rated, rating) != PROFILE_SUCCESS)
+                    {
+                        notify(NOTIFY_ERROR, "Not enough memory to store the rating.");
+                    }
+                    else
+                    {
+                        recommend_rating_changed(catalog->recommend, profile, rated, rating);
+                    }
+                    erase();
+                    wnoutrefresh(stdscr);
+                    list_widget_invalidate(&list);
+                    list_widget_touch(&list);
+                }
+                else if (rated) 
+                {
+                    rate_movie(catalog, rated);
+                    erase(); // Drop the prompt rate_movie left on stdscr
+                    wnoutrefresh(stdscr);
+                    if (state.filter.length > 0)
+                    {
+                        show_filter_results(&list, &state, false); // Re-sort the matches
+                    }
+
+                    // Keep the rated movie highlighted where the ordering moved it
+                    int position = movie_list_position(&state, rated);
+                    if (position >= 0) list_widget_select(&list, position);
+                    list_widget_invalidate(&list);
+                    list_widget_touch(&list);
+                }
+                break;
+            }
+            case 'd':
+            {
+                Movie *selected = (Movie*)list_widget_selected(&list);
+                if (selected) 
+                {
+                    int id = selected->id;
+                    handle_deletion(catalog, id);
+                    if (!catalog_get(catalog, id) && id < state.mark_capacity && state.marks[id])
+                    {
+                        state.marks[id] = 0; // The slot goes to the next movie added
+                        state.mark_count--;
+                        show_list_tag(&list, &state);
+                    }
+                    if (state.filter.length > 0)
+                    {
+                        if (movie_filter_refresh(&state.filter, catalog) != MOVIE_SUCCESS)
+                        {
+                            movie_filter_clear(&state.filter);
+                        }
+                        show_filter_results(&list, &state, false);
+                        show_filter_footer(&list, &state, typing, footer, sizeof(footer));
+                    }
+                    else
+                    {
+                        list_widget_set_total(&list, catalog->movies.count);
+                    }
+                } 
+                else 
+                {
+                    notify(NOTIFY_WARNING, "No movies to delete.");
+                }
+                list_widget_touch(&list);
+                break;
+            }
+            case 's':
+            {
+                state.order = (state.order + 1) % MOVIE_LIST_ORDER_COUNT;
+                if (profile_active(profile) && movie_list_orders[state.order].view == MOVIE_VIEW_RATING)
+                {
+                    state.order = (state.order + 1) % MOVIE_LIST_ORDER_COUNT; // That view follows the catalog's ratings
+                }
+                show_list_tag(&list, &state);
+                if (state.filter.length > 0)
+                {
+                    show_filter_results(&list, &state, true);
+                }
+                list_widget_select(&list, 0);
+                list_widget_invalidate(&list);
+                break;
+            }
+            case ' ':
+            case 'a':
+            case 'u':
+            {
+                Movie *selected = (Movie*)list_widget_selected(&list);
+                bool ok = true;
+                if (ch == 'u') clear_movie_marks(&state);
+                else if (ch == 'a') ok = mark_all_movies(&state);
+                else if (selected) ok = set_movie_mark(&state, selected, !(selected->id < state.mark_capacity && state.marks[selected->id]));
+                if (!ok) notify(NOTIFY_ERROR, "Not enough memory to mark the movies.");
+                if (ch == ' ') list_widget_move(&list, 1);
+                show_list_tag(&list, &state);
+                show_filter_footer(&list, &state, typing, footer, sizeof(footer));
+                list_widget_invalidate(&list);
+                break;
+            }
+            case 'e':
+            {
+                Movie *selected = (Movie*)list_widget_selected(&list);
+                Movie **movies;
+                int count = selected || state.mark_count > 0 ? collect_marked_movies(&state, selected, &movies) : 0;
+                if (count < 0)
+                {
+                    notify(NOTIFY_ERROR, "Not enough memory to edit the movies.");
+                    break;
+                }
+                if (count == 0)
+                {
+                    notify(NOTIFY_WARNING, "No movies to edit.");
+                    break;
+                }
+                if (edit_movie_ui(catalog, profile, movies, count))
+                {
+                    if (state.filter.length > 0)
+                    {
+                        // New directors and titles may match the query or stop matching it
+                        if (movie_filter_refresh(&state.filter, catalog) != MOVIE_SUCCESS)
+                        {
+                            movie_filter_clear(&state.filter);
+                        }
+                        show_filter_results(&list, &state, false);
+                        show_filter_footer(&list, &state, typing, footer, sizeof(footer));
+                    }
+                    int position = movie_list_position(&state, movies[0]);
+                    if (position >= 0) list_widget_select(&list, position);
+                }
+                free(movies);
+                list_widget_invalidate(&list);
+                list_widget_touch(&list);
+                break;
+            }
+            case 'm':
+                display_recommendations_ui(catalog, profile);
+                list_widget_touch(&list);
+                break;
+            case 'z':
+            case 'y':
+            {
+                char label[HISTORY_LABEL_SIZE];
+                bool undo = ch == 'z';
+                HistoryError err = undo ? history_undo(catalog->history, label, sizeof(label))
+                                        : history_redo(catalog->history, label, sizeof(label));
+                if (err == HISTORY_ERROR_EMPTY)
+                {
+                    notify(NOTIFY_WARNING, undo ? "Nothing to undo." : "Nothing to redo.");
+                    break;
+                }
+                if (err != HISTORY_SUCCESS)
+                {
+                    notify(NOTIFY_ERROR, "Not enough memory to %s the change.", undo ? "undo" : "redo");
+                    break;
+                }
+                notify(NOTIFY_INFO, "%s the %s.", undo ? "Undid" : "Redid", label);
+
+                // Any movie may have come back, gone, or changed its title, director or place
+                unmark_removed_movies(&state);
+                show_list_tag(&list, &state);
+                if (state.filter.length > 0)
+                {
+                    if (movie_filter_refresh(&state.filter, catalog) != MOVIE_SUCCESS)
+                    {
+                        movie_filter_clear(&state.filter);
+                    }
+                    show_filter_results(&list, &state, false);
+                }
+                else
+                {
+                    list_widget_set_total(&list, catalog->movies.count);
+                }
+                show_filter_footer(&list, &state, typing, footer, sizeof(footer));
+                list_widget_invalidate(&list);
+                list_widget_touch(&list);
+                break;
+            }
+            case 'q':
+                if (perf_overlay) delwin(perf_overlay);
+                close_movie_list(&list, &state);
+                erase();
+                refresh();
+                return;
+        }
+    }
+}
+
+
+// The records of the page on screen, copied out of a paged snapshot
+typedef struct
+{
+    PagedCatalog *paged;
+    PagedMovie *rows;
+    int capacity;
+} PagedListState;
+
+
+/**
+ * @brief List widget callback: reads the visible page of a paged snapshot.
+ *
+ * Only these records are copied out of the page cache; the buffer grows with
+ * the terminal height and nothing else.
+ */
+
+static int paged_list_fetch(void *context, int start, void **rows, int max)
+{
+    PagedListState *state = (PagedListState*)context;
+    if (max > state->capacity)
+    {
+        PagedMovie *grown = realloc(state->rows, (size_t)max * sizeof(*grown));
+        if (!grown) return -1;
+        state->rows = grown;
+        state->capacity = max;
+    }
+
+    int count = 0;
+    int total = paged_catalog_count(state->paged);
+    for (int index = start; index < total && count < max; ++index)
+    {
+        if (paged_catalog_read(state->paged, index, &state->rows[count]) != PAGED_SUCCESS) return -1;
+        rows[count] = &state->rows[count];
+        count++;
+    }
+    return count;
+}
+
+
+/**
+ * @brief List widget callback: formats one movie of a paged snapshot.
+ */
+
+static void paged_list_format(void *context, const void *record, int position, char *buffer, size_t size)
+{
+    (void)context;
+    const Movie *movie = &((const PagedMovie*)record)->movie;
+    snprintf(buffer, size, "%4d |%-15.15s |%-15.15s |%4d - %.1f/5",
+             position + 1, movie->title, movie->director, movie->year, movie->rating);
+}
+
+
+/**
+ * @brief Asks for the text to look for in a paged snapshot.
+ */
+
+static void read_paged_query(char *query, int size)
+{
+    WINDOW *win = newwin(5, 50, 5, 5);
+    box(win, 0, 0);
+    mvwprintw(win, 1, 2, "Find title or director:");
+    wmove(win, 2, 2);
+    wrefresh(win);
+    echo();
+    wgetnstr(win, query, size - 1);
+    noecho();
+    delwin(win);
+    erase();
+    wnoutrefresh(stdscr);
+}
+
+
+/**
+ * @brief Jumps to the next movie after the highlight that matches the query, wrapping around once.
+ */
+
+static void find_paged_movie(ListWidget *list, PagedCatalog *paged, const char *query)
+{
+    notify(NOTIFY_INFO, "Searching for \"%s\"...", query);
+    notify_update(); // A search may read the whole file
+
+    int found = paged_catalog_find(paged, list->highlight + 1, query);
+    if (found < 0) found = paged_catalog_find(paged, 0, query);
+    if (found < 0)
+    {
+        notify(NOTIFY_WARNING, "No movie matches \"%s\".", query);
+        return;
+    }
+    list_widget_select(list, found);
+}
+
+
+/**
+ * @fn void display_paged_movie_list_ui(PagedCatalog *paged, const char *filename)
+ * @brief Browses a snapshot through its page cache, without loading the catalog.
+ *
+ * The list looks like the regular movie list, but every page is read from the
+ * file on demand (see paged_catalog.c), so memory follows the cache budget and
+ * not the size of the catalog. It is read-only and in file order: the sorted
+ * views, the filter index and the statistics all need the whole catalog in
+ * memory. '/' asks for a title or director to find, 'n' finds the next match,
+ * and the tag shows how much of the budget the cache holds.
+ *
+ * @param paged An open paged snapshot.
+ * @param filename Its name, for the title and messages.
+ */
+
+void display_paged_movie_list_ui(PagedCatalog *paged, const char *filename)
+{
+    PagedListState state = { paged, NULL, 0 };
+    ListWidget list;
+    char query[PAGED_TEXT_SIZE] = "";
+    char tag[24];
+
+    if (!list_widget_create(&list, filename, " No  | Title           | Director     | Year - Rating |",
+                            "Arrows/Pg:Move,'/':Find,'n':Next,'q':Quit. Read-only.",
+                            paged_list_fetch, paged_list_format, &state))
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to show the list.");
+        return;
+    }
+    list_widget_set_total(&list, paged_catalog_count(paged));
+
+    while (1)
+    {
+        // As of the previous frame, which is close enough for a gauge
+        snprintf(tag, sizeof(tag), "cache %.1f/%.0fMB", (double)paged_catalog_resident(paged) / (1 << 20),
+                 (double)paged_catalog_budget(paged) / (1 << 20));
+        list_widget_set_tag(&list, tag);
+
+        PERF_BEGIN(frame);
+        bool rendered = list_widget_render(&list);
+        PERF_END(frame, PERF_FRAME);
+        if (!rendered)
+        {
+            notify(NOTIFY_ERROR, "Could not read %s.", filename);
+            break;
+        }
+
+        InputEvent event;
+        if (!input_read(list.win, -1, &event)) continue;
+
+        switch (event.key)
+        {
+            case KEY_UP:
+                list_widget_move(&list, -event.count);
+                break;
+            case KEY_DOWN:
+                list_widget_move(&list, event.count);
+                break;
+            case KEY_PPAGE:
+                list_widget_move(&list, -list.page_size * event.count);
+                break;
+            case KEY_NPAGE:
+                list_widget_move(&list, list.page_size * event.count);
+                break;
+            case KEY_HOME:
+                list_widget_select(&list, 0);
+                break;
+            case KEY_END:
+                list_widget_select(&list, list.total - 1);
+                break;
+            case KEY_RESIZE:
+                if (!list_widget_resize(&list))
+                {
+                    list_widget_destroy(&list);
+                    free(state.rows);
+                    return;
+                }
+                break;
+            case '/':
+                read_paged_query(query, (int)sizeof(query));
+                list_widget_touch(&list);
+                if (query[0]) find_paged_movie(&list, paged, query);
+                break;
+            case 'n':
+                if (query[0]) find_paged_movie(&list, paged, query);
+                else notify(NOTIFY_INFO, "Press '/' to find a movie first.");
+                break;
+            case 'q':
+                list_widget_destroy(&list);
+                free(state.rows);
+                erase();
+                refresh();
+                return;
+        }
+    }
+    list_widget_destroy(&list);
+    free(state.rows);
+    erase();
+    refresh();
+}
+
+
+/**
+ * @brief Asks for one line of text on a form row until it is not blank.
+ */
+
+static void read_form_text(WINDOW *win, int y, const char *prompt, char *buffer, int size)
+{
+    while (1)
+    {
+        mvwprintw(win, y, 2, "%s", prompt);
+        wclrtoeol(win);
+        box(win, 0, 0);
+        wgetnstr(win, buffer, size - 1);
+        if (buffer[0] != '\0') return;
+        mvwprintw(win, 6, 2, "Error: This field cannot be blank.");
+        wrefresh(win);
+    }
+}
+
+
+/**
+ * @brief Asks for a positive whole number on a form row until one is given.
+ */
+
+static int read_form_count(WINDOW *win, int y, const char *prompt)
+{
+    char buffer[16];
+    while (1)
+    {
+        mvwprintw(win, y, 2, "%s", prompt);
+        wclrtoeol(win);
+        box(win, 0, 0);
+        wgetnstr(win, buffer, (int)sizeof(buffer) - 1);
+        char *end;
+        long value = strtol(buffer, &end, 10);
+        if (end != buffer && *end == '\0' && value > 0 && value < 100000) return (int)value;
+        mvwprintw(win, 6, 2, "Error: Please enter a number above 0.");
+        wrefresh(win);
+    }
+}
+
+
+/**
+ * @fn void add_tv_series_ui(TvCatalog *catalog)
+ * @brief Asks for the details of a new TV series and adds it to the catalog.
+ *
+ * The form asks for the title, creator, number of seasons and number of
+ * episodes, repeating a question until its answer is valid. The series is
+ * created with `create_tv_series()` and handed to the catalog; the outcome is
+ * reported on the status line.
+ *
+ * @param catalog The catalog receiving the series.
+ */
+
+void add_tv_series_ui(TvCatalog *catalog)
+{
+    char title[100], creator[100];
+
+    WINDOW *win = newwin(10, 50, 5, 5);
+    box(win, 0, 0);
+    wrefresh(win);
+    echo();
+    read_form_text(win, 1, "Enter series title: ", title, (int)sizeof(title));
+    read_form_text(win, 2, "Enter series creator: ", creator, (int)sizeof(creator));
+    int seasons = read_form_count(win, 3, "Enter number of seasons: ");
+    int episodes = read_form_count(win, 4, "Enter number of episodes: ");
+    noecho();
+    delwin(win);
+    erase();
+    refresh();
+
+    TV_Series *series = create_tv_series(title, creator, seasons, episodes);
+    if (!series || tv_catalog_add(catalog, series) != TV_SERIES_SUCCESS)
+    {
+        delete_tv_series(series);
+        notify(NOTIFY_ERROR, "Failed to create a new TV series entry.");
+        return;
+    }
+    notify(NOTIFY_INFO, "Added \"%s\".", series->title);
+}
+
+
+/**
+ * @fn void read_user_name_ui(const char *current, char *name, int size)
+ * @brief Asks whose ratings to use from now on.
+ *
+ * @param current The active user, or an empty string when none is.
+ * @param name Receives the name typed; empty to go back to the catalog's ratings.
+ * @param size Size of `name`.
+ */
+
+void read_user_name_ui(const char *current, char *name, int size)
+{
+    WINDOW *win = newwin(7, 50, 5, 5);
+    box(win, 0, 0);
+    mvwprintw(win, 1, 2, "Current user: %s", current[0] ? current : "(shared ratings)");
+    mvwprintw(win, 4, 2, "Leave blank to use the shared ratings.");
+    mvwprintw(win, 2, 2, "User name: ");
+    wrefresh(win);
+    echo();
+    wgetnstr(win, name, size - 1);
+    noecho();
+    delwin(win);
+    erase();
+    refresh();
+}
+
+
+// What the episode list callbacks need, and the footer text they keep current
+typedef struct
+{
+    TV_Series *series;
+    char footer[96];
+} EpisodeListState;
+
+
+/**
+ * @brief Season (1-based) of the episode at list position `position`.
+ */
+
+static int episode_season(const TV_Series *series, int position)
+{
+    int low = 0, high = series->seasons - 1;
+    while (low < high) // Last season starting at or before the position, which skips empty ones
+    {
+        int middle = (low + high + 1) / 2;
+        if (series->season_starts[middle] <= (uint32_t)position) low = middle;
+        else high = middle - 1;
+    }
+    return low + 1;
+}
+
+
+/**
+ * @brief List widget callback: the rows of the episode list are the rating bytes themselves.
+ */
+
+static int episode_list_fetch(void *context, int start, void **rows, int max)
+{
+    EpisodeListState *state = (EpisodeListState*)context;
+    int count = 0;
+    for (int position = start; position < state->series->episodes && count < max; ++position)
+    {
+        rows[count++] = &state->series->episode_ratings[position];
+    }
+    return count;
+}
+
+
+/**
+ * @brief List widget callback: formats one episode row.
+ */
+
+static void episode_list_format(void *context, const void *record, int position, char *buffer, size_t size)
+{
+    EpisodeListState *state = (EpisodeListState*)context;
+    uint8_t rating = *(const uint8_t*)record;
+    int season = episode_season(state->series, position);
+    int episode = position - (int)state->series->season_starts[season - 1] + 1;
+
+    if (rating) snprintf(buffer, size, " S%02d E%03d |  %d.%d  |", season, episode, rating / TV_RATING_SCALE, rating % TV_RATING_SCALE);
+    else snprintf(buffer, size, " S%02d E%03d |   -   |", season, episode);
+}
+
+
+/**
+ * @brief Shows the cached totals of the highlighted episode's season in the footer.
+ */
+
+static void update_episode_footer(ListWidget *list, EpisodeListState *state)
+{
+    char tag[24];
+    int season = episode_season(state->series, list->highlight);
+    TV_RatingTotals totals = tv_season_totals(state->series, season);
+
+    snprintf(state->footer, sizeof(state->footer), "Season %d: %.2f, %u/%d rated. 1-5:Rate,'0':Clear,'q':Back.",
+             season, tv_season_average(state->series, season), totals.rated, tv_season_episodes(state->series, season));
+    list_widget_set_footer(list, state->footer);
+    snprintf(tag, sizeof(tag), "mean %.2f", state->series->rating);
+    list_widget_set_tag(list, tag);
+}
+
+
+/**
+ * @brief Lists the episodes of a series and rates them.
+ *
+ * A digit from 1 to 5 rates the highlighted episode and moves on to the next,
+ * so a season is rated in one sweep; '0' clears the rating. The footer shows the
+ * season average and the tag the series average, both read from the totals
+ * `rate_tv_episode()` keeps.
+ */
+
+static void display_episode_ratings_ui(TV_Series *series)
+{
+    EpisodeListState state = { series, "" };
+    ListWidget list;
+
+    if (!list_widget_create(&list, series->title, " Episode  | Rating |", "",
+                            episode_list_fetch, episode_list_format, &state))
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to show the list.");
+        return;
+    }
+    list_widget_set_total(&list, series->episodes);
+
+    while (1)
+    {
+        update_episode_footer(&list, &state);
+        list_widget_render(&list);
+
+        InputEvent event;
+        if (!input_read(list.win, -1, &event)) continue;
+        int ch = event.key;
+
+        switch (ch)
+        {
+            case KEY_UP:
+                list_widget_move(&list, -event.count);
+                break;
+            case KEY_DOWN:
+                list_widget_move(&list, event.count);
+                break;
+            case KEY_PPAGE:
+                list_widget_move(&list, -list.page_size * event.count);
+                break;
+            case KEY_NPAGE:
+                list_widget_move(&list, list.page_size * event.count);
+                break;
+            case KEY_HOME:
+                list_widget_select(&list, 0);
+                break;
+            case KEY_END:
+                list_widget_select(&list, list.total - 1);
+                break;
+            case KEY_RESIZE:
+                if (!list_widget_resize(&list))
+                {
+                    list_widget_destroy(&list);
+                    return;
+                }
+                break;
+            case '0': case '1': case '2': case '3': case '4': case '5':
+            {
+                int season = episode_season(series, list.highlight);
+                int episode = list.highlight - (int)series->season_starts[season - 1] + 1;
+                if (rate_tv_episode(series, season, episode, (float)(ch - '0')) == TV_SERIES_SUCCESS)
+                {
+                    list_widget_invalidate(&list);
+                    if (ch != '0') list_widget_move(&list, 1);
+                }
+                break;
+            }
+            case 'q':
+                list_widget_destroy(&list);
+                erase();
+                refresh();
+                return;
+        }
+    }
+}
+
+
+// Orders offered by the TV series list, cycled with 's'
+static const struct
+{
+    const char *label;
+    TvView view;
+} series_list_orders[] =
+{
+    { "catalog", TV_VIEW_ID },
+    { "title", TV_VIEW_TITLE },
+    { "creator", TV_VIEW_CREATOR },
+    { "seasons", TV_VIEW_SEASONS },
+    { "episodes", TV_VIEW_EPISODES },
+    { "rating", TV_VIEW_RATING },
+};
+
+#define SERIES_LIST_ORDER_COUNT ((int)(sizeof(series_list_orders) / sizeof(series_list_orders[0])))
+
+// What the TV series list callbacks need to fetch a page
+typedef struct
+{
+    TvCatalog *catalog;
+    int order;   // Index into series_list_orders
+} SeriesListState;
+
+
+/**
+ * @brief List widget callback: fetches a page of series from the current view.
+ */
+
+static int series_list_fetch(void *context, int start, void **rows, int max)
+{
+    SeriesListState *state = (SeriesListState*)context;
+    return collection_page(&state->catalog->series, (int)series_list_orders[state->order].view, start, rows, max);
+}
+
+
+/**
+ * @brief List widget callback: formats one series row.
+ */
+
+static void series_list_format(void *context, const void *record, int position, char *buffer, size_t size)
+{
+    (void)context;
+    const TV_Series *series = (const TV_Series*)record;
+    char rating[8] = "  -  ";
+    if (series->rating_totals.rated) snprintf(rating, sizeof(rating), "%5.2f", series->rating);
+    snprintf(buffer, size, "%4d |%-15.15s |%-15.15s |%7d |%8d | %s |",
+             position + 1, series->title, series->creator, series->seasons, series->episodes, rating);
+}
+
+
+/**
+ * @fn void display_tv_series_list_ui(TvCatalog *catalog)
+ * @brief Lists the TV series and handles sorting and deletion.
+ *
+ * Works like the movie list: rows are fetched a page at a time from the
+ * catalog's maintained views, 's' cycles through the orderings and 'd' deletes
+ * the highlighted series after confirmation. Enter opens the episode list of
+ * the highlighted series, where its episodes are rated.
+ *
+ * @param catalog The catalog to list.
+ */
+
+void display_tv_series_list_ui(TvCatalog *catalog)
+{
+    SeriesListState state = { catalog, 0 };
+    ListWidget list;
+
+    if (!list_widget_create(&list, "TV SERIES", " No  |Title           |Creator         |Seasons |Episodes |  Rate |",
+                            "Arrows/Pg:Move,Enter:Episodes,'d':Delete,'s':Sort,'q':Quit.", series_list_fetch, series_list_format, &state))
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to show the list.");
+        return;
+    }
+    list_widget_set_total(&list, catalog->series.count);
+    list_widget_set_tag(&list, "by catalog");
+
+    while (1)
+    {
+        if (!list_widget_render(&list))
+        {
+            notify(NOTIFY_ERROR, "Not enough memory to sort the list.");
+            state.order = 0;
+            list_widget_set_tag(&list, "by catalog");
+            list_widget_invalidate(&list);
+            continue;
+        }
+
+        InputEvent event;
+        if (!input_read(list.win, -1, &event)) continue;
+        int ch = event.key;
+
+        switch (ch)
+        {
+            case KEY_UP:
+                list_widget_move(&list, -event.count);
+                break;
+            case KEY_DOWN:
+                list_widget_move(&list, event.count);
+                break;
+            case KEY_PPAGE:
+                list_widget_move(&list, -list.page_size * event.count);
+                break;
+            case KEY_NPAGE:
+                list_widget_move(&list, list.page_size * event.count);
+                break;
+            case KEY_HOME:
+                list_widget_select(&list, 0);
+                break;
+            case KEY_END:
+                list_widget_select(&list, list.total - 1);
+                break;
+            case KEY_RESIZE:
+                if (!list_widget_resize(&list))
+                {
+                    list_widget_destroy(&list);
+                    return;
+                }
+                break;
+            case '\n':
+            case KEY_ENTER:
+            {
+                TV_Series *selected = (TV_Series*)list_widget_selected(&list);
+                if (selected)
+                {
+                    display_episode_ratings_ui(selected);
+                    list_widget_invalidate(&list); // Ratings may have moved it in the rating order
+                    list_widget_touch(&list);
+                }
+                break;
+            }
+            case 'd':
+            {
+                TV_Series *selected = (TV_Series*)list_widget_selected(&list);
+                if (!selected)
+                {
+                    notify(NOTIFY_WARNING, "No TV series to delete.");
+                }
+                else if (confirm_popup("Delete", "Delete \"%s\"? (y/n)", selected->title))
+                {
+                    delete_tv_series(selected);
+                    list_widget_set_total(&list, catalog->series.count);
+                    list_widget_invalidate(&list);
+                    notify(NOTIFY_INFO, "TV series deleted.");
+                }
+                else
+                {
+                    notify(NOTIFY_INFO, "Deletion canceled.");
+                }
+                list_widget_touch(&list);
+                break;
+            }
+            case 's':
+            {
+                char tag[24];
+                state.order = (state.order + 1) % SERIES_LIST_ORDER_COUNT;
+                snprintf(tag, sizeof(tag), "by %s", series_list_orders[state.order].label);
+                list_widget_set_tag(&list, tag);
+                list_widget_select(&list, 0);
+                list_widget_invalidate(&list);
+                break;
+            }
+            case 'q':
+                list_widget_destroy(&list);
+                erase();
+                refresh();
+                return;
+        }
+    }
+}
+
+
+#define STATS_TOP_DIRECTORS 8
+#define STATS_BAR_WIDTH 20
+#define STATS_RIGHT_COLUMN 40
+
+
+/**
+ * @brief Draws a histogram row: label, bar scaled against `max`, and count.
+ */
+
+static void draw_stats_bar(WINDOW *win, int y, int x, const char *label, uint32_t count, uint32_t max)
+{
+    int length = max ? (int)((uint64_t)count * STATS_BAR_WIDTH / max) : 0;
+    if (count && length == 0) length = 1;
+
+    mvwprintw(win, y, x, "%-8s", label);
+    wattron(win, COLOR_PAIR(UI_PAIR_ACCENT));
+    for (int i = 0; i < length; ++i) waddch(win, '#');
+    wattroff(win, COLOR_PAIR(UI_PAIR_ACCENT));
+    mvwprintw(win, y, x + 8 + STATS_BAR_WIDTH + 1, "%u", count);
+}
+
+
+/**
+ * @brief Fills the statistics window from the catalog's running totals.
+ *
+ * Nothing here visits the movies: the histogram folds the per-tenth counters
+ * into whole points, the director list is one pass over the director table and
+ * the decade list one pass over the fixed decade table.
+ */
+
+static void draw_stats(WINDOW *win, const CatalogStats *stats, TV_SeriesTotals tv)
+{
+    int rows = getmaxy(win) - 2;
+    int y;
+
+    werase(win);
+    box(win, 0, 0);
+    mvwprintw(win, 0, 2, " STATISTICS ");
+    mvwprintw(win, rows + 1, 2, " Press any key to return ");
+
+    // Left column: movie totals, rating histogram, TV totals
+    uint32_t buckets[6] = { 0 }; // Unrated, then 1 to 5 points rounded
+    for (int tenths = 0; tenths < STATS_RATING_BINS; ++tenths)
+    {
+        int points = (tenths + MOVIE_RATING_SCALE / 2) / MOVIE_RATING_SCALE;
+        if (tenths != 0 && points < 1) points = 1;
+        if (points > 5) points = 5;
+        buckets[points] += stats->ratings[tenths];
+    }
+    uint32_t max = 0;
+    for (int b = 0; b < 6; ++b)
+    {
+        if (buckets[b] > max) max = buckets[b];
+    }
+
+    y = 2;
+    wattron(win, A_BOLD);
+    mvwprintw(win, y++, 2, "MOVIES");
+    wattroff(win, A_BOLD);
+    mvwprintw(win, y++, 2, "%u movies, %u rated", stats->total.count, stats->total.rated);
+    mvwprintw(win, y++, 2, "Mean rating %.2f", stats_group_average(&stats->total));
+    y++;
+    wattron(win, A_BOLD);
+    mvwprintw(win, y++, 2, "RATINGS");
+    wattroff(win, A_BOLD);
+    for (int b = 5; b >= 1; --b)
+    {
+        char label[16];
+        snprintf(label, sizeof(label), "%d pt%s", b, b > 1 ? "s" : "");
+        draw_stats_bar(win, y++, 2, label, buckets[b], max);
+    }
+    draw_stats_bar(win, y++, 2, "Unrated", buckets[0], max);
+
+    y++;
+    wattron(win, A_BOLD);
+    mvwprintw(win, y++, 2, "TV SERIES");
+    wattroff(win, A_BOLD);
+    mvwprintw(win, y++, 2, "%d series", tv.series);
+    mvwprintw(win, y++, 2, "%ld seasons, %ld episodes", tv.seasons, tv.episodes);
+    mvwprintw(win, y++, 2, "%ld rated, mean %.2f", tv.rated_episodes,
+              tv.rated_episodes ? (double)tv.rating_sum / ((double)tv.rated_episodes * TV_RATING_SCALE) : 0.0);
+
+    // Right column: busiest directors, then the most recent decades that fit
+    int x = STATS_RIGHT_COLUMN;
+    const int name_width = 17; // Lines the numbers up under the headings
+
+    uint32_t codes[STATS_TOP_DIRECTORS];
+    int directors = catalog_stats_top_directors(stats, codes, STATS_TOP_DIRECTORS);
+    y = 2;
+    wattron(win, A_BOLD);
+    mvwprintw(win, y++, x, "TOP DIRECTORS     Movies  Mean");
+    wattroff(win, A_BOLD);
+    for (int i = 0; i < directors && y <= rows; ++i)
+    {
+        const StatsGroup *group = &stats->directors[codes[i]];
+        const char *name = name_from_code(codes[i]);
+        mvwprintw(win, y++, x, "%-*.*s %6u  %4.2f", name_width, name_width, name ? name : "?",
+                  group->count, stats_group_average(group));
+    }
+
+    y++;
+    if (y < rows)
+    {
+        wattron(win, A_BOLD);
+        mvwprintw(win, y++, x, "DECADES           Movies  Mean");
+        wattroff(win, A_BOLD);
+
+        int room = rows - y + 1;
+        int decade = MOVIE_DECADE_SLOTS;
+        for (int shown = 0; shown < room && decade > 1; )
+        {
+            if (stats->decades[--decade].count) shown++;
+        }
+        for (; decade < MOVIE_DECADE_SLOTS && y <= rows; ++decade)
+        {
+            const StatsGroup *group = &stats->decades[decade];
+            if (decade == 0 || group->count == 0) continue;
+            mvwprintw(win, y++, x, "%ds%*s %6u  %4.2f", decade * 10, name_width - 5, "",
+                      group->count, stats_group_average(group));
+        }
+    }
+    wrefresh(win);
+}
+
+
+/**
+ * @fn void display_stats_ui(MovieCatalog *catalog, const TvCatalog *series)
+ * @brief Shows the statistics dashboard until a key is pressed.
+ *
+ * The rating histogram, the mean rating of the busiest directors, the number
+ * of movies per decade and the TV season and episode totals are all read from
+ * totals that the record functions keep current, so the screen opens at once
+ * whatever the size of the catalog.
+ *
+ * @param catalog The movie catalog to summarize.
+ * @param series The TV series catalog to summarize.
+ */
+
+void display_stats_ui(MovieCatalog *catalog, const TvCatalog *series)
+{
+    const CatalogStats *stats = catalog_statistics(catalog);
+    if (!stats)
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to compute the statistics.");
+        return;
+    }
+
+    WINDOW *win = newwin(LINES - 1, COLS, 0, 0); // The bottom line belongs to the status window
+    keypad(win, TRUE);
+    draw_stats(win, stats, tv_catalog_totals(series));
+
+    while (1)
+    {
+        InputEvent event;
+        if (!input_read(win, -1, &event)) continue;
+        if (event.key != KEY_RESIZE) break;
+        wresize(win, LINES - 1, COLS);
+        draw_stats(win, stats, tv_catalog_totals(series));
+    }
+    delwin(win);
+    touchwin(stdscr);
+    refresh();
+}
+
+
+/**
+ * @fn void ui_print_error(const char* format, ...)
+ * @brief Displays an error message to the user.
+ * 
+ * While the UI is running the message is queued on the status line (see `notify()`).
+ * Before `init_ui()` (or after `end_ui()`) it is printed to stderr instead.
+ * 
+ * @param format A format string as in printf that contains the error message to be displayed.
+ * @param ... Variable arguments providing additional information (if necessary) to be included in the format string.
+ * 
+ * @note This function never waits for a key press.
+ * 
+ * @warning The function assumes that the format and the arguments passed to it are valid and that the format contains no more than the expected number of placeholders.
+ */
+
+void ui_print_error(const char* format, ...) 
+{
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    notify(NOTIFY_ERROR, "%s", message);
+}
+
+
+/**
+ * @file ui.c
+ * @brief UI functions for the movie management system using ncurses library.
+ */
+
+/**
+ * @brief Asks for an optional value on a form row.
+ *
+ * @return false if the answer was left blank, to keep the current value.
+ */
+
+static bool read_form_optional(WINDOW *win, int y, const char *prompt, char *buffer, int size)
+{
+    mvwprintw(win, y, 2, "%s", prompt);
+    wclrtoeol(win);
+    box(win, 0, 0);
+    wgetnstr(win, buffer, size - 1);
+    return buffer[0] != '\0';
+}
+
+
+/**
+ * @brief Asks for the changes of a bulk edit; every field left blank is kept.
+ *
+ * The title is only offered when a single movie is edited. Years have to be
+ * after 1800 and not in the future, as for a new movie, and ratings between
+ * 0 and 5; an invalid answer is asked again.
+ *
+ * @param count Number of movies being edited.
+ * @param[out] edit Receives the fields given, pointing into `title` and `director`.
+ * @param title Buffer for the new title.
+ * @param director Buffer for the new director.
+ * @param size Size of both buffers.
+ */
+
+static void read_movie_edit(int count, MovieEdit *edit, char *title, char *director, int size)
+{
+    time_t now = time(NULL);
+    int current_year = localtime(&now)->tm_year + 1900;
+    char buffer[16];
+    int y = 2;
+
+    memset(edit, 0, sizeof(*edit));
+    WINDOW *win = newwin(10, 60, 5, 5);
+    box(win, 0, 0);
+    mvwprintw(win, 1, 2, "Editing %d movie%s, leave blank to keep.", count, count == 1 ? "" : "s");
+    wrefresh(win);
+    echo();
+    if (count == 1 && read_form_optional(win, y++, "New title: ", title, size))
+    {
+        edit->fields |= MOVIE_EDIT_TITLE;
+        edit->title = title;
+    }
+    if (read_form_optional(win, y++, "New director: ", director, size))
+    {
+        edit->fields |= MOVIE_EDIT_DIRECTOR;
+        edit->director = director;
+    }
+    while (read_form_optional(win, y, "New year: ", buffer, (int)sizeof(buffer)))
+    {
+        char *end;
+        long year = strtol(buffer, &end, 10);
+        if (end != buffer && *end == '\0' && year > 1800 && year <= current_year)
+        {
+            edit->fields |= MOVIE_EDIT_YEAR;
+            edit->year = (int)year;
+            break;
+        }
+        mvwprintw(win, 7, 2, "Error: Please enter a valid year (after 1800).");
+        wclrtoeol(win);
+    }
+    y++;
+    while (read_form_optional(win, y, "New rating (0-5): ", buffer, (int)sizeof(buffer)))
+    {
+        char *end;
+        float rating = strtof(buffer, &end);
+        if (end != buffer && *end == '\0' && rating >= 0.0f && rating <= 5.0f)
+        {
+            edit->fields |= MOVIE_EDIT_RATING;
+            edit->rating = rating;
+            break;
+        }
+        mvwprintw(win, 7, 2, "Error: Please enter a rating from 0 to 5.");
+        wclrtoeol(win);
+    }
+    noecho();
+    delwin(win);
+    erase();
+    refresh();
+}
+
+
+/**
+ * @brief Applies a bulk edit asked for with `read_movie_edit()` and reports it.
+ *
+ * The catalog fields go through `edit_movies()` as one transaction. While a
+ * user profile is active the rating is theirs, so it is stored in the profile
+ * instead, movie by movie, as 'r' in the list does.
+ *
+ * @return true if anything was changed.
+ */
+
+static bool apply_movie_edit(MovieCatalog *catalog, Profile *profile, Movie **movies, int count, MovieEdit edit)
+{
+    bool personal = profile_active(profile) && (edit.fields & MOVIE_EDIT_RATING);
+    float rating = edit.rating;
+    if (personal) edit.fields &= ~(unsigned)MOVIE_EDIT_RATING;
+    if (edit.fields == 0 && !personal)
+    {
+        notify(NOTIFY_INFO, "Nothing was changed.");
+        return false;
+    }
+
+    if (edit_movies(catalog, movies, count, &edit) != MOVIE_SUCCESS)
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to edit the movies.");
+        return false;
+    }
+    for (int i = 0; personal && i < count; ++i)
+    {
+        if (profile_rate(profile, movies[i], rating) != PROFILE_SUCCESS)
+        {
+            notify(NOTIFY_ERROR, "Not enough memory to store the ratings.");
+            return true;
+        }
+        recommend_rating_changed(catalog->recommend, profile, movies[i], rating);
+    }
+    notify(NOTIFY_INFO, "Edited %d movie%s.", count, count == 1 ? "" : "s");
+    return true;
+}
+
+
+// The rows of the edit screen: the movies the edit applies to
+typedef struct
+{
+    Movie **movies;
+    int count;
+    const Profile *profile;
+} EditListState;
+
+
+/**
+ * @brief List widget callback: the rows are the movies being edited.
+ */
+
+static int edit_list_fetch(void *context, int start, void **rows, int max)
+{
+    EditListState *state = (EditListState*)context;
+    int count = 0;
+    for (int position = start; position < state->count && count < max; ++position)
+    {
+        rows[count++] = state->movies[position];
+    }
+    return count;
+}
+
+
+/**
+ * @brief List widget callback: formats one movie being edited.
+ */
+
+static void edit_list_format(void *context, const void *record, int position, char *buffer, size_t size)
+{
+    const EditListState *state = (const EditListState*)context;
+    const Movie *movie = (const Movie*)record;
+    float rating = profile_active(state->profile) ? profile_rating(state->profile, movie) : movie->rating;
+    snprintf(buffer, size, "%4d |%-15.15s |%-15.15s |%4d - %.1f/5",
+             position + 1, movie->title, movie->director, movie->year, rating);
+}
+
+
+/**
+ * @fn bool edit_movie_ui(MovieCatalog *catalog, Profile *profile, Movie **movies, int count)
+ * @brief Lists the movies about to be edited and, on Enter, edits them all at once.
+ * 
+ * The movies are shown in a list widget, which can be scrolled with the arrow
+ * and page keys to check the selection. Enter asks for the new director, year
+ * and rating (and title, for a single movie), any of which can be left as they
+ * are, and applies them to every movie listed as one bulk edit (see
+ * `edit_movies()`): the indexes, totals and journal are updated once for the
+ * batch, not once per movie. The screen closes once the edit is applied.
+ * 
+ * @param catalog The catalog the movies belong to.
+ * @param profile The active user, whose ratings an edit changes, or NULL or an inactive profile.
+ * @param movies The movies to edit.
+ * @param count The number of movies in the array.
+ * @return true if the movies were changed.
+ * 
+ * @pre The ncurses library must be initialized using init_ui() before calling this function.
+ * 
+ * @note Pressing 'q' leaves the screen without changing anything.
+ */
+
+bool edit_movie_ui(MovieCatalog *catalog, Profile *profile, Movie **movies, int count) 
+{
+    EditListState state = { movies, count, profile };
+    ListWidget list;
+    char title[32];
+
+    if (count <= 0) return false;
+    snprintf(title, sizeof(title), "EDIT %d MOVIE%s", count, count == 1 ? "" : "S");
+    if (!list_widget_create(&list, title, " No  | Title           | Director     | Year - Rating |",
+                            "Arrows/Pg:Move,Enter:Edit all,'q':Cancel.", edit_list_fetch, edit_list_format, &state))
+    {
+        notify(NOTIFY_ERROR, "Not enough memory to show the list.");
+        return false;
+    }
+    list_widget_set_total(&list, count);
+
+    while (1) 
+    {
+        list_widget_render(&list);
+
+        InputEvent event;
+        if (!input_read(list.win, -1, &event)) continue;
+
+        switch (event.key) 
+        {
+            case KEY_UP:
+                list_widget_move(&list, -event.count);
+                break;
+            case KEY_DOWN:
+                list_widget_move(&list, event.count);
+                break;
+            case KEY_PPAGE:
+                list_widget_move(&list, -list.page_size * event.count);
+                break;
+            case KEY_NPAGE:
+                list_widget_move(&list, list.page_size * event.count);
+                break;
+            case KEY_HOME:
+                list_widget_select(&list, 0);
+                break;
+            case KEY_END:
+                list_widget_select(&list, list.total - 1);
+                break;
+            case KEY_RESIZE:
+                if (!list_widget_resize(&list))
+                {
+                    list_widget_destroy(&list);
+                    return false;
+                }
+                break;
+            case '\n':
+            case KEY_ENTER:
+            {
+                char new_title[100], new_director[100];
+                MovieEdit edit;
+                read_movie_edit(count, &edit, new_title, new_director, (int)sizeof(new_title));
+                bool changed = apply_movie_edit(catalog, profile, movies, count, edit);
+                list_widget_destroy(&list);
+                return changed;
+            }
+            case 'q':
+                list_widget_destroy(&list);
+                erase();
+                refresh();
+                return false;
         }
     }
 }
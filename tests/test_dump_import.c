@@ -0,0 +1,94 @@
+/**
+ * @file test_dump_import.c
+ * @brief Checks that dump fields holding the text file's separators survive a save and reload.
+ *
+ * Quoted CSV fields may contain '|' and line breaks, which separate the fields
+ * and records of movies.txt. The test imports such rows, writes the catalog to
+ * a text file, loads it back and expects the same movies, with the separators
+ * replaced by spaces.
+ *
+ * Usage:
+ *   test_dump_import [DIR]   (scratch files go to DIR, default the current directory)
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <string.h>
+#include "catalog.h"
+#include "movie.h"
+#include "storage.h"
+#include "dump_import.h"
+#include "name_table.h"
+
+static int failures = 0;
+
+
+static void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+
+/**
+ * @brief Expects a movie with this title to be in the catalog, with the given director and year.
+ */
+
+static void expect_movie(const MovieCatalog *catalog, const char *title, const char *director, int year)
+{
+    const Movie *movie = search_movie(catalog, title);
+    char what[128];
+    snprintf(what, sizeof(what), "movie \"%s\" by \"%s\" (%d)", title, director, year);
+    expect(movie && strcmp(movie->title, title) == 0 && strcmp(movie->director, director) == 0
+           && movie->year == year, what);
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 1 ? argv[1] : ".";
+    char csv[512], text[512];
+    snprintf(csv, sizeof(csv), "%s/test_dump_import.csv", dir);
+    snprintf(text, sizeof(text), "%s/test_dump_import.txt", dir);
+
+    FILE *file = fopen(csv, "w");
+    if (!file)
+    {
+        fprintf(stderr, "FAIL: cannot write %s\n", csv);
+        return 1;
+    }
+    fputs("title,director,year,rating\n"
+          "\"A|B\",\"X\nY\",1999,3\n"
+          "\"Carriage\r\nReturn\",Z,2001,\n"
+          "Plain,P,1980,4.5\n", file);
+    fclose(file);
+
+    MovieCatalog catalog;
+    if (catalog_init(&catalog, 16) != MOVIE_SUCCESS) return 1;
+    DumpImportStats stats;
+    expect(import_dump(csv, &catalog, &stats) == DUMP_IMPORT_SUCCESS, "import succeeds");
+    expect(stats.rows == 3 && stats.added == 3 && stats.invalid == 0, "every row is imported");
+    expect_movie(&catalog, "A B", "X Y", 1999);
+    expect_movie(&catalog, "Carriage  Return", "Z", 2001);
+
+    save_movies_to_file(text, &catalog);
+    MovieCatalog reloaded;
+    if (catalog_init(&reloaded, 16) != MOVIE_SUCCESS) return 1;
+    load_movies_from_file(text, &reloaded);
+    expect(reloaded.movies.count == 3, "the text file holds one line per movie");
+    expect_movie(&reloaded, "A B", "X Y", 1999);
+    expect_movie(&reloaded, "Carriage  Return", "Z", 2001);
+    expect_movie(&reloaded, "Plain", "P", 1980);
+
+    catalog_destroy(&catalog);
+    catalog_destroy(&reloaded);
+    name_table_destroy();
+    remove(csv);
+    remove(text);
+
+    if (failures == 0) puts("test_dump_import: OK");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file test_history.c
+ * @brief Checks undo and redo of every kind of edit, and that the journal replays them.
+ *
+ * A journaled catalog gets an add, a rating, an update, a deletion and a bulk
+ * edit. Each is undone back to the start and redone again, and after every step
+ * the catalog must match the state it had then, in its records and in the
+ * columns, totals and title index kept beside them. The journal, which records
+ * the undos and redos too, is finally replayed onto the snapshot, which must
+ * give the catalog in memory.
+ *
+ * Usage:
+ *   test_history [DIR]   (scratch files go to DIR, default the current directory)
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "catalog.h"
+#include "movie.h"
+#include "storage.h"
+#include "history.h"
+#include "name_table.h"
+
+#define STATE_SIZE 1024
+#define EDIT_COUNT 5
+
+static int failures = 0;
+
+
+static void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+
+static int compare_titles(const void *a, const void *b)
+{
+    return strcmp((*(Movie *const *)a)->title, (*(Movie *const *)b)->title);
+}
+
+
+/**
+ * @brief Describes the live movies in title order, independent of their ids.
+ *
+ * Also checks that the indexes beside the records agree with them.
+ */
+
+static void describe(MovieCatalog *catalog, char *state, size_t size)
+{
+    Movie *movies[16];
+    int count = 0;
+    uint64_t rating_sum = 0;
+    for (int id = 0; id < catalog->movies.slot_count && count < 16; ++id)
+    {
+        Movie *movie = catalog_get(catalog, id);
+        if (!movie) continue;
+        movies[count++] = movie;
+
+        uint8_t tenths = movie_rating_quantize(movie->rating);
+        rating_sum += tenths;
+        expect(catalog->columns.years[id] == movie->year && catalog->columns.ratings[id] == tenths,
+               "the columns hold the movie's year and rating");
+        expect(search_movie(catalog, movie->title) == movie, "the title index finds the movie");
+    }
+    const CatalogStats *stats = catalog_statistics(catalog);
+    expect(stats && stats->total.count == (uint32_t)catalog->movies.count && stats->total.rating_sum == rating_sum,
+           "the totals match the movies");
+
+    qsort(movies, (size_t)count, sizeof(*movies), compare_titles);
+    size_t used = 0;
+    state[0] = '\0';
+    for (int i = 0; i < count && used < size; ++i)
+    {
+        used += (size_t)snprintf(state + used, size - used, "%s|%s|%d|%.1f;",
+                                 movies[i]->title, movies[i]->director, movies[i]->year, movies[i]->rating);
+    }
+}
+
+
+static void expect_state(MovieCatalog *catalog, const char *expected, const char *what)
+{
+    char state[STATE_SIZE];
+    describe(catalog, state, sizeof(state));
+    expect(strcmp(state, expected) == 0, what);
+    if (strcmp(state, expected) != 0) fprintf(stderr, "  got      %s\n  expected %s\n", state, expected);
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 1 ? argv[1] : ".";
+    char text[512], snapshot[512], journal[512];
+    snprintf(text, sizeof(text), "%s/test_history.txt", dir);
+    snprintf(snapshot, sizeof(snapshot), "%s/test_history.bin", dir);
+    snprintf(journal, sizeof(journal), "%s/test_history.journal", dir);
+    remove(text);
+    remove(snapshot);
+    remove(journal);
+
+    MovieCatalog catalog;
+    CatalogStore store;
+    if (catalog_init(&catalog, 16) != MOVIE_SUCCESS) return 1;
+    store_init(&store, text, snapshot, journal);
+    store_open(&store, &catalog);
+
+    Movie *alpha = create_movie(&catalog, "Alpha", "Ann", 1990);
+    Movie *beta = create_movie(&catalog, "Beta", "Bob", 1995);
+    Movie *gamma = create_movie(&catalog, "Gamma", "Ann", 2000);
+    if (!alpha || !beta || !gamma) return 1;
+    set_movie_rating(&catalog, gamma, 2.0f);
+
+    History history;
+    if (!history_init(&history, &catalog, HISTORY_CAPACITY)) return 1;
+    catalog.history = &history;
+
+    // states[i] is the catalog after the first i edits
+    char states[EDIT_COUNT + 1][STATE_SIZE];
+    describe(&catalog, states[0], STATE_SIZE);
+
+    Movie *delta = create_movie(&catalog, "Delta", "Dee", 2010);
+    expect(delta != NULL, "the movie is added");
+    describe(&catalog, states[1], STATE_SIZE);
+
+    expect(set_movie_rating(&catalog, alpha, 4.5f) == MOVIE_SUCCESS, "the movie is rated");
+    describe(&catalog, states[2], STATE_SIZE);
+
+    expect(update_movie(&catalog, beta, "Beta II", "Cy", 1996) == MOVIE_SUCCESS, "the movie is updated");
+    describe(&catalog, states[3], STATE_SIZE);
+
+    expect(remove_movie(&catalog, gamma->id) == MOVIE_SUCCESS, "the movie is deleted");
+    describe(&catalog, states[4], STATE_SIZE);
+
+    Movie *marked[] = { alpha, delta };
+    MovieEdit edit = { MOVIE_EDIT_YEAR | MOVIE_EDIT_RATING, NULL, NULL, 2005, 3.0f };
+    expect(edit_movies(&catalog, marked, 2, &edit) == MOVIE_SUCCESS, "the movies are edited");
+    describe(&catalog, states[5], STATE_SIZE);
+
+    // A year the snapshot loaders would refuse is refused here, and records nothing
+    MovieEdit too_early = { MOVIE_EDIT_YEAR, NULL, NULL, 1700, 0.0f };
+    expect(update_movie(&catalog, beta, "Beta II", "Cy", 1700) != MOVIE_SUCCESS, "an update to 1700 is refused");
+    expect(edit_movies(&catalog, marked, 2, &too_early) != MOVIE_SUCCESS, "a bulk edit to 1700 is refused");
+    expect_state(&catalog, states[5], "a refused edit changes nothing");
+
+    char label[HISTORY_LABEL_SIZE];
+    for (int step = EDIT_COUNT; step > 0; --step)
+    {
+        expect(history_undo(&history, label, sizeof(label)) == HISTORY_SUCCESS, "an edit is undone");
+        expect_state(&catalog, states[step - 1], "undo restores the previous state");
+    }
+    expect(history_undo(&history, label, sizeof(label)) == HISTORY_ERROR_EMPTY, "nothing is left to undo");
+
+    for (int step = 1; step <= EDIT_COUNT; ++step)
+    {
+        expect(history_redo(&history, label, sizeof(label)) == HISTORY_SUCCESS, "an edit is redone");
+        expect_state(&catalog, states[step], "redo restores the next state");
+    }
+    expect(history_redo(&history, label, sizeof(label)) == HISTORY_ERROR_EMPTY, "nothing is left to redo");
+
+    // Back to before the deletion, so the journal ends on the undo of a delete
+    for (int step = EDIT_COUNT; step > 3; --step)
+    {
+        history_undo(&history, label, sizeof(label));
+    }
+    expect_state(&catalog, states[3], "undo after redo restores the state");
+
+    catalog.history = NULL;
+    history_destroy(&history);
+    store_close(&store, &catalog);
+
+    MovieCatalog replayed;
+    CatalogStore reopened;
+    if (catalog_init(&replayed, 16) != MOVIE_SUCCESS) return 1;
+    store_init(&reopened, text, snapshot, journal);
+    store_open(&reopened, &replayed);
+    expect_state(&replayed, states[3], "the journal replays the edits, undos and redos");
+    store_close(&reopened, &replayed);
+
+    catalog_destroy(&catalog);
+    catalog_destroy(&replayed);
+    name_table_destroy();
+    remove(text);
+    remove(snapshot);
+    remove(journal);
+
+    if (failures == 0) puts("test_history: OK");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file test_journal.c
+ * @brief Checks that the journal replays every kind of edit, and recovers from torn and retired files.
+ *
+ * Edits journaled on an empty catalog must replay to the same catalog, ids
+ * included. A torn last entry is dropped and cut off so the next append follows
+ * the good ones, a corrupt entry stops the replay there, and a journal of
+ * another generation is not replayed at all. Finally a store whose background
+ * compaction left a retired journal behind must recover both journals on open.
+ *
+ * Usage:
+ *   test_journal [DIR]   (scratch files go to DIR, default the current directory)
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "catalog.h"
+#include "movie.h"
+#include "journal.h"
+#include "storage.h"
+#include "name_table.h"
+
+#define STATE_SIZE 1024
+#define GENERATION 3
+#define ENTRY_COUNT 7  // Journaled by make_edits()
+
+static int failures = 0;
+
+
+static void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+
+/**
+ * @brief Describes the live movies in id order.
+ */
+
+static void describe(const MovieCatalog *catalog, char *state, size_t size)
+{
+    size_t used = 0;
+    state[0] = '\0';
+    for (int id = 0; id < catalog->movies.slot_count && used < size; ++id)
+    {
+        const Movie *movie = catalog_get(catalog, id);
+        if (!movie) continue;
+        used += (size_t)snprintf(state + used, size - used, "%d:%s|%s|%d|%.1f;",
+                                 id, movie->title, movie->director, movie->year, movie->rating);
+    }
+}
+
+
+/**
+ * @brief Replays `filename` onto an empty catalog and describes the result.
+ *
+ * @return The number of entries applied, or -1.
+ */
+
+static int replay(const char *filename, uint64_t generation, char *state)
+{
+    MovieCatalog catalog;
+    if (catalog_init(&catalog, 16) != MOVIE_SUCCESS) return -1;
+    int applied = journal_replay(filename, generation, &catalog);
+    describe(&catalog, state, STATE_SIZE);
+    catalog_destroy(&catalog);
+    return applied;
+}
+
+
+/**
+ * @brief Makes one edit of every kind, ENTRY_COUNT entries in all.
+ */
+
+static void make_edits(MovieCatalog *catalog)
+{
+    Movie *alpha = create_movie(catalog, "Alpha", "Ann", 1990);
+    Movie *beta = create_movie(catalog, "Beta", "Bob", 1995);
+    Movie *gamma = create_movie(catalog, "Gamma", "Ann", 2000);
+    if (!alpha || !beta || !gamma) return;
+    set_movie_rating(catalog, alpha, 4.5f);
+    update_movie(catalog, beta, "Beta II", "Cy", 1996);
+    remove_movie(catalog, alpha->id);
+
+    Movie *marked[] = { beta, gamma };
+    MovieEdit edit = { MOVIE_EDIT_DIRECTOR | MOVIE_EDIT_RATING, NULL, "Dee", 0, 3.0f };
+    edit_movies(catalog, marked, 2, &edit);
+}
+
+
+static long file_size(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+
+/**
+ * @brief Journals edits, then replays the journal whole, torn and corrupt.
+ */
+
+static void check_replay(const char *filename)
+{
+    remove(filename);
+    MovieCatalog catalog;
+    Journal journal;
+    if (catalog_init(&catalog, 16) != MOVIE_SUCCESS) return;
+    if (journal_open(&journal, filename, GENERATION) != JOURNAL_SUCCESS)
+    {
+        expect(false, "the journal opens");
+        return;
+    }
+    catalog.journal = &journal;
+    make_edits(&catalog);
+    catalog.journal = NULL;
+    journal_close(&journal);
+
+    char live[STATE_SIZE], state[STATE_SIZE];
+    describe(&catalog, live, sizeof(live));
+    expect(replay(filename, GENERATION, state) == ENTRY_COUNT, "every entry is replayed");
+    expect(strcmp(state, live) == 0, "the replay rebuilds the catalog, ids included");
+    expect(replay(filename, GENERATION + 1, state) == -1, "a journal of another generation is not replayed");
+
+    // A crash in the middle of the last append
+    long whole = file_size(filename);
+    expect(truncate(filename, whole - 5) == 0, "the journal is torn");
+    expect(replay(filename, GENERATION, state) == ENTRY_COUNT - 1, "a torn last entry is dropped");
+    long good = file_size(filename);
+    expect(good < whole - 5, "the torn entry is cut off the file");
+
+    // The next session appends after the good entries
+    if (journal_open(&journal, filename, GENERATION) == JOURNAL_SUCCESS)
+    {
+        Movie *movie = create_movie(&catalog, "Epsilon", "Eve", 2020);
+        expect(movie && journal_record_add(&journal, movie) == JOURNAL_SUCCESS, "an entry is appended");
+        journal_close(&journal);
+    }
+    expect(replay(filename, GENERATION, state) == ENTRY_COUNT, "the appended entry follows the good ones");
+    expect(strstr(state, "Epsilon") != NULL, "the appended entry is replayed");
+
+    // A corrupt entry stops the replay there, and the rest of the file goes with it
+    FILE *file = fopen(filename, "r+b");
+    if (file)
+    {
+        fseek(file, (long)sizeof(JournalHeader) + 12, SEEK_SET); // Inside the first entry's year
+        fputc(0x7f, file);
+        fclose(file);
+    }
+    expect(replay(filename, GENERATION, state) == 0, "a corrupt entry stops the replay");
+    expect(file_size(filename) == (long)sizeof(JournalHeader), "the entries from the corrupt one on are cut off");
+
+    catalog_destroy(&catalog);
+    remove(filename);
+}
+
+
+/**
+ * @brief Opens a store whose last background compaction never wrote its snapshot.
+ */
+
+static void check_recovery(const char *text, const char *snapshot, const char *journal)
+{
+    remove(text);
+    remove(snapshot);
+    remove(journal);
+
+    MovieCatalog catalog;
+    CatalogStore store;
+    if (catalog_init(&catalog, 16) != MOVIE_SUCCESS) return;
+    store_init(&store, text, snapshot, journal);
+    store_open(&store, &catalog);
+    make_edits(&catalog);
+
+    // What store_maintain() does before the worker writes the files, which it never does
+    uint64_t generation = store.generation + 1;
+    expect(journal_rotate(&store.journal, journal, store.retired_filename, generation) == JOURNAL_SUCCESS,
+           "the journal is retired");
+    catalog_compact(&catalog);
+    store.generation = generation;
+    Movie *movie = create_movie(&catalog, "Zeta", "Zed", 2021);
+    set_movie_rating(&catalog, movie, 1.5f);
+    char live[STATE_SIZE];
+    describe(&catalog, live, sizeof(live));
+    store_close(&store, &catalog);
+    catalog_destroy(&catalog);
+    expect(access(store.retired_filename, F_OK) == 0, "the retired journal is left behind");
+
+    for (int run = 0; run < 2; ++run)
+    {
+        MovieCatalog reopened;
+        CatalogStore again;
+        if (catalog_init(&reopened, 16) != MOVIE_SUCCESS) return;
+        store_init(&again, text, snapshot, journal);
+        store_open(&again, &reopened);
+        char state[STATE_SIZE];
+        describe(&reopened, state, sizeof(state));
+        expect(strcmp(state, live) == 0, run == 0 ? "both journals are recovered" : "the recovery is saved");
+        expect(access(again.retired_filename, F_OK) != 0, "the retired journal is folded into the snapshot");
+        store_close(&again, &reopened);
+        catalog_destroy(&reopened);
+    }
+
+    remove(text);
+    remove(snapshot);
+    remove(journal);
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 1 ? argv[1] : ".";
+    char text[512], snapshot[512], journal[512];
+    snprintf(text, sizeof(text), "%s/test_journal.txt", dir);
+    snprintf(snapshot, sizeof(snapshot), "%s/test_journal.bin", dir);
+    snprintf(journal, sizeof(journal), "%s/test_journal.journal", dir);
+
+    check_replay(journal);
+    check_recovery(text, snapshot, journal);
+    name_table_destroy();
+
+    if (failures == 0) puts("test_journal: OK");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+/**
+ * @file test_snapshot.c
+ * @brief Checks that plain and packed snapshots load back as saved, and that damaged ones are refused.
+ *
+ * A catalog with rated and unrated movies, shared directors and a deleted slot
+ * is saved in both formats, then loaded into an empty catalog and appended to a
+ * populated one. Truncated files, a bad magic, a string offset past the table, a
+ * year the catalog refuses, a damaged zlib stream and a damaged block index
+ * must all fail without adding a movie.
+ *
+ * Usage:
+ *   test_snapshot [DIR]   (scratch files go to DIR, default the current directory)
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "catalog.h"
+#include "movie.h"
+#include "snapshot.h"
+#include "packed_snapshot.h"
+#include "storage.h"
+#include "name_table.h"
+
+#define MOVIE_COUNT (PACKED_BLOCK_RECORDS + 500) // Two blocks when packed
+#define TRUNCATIONS 400                          // Lengths tried past the header
+#define GENERATION 7
+
+typedef SnapshotError (*LoadFn)(const char *filename, MovieCatalog *catalog, uint64_t *generation);
+
+static int failures = 0;
+
+
+static void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+
+static bool write_bytes(const char *filename, const char *data, size_t size)
+{
+    FILE *file = fopen(filename, "wb");
+    if (!file) return false;
+    bool ok = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+
+/**
+ * @brief Expects `loaded` to hold the live movies of `saved`, in id order, after its first `offset` ids.
+ */
+
+static void expect_same_movies(const MovieCatalog *saved, const MovieCatalog *loaded, int offset, const char *what)
+{
+    int id = offset;
+    bool same = loaded->movies.count == offset + saved->movies.count;
+    for (int i = 0; same && i < saved->movies.slot_count; ++i)
+    {
+        const Movie *a = catalog_get(saved, i);
+        if (!a) continue;
+        const Movie *b = catalog_get(loaded, id++);
+        same = b && strcmp(a->title, b->title) == 0 && strcmp(a->director, b->director) == 0
+            && a->year == b->year && a->rating == b->rating;
+    }
+    expect(same, what);
+}
+
+
+/**
+ * @brief Expects a damaged file to be refused with the catalog left empty.
+ */
+
+static void expect_refused(const char *filename, LoadFn load, const char *data, size_t size, const char *what)
+{
+    MovieCatalog catalog;
+    uint64_t generation;
+    if (catalog_init(&catalog, 16) != MOVIE_SUCCESS || !write_bytes(filename, data, size))
+    {
+        expect(false, "the damaged file is written");
+        return;
+    }
+    SnapshotError err = load(filename, &catalog, &generation);
+    expect(err != SNAPSHOT_SUCCESS && catalog.movies.count == 0, what);
+    catalog_destroy(&catalog);
+}
+
+
+/**
+ * @brief Saves, reloads and damages one snapshot format.
+ */
+
+static void check_format(const MovieCatalog *saved, const char *filename, LoadFn load)
+{
+    MovieCatalog loaded;
+    uint64_t generation = 0;
+    if (catalog_init(&loaded, 16) != MOVIE_SUCCESS) return;
+    expect(load(filename, &loaded, &generation) == SNAPSHOT_SUCCESS, "the snapshot loads");
+    expect(generation == GENERATION, "the generation is kept");
+    expect_same_movies(saved, &loaded, 0, "the snapshot holds the saved movies");
+    catalog_destroy(&loaded);
+
+    MovieCatalog populated;
+    if (catalog_init(&populated, 16) != MOVIE_SUCCESS) return;
+    create_movie(&populated, "Already here", "Someone", 1970);
+    expect(load(filename, &populated, &generation) == SNAPSHOT_SUCCESS, "the snapshot loads into a populated catalog");
+    expect(strcmp(catalog_get(&populated, 0)->title, "Already here") == 0, "the catalog keeps its own movie");
+    expect_same_movies(saved, &populated, 1, "the snapshot's movies follow the catalog's own");
+    catalog_destroy(&populated);
+
+    char *data;
+    size_t size;
+    if (read_whole_file(filename, &data, &size) != 0)
+    {
+        expect(false, "the snapshot is read back");
+        return;
+    }
+    char damaged_name[512 + sizeof(".damaged")];
+    snprintf(damaged_name, sizeof(damaged_name), "%s.damaged", filename);
+    for (size_t length = 0; length < size; length += length < 128 ? 1 : size / TRUNCATIONS + 1)
+    {
+        expect_refused(damaged_name, load, data, length, "a truncated snapshot is refused");
+    }
+    expect_refused(damaged_name, load, data, size - 1, "a snapshot missing its last byte is refused");
+    char magic = data[0];
+    data[0] = 'X';
+    expect_refused(damaged_name, load, data, size, "a snapshot with a bad magic is refused");
+    data[0] = magic;
+    free(data);
+    remove(damaged_name);
+}
+
+
+/**
+ * @brief Expects plain snapshots with a bad string offset or year to be refused.
+ */
+
+static void check_plain_records(const char *filename)
+{
+    char *data;
+    size_t size;
+    if (read_whole_file(filename, &data, &size) != 0)
+    {
+        expect(false, "the snapshot is read back");
+        return;
+    }
+    SnapshotHeader header;
+    memcpy(&header, data, sizeof(header));
+    SnapshotRecord *records = (SnapshotRecord*)(data + sizeof(header));
+    SnapshotRecord last = records[header.record_count - 1];
+    char damaged_name[512 + sizeof(".damaged")];
+    snprintf(damaged_name, sizeof(damaged_name), "%s.damaged", filename);
+
+    records[header.record_count - 1].title_offset = (uint32_t)header.string_table_size;
+    expect_refused(damaged_name, load_snapshot, data, size, "a title past the string table is refused");
+    records[header.record_count - 1] = last;
+    records[header.record_count - 1].director_offset = UINT32_MAX;
+    expect_refused(damaged_name, load_snapshot, data, size, "a director past the string table is refused");
+    records[header.record_count - 1] = last;
+    records[header.record_count - 1].year = 1700;
+    expect_refused(damaged_name, load_snapshot, data, size, "a year the catalog refuses is refused");
+
+    free(data);
+    remove(damaged_name);
+}
+
+
+/**
+ * @brief Expects packed snapshots with a damaged block or block index to be refused.
+ */
+
+static void check_packed_blocks(const char *filename)
+{
+    char *data;
+    size_t size;
+    if (read_whole_file(filename, &data, &size) != 0)
+    {
+        expect(false, "the packed snapshot is read back");
+        return;
+    }
+    PackedHeader header;
+    memcpy(&header, data, sizeof(header));
+    PackedBlock *blocks = (PackedBlock*)(data + header.index_offset);
+    expect(header.block_count == 2, "the packed snapshot has two blocks");
+    char damaged_name[512 + sizeof(".damaged")];
+    snprintf(damaged_name, sizeof(damaged_name), "%s.damaged", filename);
+
+    PackedBlock last = blocks[header.block_count - 1];
+    char *stream = data + last.offset + last.compressed_size / 2;
+    *stream ^= 0x5a;
+    expect_refused(damaged_name, load_packed_snapshot, data, size, "a damaged zlib stream is refused");
+    *stream ^= 0x5a;
+
+    blocks[header.block_count - 1].offset = header.index_offset;
+    expect_refused(damaged_name, load_packed_snapshot, data, size, "a block past the data is refused");
+    blocks[header.block_count - 1] = last;
+    blocks[header.block_count - 1].decoded_size++;
+    expect_refused(damaged_name, load_packed_snapshot, data, size, "a block of the wrong decoded size is refused");
+    blocks[header.block_count - 1] = last;
+    blocks[0].records--;
+    expect_refused(damaged_name, load_packed_snapshot, data, size, "a block of the wrong record count is refused");
+    blocks[0].records++;
+
+    // Re-encode the last block with a year the catalog refuses; it sits just before the index
+    uLongf length = last.encoded_size;
+    unsigned char *encoded = malloc(last.encoded_size);
+    uLongf bound = compressBound(last.encoded_size);
+    char *rebuilt = malloc(last.offset + bound + header.block_count * sizeof(PackedBlock));
+    if (encoded && rebuilt
+        && uncompress(encoded, &length, (const Bytef*)data + last.offset, last.compressed_size) == Z_OK)
+    {
+        int32_t year = 1700;
+        memcpy(encoded, &year, sizeof(year)); // years[0]
+        uLongf compressed_size = bound;
+        memcpy(rebuilt, data, last.offset);
+        if (compress2((Bytef*)rebuilt + last.offset, &compressed_size, encoded, length, Z_DEFAULT_COMPRESSION) == Z_OK)
+        {
+            PackedHeader *rebuilt_header = (PackedHeader*)rebuilt;
+            rebuilt_header->index_offset = last.offset + compressed_size;
+            blocks[header.block_count - 1].compressed_size = (uint32_t)compressed_size;
+            memcpy(rebuilt + rebuilt_header->index_offset, blocks, header.block_count * sizeof(PackedBlock));
+            expect_refused(damaged_name, load_packed_snapshot, rebuilt,
+                           rebuilt_header->index_offset + header.block_count * sizeof(PackedBlock),
+                           "a packed year the catalog refuses is refused");
+        }
+    }
+    free(encoded);
+    free(rebuilt);
+
+    free(data);
+    remove(damaged_name);
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 1 ? argv[1] : ".";
+    char plain[512], packed[512];
+    snprintf(plain, sizeof(plain), "%s/test_snapshot.bin", dir);
+    snprintf(packed, sizeof(packed), "%s/test_snapshot.mbz", dir);
+
+    MovieCatalog catalog;
+    if (catalog_init(&catalog, 16) != MOVIE_SUCCESS) return 1;
+    for (int i = 0; i < MOVIE_COUNT; ++i)
+    {
+        char title[64];
+        snprintf(title, sizeof(title), "Movie %04d: Part %d", i, i % 3);
+        Movie *movie = create_movie(&catalog, title, i % 4 ? "Shared Director" : "Another One", 1900 + i % 120);
+        if (!movie) return 1;
+        if (i % 5) set_movie_rating(&catalog, movie, (float)(i % 10) / 2.0f);
+    }
+    remove_movie(&catalog, 10); // A hole, which the snapshot closes
+
+    expect(save_snapshot(plain, &catalog, GENERATION) == SNAPSHOT_SUCCESS, "the snapshot is saved");
+    check_format(&catalog, plain, load_snapshot);
+    check_plain_records(plain);
+
+    expect(save_packed_snapshot(packed, &catalog, GENERATION) == SNAPSHOT_SUCCESS, "the packed snapshot is saved");
+    check_format(&catalog, packed, load_packed_snapshot);
+    check_packed_blocks(packed);
+
+    catalog_destroy(&catalog);
+    name_table_destroy();
+    remove(plain);
+    remove(packed);
+
+    if (failures == 0) puts("test_snapshot: OK");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file test_text_load.c
+ * @brief Checks that bad movies.txt lines are reported with their line numbers and skipped.
+ *
+ * A hand-edited text file mixes valid lines with ratings that are not numbers,
+ * have trailing junk or lie outside 0 to 5, and a year the catalog refuses. Only
+ * the valid lines may load, with their ratings, and every other line must be
+ * reported by its number, single-threaded and split across parser threads alike.
+ *
+ * Usage:
+ *   test_text_load [DIR]   (scratch files go to DIR, default the current directory)
+ */
+
+/*LIBRARY INCLUSIONS*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "catalog.h"
+#include "movie.h"
+#include "storage.h"
+#include "name_table.h"
+
+#define PADDING_LINES 120000 // Enough for the file to be split between threads
+#define LAST_LINE (PADDING_LINES + 12)
+
+static int failures = 0;
+
+
+static void expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+
+/**
+ * @brief Loads `filename` with `threads` parser threads and checks what was kept.
+ */
+
+static void check_load(const char *filename, const char *log, int threads)
+{
+    MovieCatalog catalog;
+    if (catalog_init(&catalog, 16) != MOVIE_SUCCESS) return;
+    storage_set_parse_threads(threads);
+
+    // Catch what the loader reports
+    fflush(stderr);
+    int saved = dup(STDERR_FILENO);
+    if (!freopen(log, "w", stderr)) return;
+    load_movies_from_file(filename, &catalog);
+    fflush(stderr);
+    dup2(saved, STDERR_FILENO);
+    close(saved);
+
+    char *report;
+    size_t size;
+    if (read_whole_file(log, &report, &size) == 0)
+    {
+        char expected[512];
+        snprintf(expected, sizeof(expected),
+                 "Error parsing line 2: Junk\n"
+                 "Error parsing line 3: Trailing\n"
+                 "Error parsing line 4: Negative\n"
+                 "Error parsing line 5: Too high\n"
+                 "Error parsing line 6: Not a number\n"
+                 "Error parsing line 7: Empty\n"
+                 "Error parsing line 10: not added to the movies\n"
+                 "Error parsing line %d: not added to the movies\n", LAST_LINE);
+        expect(strcmp(report, expected) == 0, "every bad line is reported by its number");
+        if (strcmp(report, expected) != 0) fprintf(stderr, "  got\n%s", report);
+        free(report);
+    }
+
+    expect(catalog.movies.count == PADDING_LINES + 3, "only the valid lines are loaded");
+    const Movie *rated = search_movie(&catalog, "Rated");
+    expect(rated && rated->rating == 4.5f, "a valid rating is kept");
+    const Movie *unrated = search_movie(&catalog, "Unrated");
+    expect(unrated && unrated->rating == 0.0f, "a line without a rating is unrated");
+    const Movie *top = search_movie(&catalog, "Top");
+    expect(top && top->rating == 5.0f, "a rating of 5 is kept");
+
+    const char *refused[] = { "Junk", "Trailing", "Negative", "Too high", "Not a number", "Empty", "Too early", "Last" };
+    for (size_t i = 0; i < sizeof(refused) / sizeof(refused[0]); ++i)
+    {
+        expect(search_movie(&catalog, refused[i]) == NULL, "a bad line is skipped");
+    }
+    catalog_destroy(&catalog);
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 1 ? argv[1] : ".";
+    char text[512], log[512];
+    snprintf(text, sizeof(text), "%s/test_text_load.txt", dir);
+    snprintf(log, sizeof(log), "%s/test_text_load.log", dir);
+
+    FILE *file = fopen(text, "w");
+    if (!file)
+    {
+        fprintf(stderr, "FAIL: cannot write %s\n", text);
+        return 1;
+    }
+    fputs("Rated|Ann|1990|4.5\n"
+          "Junk|Ann|1990|abc\n"
+          "Trailing|Ann|1990|3.5x\n"
+          "Negative|Bob|1991|-1\n"
+          "Too high|Bob|1991|7.5\n"
+          "Not a number|Bob|1991|nan\n"
+          "Empty|Cy|1992|\n"
+          "Unrated|Cy|1992\n"
+          "\n"
+          "Too early|Cy|1700|2\n", file);
+    for (int i = 0; i < PADDING_LINES; ++i)
+    {
+        fprintf(file, "Padding %05d|Dee|2000|%.1f\n", i, (float)(i % 11) / 2.0f);
+    }
+    fputs("Top|Eve|2001|5\n"
+          "Last|Eve|1800", file); // No newline after the last line
+    fclose(file);
+
+    check_load(text, log, 1);
+    check_load(text, log, 4);
+    name_table_destroy();
+    remove(text);
+    remove(log);
+
+    if (failures == 0) puts("test_text_load: OK");
+    return failures == 0 ? 0 : 1;
+}